@@ -0,0 +1,505 @@
+/**
+ * @file amg.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Smoothed aggregation algebraic multigrid (AMG), used as a
+ *        preconditioner for the Krylov solvers.
+ *
+ * Each level groups the unknowns (nodes of block_size unknowns each) into
+ * aggregates of strongly connected nodes; the tentative prolongator
+ * injects a constant per aggregate and component, and one damped Jacobi
+ * step smooths it, P = (I - omega D^-1 A) P_tent. The coarse matrix is the
+ * Galerkin product P^T A P. Levels are added until the matrix is small
+ * enough to factor densely.
+ *
+ * A V-cycle smooths with a Chebyshev polynomial in D^-1 A, which needs only
+ * products and vector updates, so it runs in parallel as well as the
+ * products do (unlike Gauss-Seidel), and with the same polynomial before
+ * and after the coarse correction the cycle is symmetric: a valid
+ * preconditioner for CG.
+ *
+ * Everything but the aggregation (a greedy pass over the nodes) and the
+ * transposes runs in parallel: the strength measure and the Galerkin
+ * product are sparse products, and the cycle is made of products and
+ * vector updates.
+ */
+
+#ifndef FMM_AMG_HPP
+#define FMM_AMG_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "krylov.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "sparse.hpp"
+
+/**
+ * @brief Parameters of the hierarchy and the cycle.
+ */
+struct AmgOptions {
+    double strength = 0.08;             /**< Nodes i, j are strongly connected if |A_ij| >= strength sqrt(|A_ii| |A_jj|) (block norms), halved on each coarser level. */
+    size_t block_size = 1;              /**< Unknowns per node, kept together by the aggregation (3 for elasticity). */
+    size_t max_levels = 20;             /**< The most levels, the finest included. */
+    size_t coarse_size = 500;           /**< Coarsening stops at this many unknowns. */
+    size_t smoother_degree = 2;         /**< Chebyshev degree, before and after the coarse correction. */
+    double smoother_ratio = 30.0;       /**< The smoother damps eigenvalues in [lambda_max / ratio, lambda_max]. */
+    double prolongator_damping = 4.0 / 3.0; /**< omega lambda_max in the prolongator smoothing. */
+};
+
+/**
+ * @brief Seconds spent building the hierarchy, by phase (strength and
+ *        aggregation, prolongator smoothing, Galerkin products, coarse
+ *        factorisation) and in total, then in the cycles applied since.
+ */
+struct AmgTimings {
+    double aggregation = 0.0;
+    double prolongator = 0.0;
+    double galerkin = 0.0;
+    double coarse = 0.0;
+    double setup = 0.0;
+    double cycle = 0.0;
+    size_t cycles = 0;
+};
+
+namespace detail {
+
+/**
+ * @brief Coarsest levels above this many unknowns are smoothed rather than
+ *        factored (dense LU would cost more than the rest of the cycle).
+ */
+inline constexpr size_t AMG_DENSE_LIMIT = 2000;
+
+/**
+ * @brief One level of the hierarchy: its matrix, the prolongator from the
+ *        next level and its transpose, and the smoother's data.
+ */
+struct AmgLevel {
+    CsrMatrix a, p, r;
+    AlignedVector<double> inverse_diagonal;
+    double lambda_max = 0.0;
+    // Scratch for the cycle: right-hand side and solution (of the coarse
+    // levels), residual, Chebyshev direction and product.
+    mutable AlignedVector<double> b, x, residual, direction, product;
+};
+
+/**
+ * @brief The square of the strength matrix: entry (i, j) is the squared
+ *        Frobenius norm of the block of A coupling nodes i and j.
+ */
+inline CsrMatrix amg_node_norms(const CsrMatrix &a, size_t block, ThreadPool &pool) {
+    std::vector<double> squares(a.values().begin(), a.values().end());
+    for (double &v: squares) v *= v;
+    std::vector<size_t> ptr(a.row_ptr().begin(), a.row_ptr().end());
+    std::vector<uint32_t> col(a.col_idx().begin(), a.col_idx().end());
+    CsrMatrix squared(a.rows(), a.cols(), std::move(ptr), std::move(col), squares);
+    if (block == 1) return squared;
+
+    // G (nodes x unknowns) sums the rows of a node; G A^2 G^T the blocks.
+    const size_t nodes = a.rows() / block;
+    std::vector<size_t> gptr(nodes + 1);
+    std::vector<uint32_t> gcol(a.rows());
+    for (size_t i = 0; i <= nodes; ++i) gptr[i] = i * block;
+    for (size_t k = 0; k < a.rows(); ++k) gcol[k] = uint32_t(k);
+    std::vector<double> ones(a.rows(), 1.0);
+    CsrMatrix g(nodes, a.rows(), std::move(gptr), std::move(gcol), ones);
+    return spgemm(spgemm(g, squared, pool), transpose(g), pool);
+}
+
+/**
+ * @brief Groups the nodes into aggregates of strongly connected nodes
+ *        (greedy, in three phases): returns the aggregate of each node and
+ *        sets count to the number of aggregates.
+ *
+ * 1. A node whose strong neighbours are all free starts an aggregate with
+ *    them. 2. A free node joins the aggregate of a strong neighbour placed
+ *    in phase 1. 3. Free nodes left start aggregates with their free strong
+ *    neighbours.
+ */
+inline std::vector<uint32_t> amg_aggregate(const CsrMatrix &norms, double theta, size_t &count) {
+    constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    const size_t n = norms.rows();
+    auto ptr = norms.row_ptr();
+    auto col = norms.col_idx();
+    auto val = norms.values();
+    std::vector<double> diagonal(n);
+    for (size_t i = 0; i < n; ++i) diagonal[i] = norms(i, i);
+    const double theta2 = theta * theta;
+    auto strong = [&](size_t i, size_t k) {
+        return col[k] != i && val[k] >= theta2 * std::sqrt(diagonal[i] * diagonal[col[k]]) && val[k] > 0.0;
+    };
+
+    std::vector<uint32_t> aggregate(n, none);
+    std::vector<bool> root(n, false);
+    count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (aggregate[i] != none) continue;
+        bool free = true;
+        for (size_t k = ptr[i]; k < ptr[i + 1] && free; ++k) free = !strong(i, k) || aggregate[col[k]] == none;
+        if (!free) continue;
+        aggregate[i] = uint32_t(count);
+        root[i] = true;
+        for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+            if (strong(i, k)) aggregate[col[k]] = uint32_t(count), root[col[k]] = true;
+        }
+        ++count;
+    }
+    std::vector<uint32_t> joined = aggregate;
+    for (size_t i = 0; i < n; ++i) {
+        if (aggregate[i] != none) continue;
+        for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+            if (strong(i, k) && root[col[k]]) {
+                joined[i] = aggregate[col[k]];
+                break;
+            }
+        }
+    }
+    aggregate = std::move(joined);
+    for (size_t i = 0; i < n; ++i) {
+        if (aggregate[i] != none) continue;
+        aggregate[i] = uint32_t(count);
+        for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+            if (strong(i, k) && aggregate[col[k]] == none) aggregate[col[k]] = uint32_t(count);
+        }
+        ++count;
+    }
+    return aggregate;
+}
+
+/**
+ * @brief The tentative prolongator: unknown c of node i takes unknown c of
+ *        its aggregate, scaled so each column has unit norm.
+ */
+inline CsrMatrix amg_tentative(const std::vector<uint32_t> &aggregate, size_t count, size_t block) {
+    std::vector<size_t> size(count, 0);
+    for (uint32_t g: aggregate) ++size[g];
+    const size_t rows = aggregate.size() * block;
+    std::vector<size_t> row_ptr(rows + 1);
+    std::vector<uint32_t> col_idx(rows);
+    std::vector<double> values(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        const uint32_t g = aggregate[r / block];
+        row_ptr[r + 1] = r + 1;
+        col_idx[r] = uint32_t(g * block + r % block);
+        values[r] = 1.0 / std::sqrt(double(size[g]));
+    }
+    return {rows, count * block, std::move(row_ptr), std::move(col_idx), values};
+}
+
+/**
+ * @brief An upper bound on the eigenvalues of D^-1 A: the largest absolute
+ *        row sum (Gershgorin). Power iteration gives a lower estimate,
+ *        and a Chebyshev smoother tuned below the top of the spectrum
+ *        amplifies the modes above it.
+ */
+inline double amg_lambda_max(const CsrMatrix &a, std::span<const double> inverse_diagonal, ThreadPool &pool) {
+    auto ptr = a.row_ptr();
+    auto val = a.values();
+    const size_t blocks = (a.rows() + KRYLOV_BLOCK - 1) / KRYLOV_BLOCK;
+    std::vector<double> largest(blocks, 0.0);
+    parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+        for (size_t b = lo; b < hi; ++b) {
+            for (size_t i = b * KRYLOV_BLOCK; i < std::min(a.rows(), (b + 1) * KRYLOV_BLOCK); ++i) {
+                double sum = 0.0;
+                for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) sum += std::abs(val[k]);
+                largest[b] = std::max(largest[b], sum * std::abs(inverse_diagonal[i]));
+            }
+        }
+    }, pool);
+    return *std::max_element(largest.begin(), largest.end());
+}
+
+/**
+ * @brief P = (I - omega D^-1 A) P_tent, with omega lambda_max = damping.
+ */
+inline CsrMatrix amg_smooth_prolongator(const AmgLevel &level, const CsrMatrix &tentative, double damping,
+                                        ThreadPool &pool) {
+    CsrMatrix p = spgemm(level.a, tentative, pool);
+    const double omega = damping / level.lambda_max;
+    auto tcol = tentative.col_idx();
+    auto tval = tentative.values();
+    auto ptr = p.row_ptr();
+    std::span<double> values = p.values();
+    parallel_for(0, p.rows(), 1024, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const double scale = -omega * level.inverse_diagonal[i];
+            for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) values[k] *= scale;
+            // A has a diagonal, so A P_tent covers P_tent's one entry per row.
+            values[p.find(i, tcol[i])] += tval[i];
+        }
+    }, pool);
+    return p;
+}
+
+/**
+ * @brief Dense LU factors with partial pivoting, for the coarsest level.
+ */
+class AmgDenseLu {
+public:
+
+    AmgDenseLu() = default;
+
+    /**
+     * @throws std::invalid_argument if the matrix is singular.
+     */
+    explicit AmgDenseLu(const CsrMatrix &a) : _n(a.rows()), _lu(a.rows() * a.rows(), 0.0), _pivot(a.rows()) {
+        for (size_t i = 0; i < _n; ++i) {
+            for (size_t k = a.row_ptr()[i]; k < a.row_ptr()[i + 1]; ++k) _lu[i * _n + a.col_idx()[k]] = a.values()[k];
+        }
+        for (size_t c = 0; c < _n; ++c) {
+            size_t best = c;
+            for (size_t r = c + 1; r < _n; ++r) {
+                if (std::abs(_lu[r * _n + c]) > std::abs(_lu[best * _n + c])) best = r;
+            }
+            if (_lu[best * _n + c] == 0.0) throw std::invalid_argument("AmgPreconditioner singular coarse matrix");
+            _pivot[c] = best;
+            if (best != c) std::swap_ranges(&_lu[c * _n], &_lu[c * _n] + _n, &_lu[best * _n]);
+            const double inverse = 1.0 / _lu[c * _n + c];
+            for (size_t r = c + 1; r < _n; ++r) {
+                const double l = _lu[r * _n + c] *= inverse;
+                if (l == 0.0) continue;
+                for (size_t k = c + 1; k < _n; ++k) _lu[r * _n + k] -= l * _lu[c * _n + k];
+            }
+        }
+    }
+
+    void solve(std::span<const double> b, std::span<double> x) const {
+        std::copy(b.begin(), b.end(), x.begin());
+        for (size_t c = 0; c < _n; ++c) std::swap(x[c], x[_pivot[c]]);
+        for (size_t r = 0; r < _n; ++r) {
+            double sum = x[r];
+            for (size_t k = 0; k < r; ++k) sum -= _lu[r * _n + k] * x[k];
+            x[r] = sum;
+        }
+        for (size_t r = _n; r-- > 0;) {
+            double sum = x[r];
+            for (size_t k = r + 1; k < _n; ++k) sum -= _lu[r * _n + k] * x[k];
+            x[r] = sum / _lu[r * _n + r];
+        }
+    }
+
+private:
+
+    size_t _n = 0;
+    std::vector<double> _lu;
+    std::vector<size_t> _pivot;
+};
+
+} // namespace detail
+
+/**
+ * @brief A smoothed aggregation AMG hierarchy whose apply is one V-cycle,
+ *        z = M^-1 r: symmetric positive definite for a symmetric positive
+ *        definite matrix, so it preconditions cg as well as bicgstab and
+ *        gmres.
+ *
+ * apply uses scratch space held by the hierarchy: one apply at a time.
+ */
+class AmgPreconditioner {
+public:
+
+    /**
+     * @brief Builds the hierarchy for a square matrix with a nonzero
+     *        diagonal.
+     *
+     * @throws std::invalid_argument if the matrix is not square, its size is
+     *         not a multiple of block_size, a diagonal entry is zero, or the
+     *         coarsest matrix is singular.
+     */
+    explicit AmgPreconditioner(const CsrMatrix &a, const AmgOptions &options = {},
+                               ThreadPool &pool = ThreadPool::global())
+            : _options(options) {
+        using Clock = std::chrono::steady_clock;
+        auto seconds_since = [](Clock::time_point start) {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+        auto start = Clock::now();
+        const size_t block = options.block_size;
+        if (a.rows() != a.cols()) throw std::invalid_argument("AmgPreconditioner needs a square matrix");
+        if (block == 0 || a.rows() % block != 0) {
+            throw std::invalid_argument("AmgPreconditioner size is not a multiple of the block size");
+        }
+        if (options.smoother_degree == 0) throw std::invalid_argument("AmgPreconditioner smoother degree is 0");
+
+        _levels.emplace_back();
+        _levels.back().a = a;
+        while (true) {
+            detail::AmgLevel &level = _levels.back();
+            prepare(level, pool);
+            const size_t rows = level.a.rows();
+            if (rows <= options.coarse_size || _levels.size() >= options.max_levels) break;
+
+            auto phase = Clock::now();
+            // Galerkin products spread the coupling over wider stencils, so
+            // the threshold halves per level (Vanek, Mandel and Brezina).
+            const double theta = options.strength * std::ldexp(1.0, -int(_levels.size() - 1));
+            size_t count = 0;
+            std::vector<uint32_t> aggregate = detail::amg_aggregate(
+                    detail::amg_node_norms(level.a, block, pool), theta, count);
+            _timings.aggregation += seconds_since(phase);
+            // Coarsening has stalled: more levels would not pay.
+            if (count * block * 10 > rows * 9) break;
+
+            phase = Clock::now();
+            level.p = detail::amg_smooth_prolongator(level, detail::amg_tentative(aggregate, count, block),
+                                                     options.prolongator_damping, pool);
+            level.r = transpose(level.p);
+            _timings.prolongator += seconds_since(phase);
+
+            phase = Clock::now();
+            CsrMatrix coarse = spgemm(level.r, spgemm(level.a, level.p, pool), pool);
+            _timings.galerkin += seconds_since(phase);
+            _levels.emplace_back();
+            _levels.back().a = std::move(coarse);
+        }
+
+        auto phase = Clock::now();
+        if (_levels.back().a.rows() <= detail::AMG_DENSE_LIMIT) _coarse = detail::AmgDenseLu(_levels.back().a);
+        _timings.coarse = seconds_since(phase);
+        _timings.setup = seconds_since(start);
+    }
+
+    /**
+     * @brief z = M^-1 r by one V-cycle from z = 0.
+     */
+    void apply(std::span<const double> r, std::span<double> z, ThreadPool &pool = ThreadPool::global()) const {
+        auto start = std::chrono::steady_clock::now();
+        cycle(0, r, z, pool);
+        _timings.cycle += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++_timings.cycles;
+    }
+
+    /**
+     * @brief The number of levels, the finest included.
+     */
+    [[nodiscard]] size_t levels() const { return _levels.size(); }
+
+    /**
+     * @brief The matrix of level l (0 is the finest).
+     */
+    [[nodiscard]] const CsrMatrix &matrix(size_t l) const { return _levels[l].a; }
+
+    /**
+     * @brief The prolongator from level l + 1 to level l.
+     */
+    [[nodiscard]] const CsrMatrix &prolongator(size_t l) const { return _levels[l].p; }
+
+    /**
+     * @brief The entries of all levels over those of the finest: the memory
+     *        and the work of a cycle relative to a product with A.
+     */
+    [[nodiscard]] double operator_complexity() const {
+        double total = 0.0;
+        for (auto &level: _levels) total += double(level.a.nnz());
+        return total / double(_levels.front().a.nnz());
+    }
+
+    [[nodiscard]] const AmgTimings &timings() const { return _timings; }
+
+private:
+
+    /**
+     * @brief The smoother's data and the cycle's scratch for a level.
+     */
+    void prepare(detail::AmgLevel &level, ThreadPool &pool) {
+        const size_t n = level.a.rows();
+        level.inverse_diagonal.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            const double d = level.a(i, i);
+            if (d == 0.0) throw std::invalid_argument("AmgPreconditioner zero diagonal entry");
+            level.inverse_diagonal[i] = 1.0 / d;
+        }
+        level.lambda_max = detail::amg_lambda_max(level.a, level.inverse_diagonal, pool);
+        for (auto *v: {&level.b, &level.x, &level.residual, &level.direction, &level.product}) v->assign(n, 0.0);
+    }
+
+    /**
+     * @brief Chebyshev smoothing of A x = b on a level, from x = 0 if zero.
+     */
+    void smooth(const detail::AmgLevel &level, std::span<const double> b, std::span<double> x, bool zero,
+                ThreadPool &pool) const {
+        const size_t n = level.a.rows();
+        AlignedVector<double> &r = level.residual, &d = level.direction, &t = level.product;
+        const double *inverse = level.inverse_diagonal.data();
+        const double upper = level.lambda_max, lower = upper / _options.smoother_ratio;
+        const double theta = 0.5 * (upper + lower), delta = 0.5 * (upper - lower), sigma = theta / delta;
+        double rho = 1.0 / sigma;
+
+        if (!zero) spmv(level.a, std::span<const double>(x), t, pool);
+        parallel_for(0, n, detail::KRYLOV_BLOCK, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                r[i] = zero ? b[i] : b[i] - t[i];
+                d[i] = inverse[i] * r[i] / theta;
+            }
+        }, pool);
+        for (size_t k = 1;; ++k) {
+            if (k == _options.smoother_degree) {
+                parallel_for(0, n, detail::KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) x[i] = (zero && k == 1 ? 0.0 : x[i]) + d[i];
+                }, pool);
+                break;
+            }
+            spmv(level.a, std::span<const double>(d), t, pool);
+            const double rho_next = 1.0 / (2.0 * sigma - rho);
+            const double keep = rho_next * rho, step = 2.0 * rho_next / delta;
+            const bool first_step = zero && k == 1;
+            parallel_for(0, n, detail::KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    x[i] = (first_step ? 0.0 : x[i]) + d[i];
+                    r[i] -= t[i];
+                    d[i] = keep * d[i] + step * inverse[i] * r[i];
+                }
+            }, pool);
+            rho = rho_next;
+        }
+    }
+
+    /**
+     * @brief x = V-cycle approximation of A_l^-1 b from level l down.
+     */
+    void cycle(size_t l, std::span<const double> b, std::span<double> x, ThreadPool &pool) const {
+        const detail::AmgLevel &level = _levels[l];
+        if (l + 1 == _levels.size()) {
+            if (level.a.rows() <= detail::AMG_DENSE_LIMIT) {
+                _coarse.solve(b, x);
+            } else {
+                smooth(level, b, x, true, pool);
+                smooth(level, b, x, false, pool);
+            }
+            return;
+        }
+
+        smooth(level, b, x, true, pool);
+        AlignedVector<double> &r = level.residual;
+        spmv(level.a, std::span<const double>(x), r, pool);
+        parallel_for(0, r.size(), detail::KRYLOV_BLOCK, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) r[i] = b[i] - r[i];
+        }, pool);
+
+        const detail::AmgLevel &next = _levels[l + 1];
+        spmv(level.r, std::span<const double>(r), next.b, pool);
+        cycle(l + 1, next.b, next.x, pool);
+
+        AlignedVector<double> &t = level.product;
+        spmv(level.p, std::span<const double>(next.x), t, pool);
+        parallel_for(0, t.size(), detail::KRYLOV_BLOCK, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) x[i] += t[i];
+        }, pool);
+        smooth(level, b, x, false, pool);
+    }
+
+    AmgOptions _options;
+    std::vector<detail::AmgLevel> _levels;
+    detail::AmgDenseLu _coarse;
+    mutable AmgTimings _timings;
+};
+
+#endif //FMM_AMG_HPP
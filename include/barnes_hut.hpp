@@ -0,0 +1,466 @@
+/**
+ * @file barnes_hut.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A Barnes-Hut treecode for the Laplace kernel: a fast, low latency
+ *        approximate alternative to Fmm, on the LinearOctree.
+ */
+
+#ifndef FMM_BARNES_HUT_HPP
+#define FMM_BARNES_HUT_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "octree.hpp"
+#include "p2p.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief The moments of a cell's charges about its expansion centre c.
+ *
+ * With s = y - c for each charge q at y:
+ *
+ *     charge     Q = sum q,
+ *     dipole     D = sum q s,
+ *     quadrupole T = sum q (3 s s^T - |s|^2 I)   (traceless, packed),
+ *
+ * and the potential at x, r = x - c, is approximately
+ *
+ *     Q / |r| + D.r / |r|^3 + r^T T r / (2 |r|^5).
+ *
+ * The centre is the centre of |q|, so for charges of one sign (masses) the
+ * dipole vanishes and this is the classic monopole plus quadrupole.
+ */
+struct BarnesHutMoments {
+    Vector3<double> center{0.0, 0.0, 0.0};    /**< The expansion centre. */
+    double charge = 0.0;                      /**< The monopole Q. */
+    Vector3<double> dipole{0.0, 0.0, 0.0};    /**< The dipole D (zero for one signed charges). */
+    std::array<double, 6> quadrupole{};       /**< T as (xx, xy, xz, yy, yz, zz). */
+    double radius = 0.0;                      /**< The largest distance from the centre to a charge. */
+    double weight = 0.0;                      /**< sum |q|. */
+};
+
+/**
+ * @brief Parameters of a BarnesHut solver.
+ */
+struct BarnesHutOptions {
+    double theta = 0.5;    /**< The opening angle: a cell acts through its moments when radius < theta distance. */
+    size_t max_leaf = 64;  /**< The maximum number of particles per leaf. */
+};
+
+/**
+ * @brief Seconds spent in each part of the method: `tree` and `moments`
+ *        (at construction or the last update), and the tree walks with the far (moment) and near
+ *        (direct) interactions of the last evaluate, summed over threads,
+ *        and its wall time `total`.
+ */
+struct BarnesHutTimings {
+    double tree = 0.0;
+    double moments = 0.0;
+    double far_field = 0.0;
+    double near_field = 0.0;
+    double total = 0.0;
+};
+
+namespace detail {
+
+/**
+ * @brief A structure-of-arrays list of accepted cells, as the SIMD kernel
+ *        reads them.
+ */
+struct BarnesHutCells {
+    AlignedVector<double> x, y, z, q, dx, dy, dz, txx, txy, txz, tyy, tyz, tzz;
+
+    [[nodiscard]] size_t size() const { return q.size(); }
+
+    void clear() {
+        for (auto *v: {&x, &y, &z, &q, &dx, &dy, &dz, &txx, &txy, &txz, &tyy, &tyz, &tzz}) v->clear();
+    }
+
+    void push_back(const BarnesHutMoments &m) {
+        x.push_back(m.center.x);
+        y.push_back(m.center.y);
+        z.push_back(m.center.z);
+        q.push_back(m.charge);
+        dx.push_back(m.dipole.x);
+        dy.push_back(m.dipole.y);
+        dz.push_back(m.dipole.z);
+        txx.push_back(m.quadrupole[0]);
+        txy.push_back(m.quadrupole[1]);
+        txz.push_back(m.quadrupole[2]);
+        tyy.push_back(m.quadrupole[3]);
+        tyz.push_back(m.quadrupole[4]);
+        tzz.push_back(m.quadrupole[5]);
+    }
+};
+
+/**
+ * @brief Adds the potential and field of every cell to one block of
+ *        S::width targets held in registers.
+ */
+template <typename S>
+inline void barnes_hut_block(const BarnesHutCells &c, typename S::V tx, typename S::V ty, typename S::V tz,
+                             typename S::V &phi, typename S::V &ex, typename S::V &ey, typename S::V &ez) {
+    using V = typename S::V;
+    const V half = S::set1(0.5), three = S::set1(3.0), five_halves = S::set1(2.5);
+    for (size_t j = 0; j < c.size(); ++j) {
+        V rx = S::sub(tx, S::set1(c.x[j])), ry = S::sub(ty, S::set1(c.y[j])), rz = S::sub(tz, S::set1(c.z[j]));
+        V r2 = S::fmadd(rz, rz, S::fmadd(ry, ry, S::mul(rx, rx)));
+        V inv = S::rsqrt_masked(r2);
+        V inv2 = S::mul(inv, inv);
+        V inv3 = S::mul(inv, inv2), inv5 = S::mul(inv3, inv2), inv7 = S::mul(inv5, inv2);
+
+        V dx = S::set1(c.dx[j]), dy = S::set1(c.dy[j]), dz = S::set1(c.dz[j]);
+        V dr = S::fmadd(dz, rz, S::fmadd(dy, ry, S::mul(dx, rx)));
+        V tx_ = S::fmadd(S::set1(c.txz[j]), rz, S::fmadd(S::set1(c.txy[j]), ry, S::mul(S::set1(c.txx[j]), rx)));
+        V ty_ = S::fmadd(S::set1(c.tyz[j]), rz, S::fmadd(S::set1(c.tyy[j]), ry, S::mul(S::set1(c.txy[j]), rx)));
+        V tz_ = S::fmadd(S::set1(c.tzz[j]), rz, S::fmadd(S::set1(c.tyz[j]), ry, S::mul(S::set1(c.txz[j]), rx)));
+        V rtr = S::fmadd(tz_, rz, S::fmadd(ty_, ry, S::mul(tx_, rx)));
+
+        V q = S::set1(c.q[j]);
+        phi = S::fmadd(q, inv, phi);
+        phi = S::fmadd(dr, inv3, phi);
+        phi = S::fmadd(S::mul(half, rtr), inv5, phi);
+
+        // E = (Q / r^3 + 3 D.r / r^5 + 5 r.T.r / (2 r^7)) r - D / r^3 - T r / r^5.
+        V a = S::fmadd(S::mul(five_halves, rtr), inv7, S::fmadd(S::mul(three, dr), inv5, S::mul(q, inv3)));
+        ex = S::sub(S::sub(S::fmadd(a, rx, ex), S::mul(dx, inv3)), S::mul(tx_, inv5));
+        ey = S::sub(S::sub(S::fmadd(a, ry, ey), S::mul(dy, inv3)), S::mul(ty_, inv5));
+        ez = S::sub(S::sub(S::fmadd(a, rz, ez), S::mul(dz, inv3)), S::mul(tz_, inv5));
+    }
+}
+
+/**
+ * @brief Adds the potential and field of every cell to targets [0, nt),
+ *        S::width at a time (a partial last block is padded).
+ */
+template <typename S>
+void barnes_hut_cells(const BarnesHutCells &c, const double *tx, const double *ty, const double *tz, size_t nt,
+                      double *phi, double *ex, double *ey, double *ez) {
+    constexpr size_t w = S::width;
+    size_t i = 0;
+    for (; i + w <= nt; i += w) {
+        typename S::V p = S::load(phi + i), fx = S::load(ex + i), fy = S::load(ey + i), fz = S::load(ez + i);
+        barnes_hut_block<S>(c, S::load(tx + i), S::load(ty + i), S::load(tz + i), p, fx, fy, fz);
+        S::store(phi + i, p);
+        S::store(ex + i, fx);
+        S::store(ey + i, fy);
+        S::store(ez + i, fz);
+    }
+    if (i == nt) return;
+    alignas(64) double buf[7][w];
+    for (size_t l = 0; l < w; ++l) {
+        size_t k = std::min(i + l, nt - 1);
+        buf[0][l] = tx[k];
+        buf[1][l] = ty[k];
+        buf[2][l] = tz[k];
+    }
+    typename S::V p = S::zero(), fx = S::zero(), fy = S::zero(), fz = S::zero();
+    barnes_hut_block<S>(c, S::load(buf[0]), S::load(buf[1]), S::load(buf[2]), p, fx, fy, fz);
+    S::store(buf[3], p);
+    S::store(buf[4], fx);
+    S::store(buf[5], fy);
+    S::store(buf[6], fz);
+    for (size_t k = i; k < nt; ++k) {
+        phi[k] += buf[3][k - i];
+        ex[k] += buf[4][k - i];
+        ey[k] += buf[5][k - i];
+        ez[k] += buf[6][k - i];
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief A Barnes-Hut evaluation of the potentials sum_j q_j / |x_i - x_j|
+ *        and fields sum_j q_j (x_i - x_j) / |x_i - x_j|^3 of a set of charges
+ *        at their own positions (j != i), with the interface of Fmm.
+ *
+ * Every node's moments (BarnesHutMoments) are built bottom up, at
+ * construction and again on each update for moved charges. Each target
+ * leaf then walks the tree: a cell whose charges all lie within
+ * theta times its distance from the leaf's cell acts through its moments on
+ * every target of the leaf, other leaves interact directly (p2p_kernel), and
+ * other cells are opened. The accepted cells are gathered into a
+ * structure-of-arrays list and evaluated SIMD across the leaf's targets, so
+ * one walk serves a whole leaf; leaves are processed in parallel. The cost
+ * is O(N log N) with an error of order theta^3 relative to the field of the
+ * accepted cells (theta = 0 is a direct sum).
+ *
+ * Results are independent of the number of threads.
+ */
+class BarnesHut {
+public:
+
+    /**
+     * @brief Builds the tree and the moments.
+     *
+     * @throws std::invalid_argument if the sizes differ or theta is negative.
+     */
+    BarnesHut(std::span<const Vector3<double>> points, std::span<const double> charges,
+              const BarnesHutOptions &options = {}, ThreadPool &pool = ThreadPool::global())
+            : _options(options), _pool(pool), _tree(timed_tree(points, options.max_leaf, pool)),
+              _input_charges(charges.begin(), charges.end()) {
+        if (charges.size() != points.size()) throw std::invalid_argument("BarnesHut size mismatch");
+        set_theta(options.theta);
+        refresh();
+    }
+
+    /**
+     * @brief Moves the charges to new positions (in the input order):
+     *        updates the tree (see LinearOctree::update), refitting it for
+     *        small motions, and recomputes the moments bottom up.
+     *
+     * @throws std::invalid_argument if the number of points changed.
+     */
+    OctreeUpdate update(std::span<const Vector3<double>> points, const OctreeRefitPolicy &policy = {}) {
+        if (points.size() != _input_charges.size()) throw std::invalid_argument("BarnesHut size mismatch");
+        auto start = Clock::now();
+        OctreeUpdate what = _tree.update(points, policy, _pool);
+        _timings.tree = seconds_since(start);
+        refresh();
+        return what;
+    }
+
+    [[nodiscard]] const LinearOctree<double> &tree() const { return _tree; }
+
+    [[nodiscard]] const BarnesHutMoments &moments(size_t node) const { return _moments[node]; }
+
+    [[nodiscard]] double theta() const { return _options.theta; }
+
+    /**
+     * @brief Changes the opening angle for later evaluations.
+     *
+     * @throws std::invalid_argument if theta is negative.
+     */
+    void set_theta(double theta) {
+        if (!(theta >= 0.0)) throw std::invalid_argument("BarnesHut theta must be non-negative");
+        _options.theta = theta;
+    }
+
+    /**
+     * @brief The timings of the moments and of the last evaluate.
+     */
+    [[nodiscard]] const BarnesHutTimings &timings() const { return _timings; }
+
+    /**
+     * @brief Evaluates potentials and fields, in the input particle order.
+     */
+    void evaluate(std::span<double> potential, std::span<Vector3<double>> field) {
+        const size_t n = _charges.size();
+        if (potential.size() != n || field.size() != n) throw std::invalid_argument("BarnesHut size mismatch");
+
+        auto start = Clock::now();
+        AlignedVector<double> phi(n, 0.0);
+        Vector3Array<double> f(n);
+        auto leaves = _tree.leaves();
+        std::vector<std::array<double, 2>> busy(_pool.size(), {0.0, 0.0});
+        parallel_for_worker(0, leaves.size(), 4, [&](size_t b, size_t e, size_t worker) {
+            for (size_t i = b; i < e; ++i) evaluate_leaf(leaves[i], phi.data(), f, busy[worker]);
+        }, _pool);
+
+        auto perm = _tree.permutation();
+        parallel_for(0, n, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                potential[perm[i]] = phi[i];
+                field[perm[i]] = f[i];
+            }
+        }, _pool);
+
+        _timings.far_field = _timings.near_field = 0.0;
+        for (auto &t: busy) {
+            _timings.far_field += t[0];
+            _timings.near_field += t[1];
+        }
+        _timings.total = seconds_since(start);
+    }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    static double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    LinearOctree<double> timed_tree(std::span<const Vector3<double>> points, size_t max_leaf, ThreadPool &pool) {
+        auto start = Clock::now();
+        LinearOctree<double> tree(points, max_leaf, pool);
+        _timings.tree = seconds_since(start);
+        return tree;
+    }
+
+    /**
+     * @brief Sorts the charges and points into the tree's order and builds
+     *        the moments.
+     */
+    void refresh() {
+        auto start = Clock::now();
+        auto perm = _tree.permutation();
+        _charges.resize(perm.size());
+        for (size_t i = 0; i < perm.size(); ++i) _charges[i] = _input_charges[perm[i]];
+        _soa = Vector3Array<double>(_tree.points());
+        build_moments();
+        _timings.moments = seconds_since(start);
+    }
+
+    // ##################################################################### //
+    // # Moments.                                                          # //
+    // ##################################################################### //
+
+    /**
+     * @brief Leaves from their charges, then each level from its children,
+     *        deepest first.
+     */
+    void build_moments() {
+        _moments.assign(_tree.nodes().size(), {});
+        for (size_t level = _tree.depth(); level-- > 0;) {
+            auto [lb, le] = _tree.level_range(level);
+            parallel_for(lb, le, 64, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) {
+                    if (_tree.node(i).is_leaf()) {
+                        leaf_moments(i);
+                    } else {
+                        internal_moments(i);
+                    }
+                }
+            }, _pool);
+        }
+    }
+
+    void leaf_moments(size_t i) {
+        const OctreeNode &node = _tree.node(i);
+        auto pts = _tree.points();
+        BarnesHutMoments &m = _moments[i];
+        Vector3<double> weighted{0.0, 0.0, 0.0};
+        for (uint32_t k = node.begin; k < node.end; ++k) {
+            m.weight += std::abs(_charges[k]);
+            weighted = weighted + std::abs(_charges[k]) * pts[k];
+        }
+        m.center = m.weight > 0.0 ? (1.0 / m.weight) * weighted : _tree.center(i);
+        for (uint32_t k = node.begin; k < node.end; ++k) {
+            Vector3<double> s = pts[k] - m.center;
+            add_shifted(m, _charges[k], {0.0, 0.0, 0.0}, {}, s);
+            m.radius = std::max(m.radius, std::sqrt(inner(s, s)));
+        }
+    }
+
+    void internal_moments(size_t i) {
+        const OctreeNode &node = _tree.node(i);
+        BarnesHutMoments &m = _moments[i];
+        Vector3<double> weighted{0.0, 0.0, 0.0};
+        for (uint32_t c = node.first_child; c < node.first_child + node.nchildren; ++c) {
+            m.weight += _moments[c].weight;
+            weighted = weighted + _moments[c].weight * _moments[c].center;
+        }
+        m.center = m.weight > 0.0 ? (1.0 / m.weight) * weighted : _tree.center(i);
+        for (uint32_t c = node.first_child; c < node.first_child + node.nchildren; ++c) {
+            const BarnesHutMoments &child = _moments[c];
+            Vector3<double> delta = child.center - m.center;
+            add_shifted(m, child.charge, child.dipole, child.quadrupole, delta);
+            m.radius = std::max(m.radius, child.radius + std::sqrt(inner(delta, delta)));
+        }
+    }
+
+    /**
+     * @brief Adds moments (q, d, t) about a point at offset delta from m's
+     *        centre (a point charge is (q, 0, 0) at its position).
+     */
+    static void add_shifted(BarnesHutMoments &m, double q, const Vector3<double> &d,
+                            const std::array<double, 6> &t, const Vector3<double> &delta) {
+        m.charge += q;
+        m.dipole = m.dipole + d + q * delta;
+        // T' = T + 3 (d delta^T + delta d^T) - 2 (d.delta) I + q (3 delta delta^T - |delta|^2 I).
+        const double dd = inner(d, delta), d2 = inner(delta, delta);
+        const double a[3] = {delta.x, delta.y, delta.z}, b[3] = {d.x, d.y, d.z};
+        size_t k = 0;
+        for (size_t r = 0; r < 3; ++r) {
+            for (size_t c = r; c < 3; ++c, ++k) {
+                double diag = r == c ? 1.0 : 0.0;
+                m.quadrupole[k] += t[k] + 3.0 * (b[r] * a[c] + a[r] * b[c]) - 2.0 * dd * diag
+                                   + q * (3.0 * a[r] * a[c] - d2 * diag);
+            }
+        }
+    }
+
+    // ##################################################################### //
+    // # Evaluation.                                                       # //
+    // ##################################################################### //
+
+    /**
+     * @brief Whether a cell's moments are accurate enough for every target
+     *        in the cell of leaf t: radius < theta d, d the distance from the
+     *        expansion centre to t's cell.
+     */
+    bool accept(const BarnesHutMoments &m, uint32_t t) const {
+        Vector3<double> c = _tree.center(t);
+        const double h = _tree.half_width(t);
+        const double gx = std::max(0.0, std::abs(m.center.x - c.x) - h);
+        const double gy = std::max(0.0, std::abs(m.center.y - c.y) - h);
+        const double gz = std::max(0.0, std::abs(m.center.z - c.z) - h);
+        const double d2 = gx * gx + gy * gy + gz * gz;
+        return m.radius * m.radius < _options.theta * _options.theta * d2;
+    }
+
+    /**
+     * @brief Walks the tree for leaf t, then adds the accepted cells and the
+     *        opened leaves to its targets.
+     */
+    void evaluate_leaf(uint32_t t, double *phi, Vector3Array<double> &f, std::array<double, 2> &busy) {
+        auto start = Clock::now();
+        thread_local detail::BarnesHutCells cells;
+        thread_local std::vector<uint32_t> near, stack;
+        cells.clear();
+        near.clear();
+        stack.assign(1, 0);
+        while (!stack.empty()) {
+            uint32_t c = stack.back();
+            stack.pop_back();
+            const OctreeNode &node = _tree.node(c);
+            if (_moments[c].weight == 0.0) continue;
+            if (accept(_moments[c], t)) {
+                cells.push_back(_moments[c]);
+            } else if (node.is_leaf()) {
+                near.push_back(c);
+            } else {
+                // Reversed, so children are visited (and summed) in order.
+                for (uint32_t k = node.first_child + node.nchildren; k-- > node.first_child;) stack.push_back(k);
+            }
+        }
+
+        const OctreeNode &tn = _tree.node(t);
+        double *tx = _soa.x() + tn.begin, *ty = _soa.y() + tn.begin, *tz = _soa.z() + tn.begin;
+        double *fx = f.x() + tn.begin, *fy = f.y() + tn.begin, *fz = f.z() + tn.begin;
+        detail::barnes_hut_cells<detail::P2PLanes>(cells, tx, ty, tz, tn.size(), phi + tn.begin, fx, fy, fz);
+        auto mid = Clock::now();
+        busy[0] += std::chrono::duration<double>(mid - start).count();
+
+        for (uint32_t s: near) {
+            const OctreeNode &sn = _tree.node(s);
+            p2p_kernel(_soa.x() + sn.begin, _soa.y() + sn.begin, _soa.z() + sn.begin, _charges.data() + sn.begin,
+                       sn.size(), tx, ty, tz, tn.size(), phi + tn.begin, fx, fy, fz);
+        }
+        busy[1] += seconds_since(mid);
+    }
+
+    BarnesHutOptions _options;
+    ThreadPool &_pool;
+    BarnesHutTimings _timings;
+    LinearOctree<double> _tree;
+    std::vector<double> _input_charges;
+    std::vector<double> _charges;
+    Vector3Array<double> _soa;
+    std::vector<BarnesHutMoments> _moments;
+};
+
+#endif //FMM_BARNES_HUT_HPP
@@ -0,0 +1,174 @@
+/**
+ * @file ddreal.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A double-double scalar type usable with the linalg.hpp templates.
+ */
+
+#ifndef FMM_DDREAL_HPP
+#define FMM_DDREAL_HPP
+
+#include <cmath>
+#include <ostream>
+
+// ######################################################################### //
+// # Error free transformations.                                           # //
+// ######################################################################### //
+
+/**
+ * @brief Computes s = fl(a + b) and the rounding error e, so a + b = s + e
+ *        exactly (Knuth).
+ */
+inline void two_sum(double a, double b, double &s, double &e) {
+    s = a + b;
+    double bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+}
+
+/**
+ * @brief As two_sum, but requires |a| >= |b| (Dekker).
+ */
+inline void quick_two_sum(double a, double b, double &s, double &e) {
+    s = a + b;
+    e = b - (s - a);
+}
+
+/**
+ * @brief Computes p = fl(a * b) and the rounding error e, so a * b = p + e
+ *        exactly, using a fused multiply-add.
+ */
+inline void two_prod(double a, double b, double &p, double &e) {
+    p = a * b;
+    e = std::fma(a, b, -p);
+}
+
+// ######################################################################### //
+// # Scalar.                                                               # //
+// ######################################################################### //
+
+/**
+ * @brief An unevaluated sum hi + lo of two doubles with |lo| <= ulp(hi)/2,
+ *        giving roughly 106 bits of significand.
+ */
+struct DdReal {
+    double hi; /**< The leading part. */
+    double lo; /**< The trailing part. */
+
+    DdReal() : hi(0.0), lo(0.0) {}
+
+    DdReal(double x) : hi(x), lo(0.0) {}
+
+    DdReal(double h, double l) : hi(h), lo(l) {}
+
+    /**
+     * @brief Rounds this value to a double.
+     */
+    [[nodiscard]] double to_double() const { return hi + lo; }
+
+    explicit operator double() const { return to_double(); }
+};
+
+// ######################################################################### //
+// # Arithmetic operators.                                                 # //
+// ######################################################################### //
+
+/**
+ * @brief Adds two DdReal instances (the accurate, IEEE style variant).
+ */
+inline DdReal operator+(const DdReal &a, const DdReal &b) {
+    double s, e, t, f;
+    two_sum(a.hi, b.hi, s, e);
+    two_sum(a.lo, b.lo, t, f);
+    e += t;
+    quick_two_sum(s, e, s, e);
+    e += f;
+    quick_two_sum(s, e, s, e);
+    return {s, e};
+}
+
+/**
+ * @brief Negates a DdReal instance.
+ */
+inline DdReal operator-(const DdReal &a) {
+    return {-a.hi, -a.lo};
+}
+
+/**
+ * @brief Subtracts two DdReal instances.
+ */
+inline DdReal operator-(const DdReal &a, const DdReal &b) {
+    return a + (-b);
+}
+
+/**
+ * @brief Multiplies two DdReal instances.
+ */
+inline DdReal operator*(const DdReal &a, const DdReal &b) {
+    double p, e;
+    two_prod(a.hi, b.hi, p, e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    quick_two_sum(p, e, p, e);
+    return {p, e};
+}
+
+/**
+ * @brief Divides two DdReal instances (long division with one correction).
+ */
+inline DdReal operator/(const DdReal &a, const DdReal &b) {
+    double q1 = a.hi / b.hi;
+    DdReal r = a - q1 * b;
+    double q2 = r.hi / b.hi;
+    r = r - q2 * b;
+    double q3 = r.hi / b.hi;
+    double s, e;
+    quick_two_sum(q1, q2, s, e);
+    return DdReal(s, e) + DdReal(q3);
+}
+
+inline DdReal &operator+=(DdReal &a, const DdReal &b) { return a = a + b; }
+inline DdReal &operator-=(DdReal &a, const DdReal &b) { return a = a - b; }
+inline DdReal &operator*=(DdReal &a, const DdReal &b) { return a = a * b; }
+inline DdReal &operator/=(DdReal &a, const DdReal &b) { return a = a / b; }
+
+// ######################################################################### //
+// # Comparison operators.                                                 # //
+// ######################################################################### //
+
+inline bool operator==(const DdReal &a, const DdReal &b) { return a.hi == b.hi && a.lo == b.lo; }
+inline bool operator!=(const DdReal &a, const DdReal &b) { return !(a == b); }
+inline bool operator< (const DdReal &a, const DdReal &b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+inline bool operator> (const DdReal &a, const DdReal &b) { return b < a; }
+inline bool operator<=(const DdReal &a, const DdReal &b) { return !(b < a); }
+inline bool operator>=(const DdReal &a, const DdReal &b) { return !(a < b); }
+
+// ######################################################################### //
+// # Functions.                                                            # //
+// ######################################################################### //
+
+/**
+ * @brief The absolute value of a DdReal instance.
+ */
+inline DdReal abs(const DdReal &a) {
+    return a.hi < 0.0 ? -a : a;
+}
+
+/**
+ * @brief The square root of a DdReal instance (one Newton step from the
+ *        double square root).
+ */
+inline DdReal sqrt(const DdReal &a) {
+    if (a.hi <= 0.0) return DdReal(std::sqrt(a.hi));
+    double x = 1.0 / std::sqrt(a.hi);
+    double ax = a.hi * x;
+    DdReal d = a - DdReal(ax) * DdReal(ax);
+    return DdReal(ax) + DdReal(d.hi * (x * 0.5));
+}
+
+/**
+ * @brief Writes a DdReal instance (rounded to a double) to a stream.
+ */
+inline std::ostream &operator<<(std::ostream &os, const DdReal &a) {
+    return os << a.to_double();
+}
+
+#endif //FMM_DDREAL_HPP
@@ -0,0 +1,260 @@
+/**
+ * @file dipole.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Direct summation of the fields of point dipoles, vectorised over
+ *        targets, with an optional fused interaction energy.
+ *
+ * A dipole m at y has the scalar potential and field
+ *
+ *     phi(x) = m . r / |r|^3,
+ *     H(x)   = -grad phi = (3 r^ r^T - I) m / |r|^3 = 3 (m . r) r / |r|^5 - m / |r|^3,
+ *
+ * with r = x - y and r^ = r / |r| (unit prefactors, as p2p.hpp: multiply by
+ * 1 / (4 pi) for the magnetostatic stray field of moments m). The kernels
+ * never form the tensor: per pair they take m . r once and combine it with
+ * r and m.
+ */
+
+#ifndef FMM_DIPOLE_HPP
+#define FMM_DIPOLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "p2p.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief The flops counted per pairwise dipole interaction (potential and
+ *        field) when reporting Gflop/s.
+ */
+inline constexpr double DIPOLE_FLOPS_PER_INTERACTION = 32.0;
+
+/**
+ * @brief The dipole interaction tensor (3 r^ r^T - I) / |r|^3, for reference
+ *        and for small problems: the field of a moment m is
+ *        dipole_tensor(r) * m.
+ */
+template <typename T>
+Matrix3x3<T> dipole_tensor(const Vector3<T> &r) {
+    const T r2 = inner(r, r);
+    const T inv3 = T(1) / (r2 * std::sqrt(r2));
+    Matrix3x3<T> d = (T(3) * inv3 / r2) * outer(r, r);
+    for (size_t i = 0; i < 3; ++i) d.m[i][i] -= inv3;
+    return d;
+}
+
+namespace detail {
+
+/**
+ * @brief Adds the contribution of dipoles [0, ns) to one block of S::width
+ *        targets held in registers.
+ */
+template <typename S>
+inline void dipole_block(const double *sx, const double *sy, const double *sz,
+                         const double *mx, const double *my, const double *mz, size_t ns,
+                         typename S::V tx, typename S::V ty, typename S::V tz,
+                         typename S::V &phi, typename S::V &hx, typename S::V &hy, typename S::V &hz) {
+    const typename S::V three = S::set1(3.0);
+    for (size_t j = 0; j < ns; ++j) {
+        typename S::V dx = S::sub(tx, S::set1(sx[j]));
+        typename S::V dy = S::sub(ty, S::set1(sy[j]));
+        typename S::V dz = S::sub(tz, S::set1(sz[j]));
+        typename S::V r2 = S::fmadd(dz, dz, S::fmadd(dy, dy, S::mul(dx, dx)));
+        typename S::V inv = S::rsqrt_masked(r2);
+        typename S::V inv2 = S::mul(inv, inv);
+        typename S::V inv3 = S::mul(inv, inv2);
+        typename S::V vx = S::set1(mx[j]), vy = S::set1(my[j]), vz = S::set1(mz[j]);
+        typename S::V mr = S::fmadd(vz, dz, S::fmadd(vy, dy, S::mul(vx, dx)));
+        typename S::V a = S::mul(mr, inv3);
+        phi = S::add(phi, a);
+        // H += 3 (m . r) r / r^5 - m / r^3.
+        typename S::V b = S::mul(S::mul(three, a), inv2);
+        hx = S::sub(S::fmadd(b, dx, hx), S::mul(vx, inv3));
+        hy = S::sub(S::fmadd(b, dy, hy), S::mul(vy, inv3));
+        hz = S::sub(S::fmadd(b, dz, hz), S::mul(vz, inv3));
+    }
+}
+
+/**
+ * @brief The serial tiled dipole kernel over lanes S; with target moments
+ *        (Energy) it also returns -sum_t m_t . H_t of the added fields.
+ */
+template <typename S, bool Energy>
+double dipole_tiled(const double *sx, const double *sy, const double *sz,
+                    const double *mx, const double *my, const double *mz, size_t ns,
+                    const double *tx, const double *ty, const double *tz,
+                    const double *tmx, const double *tmy, const double *tmz, size_t nt,
+                    double *phi, double *hx, double *hy, double *hz) {
+    constexpr size_t w = S::width;
+    typename S::V energy = S::zero();
+    double tail = 0.0;
+    for (size_t s0 = 0; s0 < ns; s0 += P2P_TILE) {
+        size_t ts = std::min(P2P_TILE, ns - s0);
+        size_t i = 0;
+        for (; i + w <= nt; i += w) {
+            // The tile's contribution starts from zero so that the energy
+            // sees only the added field.
+            typename S::V p = S::zero(), fx = S::zero(), fy = S::zero(), fz = S::zero();
+            dipole_block<S>(sx + s0, sy + s0, sz + s0, mx + s0, my + s0, mz + s0, ts,
+                            S::load(tx + i), S::load(ty + i), S::load(tz + i), p, fx, fy, fz);
+            S::store(phi + i, S::add(S::load(phi + i), p));
+            S::store(hx + i, S::add(S::load(hx + i), fx));
+            S::store(hy + i, S::add(S::load(hy + i), fy));
+            S::store(hz + i, S::add(S::load(hz + i), fz));
+            if constexpr (Energy) {
+                typename S::V e = S::fmadd(S::load(tmz + i), fz,
+                                           S::fmadd(S::load(tmy + i), fy, S::mul(S::load(tmx + i), fx)));
+                energy = S::sub(energy, e);
+            }
+        }
+        if (i < nt) {
+            // Pad the remaining targets into one full block (repeating the
+            // last target) and use only the real lanes.
+            alignas(64) double buf[7][w];
+            for (size_t l = 0; l < w; ++l) {
+                size_t k = std::min(i + l, nt - 1);
+                buf[0][l] = tx[k];
+                buf[1][l] = ty[k];
+                buf[2][l] = tz[k];
+            }
+            typename S::V p = S::zero(), fx = S::zero(), fy = S::zero(), fz = S::zero();
+            dipole_block<S>(sx + s0, sy + s0, sz + s0, mx + s0, my + s0, mz + s0, ts,
+                            S::load(buf[0]), S::load(buf[1]), S::load(buf[2]), p, fx, fy, fz);
+            S::store(buf[3], p);
+            S::store(buf[4], fx);
+            S::store(buf[5], fy);
+            S::store(buf[6], fz);
+            for (size_t k = i; k < nt; ++k) {
+                phi[k] += buf[3][k - i];
+                hx[k] += buf[4][k - i];
+                hy[k] += buf[5][k - i];
+                hz[k] += buf[6][k - i];
+                if constexpr (Energy) {
+                    tail -= tmx[k] * buf[4][k - i] + tmy[k] * buf[5][k - i] + tmz[k] * buf[6][k - i];
+                }
+            }
+        }
+    }
+    if constexpr (!Energy) return 0.0;
+    alignas(64) double lanes[w];
+    S::store(lanes, energy);
+    for (size_t l = 0; l < w; ++l) tail += lanes[l];
+    return tail;
+}
+
+} // namespace detail
+
+// ######################################################################### //
+// # Kernels.                                                              # //
+// ######################################################################### //
+
+/**
+ * @brief Adds to every target the potential and field of the dipoles
+ *        (serial, raw arrays; the building block for FMM near-field
+ *        interactions).
+ *
+ * Pairs at zero distance contribute nothing.
+ */
+inline void dipole_kernel(const double *sx, const double *sy, const double *sz,
+                          const double *mx, const double *my, const double *mz, size_t ns,
+                          const double *tx, const double *ty, const double *tz, size_t nt,
+                          double *phi, double *hx, double *hy, double *hz) {
+    detail::dipole_tiled<detail::P2PLanes, false>(sx, sy, sz, mx, my, mz, ns, tx, ty, tz,
+                                                  nullptr, nullptr, nullptr, nt, phi, hx, hy, hz);
+}
+
+/**
+ * @brief dipole_kernel, fused with the energy of target moments tm in the
+ *        added field: returns -sum_t tm_t . H_t, taken from registers before
+ *        the field is stored.
+ */
+inline double dipole_kernel_energy(const double *sx, const double *sy, const double *sz,
+                                   const double *mx, const double *my, const double *mz, size_t ns,
+                                   const double *tx, const double *ty, const double *tz,
+                                   const double *tmx, const double *tmy, const double *tmz, size_t nt,
+                                   double *phi, double *hx, double *hy, double *hz) {
+    return detail::dipole_tiled<detail::P2PLanes, true>(sx, sy, sz, mx, my, mz, ns, tx, ty, tz,
+                                                        tmx, tmy, tmz, nt, phi, hx, hy, hz);
+}
+
+/**
+ * @brief Adds the potential and field of the dipoles to every target, in
+ *        parallel over blocks of targets.
+ *
+ * @param sources the dipole positions.
+ * @param moments the dipole moments.
+ * @param targets the target positions.
+ * @param potential the potentials to add to (one per target).
+ * @param field the fields to add to (one per target).
+ * @param mode P2PMode::self if targets are the sources.
+ * @param pool the pool to run on.
+ */
+inline void dipole_field(const Vector3Array<double> &sources, const Vector3Array<double> &moments,
+                         const Vector3Array<double> &targets, std::span<double> potential,
+                         Vector3Array<double> &field, P2PMode mode = P2PMode::distinct,
+                         ThreadPool &pool = ThreadPool::global()) {
+    if (moments.size() != sources.size() || potential.size() != targets.size() || field.size() != targets.size()) {
+        throw std::invalid_argument("dipole_field size mismatch");
+    }
+    if (mode == P2PMode::self && sources.size() != targets.size()) {
+        throw std::invalid_argument("dipole_field self mode needs targets == sources");
+    }
+    parallel_for(0, targets.size(), 256, [&](size_t b, size_t e) {
+        dipole_kernel(sources.x(), sources.y(), sources.z(), moments.x(), moments.y(), moments.z(), sources.size(),
+                      targets.x() + b, targets.y() + b, targets.z() + b, e - b,
+                      potential.data() + b, field.x() + b, field.y() + b, field.z() + b);
+    }, pool);
+}
+
+/**
+ * @brief Adds the potential and field of a set of dipoles on themselves,
+ *        as dipole_field in self mode, and returns their interaction energy
+ *        -1/2 sum_i m_i . H_i (of the added fields), from the same pass.
+ *
+ * The energy is reduced in a fixed order over fixed blocks, so it does not
+ * depend on the number of threads.
+ */
+inline double dipole_field_energy(const Vector3Array<double> &points, const Vector3Array<double> &moments,
+                                  std::span<double> potential, Vector3Array<double> &field,
+                                  ThreadPool &pool = ThreadPool::global()) {
+    const size_t n = points.size();
+    if (moments.size() != n || potential.size() != n || field.size() != n) {
+        throw std::invalid_argument("dipole_field_energy size mismatch");
+    }
+    constexpr size_t block = 256;
+    std::vector<double> energy((n + block - 1) / block, 0.0);
+    parallel_for(0, energy.size(), 1, [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; ++k) {
+            const size_t i = k * block, m = std::min(block, n - i);
+            energy[k] = dipole_kernel_energy(points.x(), points.y(), points.z(),
+                                             moments.x(), moments.y(), moments.z(), n,
+                                             points.x() + i, points.y() + i, points.z() + i,
+                                             moments.x() + i, moments.y() + i, moments.z() + i, m,
+                                             potential.data() + i, field.x() + i, field.y() + i, field.z() + i);
+        }
+    }, pool);
+    double total = 0.0;
+    for (double e: energy) total += e;
+    return 0.5 * total;
+}
+
+/**
+ * @brief The interaction energy -1/2 sum_i m_i . H_i of dipoles in their
+ *        own field (as evaluated by Fmm, say).
+ */
+inline double dipole_energy(std::span<const Vector3<double>> moments, std::span<const Vector3<double>> field) {
+    if (moments.size() != field.size()) throw std::invalid_argument("dipole_energy size mismatch");
+    double total = 0.0;
+    for (size_t i = 0; i < moments.size(); ++i) total += inner(moments[i], field[i]);
+    return -0.5 * total;
+}
+
+#endif //FMM_DIPOLE_HPP
@@ -0,0 +1,263 @@
+/**
+ * @file fft.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Self-contained mixed radix fast Fourier transforms of complex data
+ *        in one and two dimensions.
+ */
+
+#ifndef FMM_FFT_HPP
+#define FMM_FFT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+
+namespace detail {
+
+/**
+ * @brief a * b without the NaN recovery of std::complex's operator*.
+ */
+inline std::complex<double> cmul(const std::complex<double> &a, const std::complex<double> &b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+} // namespace detail
+
+/**
+ * @brief The smallest n' >= n of the form 2^a 3^b 5^c, for which Fft is
+ *        fastest.
+ */
+inline size_t fft_size(size_t n) {
+    for (size_t m = std::max<size_t>(n, 1);; ++m) {
+        size_t r = m;
+        for (size_t f: {2, 3, 5}) {
+            while (r % f == 0) r /= f;
+        }
+        if (r == 1) return m;
+    }
+}
+
+/**
+ * @brief A one dimensional complex FFT of a fixed length n.
+ *
+ * A recursive, self sorting Cooley-Tukey transform over the factorisation
+ * of n into radices 4, 2, 3, 5 and then any remaining primes (which fall
+ * back to an O(r^2) butterfly, so lengths with large prime factors work but
+ * are slow). The forward transform is y_k = sum_j x_j e^{-2 pi i jk / n};
+ * the inverse uses e^{+2 pi i jk / n} and is not normalised, so
+ * inverse(forward(x)) = n x.
+ *
+ * Plans are immutable after construction and safe to share between
+ * threads (scratch space is thread local).
+ */
+class Fft {
+public:
+
+    using Complex = std::complex<double>;
+
+    /**
+     * @throws std::invalid_argument if n is 0.
+     */
+    explicit Fft(size_t n) : _n(n) {
+        if (n == 0) throw std::invalid_argument("Fft length must be positive");
+        size_t r = n;
+        while (r % 4 == 0) {
+            _factors.push_back(4);
+            r /= 4;
+        }
+        for (size_t f = 2; r > 1; ++f) {
+            while (r % f == 0) {
+                _factors.push_back(f);
+                r /= f;
+            }
+        }
+        _twiddle.resize(n);
+        for (size_t k = 0; k < n; ++k) {
+            _twiddle[k] = std::polar(1.0, -2.0 * std::numbers::pi * double(k) / double(n));
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return _n; }
+
+    /**
+     * @brief The forward transform of x[0], x[stride], ..., in place.
+     */
+    void forward(Complex *x, size_t stride = 1) const { run(x, stride, 1, false); }
+
+    /**
+     * @brief The (unnormalised) inverse transform of x[0], x[stride], ...,
+     *        in place.
+     */
+    void inverse(Complex *x, size_t stride = 1) const { run(x, stride, 1, true); }
+
+    /**
+     * @brief The forward transforms of `batch` interleaved sequences, in
+     *        place: element i of sequence b is x[i batch + b]. The butterflies
+     *        run across the batch, so this vectorises where a loop over
+     *        strided transforms would not.
+     */
+    void forward_batch(Complex *x, size_t batch) const { run(x, 1, batch, false); }
+
+    /**
+     * @brief The (unnormalised) inverse of forward_batch.
+     */
+    void inverse_batch(Complex *x, size_t batch) const { run(x, 1, batch, true); }
+
+private:
+
+    void run(Complex *x, size_t stride, size_t batch, bool inverse) const {
+        thread_local std::vector<Complex> out;
+        if (out.size() < _n * batch) out.resize(_n * batch);
+        transform(x, stride, out.data(), _n, 0, batch, inverse);
+        if (stride == 1) {
+            std::copy(out.begin(), out.begin() + std::ptrdiff_t(_n * batch), x);
+        } else {
+            for (size_t k = 0; k < _n; ++k) x[k * stride] = out[k];
+        }
+    }
+
+    /**
+     * @brief e^{-2 pi i k / n} (or its conjugate for the inverse), k < n.
+     */
+    Complex twiddle(size_t k, bool inverse) const {
+        return inverse ? std::conj(_twiddle[k]) : _twiddle[k];
+    }
+
+    /**
+     * @brief The length n transforms of the blocks of `batch` values at in,
+     *        in + stride batch, ... into out[0, n batch), splitting by radix
+     *        _factors[f] into interleaved sub-transforms.
+     */
+    void transform(const Complex *in, size_t stride, Complex *out, size_t n, size_t f, size_t batch,
+                   bool inverse) const {
+        if (n == 1) {
+            std::copy(in, in + batch, out);
+            return;
+        }
+        const size_t r = _factors[f], m = n / r, step = _n / n;
+        for (size_t j = 0; j < r; ++j) {
+            transform(in + j * stride * batch, stride * r, out + j * m * batch, m, f + 1, batch, inverse);
+        }
+
+        // Butterflies: out[q m + k] = sum_j w_n^{jk} w_r^{jq} sub_j[k].
+        if (r == 2) {
+            for (size_t k = 0; k < m; ++k) {
+                const Complex w = twiddle(k * step, inverse);
+                Complex *x0 = out + k * batch, *x1 = out + (m + k) * batch;
+                for (size_t b = 0; b < batch; ++b) {
+                    Complex a = x0[b], c = detail::cmul(x1[b], w);
+                    x0[b] = a + c;
+                    x1[b] = a - c;
+                }
+            }
+            return;
+        }
+        if (r == 4) {
+            for (size_t k = 0; k < m; ++k) {
+                const Complex w1 = twiddle(k * step, inverse), w2 = twiddle(2 * k * step, inverse),
+                        w3 = twiddle(3 * k * step, inverse);
+                Complex *x0 = out + k * batch, *x1 = out + (m + k) * batch;
+                Complex *x2 = out + (2 * m + k) * batch, *x3 = out + (3 * m + k) * batch;
+                for (size_t b = 0; b < batch; ++b) {
+                    Complex a = x0[b], c1 = detail::cmul(x1[b], w1), c2 = detail::cmul(x2[b], w2),
+                            c3 = detail::cmul(x3[b], w3);
+                    // -i (forward) or +i (inverse) times (c1 - c3).
+                    Complex e = c1 - c3;
+                    Complex rot = inverse ? Complex(-e.imag(), e.real()) : Complex(e.imag(), -e.real());
+                    x0[b] = a + c1 + c2 + c3;
+                    x1[b] = a - c2 + rot;
+                    x2[b] = a - c1 + c2 - c3;
+                    x3[b] = a - c2 - rot;
+                }
+            }
+            return;
+        }
+
+        // (j k < n, so j k step < _n; j q is reduced mod r incrementally.)
+        thread_local std::vector<Complex> t;
+        if (t.size() < r * batch) t.resize(r * batch);
+        const size_t root = m * step;
+        for (size_t k = 0; k < m; ++k) {
+            for (size_t j = 0; j < r; ++j) {
+                const Complex w = twiddle(j * k * step, inverse);
+                const Complex *x = out + (j * m + k) * batch;
+                for (size_t b = 0; b < batch; ++b) t[j * batch + b] = detail::cmul(x[b], w);
+            }
+            for (size_t q = 0; q < r; ++q) {
+                Complex *y = out + (q * m + k) * batch;
+                std::copy(t.begin(), t.begin() + std::ptrdiff_t(batch), y);
+                for (size_t j = 1, jq = 0; j < r; ++j) {
+                    jq = jq + q >= r ? jq + q - r : jq + q;
+                    const Complex w = twiddle(jq * root, inverse);
+                    for (size_t b = 0; b < batch; ++b) y[b] += detail::cmul(t[j * batch + b], w);
+                }
+            }
+        }
+    }
+
+    size_t _n;
+    std::vector<size_t> _factors;
+    std::vector<Complex> _twiddle;
+};
+
+/**
+ * @brief A two dimensional complex FFT of a row major rows x cols grid.
+ */
+class Fft2d {
+public:
+
+    using Complex = Fft::Complex;
+
+    Fft2d(size_t rows, size_t cols) : _rows(rows), _cols(cols) {}
+
+    [[nodiscard]] size_t rows() const { return _rows.size(); }
+
+    [[nodiscard]] size_t cols() const { return _cols.size(); }
+
+    [[nodiscard]] size_t size() const { return rows() * cols(); }
+
+    void forward(Complex *x) const { run(x, false); }
+
+    /**
+     * @brief The unnormalised inverse: inverse(forward(x)) = size() x.
+     */
+    void inverse(Complex *x) const { run(x, true); }
+
+private:
+
+    /**
+     * @brief Both passes as batches: down the columns in place, then along
+     *        the rows of the transpose.
+     */
+    void run(Complex *x, bool inverse) const {
+        thread_local std::vector<Complex> t;
+        t.resize(size());
+        const size_t r = rows(), c = cols();
+        if (inverse) {
+            _rows.inverse_batch(x, c);
+        } else {
+            _rows.forward_batch(x, c);
+        }
+        for (size_t i = 0; i < r; ++i) {
+            for (size_t j = 0; j < c; ++j) t[j * r + i] = x[i * c + j];
+        }
+        if (inverse) {
+            _cols.inverse_batch(t.data(), r);
+        } else {
+            _cols.forward_batch(t.data(), r);
+        }
+        for (size_t j = 0; j < c; ++j) {
+            for (size_t i = 0; i < r; ++i) x[i * c + j] = t[j * r + i];
+        }
+    }
+
+    Fft _rows;
+    Fft _cols;
+};
+
+#endif //FMM_FFT_HPP
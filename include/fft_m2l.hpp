@@ -0,0 +1,269 @@
+/**
+ * @file fft_m2l.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief M2L translation of solid harmonic expansions by FFT on a uniform
+ *        octree: convolutions become pointwise products in frequency space.
+ *
+ * The direct M2L (see SphericalOperators::m2l_direct)
+ *
+ *     L_jk = (-1)^j sum_nq M_nq I_{n+j,q+k}(d)
+ *
+ * is a two dimensional correlation of the multipole coefficients with the
+ * irregular harmonics of the translation d, over the degree and order
+ * indices. Embedding M_nq at (-n, -q) of a rows x cols grid and I_lm at
+ * (l, m), with rows >= 2p + 1 and cols >= 3p + 1 so that no needed output
+ * wraps around, turns it into a cyclic convolution: one pointwise product
+ * of the grids' spectra. Each cell's multipole is transformed once, the
+ * kernels of the (at most 316) offsets of the uniform interaction list once
+ * per order, and every target accumulates the products over its whole list
+ * in frequency space before a single inverse transform. Per interaction
+ * this costs rows x cols complex multiply-adds, against O(p^4) for the
+ * direct sum.
+ *
+ * The kernels serve every level: with d = h c for cells of edge h,
+ * I_{n+j}(d) = h^{-(n+j+1)} I_{n+j}(c), so M_nq is scaled by h^-n before its
+ * transform and L_jk by h^-(j+1) after the inverse.
+ *
+ * Unscaled, the grids span many orders of magnitude (I_lm grows like
+ * (l + |m|)!), and the transforms' rounding, which is relative to the
+ * largest entry, swamps the low degree outputs from p of about 8 on. Any
+ * geometric scaling M_nq a^n b^q, I_lm a^-l b^-m, L_jk a^j b^k leaves the
+ * result unchanged, and a = 0.6 p, b = 1.4 balance the grids so that the
+ * potential agrees with the direct sum to about 1e-15 at p = 8 and 1e-12
+ * at p = 16.
+ */
+
+#ifndef FMM_FFT_M2L_HPP
+#define FMM_FFT_M2L_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "fft.hpp"
+#include "fmm_spherical.hpp"
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "octree.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief Visits the uniform tree interaction list of node t: the cells at
+ *        t's level that are children of the neighbours of t's parent but not
+ *        neighbours of t, as visit(source, cx, cy, cz) with (cx, cy, cz) the
+ *        offset of t from the source in cells, in Morton order of the source.
+ *
+ * Cells missing from the tree are skipped; on an adaptive tree this is only
+ * the same level part (the V list) of the interactions.
+ */
+template <typename T, typename Visit>
+inline void uniform_interaction_list(const LinearOctree<T> &tree, uint32_t t, Visit &&visit) {
+    const OctreeNode &node = tree.node(t);
+    if (node.level < 2) return;
+    uint32_t c[3];
+    morton_decode(node.key, c[0], c[1], c[2]);
+    const int64_t cells = int64_t{1} << node.level;
+    int64_t lo[3], hi[3];
+    for (size_t a = 0; a < 3; ++a) {
+        int64_t parent = int64_t(c[a] >> 1);
+        lo[a] = std::max<int64_t>(0, 2 * (parent - 1));
+        hi[a] = std::min<int64_t>(cells - 1, 2 * (parent + 1) + 1);
+    }
+    for (int64_t x = lo[0]; x <= hi[0]; ++x) {
+        for (int64_t y = lo[1]; y <= hi[1]; ++y) {
+            for (int64_t z = lo[2]; z <= hi[2]; ++z) {
+                int cx = int(c[0] - x), cy = int(c[1] - y), cz = int(c[2] - z);
+                if (std::max({std::abs(cx), std::abs(cy), std::abs(cz)}) < 2) continue;
+                uint32_t s = tree.find(morton_encode(uint32_t(x), uint32_t(y), uint32_t(z)), node.level);
+                if (s != LinearOctree<T>::npos) visit(s, cx, cy, cz);
+            }
+        }
+    }
+}
+
+/**
+ * @brief FFT based M2L of order p solid harmonic expansions (in the
+ *        SphericalOperators convention) on a uniform octree.
+ *
+ * Spectra are stored split, all real parts then all imaginary parts, so the
+ * pointwise products vectorise; a spectrum is spectrum_size() doubles. The
+ * engine is immutable after construction and safe to share between threads.
+ */
+class FftM2L {
+public:
+
+    /**
+     * @brief The largest |offset| component, in cells, of the uniform
+     *        interaction list.
+     */
+    static constexpr int REACH = 3;
+
+    explicit FftM2L(size_t order)
+            : _p(order), _fft(fft_size(2 * order + 1), fft_size(3 * order + 1)),
+              _degree_scale(std::max(1.0, 0.6 * double(order))), _order_scale(1.4) {
+        const size_t side = 2 * REACH + 1;
+        _kernels.resize(side * side * side * spectrum_size());
+        std::vector<Complex> in(sh_size(2 * _p)), grid(_fft.size());
+        for (int cx = -REACH; cx <= REACH; ++cx) {
+            for (int cy = -REACH; cy <= REACH; ++cy) {
+                for (int cz = -REACH; cz <= REACH; ++cz) {
+                    if (std::max({std::abs(cx), std::abs(cy), std::abs(cz)}) < 2) continue;
+                    irregular_harmonics(2 * _p, {double(cx), double(cy), double(cz)}, in.data());
+                    std::fill(grid.begin(), grid.end(), Complex(0.0));
+                    for (int l = 0; l <= 2 * int(_p); ++l) {
+                        for (int m = std::max(-l, -int(_p)); m <= l; ++m) {
+                            grid[cell(l, m)] = std::pow(_degree_scale, -l) * std::pow(_order_scale, -m)
+                                               * sh_get(in.data(), l, m);
+                        }
+                    }
+                    _fft.forward(grid.data());
+                    split(grid.data(), _kernels.data() + kernel_index(cx, cy, cz));
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] size_t order() const { return _p; }
+
+    /**
+     * @brief The number of coefficients per expansion.
+     */
+    [[nodiscard]] size_t size() const { return sh_size(_p); }
+
+    /**
+     * @brief The grid dimensions: rows (degree) by cols (order).
+     */
+    [[nodiscard]] size_t rows() const { return _fft.rows(); }
+
+    [[nodiscard]] size_t cols() const { return _fft.cols(); }
+
+    /**
+     * @brief The number of doubles per spectrum.
+     */
+    [[nodiscard]] size_t spectrum_size() const { return 2 * _fft.size(); }
+
+    /**
+     * @brief The spectrum of a multipole expansion about the centre of a cell
+     *        of edge h.
+     */
+    void multipole_spectrum(const Complex *m, double h, double *spectrum) const {
+        thread_local std::vector<Complex> grid;
+        grid.assign(_fft.size(), Complex(0.0));
+        const double a = _degree_scale / h;
+        double scale = 1.0;
+        for (int n = 0; n <= int(_p); ++n, scale *= a) {
+            for (int q = -n; q <= n; ++q) grid[cell(-n, -q)] = scale * std::pow(_order_scale, q) * sh_get(m, n, q);
+        }
+        _fft.forward(grid.data());
+        split(grid.data(), spectrum);
+    }
+
+    /**
+     * @brief The spectrum of the kernel for a target (cx, cy, cz) cells from
+     *        its source, each component in [-REACH, REACH] and at least one
+     *        of magnitude 2 or more.
+     */
+    [[nodiscard]] const double *kernel_spectrum(int cx, int cy, int cz) const {
+        return _kernels.data() + kernel_index(cx, cy, cz);
+    }
+
+    /**
+     * @brief acc += source * kernel, pointwise.
+     */
+    void accumulate(const double *source, const double *kernel, double *acc) const {
+        const size_t g = _fft.size();
+        const double *__restrict sr = source, *__restrict si = source + g;
+        const double *__restrict kr = kernel, *__restrict ki = kernel + g;
+        double *__restrict ar = acc, *__restrict ai = acc + g;
+        for (size_t i = 0; i < g; ++i) {
+            ar[i] += sr[i] * kr[i] - si[i] * ki[i];
+            ai[i] += sr[i] * ki[i] + si[i] * kr[i];
+        }
+    }
+
+    /**
+     * @brief Adds the local expansion, about the centre of a cell of edge h,
+     *        whose accumulated spectrum is acc.
+     */
+    void local_expansion(const double *acc, double h, Complex *l) const {
+        const size_t g = _fft.size();
+        thread_local std::vector<Complex> grid;
+        grid.resize(g);
+        for (size_t i = 0; i < g; ++i) grid[i] = Complex(acc[i], acc[g + i]);
+        _fft.inverse(grid.data());
+        const double a = _degree_scale / h;
+        double scale = 1.0 / (h * double(g));
+        for (int j = 0; j <= int(_p); ++j, scale *= a) {
+            double sign = (j & 1) ? -scale : scale, b = sign;
+            for (int k = 0; k <= j; ++k, b *= _order_scale) l[sh_index(j, k)] += b * grid[cell(j, k)];
+        }
+    }
+
+    /**
+     * @brief Adds the M2L of every uniform_interaction_list of the nodes of
+     *        a level (at least 2) of a tree.
+     *
+     * @param multipole the multipole expansions of all nodes, node major.
+     * @param local the local expansions of all nodes, node major.
+     */
+    void translate_level(const LinearOctree<double> &tree, size_t level, const Complex *multipole,
+                         Complex *local, ThreadPool &pool = ThreadPool::global()) const {
+        if (level < 2 || level >= tree.depth()) return;
+        auto [lb, le] = tree.level_range(level);
+        const double h = tree.cell_size(level);
+        const size_t n = size(), ns = spectrum_size();
+
+        std::vector<double> spectra((le - lb) * ns);
+        parallel_for(lb, le, 16, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) multipole_spectrum(multipole + i * n, h, spectra.data() + (i - lb) * ns);
+        }, pool);
+
+        parallel_for(lb, le, 4, [&](size_t b, size_t e) {
+            std::vector<double> acc(ns);
+            for (size_t t = b; t < e; ++t) {
+                std::fill(acc.begin(), acc.end(), 0.0);
+                bool any = false;
+                uniform_interaction_list(tree, uint32_t(t), [&](uint32_t s, int cx, int cy, int cz) {
+                    accumulate(spectra.data() + (s - lb) * ns, kernel_spectrum(cx, cy, cz), acc.data());
+                    any = true;
+                });
+                if (any) local_expansion(acc.data(), h, local + t * n);
+            }
+        }, pool);
+    }
+
+private:
+
+    /**
+     * @brief The grid index of (degree, order), both taken cyclically.
+     */
+    size_t cell(int degree, int order) const {
+        const int r = int(rows()), c = int(cols());
+        return size_t((degree % r + r) % r) * cols() + size_t((order % c + c) % c);
+    }
+
+    size_t kernel_index(int cx, int cy, int cz) const {
+        const size_t side = 2 * REACH + 1;
+        return ((size_t(cx + REACH) * side + size_t(cy + REACH)) * side + size_t(cz + REACH)) * spectrum_size();
+    }
+
+    void split(const Complex *grid, double *spectrum) const {
+        const size_t g = _fft.size();
+        for (size_t i = 0; i < g; ++i) {
+            spectrum[i] = grid[i].real();
+            spectrum[g + i] = grid[i].imag();
+        }
+    }
+
+    size_t _p;
+    Fft2d _fft;
+    double _degree_scale;
+    double _order_scale;
+    std::vector<double> _kernels;
+};
+
+#endif //FMM_FFT_M2L_HPP
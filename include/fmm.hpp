@@ -0,0 +1,675 @@
+/**
+ * @file fmm.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A fast multipole method for the Laplace kernel, generic over the
+ *        expansion operators, on the LinearOctree.
+ */
+
+#ifndef FMM_FMM_HPP
+#define FMM_FMM_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "dipole.hpp"
+#include "linalg.hpp"
+#include "m2l_cache.hpp"
+#include "octree.hpp"
+#include "p2p.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tasks.hpp"
+
+/**
+ * @brief How Fmm::evaluate schedules its passes.
+ */
+enum class FmmSchedule {
+    phases,     /**< Level synchronous passes, each a ThreadPool batch per level, with barriers between them. */
+    task_graph  /**< One dependency graph of per-node tasks on the TaskPool: M2L overlaps P2P. */
+};
+
+/**
+ * @brief Parameters of an Fmm.
+ */
+struct FmmOptions {
+    double theta = 0.5;    /**< The opening angle: cells interact through expansions when (r_a + r_b) < theta |c_a - c_b|. */
+    size_t max_leaf = 64;  /**< The maximum number of particles per leaf. */
+    FmmSchedule schedule = FmmSchedule::task_graph;  /**< The evaluation schedule. */
+};
+
+/**
+ * @brief A periodic cubic box: the charges in [min, min + size)^3 and their
+ *        images at n size for the integer vectors n with |n|_inf <= shells.
+ *
+ * The images form a finite cubic crystal of (2 shells + 1)^3 boxes in
+ * vacuum. Lattice sums of 1/r converge only conditionally, so for a charged
+ * box the potential grows with shells (by a constant: the field is
+ * unaffected), and a box with a dipole moment sees the crystal's surface
+ * field.
+ */
+struct PeriodicBox {
+    Vector3<double> min{0.0, 0.0, 0.0};  /**< The lower corner. */
+    double size = 1.0;                   /**< The edge length. */
+    size_t shells = 8;                   /**< The image shells summed. */
+};
+
+/**
+ * @brief Seconds spent in each part of the method.
+ *
+ * Under FmmSchedule::phases the pass times are wall times; under
+ * FmmSchedule::task_graph the passes overlap, so each is the summed time of
+ * its tasks over all threads (divide by the thread count for a wall time
+ * equivalent). `traversal` (building the interaction lists) and `total`
+ * (one evaluate) are always wall times.
+ */
+struct FmmTimings {
+    double traversal = 0.0;
+    double upward = 0.0;
+    double far_field = 0.0;
+    double downward = 0.0;
+    double near_field = 0.0;
+    double total = 0.0;
+};
+
+/**
+ * @brief A fast multipole evaluation of the potentials sum_j q_j / |x_i - x_j|
+ *        and fields sum_j q_j (x_i - x_j) / |x_i - x_j|^3 of a set of charges
+ *        at their own positions (j != i).
+ *
+ * Interactions are found by a dual tree traversal of the octree with the
+ * opening angle criterion theta; well separated cell pairs interact through
+ * M2L and pairs of leaves that are not through P2P. The traversal spawns a
+ * task per subtree pair on the TaskPool until pairs hold fewer than
+ * TRAVERSAL_GRAIN particles, which are walked serially. Expansions for all
+ * nodes are stored in one contiguous array, node after node in the tree's
+ * (level by level) order, so the upward and downward passes stream through
+ * it.
+ *
+ * Each target's interaction lists are sorted by source and every output is
+ * accumulated in a fixed order, so results are bitwise independent of the
+ * schedule and the number of threads.
+ *
+ * With a PeriodicBox the tree is built in the box, and the traversal pairs
+ * it with each image of itself up to PERIODIC_TREE_SHELLS away, so near
+ * images of a source interact through M2L or P2P as they would if they
+ * were in the box (the nearest image of a leaf is the minimum image
+ * convention). The particle arrays are never replicated: an interaction
+ * carries the image's offset, M2L takes it into the source centre, and P2P
+ * moves the (leaf sized) target block the other way. The shells beyond
+ * are far enough from the box for its multipole expansion: the kernels of
+ * all their translations are summed once into a lattice M2L operator
+ * (Ops::add_m2l_kernel), which adds their whole field to the root's local
+ * expansion in one m2l_kernel_apply per evaluate.
+ *
+ * @tparam Ops the operator family, providing `Coefficient`, `size()`, `p2m`,
+ *             `p2m_dipole`, `m2m`, `m2l`, `l2l` and `l2p` (see
+ *             SphericalOperators and CartesianOperators).
+ */
+template <typename Ops>
+class Fmm {
+public:
+
+    using Coefficient = typename Ops::Coefficient;
+
+    /**
+     * @brief The particle count below which a pair of subtrees is traversed
+     *        serially rather than split into tasks.
+     */
+    static constexpr size_t TRAVERSAL_GRAIN = 4096;
+
+    /**
+     * @brief The image shells of a PeriodicBox handled by the traversal;
+     *        farther shells are separated enough (the nearest at three box
+     *        widths) for M2L from the root.
+     */
+    static constexpr size_t PERIODIC_TREE_SHELLS = 2;
+
+    /**
+     * @brief Builds the tree and the interaction lists.
+     *
+     * @param ops the expansion operators.
+     * @param points the particle positions.
+     * @param charges the particle charges.
+     * @param options the method parameters.
+     * @param pool the pool for the tree build and the phases schedule.
+     * @param tasks the pool for the traversal and the task graph schedule.
+     */
+    Fmm(Ops ops, std::span<const Vector3<double>> points, std::span<const double> charges,
+        const FmmOptions &options = {}, ThreadPool &pool = ThreadPool::global(),
+        TaskPool &tasks = TaskPool::global())
+            : _ops(std::move(ops)), _options(options), _pool(pool), _tasks(tasks),
+              _tree(points, options.max_leaf, pool) {
+        if (charges.size() != points.size()) throw std::invalid_argument("Fmm size mismatch");
+        auto perm = _tree.permutation();
+        _charges.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i) _charges[i] = charges[perm[i]];
+        _soa = Vector3Array<double>(_tree.points());
+        build_lists();
+    }
+
+    /**
+     * @brief Builds the tree, in a periodic box, and the interaction lists
+     *        and lattice operator; arguments are as for the free space
+     *        constructor.
+     *
+     * @throws std::invalid_argument if a point lies outside the box.
+     */
+    Fmm(Ops ops, std::span<const Vector3<double>> points, std::span<const double> charges,
+        const PeriodicBox &box, const FmmOptions &options = {}, ThreadPool &pool = ThreadPool::global(),
+        TaskPool &tasks = TaskPool::global())
+            : _ops(std::move(ops)), _options(options), _pool(pool), _tasks(tasks),
+              _tree(points, periodic_cube(points, box), options.max_leaf, pool), _box(box),
+              _reach(std::min(box.shells, PERIODIC_TREE_SHELLS)) {
+        if (charges.size() != points.size()) throw std::invalid_argument("Fmm size mismatch");
+        auto perm = _tree.permutation();
+        _charges.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i) _charges[i] = charges[perm[i]];
+        _soa = Vector3Array<double>(_tree.points());
+        build_lists();
+        build_lattice();
+    }
+
+    [[nodiscard]] const LinearOctree<double> &tree() const { return _tree; }
+
+    [[nodiscard]] const Ops &operators() const { return _ops; }
+
+    /**
+     * @brief The number of M2L and P2P (leaf pair) interactions.
+     */
+    [[nodiscard]] size_t m2l_count() const { return _m2l.size(); }
+
+    [[nodiscard]] size_t p2p_count() const { return _p2p.size(); }
+
+    /**
+     * @brief Routes M2L through precomputed operators from a cache (which
+     *        builds those it lacks), resolving every interaction's operator
+     *        now so that evaluation takes no locks; nullptr restores
+     *        Ops::m2l. The cache must outlive its use here.
+     */
+    void use_m2l_cache(M2LCache<Ops> *cache) {
+        _m2l_cache = cache;
+        _m2l_operators.clear();
+        if (!cache) return;
+        _m2l_operators.resize(_m2l.size());
+        parallel_for(0, _m2l.size(), 256, [&](size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) {
+                uint32_t s = _m2l[k].source, t = _m2l[k].target;
+                double unit = std::min(_tree.half_width(s), _tree.half_width(t));
+                M2LOffset o = M2LCache<Ops>::offset(_tree.center(t) - source_center(s, _m2l[k].image), unit);
+                _m2l_operators[k] = {cache->get(o), unit};
+            }
+        }, _pool);
+    }
+
+    /**
+     * @brief Makes the sources point dipoles of these moments (in the input
+     *        particle order) in place of the charges, so that evaluate gives
+     *        the scalar potential sum_j m_j . r / |r|^3 and the field
+     *        (3 r^ r^T - I) m_j / |r|^3 summed (see dipole.hpp); an empty span
+     *        restores the charges.
+     *
+     * @throws std::invalid_argument if there is not one moment per particle.
+     */
+    void use_dipoles(std::span<const Vector3<double>> moments) {
+        if (moments.empty()) {
+            _moments.clear();
+            _moments_soa = Vector3Array<double>();
+            return;
+        }
+        if (moments.size() != _charges.size()) throw std::invalid_argument("Fmm size mismatch");
+        auto perm = _tree.permutation();
+        _moments.resize(moments.size());
+        for (size_t i = 0; i < moments.size(); ++i) _moments[i] = moments[perm[i]];
+        _moments_soa = Vector3Array<double>(std::span<const Vector3<double>>(_moments));
+    }
+
+    /**
+     * @brief The timings of the traversal and of the last evaluate.
+     */
+    [[nodiscard]] const FmmTimings &timings() const { return _timings; }
+
+    /**
+     * @brief Evaluates potentials and fields, in the input particle order.
+     */
+    void evaluate(std::span<double> potential, std::span<Vector3<double>> field) {
+        const size_t n = _charges.size();
+        if (potential.size() != n || field.size() != n) throw std::invalid_argument("Fmm size mismatch");
+
+        auto start = Clock::now();
+        std::vector<double> phi(n, 0.0);
+        Vector3Array<double> f(n);
+        _multipole.assign(_tree.nodes().size() * _ops.size(), Coefficient(0.0));
+        _local.assign(_tree.nodes().size() * _ops.size(), Coefficient(0.0));
+
+        if (_options.schedule == FmmSchedule::task_graph) {
+            run_graph(phi, f);
+        } else {
+            run_phases(phi, f);
+        }
+
+        auto perm = _tree.permutation();
+        parallel_for(0, n, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                potential[perm[i]] = phi[i];
+                field[perm[i]] = f[i];
+            }
+        }, _pool);
+        _timings.total = seconds_since(start);
+    }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    static double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief An interaction: of target with image `image` of source (see
+     *        image_shift; always central_image() without a periodic box).
+     */
+    struct Pair {
+        uint32_t target;
+        uint32_t source;
+        uint32_t image;
+    };
+
+    struct CachedM2L {
+        const double *op;
+        double unit;
+    };
+
+    struct Lists {
+        std::vector<Pair> m2l, p2p;
+    };
+
+    enum Phase { UPWARD, FAR_FIELD, DOWNWARD, NEAR_FIELD, NPHASES };
+
+    /**
+     * @brief Per worker task time accumulators, one cache line each.
+     */
+    struct alignas(64) PhaseTimes {
+        double seconds[NPHASES] = {};
+    };
+
+    // ##################################################################### //
+    // # Periodic images.                                                  # //
+    // ##################################################################### //
+
+    static BoundingCube<double> periodic_cube(std::span<const Vector3<double>> points, const PeriodicBox &box) {
+        if (!(box.size > 0.0)) throw std::invalid_argument("Fmm periodic box size must be positive");
+        const Vector3<double> hi = box.min + Vector3<double>{box.size, box.size, box.size};
+        for (const Vector3<double> &p: points) {
+            if (!(p.x >= box.min.x && p.y >= box.min.y && p.z >= box.min.z && p.x < hi.x && p.y < hi.y
+                  && p.z < hi.z)) {
+                throw std::invalid_argument("Fmm point outside the periodic box");
+            }
+        }
+        return {box.min, box.size};
+    }
+
+    /**
+     * @brief The images are numbered over [-reach, reach]^3, x slowest.
+     */
+    uint32_t central_image() const {
+        const uint32_t side = uint32_t(2 * _reach + 1);
+        return side * side * side / 2;
+    }
+
+    /**
+     * @brief The offset n box.size of an image from the box.
+     */
+    Vector3<double> image_shift(uint32_t image) const {
+        if (_reach == 0) return {0.0, 0.0, 0.0};
+        const int side = int(2 * _reach + 1), reach = int(_reach);
+        const int x = int(image) / (side * side) - reach, y = int(image) / side % side - reach,
+                z = int(image) % side - reach;
+        return {_box.size * x, _box.size * y, _box.size * z};
+    }
+
+    /**
+     * @brief The centre of an image of a node.
+     */
+    Vector3<double> source_center(uint32_t s, uint32_t image) const {
+        return _tree.center(s) + image_shift(image);
+    }
+
+    /**
+     * @brief The lattice M2L operator: the summed kernels of the images
+     *        beyond PERIODIC_TREE_SHELLS, from the root to itself.
+     */
+    void build_lattice() {
+        const int shells = int(_box.shells), reach = int(_reach);
+        if (shells <= reach) return;
+        _lattice.assign(_ops.m2l_kernel_size(), 0.0);
+        for (int x = -shells; x <= shells; ++x) {
+            for (int y = -shells; y <= shells; ++y) {
+                for (int z = -shells; z <= shells; ++z) {
+                    if (std::max({std::abs(x), std::abs(y), std::abs(z)}) <= reach) continue;
+                    _ops.add_m2l_kernel({-_box.size * x, -_box.size * y, -_box.size * z}, _lattice.data());
+                }
+            }
+        }
+    }
+
+    // ##################################################################### //
+    // # Interaction lists.                                                # //
+    // ##################################################################### //
+
+    /**
+     * @brief The radius of the sphere around a node's cell.
+     */
+    double radius(uint32_t i) const {
+        return std::sqrt(3.0) * _tree.half_width(i);
+    }
+
+    bool well_separated(uint32_t a, uint32_t b, uint32_t image) const {
+        Vector3<double> d = _tree.center(a) - source_center(b, image);
+        double r = radius(a) + radius(b);
+        return r * r < _options.theta * _options.theta * inner(d, d);
+    }
+
+    /**
+     * @brief Records the pair (a, image of b) as an M2L or P2P interaction,
+     *        or else calls visit on each pair of the split (the larger, or
+     *        else the target, node is split).
+     */
+    template <typename Visit>
+    void interact(uint32_t a, uint32_t b, uint32_t image, Lists &lists, Visit &&visit) const {
+        if ((a != b || image != central_image()) && well_separated(a, b, image)) {
+            lists.m2l.push_back({a, b, image});
+            return;
+        }
+        const OctreeNode &na = _tree.node(a), &nb = _tree.node(b);
+        if (na.is_leaf() && nb.is_leaf()) {
+            lists.p2p.push_back({a, b, image});
+            return;
+        }
+        bool split_a = nb.is_leaf() || (!na.is_leaf() && na.level <= nb.level);
+        if (split_a) {
+            for (uint32_t c = na.first_child; c < na.first_child + na.nchildren; ++c) visit(c, b);
+        } else {
+            for (uint32_t c = nb.first_child; c < nb.first_child + nb.nchildren; ++c) visit(a, c);
+        }
+    }
+
+    void traverse(uint32_t a, uint32_t b, uint32_t image, Lists &lists) const {
+        interact(a, b, image, lists, [&](uint32_t c, uint32_t d) { traverse(c, d, image, lists); });
+    }
+
+    void traverse_task(uint32_t a, uint32_t b, uint32_t image, std::vector<Lists> &lists) {
+        Lists &mine = lists[TaskPool::current_worker()];
+        if (size_t(_tree.node(a).size()) + _tree.node(b).size() <= TRAVERSAL_GRAIN) {
+            traverse(a, b, image, mine);
+            return;
+        }
+        interact(a, b, image, mine, [&](uint32_t c, uint32_t d) {
+            _tasks.spawn([this, c, d, image, &lists]() { traverse_task(c, d, image, lists); });
+        });
+    }
+
+    /**
+     * @brief Traverses the tree (against each of its images) in parallel,
+     *        then groups the interactions by target (a counting sort) and
+     *        sorts each target's list by source and image, so the lists do
+     *        not depend on how the traversal was scheduled.
+     */
+    void build_lists() {
+        auto start = Clock::now();
+        std::vector<Lists> lists(_tasks.size());
+        const uint32_t side = uint32_t(2 * _reach + 1);
+        _tasks.run([&]() {
+            for (uint32_t image = 0; image < side * side * side; ++image) {
+                _tasks.spawn([this, image, &lists]() { traverse_task(0, 0, image, lists); });
+            }
+        });
+
+        _m2l.clear();
+        _p2p.clear();
+        for (Lists &l: lists) {
+            _m2l.insert(_m2l.end(), l.m2l.begin(), l.m2l.end());
+            _p2p.insert(_p2p.end(), l.p2p.begin(), l.p2p.end());
+        }
+        group(_m2l, _m2l_offsets);
+        group(_p2p, _p2p_offsets);
+        _timings.traversal = seconds_since(start);
+    }
+
+    void group(std::vector<Pair> &pairs, std::vector<size_t> &offsets) const {
+        offsets.assign(_tree.nodes().size() + 1, 0);
+        for (const Pair &p: pairs) ++offsets[p.target + 1];
+        for (size_t i = 1; i < offsets.size(); ++i) offsets[i] += offsets[i - 1];
+        std::vector<Pair> sorted(pairs.size());
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (const Pair &p: pairs) sorted[next[p.target]++] = p;
+        pairs.swap(sorted);
+        parallel_for(0, offsets.size() - 1, 256, [&](size_t b, size_t e) {
+            for (size_t t = b; t < e; ++t) {
+                std::sort(pairs.begin() + offsets[t], pairs.begin() + offsets[t + 1],
+                          [](const Pair &x, const Pair &y) {
+                              return x.source < y.source || (x.source == y.source && x.image < y.image);
+                          });
+            }
+        }, _pool);
+    }
+
+    // ##################################################################### //
+    // # Per node work.                                                    # //
+    // ##################################################################### //
+
+    Coefficient *multipole(size_t node) { return _multipole.data() + node * _ops.size(); }
+
+    Coefficient *local(size_t node) { return _local.data() + node * _ops.size(); }
+
+    /**
+     * @brief P2M for a leaf, or M2M from the children of an internal node.
+     */
+    void up(size_t i) {
+        const OctreeNode &node = _tree.node(i);
+        if (node.is_leaf() && !_moments.empty()) {
+            _ops.p2m_dipole(_tree.center(i), _tree.points().subspan(node.begin, node.size()),
+                            std::span<const Vector3<double>>(_moments).subspan(node.begin, node.size()),
+                            multipole(i));
+            return;
+        }
+        if (node.is_leaf()) {
+            _ops.p2m(_tree.center(i), _tree.points().subspan(node.begin, node.size()),
+                     std::span<const double>(_charges).subspan(node.begin, node.size()), multipole(i));
+            return;
+        }
+        for (uint32_t c = node.first_child; c < node.first_child + node.nchildren; ++c) {
+            _ops.m2m(multipole(c), _tree.center(c), _tree.center(i), multipole(i));
+        }
+    }
+
+    /**
+     * @brief The M2L interactions into target t (and for the root, the
+     *        lattice of far periodic images).
+     */
+    void far(size_t t) {
+        for (size_t k = _m2l_offsets[t]; k < _m2l_offsets[t + 1]; ++k) {
+            uint32_t s = _m2l[k].source;
+            if (_m2l_cache) {
+                _m2l_cache->apply(_m2l_operators[k].op, multipole(s), _m2l_operators[k].unit, local(t));
+            } else {
+                _ops.m2l(multipole(s), source_center(s, _m2l[k].image), _tree.center(t), local(t));
+            }
+        }
+        if (t == 0 && !_lattice.empty()) _ops.m2l_kernel_apply(_lattice.data(), multipole(0), local(0));
+    }
+
+    /**
+     * @brief L2L from the parent, then L2P for a leaf.
+     */
+    void down(size_t i, std::vector<double> &phi, Vector3Array<double> &f) {
+        const OctreeNode &node = _tree.node(i);
+        if (i != 0) _ops.l2l(local(node.parent), _tree.center(node.parent), _tree.center(i), local(i));
+        if (!node.is_leaf()) return;
+
+        thread_local std::vector<Vector3<double>> g;
+        g.assign(node.size(), {0.0, 0.0, 0.0});
+        _ops.l2p(local(i), _tree.center(i), _tree.points().subspan(node.begin, node.size()),
+                 std::span<double>(phi).subspan(node.begin, node.size()), g);
+        for (uint32_t k = 0; k < node.size(); ++k) f.set(node.begin + k, f[node.begin + k] + g[k]);
+    }
+
+    /**
+     * @brief The P2P interactions into leaf t. For an image of a source the
+     *        targets are moved by minus its offset instead, in a leaf sized
+     *        scratch block.
+     */
+    void near(size_t t, std::vector<double> &phi, Vector3Array<double> &f) {
+        const OctreeNode &tn = _tree.node(t);
+        thread_local Vector3Array<double> shifted;
+        for (size_t k = _p2p_offsets[t]; k < _p2p_offsets[t + 1]; ++k) {
+            const OctreeNode &sn = _tree.node(_p2p[k].source);
+            const double *tx = _soa.x() + tn.begin, *ty = _soa.y() + tn.begin, *tz = _soa.z() + tn.begin;
+            if (_p2p[k].image != central_image()) {
+                if (shifted.size() < tn.size()) shifted = Vector3Array<double>(tn.size());
+                Vector3<double> shift = image_shift(_p2p[k].image);
+                for (uint32_t i = 0; i < tn.size(); ++i) {
+                    shifted.x()[i] = tx[i] - shift.x;
+                    shifted.y()[i] = ty[i] - shift.y;
+                    shifted.z()[i] = tz[i] - shift.z;
+                }
+                tx = shifted.x();
+                ty = shifted.y();
+                tz = shifted.z();
+            }
+            if (!_moments.empty()) {
+                dipole_kernel(_soa.x() + sn.begin, _soa.y() + sn.begin, _soa.z() + sn.begin,
+                              _moments_soa.x() + sn.begin, _moments_soa.y() + sn.begin,
+                              _moments_soa.z() + sn.begin, sn.size(), tx, ty, tz, tn.size(),
+                              phi.data() + tn.begin, f.x() + tn.begin, f.y() + tn.begin, f.z() + tn.begin);
+                continue;
+            }
+            p2p_kernel(_soa.x() + sn.begin, _soa.y() + sn.begin, _soa.z() + sn.begin,
+                       _charges.data() + sn.begin, sn.size(), tx, ty, tz, tn.size(),
+                       phi.data() + tn.begin, f.x() + tn.begin, f.y() + tn.begin, f.z() + tn.begin);
+        }
+    }
+
+    // ##################################################################### //
+    // # Schedules.                                                        # //
+    // ##################################################################### //
+
+    /**
+     * @brief Upward (deepest level first), far field, near field, downward
+     *        (root first); P2P precedes L2P as in the task graph.
+     */
+    void run_phases(std::vector<double> &phi, Vector3Array<double> &f) {
+        const size_t nn = _tree.nodes().size();
+
+        auto start = Clock::now();
+        for (size_t level = _tree.depth(); level-- > 0;) {
+            auto [lb, le] = _tree.level_range(level);
+            parallel_for(lb, le, 16, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) up(i);
+            }, _pool);
+        }
+        _timings.upward = seconds_since(start);
+
+        start = Clock::now();
+        parallel_for(0, nn, 16, [&](size_t b, size_t e) {
+            for (size_t t = b; t < e; ++t) far(t);
+        }, _pool);
+        _timings.far_field = seconds_since(start);
+
+        start = Clock::now();
+        auto leaves = _tree.leaves();
+        parallel_for(0, leaves.size(), 4, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) near(leaves[i], phi, f);
+        }, _pool);
+        _timings.near_field = seconds_since(start);
+
+        start = Clock::now();
+        for (size_t level = 0; level < _tree.depth(); ++level) {
+            auto [lb, le] = _tree.level_range(level);
+            parallel_for(lb, le, 16, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) down(i, phi, f);
+            }, _pool);
+        }
+        _timings.downward = seconds_since(start);
+    }
+
+    /**
+     * @brief One task per node and pass: up(i) after up(children), far(t)
+     *        after the root's up (so after every multipole), down(i) after
+     *        far(i), down(parent) and, for a leaf, near(i). The near field
+     *        tasks have no predecessors and run alongside everything else.
+     */
+    void run_graph(std::vector<double> &phi, Vector3Array<double> &f) {
+        const size_t nn = _tree.nodes().size();
+        std::vector<PhaseTimes> busy(_tasks.size());
+        auto timed = [&busy](Phase phase, auto body) {
+            return [&busy, phase, body]() {
+                auto start = Clock::now();
+                body();
+                busy[TaskPool::current_worker()].seconds[phase] += seconds_since(start);
+            };
+        };
+
+        TaskGraph graph;
+        std::vector<size_t> up_task(nn), down_task(nn);
+        for (size_t i = 0; i < nn; ++i) {
+            up_task[i] = graph.add(timed(UPWARD, [this, i]() { up(i); }));
+            down_task[i] = graph.add(timed(DOWNWARD, [this, i, &phi, &f]() { down(i, phi, f); }));
+        }
+        for (size_t i = 1; i < nn; ++i) {
+            uint32_t parent = _tree.node(i).parent;
+            graph.precede(up_task[i], up_task[parent]);
+            graph.precede(down_task[parent], down_task[i]);
+        }
+        for (size_t t = 0; t < nn; ++t) {
+            if (_m2l_offsets[t] == _m2l_offsets[t + 1] && !(t == 0 && !_lattice.empty())) continue;
+            size_t id = graph.add(timed(FAR_FIELD, [this, t]() { far(t); }));
+            graph.precede(up_task[0], id);
+            graph.precede(id, down_task[t]);
+        }
+        for (uint32_t t: _tree.leaves()) {
+            if (_p2p_offsets[t] == _p2p_offsets[t + 1]) continue;
+            size_t id = graph.add(timed(NEAR_FIELD, [this, t, &phi, &f]() { near(t, phi, f); }));
+            graph.precede(id, down_task[t]);
+        }
+        graph.run(_tasks);
+
+        double sum[NPHASES] = {};
+        for (const PhaseTimes &b: busy) {
+            for (size_t p = 0; p < NPHASES; ++p) sum[p] += b.seconds[p];
+        }
+        _timings.upward = sum[UPWARD];
+        _timings.far_field = sum[FAR_FIELD];
+        _timings.downward = sum[DOWNWARD];
+        _timings.near_field = sum[NEAR_FIELD];
+    }
+
+    Ops _ops;
+    FmmOptions _options;
+    ThreadPool &_pool;
+    TaskPool &_tasks;
+    LinearOctree<double> _tree;
+    std::vector<double> _charges;
+    std::vector<Vector3<double>> _moments;
+    Vector3Array<double> _soa, _moments_soa;
+    std::vector<Pair> _m2l, _p2p;
+    std::vector<size_t> _m2l_offsets, _p2p_offsets;
+    std::vector<Coefficient> _multipole, _local;
+    M2LCache<Ops> *_m2l_cache = nullptr;
+    std::vector<CachedM2L> _m2l_operators;
+    PeriodicBox _box;
+    size_t _reach = 0;
+    std::vector<double> _lattice;
+    FmmTimings _timings;
+};
+
+#endif //FMM_FMM_HPP
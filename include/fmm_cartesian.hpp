@@ -0,0 +1,510 @@
+/**
+ * @file fmm_cartesian.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Cartesian Taylor expansions of the Laplace kernel 1/|r| and their
+ *        translation operators (P2M, M2M, M2L, L2L, L2P), with the expansion
+ *        order a template parameter.
+ *
+ * With multi-indices a = (a_x, a_y, a_z), |a| = a_x + a_y + a_z,
+ * a! = a_x! a_y! a_z! and r^a = x^a_x y^a_y z^a_z, a multipole expansion about
+ * c is
+ *
+ *     M_a = sum_i q_i (y_i - c)^a / a!,   |a| <= P,
+ *
+ * with potential sum_a (-1)^|a| M_a D^a G(x - c), G = 1/|r|; a local
+ * expansion about c is the Taylor series
+ *
+ *     L_b = D^b phi(c),   phi(x) = sum_b L_b (x - c)^b / b!,
+ *
+ * and M2L is L_b = sum_a (-1)^|a| M_a D^{a+b} G(c_t - c_s), |a| + |b| <= P.
+ *
+ * The coefficient and derivative tensors are symmetric, so they are stored
+ * packed: one value per multi-index, (P + 1)(P + 2)(P + 3) / 6 in all,
+ * ordered by degree. Every operator is a fixed list of terms generated at
+ * compile time and expanded by a fold expression into straight line code:
+ * no index arithmetic or loop control is left at run time. This suits low
+ * orders (P <= 6 or so), where it beats the spherical operators; code size
+ * grows as P^6.
+ */
+
+#ifndef FMM_FMM_CARTESIAN_HPP
+#define FMM_FMM_CARTESIAN_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "linalg.hpp"
+
+/**
+ * @brief Forces inlining of the per-term lambdas of the unrolled operators,
+ *        which otherwise exceed the compiler's inlining budget from P = 5 on.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define FMM_ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define FMM_ALWAYS_INLINE
+#endif
+
+// ######################################################################### //
+// # Packed multi-indices.                                                 # //
+// ######################################################################### //
+
+/**
+ * @brief A multi-index (a_x, a_y, a_z).
+ */
+struct CartesianIndex {
+    size_t x = 0;
+    size_t y = 0;
+    size_t z = 0;
+
+    [[nodiscard]] constexpr size_t degree() const { return x + y + z; }
+};
+
+/**
+ * @brief The number of multi-indices of degree at most p.
+ */
+constexpr size_t cart_size(size_t p) {
+    return (p + 1) * (p + 2) * (p + 3) / 6;
+}
+
+/**
+ * @brief The storage index of (a_x, a_y, a_z): by degree n, then by
+ *        decreasing a_x, then by decreasing a_y.
+ */
+constexpr size_t cart_index(size_t ax, size_t ay, size_t az) {
+    size_t n = ax + ay + az, j = ay + az;
+    return n * (n + 1) * (n + 2) / 6 + j * (j + 1) / 2 + az;
+}
+
+constexpr size_t cart_index(const CartesianIndex &a) {
+    return cart_index(a.x, a.y, a.z);
+}
+
+namespace detail {
+
+/**
+ * @brief Calls f(std::integral_constant<size_t, i>) for i = 0 .. N - 1, as
+ *        one expanded sequence of calls.
+ */
+template <size_t N, typename F>
+FMM_ALWAYS_INLINE inline void static_for(F &&f) {
+    [&]<size_t... I>(std::index_sequence<I...>) FMM_ALWAYS_INLINE {
+        (f(std::integral_constant<size_t, I>{}), ...);
+    }(std::make_index_sequence<N>{});
+}
+
+inline constexpr size_t CART_NONE = SIZE_MAX;
+
+/**
+ * @brief The term lists of the order P operators, built at compile time.
+ */
+template <size_t P>
+struct CartesianTables {
+
+    static constexpr size_t size = cart_size(P);
+
+    static constexpr std::array<CartesianIndex, size> indices = [] {
+        std::array<CartesianIndex, size> r{};
+        for (size_t n = 0; n <= P; ++n) {
+            for (size_t ax = n + 1; ax-- > 0;) {
+                for (size_t ay = n - ax + 1; ay-- > 0;) {
+                    CartesianIndex a{ax, ay, n - ax - ay};
+                    r[cart_index(a)] = a;
+                }
+            }
+        }
+        return r;
+    }();
+
+    static constexpr size_t component(const CartesianIndex &a, size_t axis) {
+        return axis == 0 ? a.x : axis == 1 ? a.y : a.z;
+    }
+
+    /**
+     * @brief The index of a - k e_axis, or CART_NONE.
+     */
+    static constexpr size_t lower(const CartesianIndex &a, size_t axis, size_t k) {
+        if (component(a, axis) < k) return CART_NONE;
+        CartesianIndex b = a;
+        (axis == 0 ? b.x : axis == 1 ? b.y : b.z) -= k;
+        return cart_index(b);
+    }
+
+    /**
+     * @brief Monomials r^a / a! = r^{a - e_i} / (a - e_i)! * r_i / a_i, from
+     *        the first non-zero axis i.
+     */
+    struct MonomialStep {
+        size_t from = 0;
+        size_t axis = 0;
+        double scale = 1.0;
+    };
+
+    static constexpr std::array<MonomialStep, size> monomial_steps = [] {
+        std::array<MonomialStep, size> r{};
+        for (size_t k = 1; k < size; ++k) {
+            const CartesianIndex &a = indices[k];
+            size_t axis = a.x > 0 ? 0 : a.y > 0 ? 1 : 2;
+            r[k] = {lower(a, axis, 1), axis, 1.0 / double(component(a, axis))};
+        }
+        return r;
+    }();
+
+    /**
+     * @brief The derivatives of 1/|r| from the recurrence
+     *
+     *     n |r|^2 D^a = -(2n - 1) sum_i a_i r_i D^{a - e_i}
+     *                   - (n - 1) sum_i a_i (a_i - 1) D^{a - 2e_i},   n = |a|.
+     */
+    struct DerivativeStep {
+        std::array<size_t, 3> first{CART_NONE, CART_NONE, CART_NONE};
+        std::array<double, 3> first_scale{};
+        std::array<size_t, 3> second{CART_NONE, CART_NONE, CART_NONE};
+        std::array<double, 3> second_scale{};
+    };
+
+    static constexpr std::array<DerivativeStep, size> derivative_steps = [] {
+        std::array<DerivativeStep, size> r{};
+        for (size_t k = 1; k < size; ++k) {
+            const CartesianIndex &a = indices[k];
+            double n = double(a.degree());
+            for (size_t i = 0; i < 3; ++i) {
+                double ai = double(component(a, i));
+                r[k].first[i] = lower(a, i, 1);
+                r[k].first_scale[i] = -(2.0 * n - 1.0) * ai / n;
+                r[k].second[i] = lower(a, i, 2);
+                r[k].second_scale[i] = -(n - 1.0) * ai * (ai - 1.0) / n;
+            }
+        }
+        return r;
+    }();
+
+    /**
+     * @brief The pairs (hi, lo) with lo <= hi componentwise, and the index
+     *        of hi - lo: the terms of M2M and L2L.
+     */
+    struct ShiftTerm {
+        size_t hi = 0;
+        size_t lo = 0;
+        size_t diff = 0;
+    };
+
+    static constexpr size_t shift_count = [] {
+        size_t count = 0;
+        for (const CartesianIndex &a: indices) count += (a.x + 1) * (a.y + 1) * (a.z + 1);
+        return count;
+    }();
+
+    static constexpr std::array<ShiftTerm, shift_count> shift_terms = [] {
+        std::array<ShiftTerm, shift_count> r{};
+        size_t t = 0;
+        for (size_t k = 0; k < size; ++k) {
+            const CartesianIndex &a = indices[k];
+            for (size_t bx = 0; bx <= a.x; ++bx) {
+                for (size_t by = 0; by <= a.y; ++by) {
+                    for (size_t bz = 0; bz <= a.z; ++bz) {
+                        r[t++] = {k, cart_index(bx, by, bz), cart_index(a.x - bx, a.y - by, a.z - bz)};
+                    }
+                }
+            }
+        }
+        return r;
+    }();
+
+    /**
+     * @brief The M2L terms: local b, multipole a, derivative a + b, and the
+     *        sign (-1)^|a|.
+     */
+    struct M2LTerm {
+        size_t local = 0;
+        size_t multipole = 0;
+        size_t derivative = 0;
+        bool negative = false;
+    };
+
+    static constexpr size_t m2l_count = [] {
+        size_t count = 0;
+        for (const CartesianIndex &b: indices) count += cart_size(P - b.degree());
+        return count;
+    }();
+
+    static constexpr std::array<M2LTerm, m2l_count> m2l_terms = [] {
+        std::array<M2LTerm, m2l_count> r{};
+        size_t t = 0;
+        for (size_t kb = 0; kb < size; ++kb) {
+            const CartesianIndex &b = indices[kb];
+            for (size_t ka = 0; ka < cart_size(P - b.degree()); ++ka) {
+                const CartesianIndex &a = indices[ka];
+                r[t++] = {kb, ka, cart_index(a.x + b.x, a.y + b.y, a.z + b.z), (a.degree() & 1) != 0};
+            }
+        }
+        return r;
+    }();
+
+    /**
+     * @brief For |b| < P, the indices of b + e_x, b + e_y and b + e_z: the
+     *        gradient of a local expansion.
+     */
+    static constexpr size_t gradient_count = cart_size(P - 1);
+
+    static constexpr std::array<std::array<size_t, 3>, gradient_count> gradient_terms = [] {
+        std::array<std::array<size_t, 3>, gradient_count> r{};
+        for (size_t k = 0; k < gradient_count; ++k) {
+            const CartesianIndex &b = indices[k];
+            r[k] = {cart_index(b.x + 1, b.y, b.z), cart_index(b.x, b.y + 1, b.z), cart_index(b.x, b.y, b.z + 1)};
+        }
+        return r;
+    }();
+};
+
+} // namespace detail
+
+// ######################################################################### //
+// # Tensors.                                                              # //
+// ######################################################################### //
+
+/**
+ * @brief The scaled monomials r^a / a!, |a| <= P, packed.
+ */
+template <size_t P>
+inline void cart_monomials(const Vector3<double> &r, double *out) {
+    using Tables = detail::CartesianTables<P>;
+    const double c[3] = {r.x, r.y, r.z};
+    out[0] = 1.0;
+    detail::static_for<Tables::size - 1>([&](auto i) FMM_ALWAYS_INLINE {
+        constexpr size_t k = i + 1;
+        constexpr auto step = Tables::monomial_steps[k];
+        out[k] = out[step.from] * c[step.axis] * step.scale;
+    });
+}
+
+/**
+ * @brief The derivatives D^a (1/|r|), |a| <= P, packed (r != 0).
+ */
+template <size_t P>
+inline void cart_derivatives(const Vector3<double> &r, double *out) {
+    using Tables = detail::CartesianTables<P>;
+    const double c[3] = {r.x, r.y, r.z};
+    const double inv_r2 = 1.0 / (r.x * r.x + r.y * r.y + r.z * r.z);
+    out[0] = std::sqrt(inv_r2);
+    detail::static_for<Tables::size - 1>([&](auto i) FMM_ALWAYS_INLINE {
+        constexpr size_t k = i + 1;
+        constexpr auto step = Tables::derivative_steps[k];
+        double v = 0.0;
+        detail::static_for<3>([&](auto axis) FMM_ALWAYS_INLINE {
+            if constexpr (step.first[axis] != detail::CART_NONE) {
+                v += step.first_scale[axis] * c[axis] * out[step.first[axis]];
+            }
+            if constexpr (step.second[axis] != detail::CART_NONE && step.second_scale[axis] != 0.0) {
+                v += step.second_scale[axis] * out[step.second[axis]];
+            }
+        });
+        out[k] = v * inv_r2;
+    });
+}
+
+// ######################################################################### //
+// # Operators.                                                            # //
+// ######################################################################### //
+
+/**
+ * @brief The Cartesian Taylor expansion operators of order P.
+ *
+ * The interface matches SphericalOperators, so Fmm<CartesianOperators<P>>
+ * and Fmm<SphericalOperators> are interchangeable; all operators add to
+ * their output, are thread safe and use only stack storage.
+ *
+ * @tparam P the expansion order (at least 1).
+ */
+template <size_t P>
+class CartesianOperators {
+public:
+
+    static_assert(P >= 1, "CartesianOperators needs P >= 1 for the field");
+
+    using Coefficient = double;
+
+    [[nodiscard]] static constexpr size_t order() { return P; }
+
+    /**
+     * @brief The number of coefficients per expansion.
+     */
+    [[nodiscard]] static constexpr size_t size() { return cart_size(P); }
+
+    /**
+     * @brief Adds the multipole expansion about center of point charges.
+     */
+    void p2m(const Vector3<double> &center, std::span<const Vector3<double>> points,
+             std::span<const double> charges, double *m) const {
+        std::array<double, size()> r, acc{};
+        for (size_t i = 0; i < points.size(); ++i) {
+            cart_monomials<P>(points[i] - center, r.data());
+            const double q = charges[i];
+            detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE { acc[k] += q * r[k]; });
+        }
+        detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE { m[k] += acc[k]; });
+    }
+
+    /**
+     * @brief Adds the multipole expansion about center of point dipoles:
+     *        (m . grad) (y - c)^a / a! per dipole, the limit of a pair of
+     *        opposite charges.
+     */
+    void p2m_dipole(const Vector3<double> &center, std::span<const Vector3<double>> points,
+                    std::span<const Vector3<double>> moments, double *m) const {
+        using Tables = detail::CartesianTables<P>;
+        std::array<double, size()> r, acc{};
+        for (size_t i = 0; i < points.size(); ++i) {
+            cart_monomials<P>(points[i] - center, r.data());
+            const Vector3<double> &d = moments[i];
+            for (size_t k = 1; k < size(); ++k) {
+                const CartesianIndex &a = Tables::indices[k];
+                double v = 0.0;
+                if (a.x > 0) v += d.x * r[cart_index(a.x - 1, a.y, a.z)];
+                if (a.y > 0) v += d.y * r[cart_index(a.x, a.y - 1, a.z)];
+                if (a.z > 0) v += d.z * r[cart_index(a.x, a.y, a.z - 1)];
+                acc[k] += v;
+            }
+        }
+        for (size_t k = 0; k < size(); ++k) m[k] += acc[k];
+    }
+
+    /**
+     * @brief Adds a child multipole expansion, shifted to the parent centre.
+     */
+    void m2m(const double *child, const Vector3<double> &child_center,
+             const Vector3<double> &parent_center, double *parent) const {
+        std::array<double, size()> r, acc{};
+        cart_monomials<P>(child_center - parent_center, r.data());
+        detail::static_for<Tables::shift_count>([&](auto t) FMM_ALWAYS_INLINE {
+            constexpr auto term = Tables::shift_terms[t];
+            acc[term.hi] += child[term.lo] * r[term.diff];
+        });
+        detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE { parent[k] += acc[k]; });
+    }
+
+    /**
+     * @brief Adds the local expansion about target_center of a multipole
+     *        expansion about source_center.
+     */
+    void m2l(const double *m, const Vector3<double> &source_center,
+             const Vector3<double> &target_center, double *l) const {
+        std::array<double, size()> d;
+        cart_derivatives<P>(target_center - source_center, d.data());
+        translate(m, d.data(), l);
+    }
+
+    /**
+     * @brief The number of doubles in a precomputed M2L operator.
+     */
+    [[nodiscard]] static constexpr size_t m2l_operator_size() { return size(); }
+
+    /**
+     * @brief The M2L operator for d = target_center - source_center: the
+     *        derivatives D^a (1/|d|).
+     */
+    void m2l_operator(const Vector3<double> &d, double *op) const { cart_derivatives<P>(d, op); }
+
+    /**
+     * @brief Adds M2L by an operator precomputed for d / unit.
+     *
+     * D^a (1/|r|) is homogeneous of degree -(|a| + 1), so the derivatives
+     * for d are those for d / unit scaled by unit^-(|a| + 1).
+     */
+    void m2l_apply(const double *op, const double *m, double unit, double *l) const {
+        std::array<double, P + 1> pw;
+        pw[0] = 1.0 / unit;
+        for (size_t n = 1; n <= P; ++n) pw[n] = pw[n - 1] * pw[0];
+        std::array<double, size()> d;
+        detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE {
+            d[k] = op[k] * pw[Tables::indices[k].degree()];
+        });
+        translate(m, d.data(), l);
+    }
+
+    /**
+     * @brief The number of doubles in an M2L kernel (see add_m2l_kernel).
+     */
+    [[nodiscard]] static constexpr size_t m2l_kernel_size() { return size(); }
+
+    /**
+     * @brief Adds the M2L kernel of d = target_center - source_center, the
+     *        derivatives D^a (1/|d|). M2L is linear in its kernel, so the sum
+     *        of the kernels of several translations (a lattice of images,
+     *        say) applies all of them in one m2l_kernel_apply.
+     */
+    void add_m2l_kernel(const Vector3<double> &d, double *kernel) const {
+        std::array<double, size()> k;
+        cart_derivatives<P>(d, k.data());
+        for (size_t i = 0; i < size(); ++i) kernel[i] += k[i];
+    }
+
+    /**
+     * @brief Adds M2L by a (possibly summed) kernel.
+     */
+    void m2l_kernel_apply(const double *kernel, const double *m, double *l) const { translate(m, kernel, l); }
+
+    /**
+     * @brief Adds a parent local expansion, shifted to the child centre.
+     */
+    void l2l(const double *parent, const Vector3<double> &parent_center,
+             const Vector3<double> &child_center, double *child) const {
+        std::array<double, size()> r, acc{};
+        cart_monomials<P>(child_center - parent_center, r.data());
+        detail::static_for<Tables::shift_count>([&](auto t) FMM_ALWAYS_INLINE {
+            constexpr auto term = Tables::shift_terms[t];
+            acc[term.lo] += parent[term.hi] * r[term.diff];
+        });
+        detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE { child[k] += acc[k]; });
+    }
+
+    /**
+     * @brief Adds the potential and field (minus the gradient) of a local
+     *        expansion at points.
+     */
+    void l2p(const double *l, const Vector3<double> &center, std::span<const Vector3<double>> points,
+             std::span<double> potential, std::span<Vector3<double>> field) const {
+        std::array<double, size()> r;
+        for (size_t i = 0; i < points.size(); ++i) {
+            cart_monomials<P>(points[i] - center, r.data());
+            double phi = 0.0, gx = 0.0, gy = 0.0, gz = 0.0;
+            detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE { phi += l[k] * r[k]; });
+            detail::static_for<Tables::gradient_count>([&](auto k) FMM_ALWAYS_INLINE {
+                constexpr auto g = Tables::gradient_terms[k];
+                gx += l[g[0]] * r[k];
+                gy += l[g[1]] * r[k];
+                gz += l[g[2]] * r[k];
+            });
+            potential[i] += phi;
+            field[i] = field[i] - Vector3<double>{gx, gy, gz};
+        }
+    }
+
+private:
+
+    using Tables = detail::CartesianTables<P>;
+
+    /**
+     * @brief Adds L_b = sum_a (-1)^|a| M_a D^{a+b} given the derivatives d.
+     */
+    FMM_ALWAYS_INLINE static void translate(const double *m, const double *d, double *l) {
+        std::array<double, size()> acc{};
+        detail::static_for<Tables::m2l_count>([&](auto t) FMM_ALWAYS_INLINE {
+            constexpr auto term = Tables::m2l_terms[t];
+            if constexpr (term.negative) {
+                acc[term.local] -= m[term.multipole] * d[term.derivative];
+            } else {
+                acc[term.local] += m[term.multipole] * d[term.derivative];
+            }
+        });
+        detail::static_for<size()>([&](auto k) FMM_ALWAYS_INLINE { l[k] += acc[k]; });
+    }
+};
+
+#endif //FMM_FMM_CARTESIAN_HPP
@@ -0,0 +1,665 @@
+/**
+ * @file fmm_spherical.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Solid harmonic multipole and local expansions of the Laplace kernel
+ *        1/|r| and their translation operators (P2M, M2M, M2L, L2L, L2P).
+ *
+ * The expansions use the scaled regular and irregular solid harmonics
+ *
+ *     R_lm(r) = r^l P_l^m(cos t) e^{im p} / (l + m)!,
+ *     I_lm(r) = (l - m)! P_l^m(cos t) e^{im p} / r^{l+1},
+ *
+ * (with the Condon-Shortley phase) for which
+ *
+ *     1/|x - y| = sum_lm conj(R_lm(y)) I_lm(x),   |y| < |x|,
+ *     R_lm(a + b) = sum_jk R_jk(a) R_{l-j,m-k}(b),
+ *     I_lm(a + b) = sum_jk (-1)^j conj(R_jk(b)) I_{l+j,m+k}(a),   |b| < |a|.
+ *
+ * A multipole expansion about c is M_lm = sum_i q_i conj(R_lm(y_i - c)), with
+ * potential sum_lm M_lm I_lm(x - c); a local expansion about c is L_lm with
+ * potential sum_lm L_lm conj(R_lm(x - c)). Since X_{l,-m} = (-1)^m conj(X_lm)
+ * for all of these, only m >= 0 is stored: (p + 1)(p + 2) / 2 complex
+ * coefficients per expansion, l major, in one contiguous block.
+ */
+
+#ifndef FMM_FMM_SPHERICAL_HPP
+#define FMM_FMM_SPHERICAL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "linalg.hpp"
+
+using Complex = std::complex<double>;
+
+// ######################################################################### //
+// # Solid harmonics.                                                      # //
+// ######################################################################### //
+
+/**
+ * @brief The storage index of degree l, order m >= 0.
+ */
+constexpr size_t sh_index(size_t l, size_t m) {
+    return l * (l + 1) / 2 + m;
+}
+
+/**
+ * @brief The number of stored coefficients of an order p expansion.
+ */
+constexpr size_t sh_size(size_t p) {
+    return (p + 1) * (p + 2) / 2;
+}
+
+/**
+ * @brief Coefficient (l, m) of a stored expansion, for any |m| <= l, using
+ *        X_{l,-m} = (-1)^m conj(X_lm); zero outside the stored range.
+ */
+inline Complex sh_get(const Complex *x, int l, int m) {
+    if (l < 0 || m > l || -m > l) return 0.0;
+    if (m >= 0) return x[sh_index(l, m)];
+    Complex c = std::conj(x[sh_index(l, -m)]);
+    return (m & 1) ? -c : c;
+}
+
+/**
+ * @brief The regular solid harmonics R_lm(r), 0 <= m <= l <= p.
+ */
+inline void regular_harmonics(size_t p, const Vector3<double> &r, Complex *out) {
+    const double r2 = r.x * r.x + r.y * r.y + r.z * r.z;
+    const Complex xy(r.x, r.y);
+    out[0] = 1.0;
+    for (size_t l = 0; l < p; ++l) {
+        out[sh_index(l + 1, l + 1)] = -xy / double(2 * l + 2) * out[sh_index(l, l)];
+        for (size_t m = 0; m <= l; ++m) {
+            Complex prev = m + 1 <= l ? out[sh_index(l - 1, m)] : Complex(0.0);
+            out[sh_index(l + 1, m)] = (double(2 * l + 1) * r.z * out[sh_index(l, m)] - r2 * prev)
+                                      / double((l + m + 1) * (l - m + 1));
+        }
+    }
+}
+
+/**
+ * @brief The irregular solid harmonics I_lm(r), 0 <= m <= l <= p (r != 0).
+ */
+inline void irregular_harmonics(size_t p, const Vector3<double> &r, Complex *out) {
+    const double r2 = r.x * r.x + r.y * r.y + r.z * r.z;
+    const double inv_r2 = 1.0 / r2;
+    const Complex xy(r.x, r.y);
+    out[0] = 1.0 / std::sqrt(r2);
+    for (size_t l = 0; l < p; ++l) {
+        out[sh_index(l + 1, l + 1)] = -double(2 * l + 1) * xy * inv_r2 * out[sh_index(l, l)];
+        for (size_t m = 0; m <= l; ++m) {
+            Complex prev = m + 1 <= l ? out[sh_index(l - 1, m)] : Complex(0.0);
+            out[sh_index(l + 1, m)] = (double(2 * l + 1) * r.z * out[sh_index(l, m)]
+                                       - double(l * l - m * m) * prev) * inv_r2;
+        }
+    }
+}
+
+// ######################################################################### //
+// # Rotations.                                                            # //
+// ######################################################################### //
+
+/**
+ * @brief Wigner (small) d matrices d^l(beta), l = 0 .. p, for rotations
+ *        about the y axis, in the convention
+ *
+ *     S_lm(Ry(beta) r) = sum_m' d^l_{mm'}(beta) S_lm'(r),
+ *     S_lm = sqrt((l + m)! (l - m)!) R_lm,
+ *
+ * where Ry(beta) maps (x, z) to (x cos b + z sin b, -x sin b + z cos b).
+ *
+ * The first and last rows and columns of each d^l come from the closed form
+ * (a single term there); the interior from the three term recurrence in l of
+ * Dachsel (J. Chem. Phys. 124, 144115 (2006)), which is stable for all beta.
+ */
+class WignerD {
+public:
+
+    WignerD() = default;
+
+    WignerD(size_t p, double beta) { compute(p, beta); }
+
+    void compute(size_t p, double beta) {
+        _p = p;
+        _d.assign(offset(p + 1), 0.0);
+        const double cb = std::cos(beta), c = std::cos(0.5 * beta), s = std::sin(0.5 * beta);
+
+        std::vector<double> lf(2 * p + 2);
+        lf[0] = 0.0;
+        for (size_t i = 1; i < lf.size(); ++i) lf[i] = lf[i - 1] + std::log(double(i));
+
+        auto closed = [&](int l, int m, int mp) {
+            // The only k with non-negative factorial arguments on an edge.
+            int k = std::max(0, mp - m);
+            if (k > std::min(l + mp, l - m)) k = std::min(l + mp, l - m);
+            double mag = 0.5 * (lf[l + m] + lf[l - m] + lf[l + mp] + lf[l - mp])
+                         - lf[l + mp - k] - lf[k] - lf[l - k - m] - lf[k - mp + m];
+            int pc = 2 * l - 2 * k + mp - m, ps = 2 * k - mp + m;
+            double v = std::exp(mag) * std::pow(c, pc) * std::pow(s, ps);
+            return ((k - mp + m) & 1) ? -v : v;
+        };
+
+        at(0, 0, 0) = 1.0;
+        for (int l = 1; l <= int(p); ++l) {
+            for (int m = -l; m <= l; ++m) {
+                for (int mp = -l; mp <= l; ++mp) {
+                    if (std::abs(m) == l || std::abs(mp) == l) {
+                        at(l, m, mp) = closed(l, m, mp);
+                        continue;
+                    }
+                    double a = double(l) * double(2 * l - 1) / std::sqrt(double(l * l - m * m) * double(l * l - mp * mp));
+                    // (For l = 1 only m = mp = 0 is interior, and m mp / (l (l - 1)) is 0.)
+                    double mm = m * mp == 0 ? 0.0 : double(m * mp) / double(l * (l - 1));
+                    double v = (cb - mm) * at(l - 1, m, mp);
+                    if (std::abs(m) <= l - 2 && std::abs(mp) <= l - 2) {
+                        v -= std::sqrt(double((l - 1) * (l - 1) - m * m) * double((l - 1) * (l - 1) - mp * mp))
+                             / (double(l - 1) * double(2 * l - 1)) * at(l - 2, m, mp);
+                    }
+                    at(l, m, mp) = a * v;
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] size_t order() const { return _p; }
+
+    /**
+     * @brief d^l_{m,mp}.
+     */
+    [[nodiscard]] double operator()(int l, int m, int mp) const {
+        return _d[offset(l) + size_t(m + l) * size_t(2 * l + 1) + size_t(mp + l)];
+    }
+
+private:
+
+    static size_t offset(size_t l) {
+        // sum_{j < l} (2j + 1)^2
+        return l * (4 * l * l - 1) / 3;
+    }
+
+    double &at(int l, int m, int mp) {
+        return _d[offset(l) + size_t(m + l) * size_t(2 * l + 1) + size_t(mp + l)];
+    }
+
+    size_t _p = 0;
+    std::vector<double> _d;
+};
+
+/**
+ * @brief Read only access to the coefficients of a rotation onto +z, held
+ *        by a SphericalRotation or packed in a precomputed M2L operator.
+ */
+class SphericalRotationView {
+public:
+
+    SphericalRotationView(size_t p, const double *scale, const Complex *phase)
+            : _p(p), _scale(scale), _phase(phase) {}
+
+    /**
+     * @brief The number of T^l_{m,mp} (m >= 0) for order p.
+     */
+    [[nodiscard]] static size_t scale_size(size_t p) { return sh_size(p) * (2 * p + 1); }
+
+    /**
+     * @brief T^l_{m,mp} for m >= 0.
+     */
+    [[nodiscard]] double t(int l, int m, int mp) const {
+        return _scale[sh_index(l, m) * (2 * _p + 1) + size_t(mp + l)];
+    }
+
+    /**
+     * @brief e^{im phi} for m >= 0.
+     */
+    [[nodiscard]] Complex phase(int m) const { return _phase[m]; }
+
+    /**
+     * @brief T^l_{m,mp} for any m (T_{-m,-mp} = (-1)^{m+mp} T_{m,mp}).
+     */
+    [[nodiscard]] double t_any(int l, int m, int mp) const {
+        if (m >= 0) return t(l, m, mp);
+        double v = t(l, -m, -mp);
+        return ((m + mp) & 1) ? -v : v;
+    }
+
+private:
+
+    size_t _p;
+    const double *_scale;
+    const Complex *_phase;
+};
+
+/**
+ * @brief The rotation that maps a direction onto +z, for rotation
+ *        accelerated M2L.
+ *
+ * With the direction at polar angle theta and azimuth phi, the rotation is
+ * Q = Ry(-theta) Rz(-phi), and the solid harmonics transform as
+ *
+ *     R_lm(Q r) = sum_m' T^l_{mm'} e^{-im' phi} R_lm'(r),
+ *     T^l_{mm'} = d^l_{mm'}(-theta) sqrt((l + m')! (l - m')! / ((l + m)! (l - m)!)).
+ */
+class SphericalRotation {
+public:
+
+    SphericalRotation() = default;
+
+    SphericalRotation(size_t p, const Vector3<double> &direction) { compute(p, direction); }
+
+    void compute(size_t p, const Vector3<double> &direction) {
+        _p = p;
+        double rho = std::hypot(direction.x, direction.y);
+        double theta = std::atan2(rho, direction.z);
+        double phi = std::atan2(direction.y, direction.x);
+        WignerD d(p, -theta);
+
+        _phase.resize(p + 1);
+        for (size_t m = 0; m <= p; ++m) _phase[m] = std::polar(1.0, double(m) * phi);
+
+        std::vector<double> f(2 * p + 1, 1.0);
+        for (size_t i = 1; i < f.size(); ++i) f[i] = f[i - 1] * double(i);
+        _scale.resize(SphericalRotationView::scale_size(p));
+        for (int l = 0; l <= int(p); ++l) {
+            for (int m = 0; m <= l; ++m) {
+                for (int mp = -l; mp <= l; ++mp) {
+                    _scale[sh_index(l, m) * (2 * p + 1) + size_t(mp + l)]
+                            = d(l, m, mp) * std::sqrt(f[l + mp] * f[l - mp] / (f[l + m] * f[l - m]));
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] SphericalRotationView view() const { return {_p, _scale.data(), _phase.data()}; }
+
+    /**
+     * @brief T^l_{m,mp} for m >= 0.
+     */
+    [[nodiscard]] double t(int l, int m, int mp) const { return view().t(l, m, mp); }
+
+    /**
+     * @brief e^{im phi} for m >= 0.
+     */
+    [[nodiscard]] Complex phase(int m) const { return _phase[m]; }
+
+    /**
+     * @brief T^l_{m,mp} for any m.
+     */
+    [[nodiscard]] double t_any(int l, int m, int mp) const { return view().t_any(l, m, mp); }
+
+    [[nodiscard]] const std::vector<double> &scales() const { return _scale; }
+
+    [[nodiscard]] const std::vector<Complex> &phases() const { return _phase; }
+
+private:
+
+    size_t _p = 0;
+    std::vector<Complex> _phase;
+    std::vector<double> _scale;
+};
+
+// ######################################################################### //
+// # Operators.                                                            # //
+// ######################################################################### //
+
+/**
+ * @brief The spherical harmonic expansion operators of order p.
+ *
+ * All operators add to their output. They are thread safe (scratch space is
+ * thread local) and take expansion centres and particle spans directly, so
+ * they can be used with any tree; see fmm.hpp for the driver.
+ */
+class SphericalOperators {
+public:
+
+    using Coefficient = Complex;
+
+    /**
+     * @param order the expansion order p.
+     * @param rotate_m2l whether m2l() uses the O(p^3) rotation based
+     *                   translation (true) or the O(p^4) direct one.
+     */
+    explicit SphericalOperators(size_t order, bool rotate_m2l = true)
+            : _p(order), _rotate(rotate_m2l), _fact(2 * order + 2, 1.0) {
+        for (size_t i = 1; i < _fact.size(); ++i) _fact[i] = _fact[i - 1] * double(i);
+    }
+
+    [[nodiscard]] size_t order() const { return _p; }
+
+    /**
+     * @brief The number of coefficients per expansion.
+     */
+    [[nodiscard]] size_t size() const { return sh_size(_p); }
+
+    /**
+     * @brief Adds the multipole expansion about center of point charges.
+     */
+    void p2m(const Vector3<double> &center, std::span<const Vector3<double>> points,
+             std::span<const double> charges, Complex *m) const {
+        Complex *r = scratch(0, size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            regular_harmonics(_p, points[i] - center, r);
+            for (size_t k = 0; k < size(); ++k) m[k] += charges[i] * std::conj(r[k]);
+        }
+    }
+
+    /**
+     * @brief Adds the multipole expansion about center of point dipoles:
+     *        (m . grad) conj(R_lm(y - c)) per dipole, the limit of a pair of
+     *        opposite charges.
+     */
+    void p2m_dipole(const Vector3<double> &center, std::span<const Vector3<double>> points,
+                    std::span<const Vector3<double>> moments, Complex *m) const {
+        Complex *r = scratch(0, size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            regular_harmonics(_p, points[i] - center, r);
+            const Vector3<double> &d = moments[i];
+            const Complex up(0.5 * d.x, -0.5 * d.y), down(-0.5 * d.x, -0.5 * d.y);
+            for (int l = 1; l <= int(_p); ++l) {
+                for (int k = 0; k <= l; ++k) {
+                    // See l2p for the derivatives of R_lk.
+                    Complex g = d.z * sh_get(r, l - 1, k) + up * sh_get(r, l - 1, k + 1)
+                                + down * sh_get(r, l - 1, k - 1);
+                    m[sh_index(l, k)] += std::conj(g);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Adds a child multipole expansion, shifted to the parent centre.
+     */
+    void m2m(const Complex *child, const Vector3<double> &child_center,
+             const Vector3<double> &parent_center, Complex *parent) const {
+        Complex *r = scratch(0, size());
+        regular_harmonics(_p, child_center - parent_center, r);
+        for (int l = 0; l <= int(_p); ++l) {
+            for (int m = 0; m <= l; ++m) {
+                Complex acc = 0.0;
+                for (int j = 0; j <= l; ++j) {
+                    for (int k = std::max(-j, m - (l - j)); k <= std::min(j, m + (l - j)); ++k) {
+                        acc += std::conj(sh_get(r, j, k)) * sh_get(child, l - j, m - k);
+                    }
+                }
+                parent[sh_index(l, m)] += acc;
+            }
+        }
+    }
+
+    /**
+     * @brief Adds the local expansion about target_center of a multipole
+     *        expansion about source_center.
+     */
+    void m2l(const Complex *m, const Vector3<double> &source_center,
+             const Vector3<double> &target_center, Complex *l) const {
+        if (_rotate) {
+            m2l_rotated(m, source_center, target_center, l);
+        } else {
+            m2l_direct(m, source_center, target_center, l);
+        }
+    }
+
+    /**
+     * @brief M2L by the full O(p^4) double sum.
+     */
+    void m2l_direct(const Complex *m, const Vector3<double> &source_center,
+                    const Vector3<double> &target_center, Complex *l) const {
+        Complex *in = scratch(0, sh_size(2 * _p));
+        irregular_harmonics(2 * _p, target_center - source_center, in);
+        convolve(m, in, l);
+    }
+
+    /**
+     * @brief M2L by rotating the translation onto the z axis, translating
+     *        along it (where only I_{n,0} is non-zero), and rotating back:
+     *        three O(p^3) steps.
+     */
+    void m2l_rotated(const Complex *m, const Vector3<double> &source_center,
+                     const Vector3<double> &target_center, Complex *l) const {
+        Vector3<double> d = target_center - source_center;
+        m2l_rotated(m, std::sqrt(inner(d, d)), rotation(d).view(), l);
+    }
+
+    /**
+     * @brief As m2l_rotated, with the rotation for the direction of
+     *        target_center - source_center precomputed (and reusable for
+     *        every translation along that direction) and the distance
+     *        between the centres.
+     */
+    void m2l_rotated(const Complex *m, double distance, const SphericalRotationView &rot, Complex *l) const {
+        const size_t n = size();
+        Complex *mr = scratch(0, 2 * n);
+        Complex *lr = mr + n;
+
+        // Rotate the multipole expansion into the frame where d is +z.
+        for (int j = 0; j <= int(_p); ++j) {
+            for (int k = 0; k <= j; ++k) {
+                Complex acc = 0.0;
+                for (int q = -j; q <= j; ++q) {
+                    Complex ph = q >= 0 ? rot.phase(q) : std::conj(rot.phase(-q));
+                    acc += rot.t(j, k, q) * ph * sh_get(m, j, q);
+                }
+                mr[sh_index(j, k)] = acc;
+            }
+        }
+
+        // Translate along z: L'_jk = (-1)^j sum_n M'_{n,-k} (n + j)! / a^{n+j+1}.
+        // The scaled I_{n,0}(0, 0, a) = n! / a^{n+1} are kept in the real
+        // parts of a scratch buffer.
+        const double inv_a = 1.0 / distance;
+        Complex *axial = scratch(1, 2 * _p + 1);
+        double pw = inv_a;
+        for (size_t i = 0; i <= 2 * _p; ++i, pw *= inv_a) axial[i] = _fact[i] * pw;
+        for (int j = 0; j <= int(_p); ++j) {
+            double sign = (j & 1) ? -1.0 : 1.0;
+            for (int k = 0; k <= j; ++k) {
+                Complex acc = 0.0;
+                for (int q = k; q <= int(_p); ++q) acc += sh_get(mr, q, -k) * axial[q + j].real();
+                lr[sh_index(j, k)] = sign * acc;
+            }
+        }
+
+        // Rotate back: L_jk = sum_q L'_jq T^j_{q,k} e^{ik phi}.
+        for (int j = 0; j <= int(_p); ++j) {
+            for (int k = 0; k <= j; ++k) {
+                Complex acc = 0.0;
+                for (int q = -j; q <= j; ++q) acc += sh_get(lr, j, q) * rot.t_any(j, q, k);
+                l[sh_index(j, k)] += acc * rot.phase(k);
+            }
+        }
+    }
+
+    /**
+     * @brief The number of doubles in a precomputed M2L operator: the
+     *        rotation's T^l_{m,mp}, its phases and the distance.
+     */
+    [[nodiscard]] size_t m2l_operator_size() const {
+        return SphericalRotationView::scale_size(_p) + 2 * (_p + 1) + 1;
+    }
+
+    /**
+     * @brief The M2L operator for d = target_center - source_center.
+     */
+    void m2l_operator(const Vector3<double> &d, double *op) const {
+        const SphericalRotation &rot = rotation(d);
+        std::copy(rot.scales().begin(), rot.scales().end(), op);
+        op += rot.scales().size();
+        for (const Complex &ph: rot.phases()) {
+            *op++ = ph.real();
+            *op++ = ph.imag();
+        }
+        *op = std::sqrt(inner(d, d));
+    }
+
+    /**
+     * @brief Adds M2L by an operator precomputed for d / unit: the rotation
+     *        depends only on the direction, and the distance scales.
+     */
+    void m2l_apply(const double *op, const Complex *m, double unit, Complex *l) const {
+        const size_t ns = SphericalRotationView::scale_size(_p);
+        // std::complex<double> is layout compatible with double[2].
+        const auto *phase = reinterpret_cast<const Complex *>(op + ns);
+        m2l_rotated(m, op[ns + 2 * (_p + 1)] * unit, SphericalRotationView(_p, op, phase), l);
+    }
+
+    /**
+     * @brief The number of doubles in an M2L kernel (see add_m2l_kernel).
+     */
+    [[nodiscard]] size_t m2l_kernel_size() const { return 2 * sh_size(2 * _p); }
+
+    /**
+     * @brief Adds the M2L kernel of d = target_center - source_center, the
+     *        irregular harmonics I_lm(d) to degree 2p (as complex pairs).
+     *        M2L is linear in its kernel, so the sum of the kernels of
+     *        several translations (a lattice of images, say) applies all of
+     *        them in one m2l_kernel_apply.
+     */
+    void add_m2l_kernel(const Vector3<double> &d, double *kernel) const {
+        Complex *in = scratch(0, sh_size(2 * _p));
+        irregular_harmonics(2 * _p, d, in);
+        for (size_t i = 0; i < sh_size(2 * _p); ++i) {
+            kernel[2 * i] += in[i].real();
+            kernel[2 * i + 1] += in[i].imag();
+        }
+    }
+
+    /**
+     * @brief Adds M2L by a (possibly summed) kernel, by the direct sum.
+     */
+    void m2l_kernel_apply(const double *kernel, const Complex *m, Complex *l) const {
+        // std::complex<double> is layout compatible with double[2].
+        convolve(m, reinterpret_cast<const Complex *>(kernel), l);
+    }
+
+    /**
+     * @brief Adds a parent local expansion, shifted to the child centre.
+     */
+    void l2l(const Complex *parent, const Vector3<double> &parent_center,
+             const Vector3<double> &child_center, Complex *child) const {
+        Complex *r = scratch(0, size());
+        regular_harmonics(_p, child_center - parent_center, r);
+        for (int n = 0; n <= int(_p); ++n) {
+            for (int q = 0; q <= n; ++q) {
+                Complex acc = 0.0;
+                for (int j = n; j <= int(_p); ++j) {
+                    for (int k = std::max(-j, q - (j - n)); k <= std::min(j, q + (j - n)); ++k) {
+                        acc += sh_get(parent, j, k) * std::conj(sh_get(r, j - n, k - q));
+                    }
+                }
+                child[sh_index(n, q)] += acc;
+            }
+        }
+    }
+
+    /**
+     * @brief Adds the potential and field (minus the gradient) of a local
+     *        expansion at points.
+     */
+    void l2p(const Complex *l, const Vector3<double> &center, std::span<const Vector3<double>> points,
+             std::span<double> potential, std::span<Vector3<double>> field) const {
+        Complex *r = scratch(0, size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            regular_harmonics(_p, points[i] - center, r);
+            double phi = 0.0, gx = 0.0, gy = 0.0, gz = 0.0;
+            for (int j = 0; j <= int(_p); ++j) {
+                for (int k = 0; k <= j; ++k) {
+                    // m and -m terms are complex conjugates: count m > 0 twice.
+                    double w = k == 0 ? 1.0 : 2.0;
+                    Complex c = l[sh_index(j, k)];
+                    phi += w * (c * std::conj(r[sh_index(j, k)])).real();
+                    if (j == 0) continue;
+                    // dR_jk/dz = R_{j-1,k}; (d/dx + i d/dy) R_jk = R_{j-1,k+1};
+                    // (d/dx - i d/dy) R_jk = -R_{j-1,k-1}.
+                    Complex up = sh_get(r, j - 1, k + 1), down = -sh_get(r, j - 1, k - 1);
+                    Complex dx = 0.5 * (up + down), dy = Complex(0.0, -0.5) * (up - down);
+                    gz += w * (c * std::conj(sh_get(r, j - 1, k))).real();
+                    gx += w * (c * std::conj(dx)).real();
+                    gy += w * (c * std::conj(dy)).real();
+                }
+            }
+            potential[i] += phi;
+            field[i] = field[i] - Vector3<double>{gx, gy, gz};
+        }
+    }
+
+private:
+
+    /**
+     * @brief The rotation for direction d, from a thread local cache.
+     *
+     * Computing a rotation costs several times the translation itself, but
+     * tree cells sit on a grid, so M2L directions repeat: a few thousand
+     * distinct ones serve millions of translations. Directions are keyed
+     * to 2^-48 and each rotation is built from its key (not from whichever
+     * d came first), so results do not depend on the order of calls; the
+     * cache is dropped when it reaches ROTATION_CACHE_LIMIT entries.
+     */
+    const SphericalRotation &rotation(const Vector3<double> &d) const {
+        struct Key {
+            int64_t x, y, z;
+            size_t p;
+
+            bool operator==(const Key &) const = default;
+        };
+        struct Hash {
+            size_t operator()(const Key &k) const {
+                uint64_t h = uint64_t(k.x) * 0x9e3779b97f4a7c15ull;
+                h = (h ^ uint64_t(k.y)) * 0xff51afd7ed558ccdull;
+                h = (h ^ uint64_t(k.z)) * 0xc4ceb9fe1a85ec53ull;
+                return size_t(h ^ (h >> 29) ^ k.p);
+            }
+        };
+        thread_local std::unordered_map<Key, SphericalRotation, Hash> cache;
+
+        const double scale = std::ldexp(1.0, 48) / std::sqrt(inner(d, d));
+        Key key{std::llround(d.x * scale), std::llround(d.y * scale), std::llround(d.z * scale), _p};
+        auto it = cache.find(key);
+        if (it == cache.end()) {
+            if (cache.size() >= ROTATION_CACHE_LIMIT) cache.clear();
+            // Built from the key, so every thread has the same rotation.
+            Vector3<double> direction{double(key.x), double(key.y), double(key.z)};
+            it = cache.emplace(key, SphericalRotation(_p, direction)).first;
+        }
+        return it->second;
+    }
+
+    static constexpr size_t ROTATION_CACHE_LIMIT = 4096;
+
+    /**
+     * @brief Adds L_jk = (-1)^j sum_nq M_nq I_{n+j,q+k}, given the irregular
+     *        harmonics in (to degree 2p).
+     */
+    void convolve(const Complex *m, const Complex *in, Complex *l) const {
+        for (int j = 0; j <= int(_p); ++j) {
+            double sign = (j & 1) ? -1.0 : 1.0;
+            for (int k = 0; k <= j; ++k) {
+                Complex acc = 0.0;
+                for (int n = 0; n <= int(_p); ++n) {
+                    for (int q = -n; q <= n; ++q) acc += sh_get(m, n, q) * sh_get(in, n + j, q + k);
+                }
+                l[sh_index(j, k)] += sign * acc;
+            }
+        }
+    }
+
+    /**
+     * @brief Thread local scratch buffer `slot` of at least n coefficients.
+     */
+    static Complex *scratch(size_t slot, size_t n) {
+        thread_local std::vector<Complex> buffers[2];
+        if (buffers[slot].size() < n) buffers[slot].resize(n);
+        return buffers[slot].data();
+    }
+
+    size_t _p;
+    bool _rotate;
+    std::vector<double> _fact;
+};
+
+#endif //FMM_FMM_SPHERICAL_HPP
@@ -0,0 +1,141 @@
+/**
+ * @file hilbert.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief 63-bit Hilbert curve keys and Hilbert ordering of particles.
+ */
+
+#ifndef FMM_HILBERT_HPP
+#define FMM_HILBERT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "parallel.hpp"
+#include "permutation.hpp"
+#include "radix_sort.hpp"
+
+// ######################################################################### //
+// # Keys.                                                                 # //
+// ######################################################################### //
+
+/**
+ * @brief The Hilbert key of a grid cell on the 2^21 grid.
+ *
+ * The cell is converted to the "transposed" Hilbert index with Skilling's
+ * algorithm (AIP Conf. Proc. 707, 381 (2004)), whose bits are then
+ * interleaved, most significant from x, into a 63-bit key. Cells with
+ * consecutive keys are face neighbours.
+ */
+inline uint64_t hilbert_encode(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t X[3] = {x, y, z};
+    const uint32_t m = uint32_t{1} << (MORTON_BITS - 1);
+
+    for (uint32_t q = m; q > 1; q >>= 1) {
+        uint32_t p = q - 1;
+        for (uint32_t &xi: X) {
+            if (xi & q) {
+                X[0] ^= p;
+            } else {
+                uint32_t t = (X[0] ^ xi) & p;
+                X[0] ^= t;
+                xi ^= t;
+            }
+        }
+    }
+
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    uint32_t t = 0;
+    for (uint32_t q = m; q > 1; q >>= 1) {
+        if (X[2] & q) t ^= q - 1;
+    }
+    for (uint32_t &xi: X) xi ^= t;
+
+    return morton_encode(X[2], X[1], X[0]);
+}
+
+/**
+ * @brief The grid cell of a Hilbert key (the inverse of hilbert_encode).
+ */
+inline void hilbert_decode(uint64_t key, uint32_t &x, uint32_t &y, uint32_t &z) {
+    uint32_t X[3];
+    morton_decode(key, X[2], X[1], X[0]);
+
+    uint32_t t = X[2] >> 1;
+    X[2] ^= X[1];
+    X[1] ^= X[0];
+    X[0] ^= t;
+
+    for (uint32_t q = 2; q != MORTON_CELLS; q <<= 1) {
+        uint32_t p = q - 1;
+        for (int i = 2; i >= 0; --i) {
+            if (X[i] & q) {
+                X[0] ^= p;
+            } else {
+                t = (X[0] ^ X[i]) & p;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    x = X[0];
+    y = X[1];
+    z = X[2];
+}
+
+/**
+ * @brief The Hilbert key of a point in a bounding cube.
+ */
+template <typename T>
+inline uint64_t hilbert_key(const BoundingCube<T> &cube, const Vector3<T> &p) {
+    uint32_t x, y, z;
+    morton_cell(cube, p, x, y, z);
+    return hilbert_encode(x, y, z);
+}
+
+// ######################################################################### //
+// # Reordering.                                                           # //
+// ######################################################################### //
+
+/**
+ * @brief The permutation that sorts points along the Hilbert curve through
+ *        their bounding cube.
+ *
+ * Apply it to the positions and every per-particle attribute array before
+ * building trees or neighbour lists, and use Permutation::scatter (or
+ * unapply) to return results in the input order:
+ *
+ * @code
+ * Permutation order = hilbert_permutation<double>(positions);
+ * order.apply(positions, charges, velocities);
+ * // ... compute potentials in Hilbert order ...
+ * order.unapply(potentials);
+ * @endcode
+ */
+template <typename T>
+Permutation hilbert_permutation(std::span<const Vector3<T>> points,
+                                ThreadPool &pool = ThreadPool::global()) {
+    const size_t n = points.size();
+    BoundingCube<T> cube = bounding_cube(points, pool);
+
+    std::vector<uint64_t> keys(n);
+    std::vector<uint32_t> order(n);
+    parallel_for(0, n, 1 << 12, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            keys[i] = hilbert_key(cube, points[i]);
+            order[i] = static_cast<uint32_t>(i);
+        }
+    }, pool);
+    radix_sort(keys, order, 3 * MORTON_BITS, pool);
+
+    return Permutation(std::move(order), pool);
+}
+
+#endif //FMM_HILBERT_HPP
@@ -0,0 +1,532 @@
+/**
+ * @file interval.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Interval arithmetic with directed rounding, usable with the
+ *        linalg.hpp templates, and SIMD batch kernels for certified bounds.
+ *
+ * The floating point implementation works in upward rounding only: an upper
+ * bound is fl_up(a op b) and a lower bound is -fl_up((-a) op' b), so a single
+ * rounding mode switch serves both bounds. Translation units using Interval
+ * of a built-in floating type should be compiled with -frounding-math; the
+ * kernels additionally pass every rounded value through an optimisation
+ * barrier so that the negations cannot be folded away.
+ */
+
+#ifndef FMM_INTERVAL_HPP
+#define FMM_INTERVAL_HPP
+
+#include <cfenv>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "linalg.hpp"
+
+// ######################################################################### //
+// # Rounding control.                                                     # //
+// ######################################################################### //
+
+/**
+ * @brief Switches the floating point environment to upward rounding for the
+ *        lifetime of the object (if it is not already), then restores it.
+ */
+class UpwardRounding {
+public:
+    UpwardRounding() : _saved(std::fegetround()) {
+        if (_saved != FE_UPWARD) std::fesetround(FE_UPWARD);
+    }
+
+    UpwardRounding(const UpwardRounding &) = delete;
+    UpwardRounding &operator=(const UpwardRounding &) = delete;
+
+    ~UpwardRounding() {
+        if (_saved != FE_UPWARD) std::fesetround(_saved);
+    }
+
+private:
+    int _saved;
+};
+
+/**
+ * @brief An optimisation barrier: returns its argument, but the compiler can
+ *        neither constant fold through it nor move it across a rounding mode
+ *        change.
+ */
+template <typename T>
+inline T opaque(T v) {
+#if defined(__GNUC__)
+    if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+        asm volatile("" : "+x"(v) : : "memory");
+    } else {
+        asm volatile("" : "+m"(v) : : "memory");
+    }
+#endif
+    return v;
+}
+
+// ######################################################################### //
+// # Directed rounding primitives.                                         # //
+// ######################################################################### //
+
+/**
+ * @brief Directed rounding primitives for an interval bound type.
+ *
+ * A specialisation provides `Scope` (an RAII object establishing whatever
+ * state the primitives need), `add_down`, `add_up`, `sub_down`, `sub_up`,
+ * `mul_down`, `mul_up`, `div_down`, `div_up`, `sqrt_down`, `sqrt_up`, and
+ * `from_down`, `from_up` (outward rounded conversion from a double).
+ *
+ * @tparam T the bound type.
+ */
+template <typename T, typename Enable = void>
+struct IntervalRounding;
+
+/**
+ * @brief Directed rounding for the built-in floating point types, using
+ *        upward rounding and negation for the lower bounds.
+ */
+template <typename T>
+struct IntervalRounding<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+
+    using Scope = UpwardRounding;
+
+    static T add_up(T a, T b) { return opaque(opaque(a) + b); }
+    static T add_down(T a, T b) { return -opaque(opaque(-a) - b); }
+    static T sub_up(T a, T b) { return opaque(opaque(a) - b); }
+    static T sub_down(T a, T b) { return -opaque(opaque(b) - a); }
+    static T mul_up(T a, T b) { return opaque(opaque(a) * b); }
+    static T mul_down(T a, T b) { return -opaque(opaque(-a) * b); }
+    static T div_up(T a, T b) { return opaque(opaque(a) / b); }
+    static T div_down(T a, T b) { return -opaque(opaque(-a) / b); }
+
+    static T sqrt_up(T a) { return opaque(std::sqrt(opaque(a))); }
+
+    static T sqrt_down(T a) {
+        // sqrt rounded up, stepped down one ulp unless it squares to <= a.
+        T s = sqrt_up(a);
+        if (mul_up(s, s) > a) s = std::nextafter(s, T(0));
+        return s;
+    }
+
+    static T from_up(double x) {
+        T r = static_cast<T>(x);
+        if (static_cast<long double>(r) < static_cast<long double>(x)) {
+            r = std::nextafter(r, std::numeric_limits<T>::infinity());
+        }
+        return r;
+    }
+
+    static T from_down(double x) {
+        T r = static_cast<T>(x);
+        if (static_cast<long double>(r) > static_cast<long double>(x)) {
+            r = std::nextafter(r, -std::numeric_limits<T>::infinity());
+        }
+        return r;
+    }
+
+    static T infinity() { return std::numeric_limits<T>::infinity(); }
+};
+
+// ######################################################################### //
+// # Interval.                                                             # //
+// ######################################################################### //
+
+/**
+ * @brief A closed interval [lo, hi] that is guaranteed to enclose the exact
+ *        result of the operations applied to it.
+ *
+ * @tparam T the bound type (float, double, long double, or MpReal with
+ *           mpinterval.hpp).
+ */
+template <typename T>
+struct Interval {
+    T lo; /**< The lower bound. */
+    T hi; /**< The upper bound. */
+
+    Interval() : lo(0.0), hi(0.0) {}
+
+    /**
+     * @brief A degenerate interval [x, x].
+     */
+    Interval(const T &x) : lo(x), hi(x) {}
+
+    /**
+     * @brief An interval enclosing a double (outward rounded if T is
+     *        narrower than double).
+     */
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U> && !std::is_same_v<U, T>>>
+    Interval(U x) : lo(IntervalRounding<T>::from_down(static_cast<double>(x))),
+                    hi(IntervalRounding<T>::from_up(static_cast<double>(x))) {}
+
+    /**
+     * @brief The interval [l, h].
+     */
+    Interval(const T &l, const T &h) : lo(l), hi(h) {}
+};
+
+// ######################################################################### //
+// # Arithmetic operators.                                                 # //
+// ######################################################################### //
+
+/**
+ * @brief Adds two Interval instances.
+ */
+template <typename T>
+Interval<T> operator+(const Interval<T> &a, const Interval<T> &b) {
+    using R = IntervalRounding<T>;
+    [[maybe_unused]] typename R::Scope scope;
+    return {R::add_down(a.lo, b.lo), R::add_up(a.hi, b.hi)};
+}
+
+/**
+ * @brief Subtracts two Interval instances.
+ */
+template <typename T>
+Interval<T> operator-(const Interval<T> &a, const Interval<T> &b) {
+    using R = IntervalRounding<T>;
+    [[maybe_unused]] typename R::Scope scope;
+    return {R::sub_down(a.lo, b.hi), R::sub_up(a.hi, b.lo)};
+}
+
+/**
+ * @brief Negates an Interval instance.
+ */
+template <typename T>
+Interval<T> operator-(const Interval<T> &a) {
+    return {-a.hi, -a.lo};
+}
+
+/**
+ * @brief Multiplies two Interval instances (the bounds are the extreme
+ *        directed-rounded products of the four endpoint pairs).
+ */
+template <typename T>
+Interval<T> operator*(const Interval<T> &a, const Interval<T> &b) {
+    using R = IntervalRounding<T>;
+    [[maybe_unused]] typename R::Scope scope;
+    T lo = R::mul_down(a.lo, b.lo);
+    T hi = R::mul_up(a.lo, b.lo);
+    const T *pairs[3][2] = {{&a.lo, &b.hi}, {&a.hi, &b.lo}, {&a.hi, &b.hi}};
+    for (auto &p: pairs) {
+        T d = R::mul_down(*p[0], *p[1]);
+        T u = R::mul_up(*p[0], *p[1]);
+        if (d < lo) lo = d;
+        if (u > hi) hi = u;
+    }
+    return {lo, hi};
+}
+
+/**
+ * @brief Divides two Interval instances; division by an interval containing
+ *        zero gives the whole real line.
+ */
+template <typename T>
+Interval<T> operator/(const Interval<T> &a, const Interval<T> &b) {
+    using R = IntervalRounding<T>;
+    if (!(b.lo > T(0.0) || b.hi < T(0.0))) return {-R::infinity(), R::infinity()};
+    [[maybe_unused]] typename R::Scope scope;
+    T lo = R::div_down(a.lo, b.lo);
+    T hi = R::div_up(a.lo, b.lo);
+    const T *pairs[3][2] = {{&a.lo, &b.hi}, {&a.hi, &b.lo}, {&a.hi, &b.hi}};
+    for (auto &p: pairs) {
+        T d = R::div_down(*p[0], *p[1]);
+        T u = R::div_up(*p[0], *p[1]);
+        if (d < lo) lo = d;
+        if (u > hi) hi = u;
+    }
+    return {lo, hi};
+}
+
+template <typename T> Interval<T> &operator+=(Interval<T> &a, const Interval<T> &b) { return a = a + b; }
+template <typename T> Interval<T> &operator-=(Interval<T> &a, const Interval<T> &b) { return a = a - b; }
+template <typename T> Interval<T> &operator*=(Interval<T> &a, const Interval<T> &b) { return a = a * b; }
+template <typename T> Interval<T> &operator/=(Interval<T> &a, const Interval<T> &b) { return a = a / b; }
+
+// ######################################################################### //
+// # Functions.                                                            # //
+// ######################################################################### //
+
+/**
+ * @brief The square root of an Interval instance (negative parts clipped).
+ */
+template <typename T>
+Interval<T> sqrt(const Interval<T> &a) {
+    using R = IntervalRounding<T>;
+    [[maybe_unused]] typename R::Scope scope;
+    T zero(0.0);
+    T lo = a.lo > zero ? R::sqrt_down(a.lo) : zero;
+    T hi = a.hi > zero ? R::sqrt_up(a.hi) : zero;
+    return {lo, hi};
+}
+
+/**
+ * @brief The width hi - lo (rounded up).
+ */
+template <typename T>
+T width(const Interval<T> &a) {
+    using R = IntervalRounding<T>;
+    [[maybe_unused]] typename R::Scope scope;
+    return R::sub_up(a.hi, a.lo);
+}
+
+/**
+ * @brief Whether x lies in the interval.
+ */
+template <typename T>
+bool contains(const Interval<T> &a, const T &x) {
+    return a.lo <= x && x <= a.hi;
+}
+
+/**
+ * @brief Whether every value in the interval is > 0.
+ */
+template <typename T>
+bool certainly_positive(const Interval<T> &a) { return a.lo > T(0.0); }
+
+/**
+ * @brief Whether every value in the interval is < 0.
+ */
+template <typename T>
+bool certainly_negative(const Interval<T> &a) { return a.hi < T(0.0); }
+
+/**
+ * @brief Whether the interval contains zero.
+ */
+template <typename T>
+bool possibly_zero(const Interval<T> &a) { return a.lo <= T(0.0) && T(0.0) <= a.hi; }
+
+/**
+ * @brief Writes an Interval instance to a stream.
+ */
+template <typename T>
+std::ostream &operator<<(std::ostream &os, const Interval<T> &a) {
+    return os << "[" << a.lo << ", " << a.hi << "]";
+}
+
+// ######################################################################### //
+// # SIMD batch kernels.                                                   # //
+// ######################################################################### //
+
+#if defined(__SSE2__)
+
+/**
+ * @brief One Interval<double> in an SSE register as (-lo, hi).
+ *
+ * With upward rounding in effect a single vector operation yields both the
+ * upper bound and the negated lower bound. Only valid inside an
+ * UpwardRounding scope; used by the batch kernels through the generic
+ * linalg.hpp templates.
+ */
+struct IntervalSse {
+    __m128d v; /**< (-lo, hi). */
+
+    static IntervalSse load(const Interval<double> &a) {
+        return {_mm_xor_pd(_mm_loadu_pd(&a.lo), _mm_set_pd(0.0, -0.0))};
+    }
+
+    void store(Interval<double> &a) const {
+        _mm_storeu_pd(&a.lo, _mm_xor_pd(v, _mm_set_pd(0.0, -0.0)));
+    }
+};
+
+inline IntervalSse operator+(IntervalSse a, IntervalSse b) {
+    return {_mm_add_pd(a.v, b.v)};
+}
+
+inline IntervalSse operator-(IntervalSse a) {
+    return {_mm_shuffle_pd(a.v, a.v, 1)};
+}
+
+inline IntervalSse operator-(IntervalSse a, IntervalSse b) {
+    return {_mm_add_pd(a.v, _mm_shuffle_pd(b.v, b.v, 1))};
+}
+
+inline IntervalSse operator*(IntervalSse a, IntervalSse b) {
+    // a = (-al, ah), b = (-bl, bh); each m holds (-(lower candidate), upper
+    // candidate), and the result is their lane-wise maximum.
+    const __m128d neg_lo = _mm_set_pd(0.0, -0.0);
+    const __m128d neg_hi = _mm_set_pd(-0.0, 0.0);
+    __m128d a0 = _mm_unpacklo_pd(a.v, a.v);
+    __m128d a1 = _mm_unpackhi_pd(a.v, a.v);
+    __m128d b0 = _mm_unpacklo_pd(b.v, b.v);
+    __m128d b1 = _mm_unpackhi_pd(b.v, b.v);
+    __m128d m1 = _mm_mul_pd(a.v, _mm_xor_pd(b.v, neg_lo));
+    __m128d m2 = _mm_mul_pd(a0, _mm_shuffle_pd(b.v, b.v, 1));
+    __m128d m3 = _mm_mul_pd(a1, _mm_xor_pd(b0, neg_hi));
+    __m128d m4 = _mm_mul_pd(_mm_xor_pd(b1, _mm_set1_pd(-0.0)), _mm_shuffle_pd(a.v, a.v, 1));
+    return {_mm_max_pd(_mm_max_pd(m1, m2), _mm_max_pd(m3, m4))};
+}
+
+#endif
+
+#if defined(__AVX__)
+
+/**
+ * @brief Two Interval<double> in an AVX register as (-lo0, hi0, -lo1, hi1).
+ */
+struct IntervalAvx {
+    __m256d v; /**< (-lo0, hi0, -lo1, hi1). */
+
+    static IntervalAvx load(const Interval<double> &a, const Interval<double> &b) {
+        __m256d x = _mm256_set_m128d(_mm_loadu_pd(&b.lo), _mm_loadu_pd(&a.lo));
+        return {_mm256_xor_pd(x, _mm256_set_pd(0.0, -0.0, 0.0, -0.0))};
+    }
+
+    void store(Interval<double> &a, Interval<double> &b) const {
+        __m256d x = _mm256_xor_pd(v, _mm256_set_pd(0.0, -0.0, 0.0, -0.0));
+        _mm_storeu_pd(&a.lo, _mm256_castpd256_pd128(x));
+        _mm_storeu_pd(&b.lo, _mm256_extractf128_pd(x, 1));
+    }
+};
+
+inline IntervalAvx operator+(IntervalAvx a, IntervalAvx b) {
+    return {_mm256_add_pd(a.v, b.v)};
+}
+
+inline IntervalAvx operator-(IntervalAvx a) {
+    return {_mm256_permute_pd(a.v, 0b0101)};
+}
+
+inline IntervalAvx operator-(IntervalAvx a, IntervalAvx b) {
+    return {_mm256_add_pd(a.v, _mm256_permute_pd(b.v, 0b0101))};
+}
+
+inline IntervalAvx operator*(IntervalAvx a, IntervalAvx b) {
+    const __m256d neg_lo = _mm256_set_pd(0.0, -0.0, 0.0, -0.0);
+    const __m256d neg_hi = _mm256_set_pd(-0.0, 0.0, -0.0, 0.0);
+    __m256d a0 = _mm256_movedup_pd(a.v);
+    __m256d a1 = _mm256_permute_pd(a.v, 0b1111);
+    __m256d b0 = _mm256_movedup_pd(b.v);
+    __m256d b1 = _mm256_permute_pd(b.v, 0b1111);
+    __m256d m1 = _mm256_mul_pd(a.v, _mm256_xor_pd(b.v, neg_lo));
+    __m256d m2 = _mm256_mul_pd(a0, _mm256_permute_pd(b.v, 0b0101));
+    __m256d m3 = _mm256_mul_pd(a1, _mm256_xor_pd(b0, neg_hi));
+    __m256d m4 = _mm256_mul_pd(_mm256_xor_pd(b1, _mm256_set1_pd(-0.0)), _mm256_permute_pd(a.v, 0b0101));
+    return {_mm256_max_pd(_mm256_max_pd(m1, m2), _mm256_max_pd(m3, m4))};
+}
+
+#endif
+
+namespace detail {
+
+inline void interval_check_sizes(size_t r, size_t a, size_t b) {
+    if (r != a || r != b) throw std::invalid_argument("interval batch size mismatch");
+}
+
+#if defined(__SSE2__)
+
+inline Vector3<IntervalSse> load_sse(const Vector3<Interval<double>> &a) {
+    return {IntervalSse::load(a.x), IntervalSse::load(a.y), IntervalSse::load(a.z)};
+}
+
+inline Matrix3x3<IntervalSse> load_sse(const Matrix3x3<Interval<double>> &a) {
+    Matrix3x3<IntervalSse> r;
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 3; ++j) r.m[i][j] = IntervalSse::load(a.m[i][j]);
+    return r;
+}
+
+#endif
+
+#if defined(__AVX__)
+
+inline Vector3<IntervalAvx> load_avx(const Vector3<Interval<double>> &a, const Vector3<Interval<double>> &b) {
+    return {IntervalAvx::load(a.x, b.x), IntervalAvx::load(a.y, b.y), IntervalAvx::load(a.z, b.z)};
+}
+
+inline Matrix3x3<IntervalAvx> load_avx(const Matrix3x3<Interval<double>> &a, const Matrix3x3<Interval<double>> &b) {
+    Matrix3x3<IntervalAvx> r;
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 3; ++j) r.m[i][j] = IntervalAvx::load(a.m[i][j], b.m[i][j]);
+    return r;
+}
+
+#endif
+
+} // namespace detail
+
+/**
+ * @brief Certified inner products r[i] ⊇ <a[i], b[i]>.
+ *
+ * Uses two intervals per AVX register (or one per SSE register) with both
+ * bounds of each interval computed by the same instruction; falls back to the
+ * scalar Interval operators when neither is available.
+ */
+inline void interval_batch_inner(std::span<Interval<double>> r,
+                                 std::span<const Vector3<Interval<double>>> a,
+                                 std::span<const Vector3<Interval<double>>> b) {
+    detail::interval_check_sizes(r.size(), a.size(), b.size());
+    UpwardRounding scope;
+    size_t i = 0;
+#if defined(__AVX__)
+    for (; i + 2 <= r.size(); i += 2) {
+        IntervalAvx d = inner(detail::load_avx(a[i], a[i + 1]), detail::load_avx(b[i], b[i + 1]));
+        d.store(r[i], r[i + 1]);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i < r.size(); ++i) {
+        inner(detail::load_sse(a[i]), detail::load_sse(b[i])).store(r[i]);
+    }
+#endif
+    for (; i < r.size(); ++i) r[i] = inner(a[i], b[i]);
+}
+
+/**
+ * @brief Certified cross products r[i] ⊇ a[i] x b[i].
+ */
+inline void interval_batch_cross(std::span<Vector3<Interval<double>>> r,
+                                 std::span<const Vector3<Interval<double>>> a,
+                                 std::span<const Vector3<Interval<double>>> b) {
+    detail::interval_check_sizes(r.size(), a.size(), b.size());
+    UpwardRounding scope;
+    size_t i = 0;
+#if defined(__AVX__)
+    for (; i + 2 <= r.size(); i += 2) {
+        Vector3<IntervalAvx> c = cross(detail::load_avx(a[i], a[i + 1]), detail::load_avx(b[i], b[i + 1]));
+        c.x.store(r[i].x, r[i + 1].x);
+        c.y.store(r[i].y, r[i + 1].y);
+        c.z.store(r[i].z, r[i + 1].z);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i < r.size(); ++i) {
+        Vector3<IntervalSse> c = cross(detail::load_sse(a[i]), detail::load_sse(b[i]));
+        c.x.store(r[i].x);
+        c.y.store(r[i].y);
+        c.z.store(r[i].z);
+    }
+#endif
+    for (; i < r.size(); ++i) r[i] = cross(a[i], b[i]);
+}
+
+/**
+ * @brief Certified determinants r[i] ⊇ det(a[i]).
+ */
+inline void interval_batch_det(std::span<Interval<double>> r,
+                               std::span<const Matrix3x3<Interval<double>>> a) {
+    detail::interval_check_sizes(r.size(), a.size(), a.size());
+    UpwardRounding scope;
+    size_t i = 0;
+#if defined(__AVX__)
+    for (; i + 2 <= r.size(); i += 2) {
+        det(detail::load_avx(a[i], a[i + 1])).store(r[i], r[i + 1]);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i < r.size(); ++i) {
+        det(detail::load_sse(a[i])).store(r[i]);
+    }
+#endif
+    for (; i < r.size(); ++i) r[i] = det(a[i]);
+}
+
+#endif //FMM_INTERVAL_HPP
@@ -0,0 +1,702 @@
+/**
+ * @file krylov.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Preconditioned Krylov solvers (CG, BiCGStab and restarted GMRES)
+ *        for CSR and BSR matrices, with Jacobi, 3 x 3 block Jacobi and
+ *        ILU(0) preconditioners.
+ *
+ * The solvers read the matrix only through spmv and the preconditioner only
+ * through `m.apply(r, z, pool)` (z = M^-1 r), so any matrix with an spmv
+ * overload and any such preconditioner will do.
+ *
+ * Each iteration is a few passes over vectors of n doubles, and for large
+ * systems these passes cost as much as the product, so dot products are
+ * fused with the vector updates that precede them: CG updates x and r and
+ * takes |r|^2 in one pass, and GMRES orthogonalises against all basis
+ * vectors with one pass computing every projection (classical Gram-Schmidt,
+ * done twice for stability) rather than one pass per vector. Reductions sum
+ * fixed blocks in a fixed order, so results do not depend on the number of
+ * threads.
+ */
+
+#ifndef FMM_KRYLOV_HPP
+#define FMM_KRYLOV_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "sparse.hpp"
+
+/**
+ * @brief Stopping criteria: the solvers stop when |b - A x| <= tolerance
+ *        |b| or after max_iterations iterations; GMRES restarts after
+ *        `restart` iterations.
+ */
+struct KrylovOptions {
+    double tolerance = 1.0e-8;
+    size_t max_iterations = 1000;
+    size_t restart = 30;
+};
+
+/**
+ * @brief Seconds spent in each phase of a solve: matrix products, the
+ *        preconditioner, vector updates with their (fused) reductions, and
+ *        the wall time `total`.
+ */
+struct KrylovTimings {
+    double matvec = 0.0;
+    double preconditioner = 0.0;
+    double vector = 0.0;
+    double total = 0.0;
+};
+
+/**
+ * @brief The outcome of a solve. `residual` and `history` are relative
+ *        residuals |b - A x| / |b|, as the solver tracks them (recursively
+ *        updated for CG and BiCGStab, recomputed at each restart by GMRES),
+ *        history[0] being that of the initial guess.
+ */
+struct KrylovStats {
+    bool converged = false;
+    size_t iterations = 0;
+    size_t matvecs = 0;
+    size_t preconditioner_applications = 0;
+    double residual = 0.0;
+    std::vector<double> history;
+    KrylovTimings timings;
+};
+
+// ######################################################################### //
+// # Preconditioners.                                                      # //
+// ######################################################################### //
+
+/**
+ * @brief No preconditioning: z = r.
+ */
+struct IdentityPreconditioner {
+    void apply(std::span<const double> r, std::span<double> z, ThreadPool &pool = ThreadPool::global()) const {
+        parallel_for(0, r.size(), 1 << 14, [&](size_t b, size_t e) {
+            std::copy(r.begin() + std::ptrdiff_t(b), r.begin() + std::ptrdiff_t(e), z.begin() + std::ptrdiff_t(b));
+        }, pool);
+    }
+};
+
+/**
+ * @brief Jacobi (diagonal) preconditioning: z_i = r_i / a_ii.
+ */
+class JacobiPreconditioner {
+public:
+
+    /**
+     * @throws std::invalid_argument if the matrix is not square or a
+     *         diagonal entry is zero (or missing).
+     */
+    template <typename Matrix>
+    explicit JacobiPreconditioner(const Matrix &a) : _inverse(a.rows()) {
+        if (a.rows() != a.cols()) throw std::invalid_argument("JacobiPreconditioner needs a square matrix");
+        for (size_t i = 0; i < a.rows(); ++i) {
+            double d = a(i, i);
+            if (d == 0.0) throw std::invalid_argument("JacobiPreconditioner zero diagonal entry");
+            _inverse[i] = 1.0 / d;
+        }
+    }
+
+    void apply(std::span<const double> r, std::span<double> z, ThreadPool &pool = ThreadPool::global()) const {
+        parallel_for(0, r.size(), 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) z[i] = _inverse[i] * r[i];
+        }, pool);
+    }
+
+private:
+
+    AlignedVector<double> _inverse;
+};
+
+/**
+ * @brief Block Jacobi preconditioning with the 3 x 3 diagonal blocks: z_i =
+ *        A_ii^-1 r_i for each triple of unknowns (one node of a vector
+ *        field), the inverses formed once as adj(A_ii) / det(A_ii).
+ */
+class BlockJacobiPreconditioner {
+public:
+
+    /**
+     * @throws std::invalid_argument if the matrix is not square with a
+     *         multiple of 3 rows, or a diagonal block is singular.
+     */
+    template <typename Matrix>
+    explicit BlockJacobiPreconditioner(const Matrix &a) : _inverse(a.rows() / 3) {
+        if (a.rows() != a.cols() || a.rows() % 3 != 0) {
+            throw std::invalid_argument("BlockJacobiPreconditioner needs a square matrix of 3 x 3 blocks");
+        }
+        for (size_t i = 0; i < _inverse.size(); ++i) {
+            Matrix3x3<double> block;
+            for (size_t p = 0; p < 3; ++p) {
+                for (size_t q = 0; q < 3; ++q) block.m[p][q] = a(3 * i + p, 3 * i + q);
+            }
+            double d = det(block);
+            if (d == 0.0 || !std::isfinite(d)) {
+                throw std::invalid_argument("BlockJacobiPreconditioner singular diagonal block");
+            }
+            _inverse[i] = adj(block) / d;
+        }
+    }
+
+    void apply(std::span<const double> r, std::span<double> z, ThreadPool &pool = ThreadPool::global()) const {
+        parallel_for(0, _inverse.size(), 1 << 12, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                const double (&m)[3][3] = _inverse[i].m;
+                const double r0 = r[3 * i], r1 = r[3 * i + 1], r2 = r[3 * i + 2];
+                z[3 * i] = m[0][0] * r0 + m[0][1] * r1 + m[0][2] * r2;
+                z[3 * i + 1] = m[1][0] * r0 + m[1][1] * r1 + m[1][2] * r2;
+                z[3 * i + 2] = m[2][0] * r0 + m[2][1] * r1 + m[2][2] * r2;
+            }
+        }, pool);
+    }
+
+private:
+
+    AlignedVector<Matrix3x3<double>> _inverse;
+};
+
+/**
+ * @brief Incomplete LU factorisation without fill, ILU(0): L U agrees with
+ *        A on the pattern of A, L unit lower and U upper triangular, both
+ *        stored in one copy of A's pattern.
+ *
+ * The triangular solves are serial (each unknown depends on the previous
+ * ones), so on many threads this is the preconditioner to use when its
+ * lower iteration count outweighs that.
+ */
+class Ilu0Preconditioner {
+public:
+
+    /**
+     * @throws std::invalid_argument if the matrix is not square, a diagonal
+     *         entry is missing from the pattern, or a pivot is zero.
+     */
+    explicit Ilu0Preconditioner(const CsrMatrix &a) : _lu(a), _diagonal(a.rows()) {
+        if (a.rows() != a.cols()) throw std::invalid_argument("Ilu0Preconditioner needs a square matrix");
+        const size_t n = a.rows();
+        auto ptr = _lu.row_ptr();
+        auto col = _lu.col_idx();
+        std::span<double> lu = _lu.values();
+        for (size_t i = 0; i < n; ++i) {
+            _diagonal[i] = _lu.find(i, i);
+            if (_diagonal[i] == CsrMatrix::npos) throw std::invalid_argument("Ilu0Preconditioner missing diagonal");
+        }
+
+        // Row i: for each k < i in the row, l_ik = a_ik / u_kk and row k's
+        // upper part, where it meets row i's pattern, is subtracted.
+        std::vector<size_t> position(n, CsrMatrix::npos);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t p = ptr[i]; p < ptr[i + 1]; ++p) position[col[p]] = p;
+            for (size_t p = ptr[i]; p < _diagonal[i]; ++p) {
+                const size_t k = col[p];
+                const double pivot = lu[_diagonal[k]];
+                if (pivot == 0.0) throw std::invalid_argument("Ilu0Preconditioner zero pivot");
+                lu[p] /= pivot;
+                for (size_t q = _diagonal[k] + 1; q < ptr[k + 1]; ++q) {
+                    if (position[col[q]] != CsrMatrix::npos) lu[position[col[q]]] -= lu[p] * lu[q];
+                }
+            }
+            for (size_t p = ptr[i]; p < ptr[i + 1]; ++p) position[col[p]] = CsrMatrix::npos;
+            if (lu[_diagonal[i]] == 0.0) throw std::invalid_argument("Ilu0Preconditioner zero pivot");
+        }
+    }
+
+    void apply(std::span<const double> r, std::span<double> z, ThreadPool & = ThreadPool::global()) const {
+        const size_t n = _lu.rows();
+        auto ptr = _lu.row_ptr();
+        auto col = _lu.col_idx();
+        auto lu = _lu.values();
+        for (size_t i = 0; i < n; ++i) {
+            double sum = r[i];
+            for (size_t p = ptr[i]; p < _diagonal[i]; ++p) sum -= lu[p] * z[col[p]];
+            z[i] = sum;
+        }
+        for (size_t i = n; i-- > 0;) {
+            double sum = z[i];
+            for (size_t p = _diagonal[i] + 1; p < ptr[i + 1]; ++p) sum -= lu[p] * z[col[p]];
+            z[i] = sum / lu[_diagonal[i]];
+        }
+    }
+
+    /**
+     * @brief The factors: L strictly below the diagonal (unit diagonal
+     *        implied), U on and above it.
+     */
+    [[nodiscard]] const CsrMatrix &factors() const { return _lu; }
+
+private:
+
+    CsrMatrix _lu;
+    std::vector<size_t> _diagonal;
+};
+
+namespace detail {
+
+// ######################################################################### //
+// # Vector kernels.                                                       # //
+// ######################################################################### //
+
+/**
+ * @brief The entries per reduction block: a block of a few vectors stays in
+ *        L1 while it is reduced.
+ */
+inline constexpr size_t KRYLOV_BLOCK = 2048;
+
+using KrylovClock = std::chrono::steady_clock;
+
+inline double krylov_seconds_since(KrylovClock::time_point start) {
+    return std::chrono::duration<double>(KrylovClock::now() - start).count();
+}
+
+/**
+ * @brief Calls f(first, last, acc) for fixed blocks of [0, n) in parallel,
+ *        each adding `count` sums into its own acc, and returns the sums of
+ *        the blocks' sums added in block order.
+ */
+template <typename F>
+inline std::vector<double> blocked_sums(size_t n, size_t count, ThreadPool &pool, F &&f) {
+    const size_t blocks = (n + KRYLOV_BLOCK - 1) / KRYLOV_BLOCK;
+    std::vector<double> partial(blocks * count, 0.0), sums(count, 0.0);
+    parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+        for (size_t b = lo; b < hi; ++b) {
+            f(b * KRYLOV_BLOCK, std::min(n, (b + 1) * KRYLOV_BLOCK), partial.data() + b * count);
+        }
+    }, pool);
+    for (size_t b = 0; b < blocks; ++b) {
+        for (size_t c = 0; c < count; ++c) sums[c] += partial[b * count + c];
+    }
+    return sums;
+}
+
+inline double dot(std::span<const double> a, std::span<const double> b, ThreadPool &pool) {
+    return blocked_sums(a.size(), 1, pool, [&](size_t first, size_t last, double *acc) {
+        double sum = 0.0;
+        for (size_t i = first; i < last; ++i) sum += a[i] * b[i];
+        acc[0] = sum;
+    })[0];
+}
+
+/**
+ * @brief Times a phase into a timing slot.
+ */
+template <typename F>
+inline void timed(double &slot, F &&f) {
+    auto start = KrylovClock::now();
+    f();
+    slot += krylov_seconds_since(start);
+}
+
+/**
+ * @brief Checks the sizes and starts the statistics; returns |b|.
+ */
+template <typename Matrix>
+inline double krylov_start(const Matrix &a, std::span<const double> b, std::span<double> x, KrylovStats &stats,
+                           ThreadPool &pool) {
+    if (a.rows() != a.cols() || b.size() != a.rows() || x.size() != a.cols()) {
+        throw std::invalid_argument("Krylov solver size mismatch");
+    }
+    double norm = 0.0;
+    timed(stats.timings.vector, [&]() { norm = std::sqrt(dot(b, b, pool)); });
+    return norm;
+}
+
+/**
+ * @brief r = b - A x; returns |r|^2.
+ */
+template <typename Matrix>
+inline double residual(const Matrix &a, std::span<const double> b, std::span<const double> x, std::span<double> r,
+                       KrylovStats &stats, ThreadPool &pool) {
+    timed(stats.timings.matvec, [&]() { spmv(a, x, r, pool); });
+    ++stats.matvecs;
+    double rr = 0.0;
+    timed(stats.timings.vector, [&]() {
+        rr = blocked_sums(r.size(), 1, pool, [&](size_t first, size_t last, double *acc) {
+            double sum = 0.0;
+            for (size_t i = first; i < last; ++i) {
+                r[i] = b[i] - r[i];
+                sum += r[i] * r[i];
+            }
+            acc[0] = sum;
+        })[0];
+    });
+    return rr;
+}
+
+template <typename Preconditioner>
+inline void precondition(const Preconditioner &m, std::span<const double> r, std::span<double> z,
+                         KrylovStats &stats, ThreadPool &pool) {
+    timed(stats.timings.preconditioner, [&]() { m.apply(r, z, pool); });
+    ++stats.preconditioner_applications;
+}
+
+/**
+ * @brief Records an iteration's relative residual; returns whether it meets
+ *        the tolerance.
+ */
+inline bool record(KrylovStats &stats, double relative, const KrylovOptions &options) {
+    stats.history.push_back(relative);
+    stats.residual = relative;
+    stats.converged = relative <= options.tolerance;
+    return stats.converged;
+}
+
+/**
+ * @brief The zero right-hand side: x = 0 solves it exactly.
+ */
+inline void zero_solution(std::span<double> x, KrylovStats &stats) {
+    std::fill(x.begin(), x.end(), 0.0);
+    stats.history.push_back(0.0);
+    stats.converged = true;
+}
+
+} // namespace detail
+
+// ######################################################################### //
+// # Solvers.                                                              # //
+// ######################################################################### //
+
+/**
+ * @brief Preconditioned conjugate gradients for symmetric positive definite
+ *        A and M; x holds the initial guess and receives the solution.
+ *
+ * Stops early (not converged) if p^T A p is not positive, i.e. A is not
+ * positive definite.
+ *
+ * @throws std::invalid_argument if the sizes do not match.
+ */
+template <typename Matrix, typename Preconditioner>
+KrylovStats cg(const Matrix &a, std::span<const double> b, std::span<double> x, const Preconditioner &m,
+               const KrylovOptions &options = {}, ThreadPool &pool = ThreadPool::global()) {
+    using namespace detail;
+    auto start = KrylovClock::now();
+    KrylovStats stats;
+    const double bnorm = krylov_start(a, b, x, stats, pool);
+    if (bnorm == 0.0) {
+        zero_solution(x, stats);
+        return stats;
+    }
+
+    const size_t n = b.size();
+    AlignedVector<double> r(n), z(n), p(n), q(n);
+    double rr = residual(a, b, x, r, stats, pool);
+    if (!record(stats, std::sqrt(rr) / bnorm, options)) {
+        precondition(m, r, z, stats, pool);
+        double rz = 0.0;
+        timed(stats.timings.vector, [&]() {
+            rz = blocked_sums(n, 1, pool, [&](size_t first, size_t last, double *acc) {
+                double sum = 0.0;
+                for (size_t i = first; i < last; ++i) {
+                    p[i] = z[i];
+                    sum += r[i] * z[i];
+                }
+                acc[0] = sum;
+            })[0];
+        });
+
+        while (stats.iterations < options.max_iterations) {
+            timed(stats.timings.matvec, [&]() { spmv(a, std::span<const double>(p), q, pool); });
+            ++stats.matvecs;
+            double pq = 0.0;
+            timed(stats.timings.vector, [&]() { pq = dot(p, q, pool); });
+            if (!(pq > 0.0)) break;
+
+            // x += alpha p, r -= alpha q and |r|^2 in one pass.
+            const double alpha = rz / pq;
+            timed(stats.timings.vector, [&]() {
+                rr = blocked_sums(n, 1, pool, [&](size_t first, size_t last, double *acc) {
+                    double sum = 0.0;
+                    for (size_t i = first; i < last; ++i) {
+                        x[i] += alpha * p[i];
+                        r[i] -= alpha * q[i];
+                        sum += r[i] * r[i];
+                    }
+                    acc[0] = sum;
+                })[0];
+            });
+            ++stats.iterations;
+            if (record(stats, std::sqrt(rr) / bnorm, options)) break;
+
+            precondition(m, r, z, stats, pool);
+            double rz_next = 0.0;
+            timed(stats.timings.vector, [&]() {
+                rz_next = dot(r, z, pool);
+                const double beta = rz_next / rz;
+                parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) p[i] = z[i] + beta * p[i];
+                }, pool);
+            });
+            rz = rz_next;
+        }
+    }
+    stats.timings.total = krylov_seconds_since(start);
+    return stats;
+}
+
+/**
+ * @brief Right preconditioned BiCGStab for general (nonsymmetric) A; x
+ *        holds the initial guess and receives the solution.
+ *
+ * Stops early (not converged) on a breakdown, when rho or omega vanishes.
+ *
+ * @throws std::invalid_argument if the sizes do not match.
+ */
+template <typename Matrix, typename Preconditioner>
+KrylovStats bicgstab(const Matrix &a, std::span<const double> b, std::span<double> x, const Preconditioner &m,
+                     const KrylovOptions &options = {}, ThreadPool &pool = ThreadPool::global()) {
+    using namespace detail;
+    auto start = KrylovClock::now();
+    KrylovStats stats;
+    const double bnorm = krylov_start(a, b, x, stats, pool);
+    if (bnorm == 0.0) {
+        zero_solution(x, stats);
+        return stats;
+    }
+
+    const size_t n = b.size();
+    AlignedVector<double> r(n), r0(n), p(n, 0.0), v(n, 0.0), s(n), t(n), ph(n), sh(n);
+    double rr = residual(a, b, x, r, stats, pool);
+    timed(stats.timings.vector, [&]() { std::copy(r.begin(), r.end(), r0.begin()); });
+    double rho = rr, rho_previous = 1.0, alpha = 1.0, omega = 1.0;
+    if (!record(stats, std::sqrt(rr) / bnorm, options)) {
+        while (stats.iterations < options.max_iterations && rho != 0.0) {
+            const double beta = stats.iterations == 0 ? 0.0 : (rho / rho_previous) * (alpha / omega);
+            timed(stats.timings.vector, [&]() {
+                parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+                }, pool);
+            });
+            precondition(m, p, ph, stats, pool);
+            timed(stats.timings.matvec, [&]() { spmv(a, std::span<const double>(ph), v, pool); });
+            ++stats.matvecs;
+            double r0v = 0.0;
+            timed(stats.timings.vector, [&]() { r0v = dot(r0, v, pool); });
+            if (r0v == 0.0) break;
+            alpha = rho / r0v;
+
+            // s = r - alpha v and |s|^2 in one pass.
+            double ss = 0.0;
+            timed(stats.timings.vector, [&]() {
+                ss = blocked_sums(n, 1, pool, [&](size_t first, size_t last, double *acc) {
+                    double sum = 0.0;
+                    for (size_t i = first; i < last; ++i) {
+                        s[i] = r[i] - alpha * v[i];
+                        sum += s[i] * s[i];
+                    }
+                    acc[0] = sum;
+                })[0];
+            });
+            if (std::sqrt(ss) / bnorm <= options.tolerance) {
+                timed(stats.timings.vector, [&]() {
+                    parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                        for (size_t i = first; i < last; ++i) x[i] += alpha * ph[i];
+                    }, pool);
+                });
+                ++stats.iterations;
+                record(stats, std::sqrt(ss) / bnorm, options);
+                break;
+            }
+
+            precondition(m, s, sh, stats, pool);
+            timed(stats.timings.matvec, [&]() { spmv(a, std::span<const double>(sh), t, pool); });
+            ++stats.matvecs;
+            std::vector<double> ts_tt;
+            timed(stats.timings.vector, [&]() {
+                ts_tt = blocked_sums(n, 2, pool, [&](size_t first, size_t last, double *acc) {
+                    double ts = 0.0, tt = 0.0;
+                    for (size_t i = first; i < last; ++i) {
+                        ts += t[i] * s[i];
+                        tt += t[i] * t[i];
+                    }
+                    acc[0] = ts;
+                    acc[1] = tt;
+                });
+            });
+            if (ts_tt[1] == 0.0) break;
+            omega = ts_tt[0] / ts_tt[1];
+
+            // x += alpha ph + omega sh, r = s - omega t, |r|^2 and r0 . r in
+            // one pass.
+            std::vector<double> sums;
+            timed(stats.timings.vector, [&]() {
+                sums = blocked_sums(n, 2, pool, [&](size_t first, size_t last, double *acc) {
+                    double norm = 0.0, projection = 0.0;
+                    for (size_t i = first; i < last; ++i) {
+                        x[i] += alpha * ph[i] + omega * sh[i];
+                        r[i] = s[i] - omega * t[i];
+                        norm += r[i] * r[i];
+                        projection += r0[i] * r[i];
+                    }
+                    acc[0] = norm;
+                    acc[1] = projection;
+                });
+            });
+            ++stats.iterations;
+            if (record(stats, std::sqrt(sums[0]) / bnorm, options) || omega == 0.0) break;
+            rho_previous = rho;
+            rho = sums[1];
+        }
+    }
+    stats.timings.total = krylov_seconds_since(start);
+    return stats;
+}
+
+/**
+ * @brief Right preconditioned GMRES restarted every options.restart
+ *        iterations, for general A; x holds the initial guess and receives
+ *        the solution.
+ *
+ * With right preconditioning the residual GMRES minimises is the true one,
+ * so the convergence test needs no extra products. The Arnoldi basis is
+ * orthogonalised by classical Gram-Schmidt applied twice: each pass
+ * projects onto all basis vectors at once, reading the new vector once
+ * (and each basis vector once) instead of once per basis vector.
+ *
+ * @throws std::invalid_argument if the sizes do not match or restart is 0.
+ */
+template <typename Matrix, typename Preconditioner>
+KrylovStats gmres(const Matrix &a, std::span<const double> b, std::span<double> x, const Preconditioner &m,
+                  const KrylovOptions &options = {}, ThreadPool &pool = ThreadPool::global()) {
+    using namespace detail;
+    auto start = KrylovClock::now();
+    KrylovStats stats;
+    const double bnorm = krylov_start(a, b, x, stats, pool);
+    if (options.restart == 0) throw std::invalid_argument("gmres restart must be positive");
+    if (bnorm == 0.0) {
+        zero_solution(x, stats);
+        return stats;
+    }
+
+    const size_t n = b.size(), restart = options.restart;
+    AlignedVector<double> basis((restart + 1) * n), z(n), w(n);
+    auto v = [&](size_t j) { return std::span<double>(basis.data() + j * n, n); };
+    // The Hessenberg matrix, column j holding h[0..j+1][j], reduced to
+    // upper triangular by Givens rotations (cs, sn) as it is built; g is
+    // the rotated right-hand side |r| e_1.
+    std::vector<double> h((restart + 1) * restart), cs(restart), sn(restart), g(restart + 1), y(restart);
+    auto hessenberg = [&](size_t i, size_t j) -> double & { return h[j * (restart + 1) + i]; };
+
+    double rr = residual(a, b, x, v(0), stats, pool);
+    if (!record(stats, std::sqrt(rr) / bnorm, options)) {
+        while (stats.iterations < options.max_iterations) {
+            const double beta = std::sqrt(rr);
+            timed(stats.timings.vector, [&]() {
+                std::span<double> v0 = v(0);
+                parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) v0[i] /= beta;
+                }, pool);
+            });
+            std::fill(g.begin(), g.end(), 0.0);
+            g[0] = beta;
+
+            size_t k = 0;
+            bool done = false;
+            while (k < restart && stats.iterations < options.max_iterations && !done) {
+                const size_t j = k++;
+                precondition(m, v(j), z, stats, pool);
+                timed(stats.timings.matvec, [&]() { spmv(a, std::span<const double>(z), w, pool); });
+                ++stats.matvecs;
+
+                double norm = 0.0;
+                timed(stats.timings.vector, [&]() {
+                    for (size_t pass = 0; pass < 2; ++pass) {
+                        // Every projection v_l . w in one pass over w.
+                        std::vector<double> c = blocked_sums(n, j + 1, pool,
+                                                             [&](size_t first, size_t last, double *acc) {
+                            for (size_t l = 0; l <= j; ++l) {
+                                const double *vl = basis.data() + l * n;
+                                double sum = 0.0;
+                                for (size_t i = first; i < last; ++i) sum += vl[i] * w[i];
+                                acc[l] = sum;
+                            }
+                        });
+                        // w -= sum_l c_l v_l and |w|^2 in one pass.
+                        norm = std::sqrt(blocked_sums(n, 1, pool, [&](size_t first, size_t last, double *acc) {
+                            for (size_t l = 0; l <= j; ++l) {
+                                const double *vl = basis.data() + l * n, cl = c[l];
+                                for (size_t i = first; i < last; ++i) w[i] -= cl * vl[i];
+                            }
+                            double sum = 0.0;
+                            for (size_t i = first; i < last; ++i) sum += w[i] * w[i];
+                            acc[0] = sum;
+                        })[0]);
+                        for (size_t l = 0; l <= j; ++l) hessenberg(l, j) += c[l];
+                    }
+                    hessenberg(j + 1, j) = norm;
+                    if (norm > 0.0) {
+                        std::span<double> next = v(j + 1);
+                        parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                            for (size_t i = first; i < last; ++i) next[i] = w[i] / norm;
+                        }, pool);
+                    }
+                });
+
+                // Apply the earlier rotations to the new column, then the
+                // rotation that zeroes its subdiagonal entry.
+                for (size_t l = 0; l < j; ++l) {
+                    const double upper = hessenberg(l, j), lower = hessenberg(l + 1, j);
+                    hessenberg(l, j) = cs[l] * upper + sn[l] * lower;
+                    hessenberg(l + 1, j) = -sn[l] * upper + cs[l] * lower;
+                }
+                const double diagonal = hessenberg(j, j), sub = hessenberg(j + 1, j);
+                const double radius = std::hypot(diagonal, sub);
+                cs[j] = radius == 0.0 ? 1.0 : diagonal / radius;
+                sn[j] = radius == 0.0 ? 0.0 : sub / radius;
+                hessenberg(j, j) = radius;
+                hessenberg(j + 1, j) = 0.0;
+                g[j + 1] = -sn[j] * g[j];
+                g[j] = cs[j] * g[j];
+
+                ++stats.iterations;
+                // A zero norm is a lucky breakdown: the solution is in the
+                // basis.
+                done = record(stats, std::abs(g[j + 1]) / bnorm, options) || norm == 0.0;
+            }
+
+            // y solves the triangular system; x += M^-1 (V y).
+            for (size_t i = k; i-- > 0;) {
+                double sum = g[i];
+                for (size_t l = i + 1; l < k; ++l) sum -= hessenberg(i, l) * y[l];
+                y[i] = hessenberg(i, i) == 0.0 ? 0.0 : sum / hessenberg(i, i);
+            }
+            timed(stats.timings.vector, [&]() {
+                parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) w[i] = 0.0;
+                    for (size_t l = 0; l < k; ++l) {
+                        const double *vl = basis.data() + l * n, yl = y[l];
+                        for (size_t i = first; i < last; ++i) w[i] += yl * vl[i];
+                    }
+                }, pool);
+            });
+            precondition(m, w, z, stats, pool);
+            timed(stats.timings.vector, [&]() {
+                parallel_for(0, n, KRYLOV_BLOCK, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) x[i] += z[i];
+                }, pool);
+            });
+            std::fill(h.begin(), h.end(), 0.0);
+
+            // Restart from the true residual, which replaces the
+            // recurrence's estimate for the last iteration.
+            rr = residual(a, b, x, v(0), stats, pool);
+            stats.history.pop_back();
+            if (record(stats, std::sqrt(rr) / bnorm, options)) break;
+        }
+    }
+    stats.timings.total = krylov_seconds_since(start);
+    return stats;
+}
+
+#endif //FMM_KRYLOV_HPP
@@ -0,0 +1,579 @@
+/**
+ * @file llg.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Adaptive time integration of the Landau-Lifshitz-Gilbert equation
+ *        dm/dt = -g (m x H + alpha m x (m x H)), g = gamma / (1 + alpha^2),
+ *        for unit vector fields on SoA Vector3Array data.
+ *
+ * Three methods, each with an embedded error estimate (the largest |dm_i|
+ * over nodes) and step size control:
+ *
+ *  - Heun, with the Euler step as its first order partner;
+ *  - Dormand-Prince 5(4), whose last stage is the first of the next step
+ *    (FSAL), so an accepted step costs six field evaluations;
+ *  - a geometric Heun that writes the equation as dm/dt = w(m) x m with
+ *    w = g (H + alpha m x H) and steps by the Cayley transform of the
+ *    averaged w (second order, its first stage the first order partner);
+ *    this keeps |m_i| = 1 exactly, with no renormalization.
+ *
+ * The Runge-Kutta methods renormalize each accepted solution. The stage
+ * slopes live in buffers allocated at construction. Each stage costs one
+ * field evaluation and one pass over the nodes, which computes the stage's
+ * torque from the field and, fused with it, the next stage's input (the
+ * last pass also gives the solution and the error). Passes run over fixed
+ * blocks of nodes in parallel and over tiles of TILE nodes within a block,
+ * writing to tile local arrays so that the loops vectorize; so results do
+ * not depend on the number of threads. The first stage's slope is kept
+ * through rejected steps (and, for Dormand-Prince, accepted ones).
+ */
+
+#ifndef FMM_LLG_HPP
+#define FMM_LLG_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "minimizer.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief mu0 times the electron gyromagnetic ratio (m / (A s)).
+ */
+inline constexpr double GAMMA0 = 2.21276148e5;
+
+/**
+ * @brief The time stepping method of an LlgIntegrator.
+ */
+enum class LlgMethod {
+    heun,   /**< Heun 2(1). */
+    rk45,   /**< Dormand-Prince 5(4), FSAL. */
+    cayley  /**< Geometric Heun by the Cayley transform, 2(1). */
+};
+
+/**
+ * @brief The damping and gyromagnetic ratio of the equation, and the step
+ *        size control: a step is accepted when its error estimate (the
+ *        largest |dm_i|) is at most tolerance, and the next step is the
+ *        last scaled by safety (tolerance / error)^(1 / (q + 1)) (q the
+ *        order of the estimate), kept within [max_shrink, max_growth] and
+ *        at most max_step.
+ */
+struct LlgOptions {
+    LlgMethod method = LlgMethod::rk45;
+    double damping = 0.1;           /**< alpha. */
+    double gamma = GAMMA0;          /**< gamma (m / (A s)). */
+    double tolerance = 1.0e-6;      /**< The largest error in any m_i per step. */
+    double initial_step = 1.0e-14;  /**< The first step (s). */
+    double min_step = 1.0e-20;      /**< The smallest step before giving up (s). */
+    double max_step = 1.0e-10;      /**< The largest step (s). */
+    double safety = 0.9;
+    double max_shrink = 0.2;
+    double max_growth = 5.0;
+};
+
+/**
+ * @brief Seconds spent evaluating fields and in the integrator's own
+ *        passes, and the wall time `total` of step().
+ */
+struct LlgTimings {
+    double field = 0.0;
+    double stages = 0.0;
+    double total = 0.0;
+};
+
+/**
+ * @brief Counts of accepted and rejected steps and field evaluations since
+ *        construction (or reset_stats()).
+ */
+struct LlgStats {
+    size_t steps = 0;
+    size_t rejected = 0;
+    size_t evaluations = 0;
+    double smallest_step = 0.0;
+    double largest_step = 0.0;
+    LlgTimings timings;
+};
+
+namespace detail {
+
+/**
+ * @brief The nodes per block of an integrator pass.
+ */
+inline constexpr size_t LLG_BLOCK = 2048;
+
+/**
+ * @brief Heun's method: a[s] are the weights of the slopes in stage s's
+ *        input (a[stages] the solution's), e the weights of the error
+ *        estimate (the solution less Euler's).
+ */
+struct LlgHeun {
+    static constexpr size_t stages = 2;
+    static constexpr bool fsal = false;
+    static constexpr size_t order = 1;
+    static constexpr double c[stages] = {0.0, 1.0};
+    static constexpr double a[stages + 1][stages] = {{0.0, 0.0}, {1.0, 0.0}, {0.5, 0.5}};
+    static constexpr double e[stages] = {-0.5, 0.5};
+};
+
+/**
+ * @brief Dormand and Prince's 5(4) pair; the last stage's input is the
+ *        solution.
+ */
+struct LlgDormandPrince {
+    static constexpr size_t stages = 7;
+    static constexpr bool fsal = true;
+    static constexpr size_t order = 4;
+    static constexpr double c[stages] = {0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0, 1.0};
+    static constexpr double a[stages + 1][stages] = {
+            {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+            {1.0 / 5.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+            {3.0 / 40.0, 9.0 / 40.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+            {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0, 0.0, 0.0, 0.0, 0.0},
+            {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0, 0.0, 0.0, 0.0},
+            {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0, 0.0, 0.0},
+            {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0, 0.0},
+            {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0, 0.0}};
+    static constexpr double e[stages] = {71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0,
+                                         -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0};
+};
+
+} // namespace detail
+
+/**
+ * @brief Integrates the LLG equation in time from a unit vector field,
+ *        which it owns, with all buffers allocated at construction.
+ */
+class LlgIntegrator {
+public:
+
+    /**
+     * @brief The nodes per tile of a pass.
+     */
+    static constexpr size_t TILE = 64;
+
+    /**
+     * @param m the starting field (normalized).
+     * @param options the method, material constants and step control.
+     * @param pool the pool for the passes.
+     *
+     * @throws std::invalid_argument if a tolerance or step bound is not
+     *         positive.
+     */
+    explicit LlgIntegrator(const Vector3Array<double> &m, const LlgOptions &options = {},
+                           ThreadPool &pool = ThreadPool::global())
+            : _n(m.size()), _options(options), _pool(pool), _m(m), _next(_n), _y(_n), _h(_n),
+              _partial((_n + detail::LLG_BLOCK - 1) / detail::LLG_BLOCK), _step(options.initial_step) {
+        if (!(options.tolerance > 0.0) || !(options.initial_step > 0.0) || !(options.min_step > 0.0) ||
+            !(options.max_step >= options.min_step)) {
+            throw std::invalid_argument("LlgIntegrator tolerance and steps must be positive");
+        }
+        const size_t stages = options.method == LlgMethod::rk45 ? detail::LlgDormandPrince::stages : 2;
+        _k.assign(stages, Vector3Array<double>(_n));
+        normalize_vectors(_m, _pool);
+    }
+
+    [[nodiscard]] size_t size() const { return _n; }
+
+    [[nodiscard]] const LlgOptions &options() const { return _options; }
+
+    [[nodiscard]] const Vector3Array<double> &magnetization() const { return _m; }
+
+    /**
+     * @brief Replaces the field (normalized).
+     *
+     * @throws std::invalid_argument if m does not have size() vectors.
+     */
+    void set_magnetization(const Vector3Array<double> &m) {
+        if (m.size() != _n) throw std::invalid_argument("LlgIntegrator size mismatch");
+        _m = m;
+        normalize_vectors(_m, _pool);
+        _slope_valid = false;
+    }
+
+    [[nodiscard]] double time() const { return _t; }
+
+    void set_time(double t) {
+        _t = t;
+        _slope_valid = false;
+    }
+
+    /**
+     * @brief The size of the next step.
+     */
+    [[nodiscard]] double step_size() const { return _step; }
+
+    void set_step_size(double h) { _step = std::clamp(h, _options.min_step, _options.max_step); }
+
+    [[nodiscard]] const LlgStats &stats() const { return _stats; }
+
+    void reset_stats() { _stats = {}; }
+
+    /**
+     * @brief Tries one step of step_size(), then sets the next step size.
+     *
+     * @tparam Field a callable `field(t, m, h)` overwriting h with the
+     *               effective field (A/m) at time t for the field m.
+     * @return whether the step was accepted (and time() advanced).
+     *
+     * @throws std::runtime_error if a rejected step leaves the step size
+     *         below min_step.
+     */
+    template <typename Field>
+    bool step(Field &&field) {
+        return attempt(field, _step, false);
+    }
+
+    /**
+     * @brief Steps until time() is t_end, shortening the last step to land
+     *        on it (without letting that shorten the steps after).
+     */
+    template <typename Field>
+    void advance(Field &&field, double t_end) {
+        while (_t < t_end) {
+            if (_t + _step >= t_end) {
+                if (attempt(field, t_end - _t, true)) _t = t_end;
+            } else {
+                attempt(field, _step, false);
+            }
+        }
+    }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    static double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief One step of size h; a step shortened to land on a time keeps
+     *        the step size unless rejected.
+     */
+    template <typename Field>
+    bool attempt(Field &field, double h, bool shortened) {
+        auto start = Clock::now();
+        double error = 0.0;
+        size_t order = 1;
+        switch (_options.method) {
+            case LlgMethod::heun:
+                error = runge_kutta<detail::LlgHeun>(field, h);
+                order = detail::LlgHeun::order;
+                break;
+            case LlgMethod::rk45:
+                error = runge_kutta<detail::LlgDormandPrince>(field, h);
+                order = detail::LlgDormandPrince::order;
+                break;
+            case LlgMethod::cayley:
+                error = cayley(field, h);
+                break;
+        }
+
+        const bool accepted = error <= _options.tolerance;
+        double factor = error > 0.0 ? _options.safety * std::pow(_options.tolerance / error, 1.0 / double(order + 1))
+                                    : _options.max_growth;
+        factor = std::clamp(factor, _options.max_shrink, _options.max_growth);
+        if (accepted) {
+            std::swap(_m, _next);
+            if (_options.method == LlgMethod::rk45) {
+                std::swap(_k.front(), _k.back());
+            } else {
+                _slope_valid = false;
+            }
+            _t += h;
+            _stats.smallest_step = _stats.steps == 0 ? h : std::min(_stats.smallest_step, h);
+            _stats.largest_step = std::max(_stats.largest_step, h);
+            ++_stats.steps;
+            if (!shortened) _step = std::min(_options.max_step, h * factor);
+        } else {
+            ++_stats.rejected;
+            _step = std::min(_options.max_step, h * factor);
+            if (_step < _options.min_step) {
+                throw std::runtime_error("LlgIntegrator step size below min_step");
+            }
+        }
+        _stats.timings.total += seconds_since(start);
+        return accepted;
+    }
+
+    template <typename Field>
+    void evaluate(Field &field, double t, const Vector3Array<double> &m) {
+        auto start = Clock::now();
+        field(t, m, _h);
+        _stats.timings.field += seconds_since(start);
+        ++_stats.evaluations;
+    }
+
+    /**
+     * @brief Runs f(i0, count) over tiles of every block, in parallel over
+     *        blocks, count being an integral constant for whole tiles (so
+     *        their loops have a fixed trip count); returns the largest value
+     *        f returns.
+     */
+    template <typename F>
+    double tiles(F &&f) {
+        const size_t blocks = _partial.size();
+        parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                const size_t first = b * detail::LLG_BLOCK, last = std::min(_n, first + detail::LLG_BLOCK);
+                double largest = 0.0;
+                size_t i = first;
+                for (; i + TILE <= last; i += TILE) {
+                    largest = std::max(largest, f(i, std::integral_constant<size_t, TILE>{}));
+                }
+                if (i < last) largest = std::max(largest, f(i, last - i));
+                _partial[b] = largest;
+            }
+        }, _pool);
+        double largest = 0.0;
+        for (double p: _partial) largest = std::max(largest, p);
+        return largest;
+    }
+
+    /**
+     * @brief The input of stage s of tableau T: m, the solution (for an FSAL
+     *        last stage) or the stage buffer.
+     */
+    template <typename T>
+    Vector3Array<double> &stage_input(size_t s) {
+        if (s == 0) return _m;
+        if (T::fsal && s + 1 == T::stages) return _next;
+        return _y;
+    }
+
+    /**
+     * @brief An explicit Runge-Kutta step of size h; returns the error
+     *        estimate.
+     */
+    template <typename T, typename Field>
+    double runge_kutta(Field &field, double h) {
+        if (!_slope_valid) {
+            evaluate(field, _t, _m);
+            stage<T, 0, true>(h);
+            _slope_valid = true;
+        } else {
+            stage<T, 0, false>(h);
+        }
+        return [&]<size_t... S>(std::index_sequence<S...>) {
+            double error = 0.0;
+            ((evaluate(field, _t + T::c[S + 1] * h, stage_input<T>(S + 1)), error = stage<T, S + 1, true>(h)), ...);
+            return error;
+        }(std::make_index_sequence<T::stages - 1>{});
+    }
+
+    /**
+     * @brief The pass of stage S: its slope k_S (from the field in _h, or
+     *        kept if not Torque), fused with the next stage's input
+     *        m + h sum_j a[S + 1][j] k_j, or at the last stage the solution
+     *        (unless FSAL made it the last stage's input) and the error
+     *        h sum_j e[j] k_j. The solution is renormalized. Returns the
+     *        largest error, or 0 before the last stage.
+     */
+    template <typename T, size_t S, bool Torque>
+    double stage(double h) {
+        constexpr bool last = S + 1 == T::stages;
+        constexpr bool solve = last ? !T::fsal : T::fsal && S + 2 == T::stages;
+        constexpr size_t row = last ? T::stages : S + 1;
+        const double g = _options.gamma / (1.0 + _options.damping * _options.damping), alpha = _options.damping;
+        const Vector3Array<double> &in = stage_input<T>(S);
+        Vector3Array<double> &out = solve ? _next : _y;
+        Vector3Array<double> &slope = _k[S];
+        const double *kx[T::stages], *ky[T::stages], *kz[T::stages];
+        for (size_t j = 0; j < T::stages; ++j) kx[j] = _k[j].x(), ky[j] = _k[j].y(), kz[j] = _k[j].z();
+
+        auto start = Clock::now();
+        const double error = tiles([&](size_t i0, auto count) -> double {
+            alignas(SOA_ALIGNMENT) double kv[3][TILE];
+            alignas(SOA_ALIGNMENT) double yv[3][TILE];
+            alignas(SOA_ALIGNMENT) double ev[TILE];
+            const double *mx = _m.x() + i0, *my = _m.y() + i0, *mz = _m.z() + i0;
+            const double *yx = in.x() + i0, *yy = in.y() + i0, *yz = in.z() + i0;
+            const double *hx = _h.x() + i0, *hy = _h.y() + i0, *hz = _h.z() + i0;
+            const double *sx = slope.x() + i0, *sy = slope.y() + i0, *sz = slope.z() + i0;
+            for (size_t k = 0; k < count; ++k) {
+                if constexpr (Torque) {
+                    // k = -g (m x H + alpha m x (m x H)).
+                    const double cx = yy[k] * hz[k] - yz[k] * hy[k];
+                    const double cy = yz[k] * hx[k] - yx[k] * hz[k];
+                    const double cz = yx[k] * hy[k] - yy[k] * hx[k];
+                    kv[0][k] = -g * (cx + alpha * (yy[k] * cz - yz[k] * cy));
+                    kv[1][k] = -g * (cy + alpha * (yz[k] * cx - yx[k] * cz));
+                    kv[2][k] = -g * (cz + alpha * (yx[k] * cy - yy[k] * cx));
+                } else {
+                    kv[0][k] = sx[k];
+                    kv[1][k] = sy[k];
+                    kv[2][k] = sz[k];
+                }
+                if constexpr (!last || solve) {
+                    const size_t i = i0 + k;
+                    [&]<size_t... J>(std::index_sequence<J...>) {
+                        yv[0][k] = mx[k] + h * (((T::a[row][J] * kx[J][i]) + ... + 0.0) + T::a[row][S] * kv[0][k]);
+                        yv[1][k] = my[k] + h * (((T::a[row][J] * ky[J][i]) + ... + 0.0) + T::a[row][S] * kv[1][k]);
+                        yv[2][k] = mz[k] + h * (((T::a[row][J] * kz[J][i]) + ... + 0.0) + T::a[row][S] * kv[2][k]);
+                    }(std::make_index_sequence<S>{});
+                }
+                if constexpr (last) {
+                    const size_t i = i0 + k;
+                    [&]<size_t... J>(std::index_sequence<J...>) {
+                        const double ex = h * (((T::e[J] * kx[J][i]) + ... + 0.0) + T::e[S] * kv[0][k]);
+                        const double ey = h * (((T::e[J] * ky[J][i]) + ... + 0.0) + T::e[S] * kv[1][k]);
+                        const double ez = h * (((T::e[J] * kz[J][i]) + ... + 0.0) + T::e[S] * kv[2][k]);
+                        ev[k] = ex * ex + ey * ey + ez * ez;
+                    }(std::make_index_sequence<S>{});
+                }
+            }
+            if constexpr (Torque) {
+                std::copy(kv[0], kv[0] + count, slope.x() + i0);
+                std::copy(kv[1], kv[1] + count, slope.y() + i0);
+                std::copy(kv[2], kv[2] + count, slope.z() + i0);
+            }
+            if constexpr (!last || solve) {
+                std::copy(yv[0], yv[0] + count, out.x() + i0);
+                std::copy(yv[1], yv[1] + count, out.y() + i0);
+                std::copy(yv[2], yv[2] + count, out.z() + i0);
+                if constexpr (solve) {
+                    double *ox = out.x(), *oy = out.y(), *oz = out.z();
+                    detail::unit_range(ox, oy, oz, ox, oy, oz, 0.0, ox, oy, oz, i0, i0 + count);
+                }
+            }
+            double largest = 0.0;
+            if constexpr (last) {
+                for (size_t k = 0; k < count; ++k) largest = std::max(largest, ev[k]);
+            }
+            return std::sqrt(largest);
+        });
+        _stats.timings.stages += seconds_since(start);
+        return error;
+    }
+
+    /**
+     * @brief A geometric Heun step of size h: with w(m) = g (H + alpha m x H)
+     *        and cay(v) m = m + (v x m + v x (v x m) / 2) / (1 + |v|^2 / 4),
+     *        the predictor y = cay(h w(m)) m and the step
+     *        cay(h (w(m) + w(y)) / 2) m; returns the largest |step - y|.
+     */
+    template <typename Field>
+    double cayley(Field &field, double h) {
+        const double g = _options.gamma / (1.0 + _options.damping * _options.damping), alpha = _options.damping;
+        Vector3Array<double> &w0 = _k[0];
+        const bool fresh = !_slope_valid;
+        if (fresh) {
+            evaluate(field, _t, _m);
+            _slope_valid = true;
+        }
+
+        auto start = Clock::now();
+        if (fresh) {
+            cayley_predictor<true>(h);
+        } else {
+            cayley_predictor<false>(h);
+        }
+        _stats.timings.stages += seconds_since(start);
+
+        evaluate(field, _t + h, _y);
+
+        // w(y), the step and its distance from the predictor.
+        start = Clock::now();
+        const double error = tiles([&](size_t i0, auto count) -> double {
+            alignas(SOA_ALIGNMENT) double nv[3][TILE];
+            alignas(SOA_ALIGNMENT) double ev[TILE];
+            const double *mx = _m.x() + i0, *my = _m.y() + i0, *mz = _m.z() + i0;
+            const double *yx = _y.x() + i0, *yy = _y.y() + i0, *yz = _y.z() + i0;
+            const double *hx = _h.x() + i0, *hy = _h.y() + i0, *hz = _h.z() + i0;
+            const double *wx = w0.x() + i0, *wy = w0.y() + i0, *wz = w0.z() + i0;
+            for (size_t k = 0; k < count; ++k) {
+                const double vx = g * (hx[k] + alpha * (yy[k] * hz[k] - yz[k] * hy[k]));
+                const double vy = g * (hy[k] + alpha * (yz[k] * hx[k] - yx[k] * hz[k]));
+                const double vz = g * (hz[k] + alpha * (yx[k] * hy[k] - yy[k] * hx[k]));
+                const double s = 0.5 * h;
+                cayley_rotate(s * (wx[k] + vx), s * (wy[k] + vy), s * (wz[k] + vz), mx[k], my[k], mz[k],
+                              nv[0][k], nv[1][k], nv[2][k]);
+                const double dx = nv[0][k] - yx[k], dy = nv[1][k] - yy[k], dz = nv[2][k] - yz[k];
+                ev[k] = dx * dx + dy * dy + dz * dz;
+            }
+            std::copy(nv[0], nv[0] + count, _next.x() + i0);
+            std::copy(nv[1], nv[1] + count, _next.y() + i0);
+            std::copy(nv[2], nv[2] + count, _next.z() + i0);
+            double largest = 0.0;
+            for (size_t k = 0; k < count; ++k) largest = std::max(largest, ev[k]);
+            return std::sqrt(largest);
+        });
+        _stats.timings.stages += seconds_since(start);
+        return error;
+    }
+
+    /**
+     * @brief w0 = w(m) from the field in _h (if Fresh, else kept) and the
+     *        predictor y = cay(h w0) m.
+     */
+    template <bool Fresh>
+    void cayley_predictor(double h) {
+        const double g = _options.gamma / (1.0 + _options.damping * _options.damping), alpha = _options.damping;
+        Vector3Array<double> &w0 = _k[0];
+        tiles([&](size_t i0, auto count) -> double {
+            alignas(SOA_ALIGNMENT) double wv[3][TILE];
+            alignas(SOA_ALIGNMENT) double yv[3][TILE];
+            const double *mx = _m.x() + i0, *my = _m.y() + i0, *mz = _m.z() + i0;
+            const double *hx = _h.x() + i0, *hy = _h.y() + i0, *hz = _h.z() + i0;
+            const double *wx = w0.x() + i0, *wy = w0.y() + i0, *wz = w0.z() + i0;
+            for (size_t k = 0; k < count; ++k) {
+                if constexpr (Fresh) {
+                    wv[0][k] = g * (hx[k] + alpha * (my[k] * hz[k] - mz[k] * hy[k]));
+                    wv[1][k] = g * (hy[k] + alpha * (mz[k] * hx[k] - mx[k] * hz[k]));
+                    wv[2][k] = g * (hz[k] + alpha * (mx[k] * hy[k] - my[k] * hx[k]));
+                } else {
+                    wv[0][k] = wx[k];
+                    wv[1][k] = wy[k];
+                    wv[2][k] = wz[k];
+                }
+                cayley_rotate(h * wv[0][k], h * wv[1][k], h * wv[2][k], mx[k], my[k], mz[k],
+                              yv[0][k], yv[1][k], yv[2][k]);
+            }
+            if constexpr (Fresh) {
+                std::copy(wv[0], wv[0] + count, w0.x() + i0);
+                std::copy(wv[1], wv[1] + count, w0.y() + i0);
+                std::copy(wv[2], wv[2] + count, w0.z() + i0);
+            }
+            std::copy(yv[0], yv[0] + count, _y.x() + i0);
+            std::copy(yv[1], yv[1] + count, _y.y() + i0);
+            std::copy(yv[2], yv[2] + count, _y.z() + i0);
+            return 0.0;
+        });
+    }
+
+    /**
+     * @brief (ox, oy, oz) = cay(v) m.
+     */
+    static void cayley_rotate(double vx, double vy, double vz, double mx, double my, double mz,
+                              double &ox, double &oy, double &oz) {
+        const double cx = vy * mz - vz * my, cy = vz * mx - vx * mz, cz = vx * my - vy * mx;
+        const double dx = vy * cz - vz * cy, dy = vz * cx - vx * cz, dz = vx * cy - vy * cx;
+        const double s = 1.0 / (1.0 + 0.25 * (vx * vx + vy * vy + vz * vz));
+        ox = mx + s * (cx + 0.5 * dx);
+        oy = my + s * (cy + 0.5 * dy);
+        oz = mz + s * (cz + 0.5 * dz);
+    }
+
+    size_t _n;
+    LlgOptions _options;
+    ThreadPool &_pool;
+
+    Vector3Array<double> _m, _next, _y, _h;
+    std::vector<Vector3Array<double>> _k;
+    std::vector<double> _partial;
+
+    double _t = 0.0;
+    double _step;
+    bool _slope_valid = false;
+    LlgStats _stats;
+};
+
+#endif //FMM_LLG_HPP
@@ -0,0 +1,385 @@
+/**
+ * @file m2l_cache.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Precomputed M2L translation operators keyed by cell offset, built
+ *        lazily and persisted in a memory-mappable file.
+ */
+
+#ifndef FMM_M2L_CACHE_HPP
+#define FMM_M2L_CACHE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "linalg.hpp"
+
+/**
+ * @brief The cache file format version; files of any other version are
+ *        rejected.
+ */
+inline constexpr uint32_t M2L_CACHE_VERSION = 1;
+
+/**
+ * @brief An integer cell offset, in units of the smaller cell's half width.
+ */
+struct M2LOffset {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t z = 0;
+
+    bool operator==(const M2LOffset &) const = default;
+};
+
+namespace detail {
+
+/**
+ * @brief The 64 byte header of an M2L cache file.
+ *
+ * The header is followed by `count` 16 byte keys (x, y, z, 0) padded to a
+ * multiple of 64 bytes, then by `count` operators of `operator_size`
+ * doubles each, in native byte order.
+ */
+struct M2LCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint64_t identity;
+    uint64_t operator_size;
+    uint64_t count;
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(M2LCacheHeader) == 64);
+
+inline constexpr char M2L_CACHE_MAGIC[8] = {'F', 'M', 'M', 'M', '2', 'L', 'C', '\0'};
+
+inline constexpr uint32_t M2L_CACHE_ENDIAN = 0x01020304u;
+
+inline uint64_t fnv1a(uint64_t h, const void *data, size_t n) {
+    auto *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+struct M2LOffsetHash {
+    size_t operator()(const M2LOffset &o) const {
+        uint64_t h = uint64_t(uint32_t(o.x)) * 0x9e3779b97f4a7c15ull;
+        h = (h ^ uint64_t(uint32_t(o.y))) * 0xff51afd7ed558ccdull;
+        h = (h ^ uint64_t(uint32_t(o.z))) * 0xc4ceb9fe1a85ec53ull;
+        return size_t(h ^ (h >> 31));
+    }
+};
+
+/**
+ * @brief A read-only view of a whole file: memory mapped where POSIX mmap
+ *        is available, read into memory otherwise.
+ */
+class MappedFile {
+public:
+
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                _data = static_cast<const unsigned char *>(p);
+                _size = size_t(st.st_size);
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return;
+        _buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        _data = reinterpret_cast<const unsigned char *>(_buffer.data());
+        _size = _buffer.size();
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (_data) ::munmap(const_cast<unsigned char *>(_data), _size);
+#endif
+    }
+
+    [[nodiscard]] const unsigned char *data() const { return _data; }
+
+    [[nodiscard]] size_t size() const { return _size; }
+
+private:
+    const unsigned char *_data = nullptr;
+    size_t _size = 0;
+#if !(defined(__unix__) || defined(__APPLE__))
+    std::vector<char> _buffer;
+#endif
+};
+
+} // namespace detail
+
+/**
+ * @brief A cache of precomputed M2L translation operators keyed by the
+ *        integer offset between cell centres.
+ *
+ * Octree cell centres sit on a grid, so the offset between the centres of
+ * two interacting cells is an integer vector o in units of the smaller
+ * cell's half width u, and few distinct offsets occur (316 per level for
+ * the classic uniform-tree interaction list; a similar bounded set for the
+ * opening-angle traversal of Fmm). Both operator families are homogeneous,
+ * so the translation by d = u o follows from an operator precomputed for o
+ * alone, and one operator per offset and order serves every level.
+ *
+ * The operators are those of the family itself (Ops::m2l_operator): the
+ * rotation and distance for SphericalOperators, the derivative tensor for
+ * CartesianOperators. These are a few kilobytes each, where a dense matrix
+ * would be tens to hundreds, so applying one is bound by arithmetic rather
+ * than memory and costs no more than M2L from a warm rotation cache.
+ *
+ * Operators are built on first use and can be saved to a file that a later
+ * run maps instead of recomputing. A file written for a different format
+ * version, byte order or operator family, order or coefficient type is
+ * rejected and the cache starts empty.
+ *
+ * Lookups are thread safe; get() returns pointers that stay valid for the
+ * cache's lifetime.
+ *
+ * @tparam Ops the operator family; in addition to Fmm's requirements it must
+ *             provide `m2l_operator_size()`, `m2l_operator(d, op)` and
+ *             `m2l_apply(op, m, unit, l)`.
+ */
+template <typename Ops>
+class M2LCache {
+public:
+
+    using Coefficient = typename Ops::Coefficient;
+
+    /**
+     * @brief An empty cache for the given operators.
+     */
+    explicit M2LCache(const Ops &ops)
+            : _ops(ops), _operator_size(ops.m2l_operator_size()), _identity(identity(ops)) {}
+
+    /**
+     * @brief A cache that starts from the operators saved in a file, if the
+     *        file exists and matches; see rejected().
+     */
+    M2LCache(const Ops &ops, const std::string &path) : M2LCache(ops) {
+        _file = std::make_unique<detail::MappedFile>(path);
+        if (!_file->data()) return;
+        if (!load()) {
+            _rejected = true;
+            _entries.clear();
+        }
+    }
+
+    /**
+     * @brief The number of doubles per operator.
+     */
+    [[nodiscard]] size_t operator_size() const { return _operator_size; }
+
+    /**
+     * @brief The number of cached offsets.
+     */
+    [[nodiscard]] size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        return _entries.size();
+    }
+
+    /**
+     * @brief The number of operators computed (rather than mapped from a
+     *        file) by this cache.
+     */
+    [[nodiscard]] size_t computed() const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        return _owned.size();
+    }
+
+    /**
+     * @brief Whether a file was given and held operators from this cache.
+     */
+    [[nodiscard]] bool loaded() const { return _loaded; }
+
+    /**
+     * @brief Whether a file was given but was stale or malformed (and so
+     *        ignored).
+     */
+    [[nodiscard]] bool rejected() const { return _rejected; }
+
+    /**
+     * @brief The offset of d in units of u, which must be integral.
+     *
+     * @throws std::invalid_argument if d / u is not (close to) an integer
+     *         vector.
+     */
+    static M2LOffset offset(const Vector3<double> &d, double unit) {
+        double c[3] = {d.x / unit, d.y / unit, d.z / unit};
+        int32_t o[3];
+        for (size_t i = 0; i < 3; ++i) {
+            double r = std::round(c[i]);
+            if (std::abs(c[i] - r) > 1.0e-6 * std::max(1.0, std::abs(r)) || std::abs(r) > 1.0e9) {
+                throw std::invalid_argument("M2LCache offset is not on the grid");
+            }
+            o[i] = static_cast<int32_t>(r);
+        }
+        return {o[0], o[1], o[2]};
+    }
+
+    /**
+     * @brief The operator for offset o, computed if not cached.
+     */
+    const double *get(const M2LOffset &o) {
+        {
+            std::shared_lock<std::shared_mutex> lock(_mutex);
+            auto it = _entries.find(o);
+            if (it != _entries.end()) return it->second;
+        }
+        std::vector<double> op(_operator_size);
+        _ops.m2l_operator({double(o.x), double(o.y), double(o.z)}, op.data());
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        auto it = _entries.find(o);
+        if (it != _entries.end()) return it->second;
+        _owned.push_back(std::move(op));
+        _entries.emplace(o, _owned.back().data());
+        return _owned.back().data();
+    }
+
+    /**
+     * @brief Adds the local expansion of a multipole expansion translated by
+     *        d = unit * (the offset of op).
+     */
+    void apply(const double *op, const Coefficient *m, double unit, Coefficient *l) const {
+        _ops.m2l_apply(op, m, unit, l);
+    }
+
+    /**
+     * @brief Writes every cached operator to a file (through a temporary
+     *        file and a rename, so a reader never sees a partial file).
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const std::string &path) const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        std::vector<std::pair<M2LOffset, const double *>> entries(_entries.begin(), _entries.end());
+
+        detail::M2LCacheHeader header{};
+        std::memcpy(header.magic, detail::M2L_CACHE_MAGIC, sizeof(header.magic));
+        header.version = M2L_CACHE_VERSION;
+        header.endian = detail::M2L_CACHE_ENDIAN;
+        header.identity = _identity;
+        header.operator_size = _operator_size;
+        header.count = entries.size();
+
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::runtime_error("M2LCache cannot write " + tmp);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (auto &[o, m]: entries) {
+                int32_t key[4] = {o.x, o.y, o.z, 0};
+                out.write(reinterpret_cast<const char *>(key), sizeof(key));
+            }
+            std::vector<char> pad(keys_bytes(entries.size()) - 16 * entries.size(), 0);
+            out.write(pad.data(), std::streamsize(pad.size()));
+            for (auto &[o, m]: entries) {
+                out.write(reinterpret_cast<const char *>(m), std::streamsize(operator_bytes()));
+            }
+            if (!out) throw std::runtime_error("M2LCache cannot write " + tmp);
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("M2LCache cannot write " + path);
+        }
+    }
+
+private:
+
+    static size_t keys_bytes(size_t count) {
+        return (16 * count + 63) / 64 * 64;
+    }
+
+    size_t operator_bytes() const {
+        return _operator_size * sizeof(double);
+    }
+
+    /**
+     * @brief A hash of everything a saved operator depends on besides the
+     *        offset: the format version, the operator type, order and
+     *        coefficient layout.
+     */
+    static uint64_t identity(const Ops &ops) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        const char *name = typeid(Ops).name();
+        h = detail::fnv1a(h, name, std::strlen(name));
+        uint64_t values[6] = {M2L_CACHE_VERSION, uint64_t(ops.order()), uint64_t(ops.size()),
+                              uint64_t(ops.m2l_operator_size()), uint64_t(sizeof(Coefficient)),
+                              uint64_t(sizeof(double))};
+        return detail::fnv1a(h, values, sizeof(values));
+    }
+
+    bool load() {
+        const unsigned char *p = _file->data();
+        const size_t size = _file->size();
+        if (size < sizeof(detail::M2LCacheHeader)) return false;
+        detail::M2LCacheHeader header;
+        std::memcpy(&header, p, sizeof(header));
+        if (std::memcmp(header.magic, detail::M2L_CACHE_MAGIC, sizeof(header.magic)) != 0) return false;
+        if (header.version != M2L_CACHE_VERSION || header.endian != detail::M2L_CACHE_ENDIAN) return false;
+        if (header.identity != _identity || header.operator_size != _operator_size) return false;
+        if (header.count > size) return false;
+        const size_t count = header.count;
+        if (size != sizeof(header) + keys_bytes(count) + count * operator_bytes()) return false;
+
+        const unsigned char *keys = p + sizeof(header);
+        auto *operators = reinterpret_cast<const double *>(keys + keys_bytes(count));
+        for (size_t i = 0; i < count; ++i) {
+            int32_t key[4];
+            std::memcpy(key, keys + 16 * i, sizeof(key));
+            _entries.emplace(M2LOffset{key[0], key[1], key[2]}, operators + i * _operator_size);
+        }
+        _loaded = true;
+        return true;
+    }
+
+    Ops _ops;
+    size_t _operator_size;
+    uint64_t _identity;
+    std::unique_ptr<detail::MappedFile> _file;
+    bool _loaded = false;
+    bool _rejected = false;
+    mutable std::shared_mutex _mutex;
+    std::unordered_map<M2LOffset, const double *, detail::M2LOffsetHash> _entries;
+    std::deque<std::vector<double>> _owned;
+};
+
+#endif //FMM_M2L_CACHE_HPP
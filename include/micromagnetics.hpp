@@ -0,0 +1,618 @@
+/**
+ * @file micromagnetics.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Micromagnetic energies (exchange, uniaxial and cubic anisotropy,
+ *        Zeeman, demagnetizing) and their gradients for a magnetization
+ *        field on a TetMesh, in one fused element loop.
+ *
+ * The unit magnetization m is linear on each element (P1) and given by its
+ * nodal values. For a material of saturation magnetization Ms, exchange
+ * constant A and anisotropy constants Ku (easy axis u) and Kc (crystal axes
+ * R) in an applied field H, the energies are (SI units)
+ *
+ *     E_ex = A int |grad m|^2,
+ *     E_u  = -Ku int (m . u)^2,
+ *     E_c  = Kc int (a1^2 a2^2 + a2^2 a3^2 + a3^2 a1^2),   a = R m,
+ *     E_z  = -mu0 Ms int m . H,
+ *     E_d  = -mu0 / 2 Ms int m . H_d.
+ *
+ * Exchange is exact (grad m is constant on an element, from the shape
+ * function gradients adj(J) / det(J) that TetMesh caches). The anisotropy
+ * and Zeeman integrals take the nodal (lumped) rule, V / 4 per node, and
+ * so does the demagnetizing term, whose field is that of the nodes as point
+ * dipoles: node i carries the moment Ms w_i m_i (w_i its share V / 4 of
+ * each of its elements) and sees the dipole fields of the others (summed
+ * directly, or by Fmm on large meshes) and its own as a uniformly
+ * magnetized sphere, -Ms m_i / 3. (Dipoles at element centroids are worse:
+ * on a structured mesh the centroids of the elements of a cell crowd along
+ * one diagonal, and the demagnetizing factors come out anisotropic.)
+ *
+ * The gradient is dE/dm_i of these discrete energies (exactly, up to the
+ * Fmm error); minimizers and integrators project it as they need. The
+ * effective field is H_i = -dE/dm_i / (mu0 Ms w_i).
+ */
+
+#ifndef FMM_MICROMAGNETICS_HPP
+#define FMM_MICROMAGNETICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "dipole.hpp"
+#include "fem_assembly.hpp"
+#include "fmm.hpp"
+#include "fmm_spherical.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+
+/**
+ * @brief The vacuum permeability (T m / A).
+ */
+inline constexpr double MU0 = 1.25663706212e-6;
+
+/**
+ * @brief The material constants and the applied field (SI units).
+ */
+struct MicromagMaterial {
+    double ms = 4.8e5;                           /**< The saturation magnetization Ms (A/m). */
+    double exchange = 1.34e-11;                  /**< The exchange constant A (J/m). */
+    double uniaxial = 0.0;                       /**< The uniaxial anisotropy constant Ku (J/m^3). */
+    Vector3<double> easy_axis{0.0, 0.0, 1.0};    /**< The uniaxial easy axis u (a unit vector). */
+    double cubic = -1.24e4;                      /**< The cubic anisotropy constant Kc (J/m^3). */
+    Matrix3x3<double> cubic_axes{1.0, 0.0, 0.0,  /**< The crystal axes, one per row (a rotation). */
+                                 0.0, 1.0, 0.0,
+                                 0.0, 0.0, 1.0};
+    Vector3<double> applied{0.0, 0.0, 0.0};      /**< The applied field H (A/m). */
+};
+
+/**
+ * @brief The energy terms evaluated.
+ */
+struct MicromagTerms {
+    bool exchange = true;
+    bool uniaxial = true;
+    bool cubic = true;
+    bool zeeman = true;
+    bool demag = true;
+};
+
+/**
+ * @brief Parameters of a MicromagEvaluator.
+ */
+struct MicromagOptions {
+    MicromagTerms terms;               /**< The terms evaluated. */
+    bool fused = true;                 /**< One element pass for all terms; false gives a pass (and a time) per term. */
+    size_t demag_direct_limit = 8192;  /**< The most nodes for which the demagnetizing field is summed directly. */
+    size_t demag_order = 8;            /**< The Fmm expansion order above demag_direct_limit. */
+    FmmOptions fmm{0.5, 256};          /**< The Fmm parameters above demag_direct_limit (large leaves suit mesh nodes). */
+};
+
+/**
+ * @brief The energies (J) of the last evaluation, by term.
+ */
+struct MicromagEnergies {
+    double exchange = 0.0;
+    double uniaxial = 0.0;
+    double cubic = 0.0;
+    double zeeman = 0.0;
+    double demag = 0.0;
+    double total = 0.0;
+};
+
+/**
+ * @brief Seconds spent in the last evaluation.
+ *
+ * `demag` is the dipole field of the nodal moments. With fused options
+ * the element pass for all the terms is `fused`; otherwise each term's pass
+ * is timed under its own name (the demagnetizing one added to `demag`).
+ */
+struct MicromagTimings {
+    double exchange = 0.0;
+    double uniaxial = 0.0;
+    double cubic = 0.0;
+    double zeeman = 0.0;
+    double demag = 0.0;
+    double fused = 0.0;
+    double total = 0.0;
+};
+
+namespace detail {
+
+inline constexpr unsigned MICROMAG_EXCHANGE = 1;
+inline constexpr unsigned MICROMAG_UNIAXIAL = 2;
+inline constexpr unsigned MICROMAG_CUBIC = 4;
+inline constexpr unsigned MICROMAG_ZEEMAN = 8;
+inline constexpr unsigned MICROMAG_DEMAG = 16;
+inline constexpr size_t MICROMAG_TERMS = 5;
+
+} // namespace detail
+
+/**
+ * @brief Evaluates the micromagnetic energy of a magnetization on a mesh
+ *        and its gradient with respect to the nodal values.
+ *
+ * The element geometry is copied at construction into structure of arrays
+ * form (volume and three shape function gradients per element, padded to
+ * whole tiles), so later node motion in the mesh is not seen. Elements are
+ * processed in tiles of TILE consecutive (Morton ordered) elements: the
+ * nodal m of a tile is gathered into tile local arrays, every enabled term
+ * runs over the tile as a loop the compiler vectorizes across elements, and
+ * the tile's nodal gradients are scattered once. Runs of COLOR_BLOCK
+ * elements are coloured as in FemAssembler so that the scatter needs no
+ * locks; energies are summed tile by tile in a fixed order, so results do
+ * not depend on the number of threads.
+ */
+class MicromagEvaluator {
+public:
+
+    /**
+     * @brief The elements per tile: the vector loops' trip count.
+     */
+    static constexpr size_t TILE = 64;
+
+    /**
+     * @brief The elements per coloured block (whole tiles): long enough for
+     *        the blocks of a colour to stream through the mesh (with single
+     *        tiles the colour by colour order is twice as slow as mesh
+     *        order).
+     */
+    static constexpr size_t COLOR_BLOCK = 8 * TILE;
+
+    /**
+     * @param mesh the mesh (read here only).
+     * @param material the material constants and the applied field.
+     * @param options the terms and the demagnetizing field method.
+     * @param pool the pool to run on.
+     */
+    MicromagEvaluator(const TetMesh &mesh, const MicromagMaterial &material, const MicromagOptions &options = {},
+                      ThreadPool &pool = ThreadPool::global())
+            : _material(material), _options(options), _pool(pool), _nodes(mesh.node_count()),
+              _elements(mesh.element_count()) {
+        _coloring = color_elements(mesh, COLOR_BLOCK);
+        const size_t tiles = (_elements + TILE - 1) / TILE, padded = tiles * TILE;
+        auto volumes = mesh.volumes();
+        auto gradients = mesh.gradients();
+        auto conn = mesh.connectivity();
+
+        // Padding elements have zero volume (and so add nothing) on node 0.
+        _connectivity.assign(4 * padded, 0);
+        _volume.assign(padded, 0.0);
+        for (auto &g: _gradient) g.assign(padded, 0.0);
+        _weights.assign(_nodes, 0.0);
+        for (size_t e = 0; e < _elements; ++e) {
+            _volume[e] = volumes[e];
+            for (size_t a = 0; a < 4; ++a) {
+                _connectivity[4 * e + a] = conn[4 * e + a];
+                _weights[conn[4 * e + a]] += 0.25 * volumes[e];
+            }
+            for (size_t a = 1; a < 4; ++a) {
+                _gradient[3 * (a - 1)][e] = gradients[e][a].x;
+                _gradient[3 * (a - 1) + 1][e] = gradients[e][a].y;
+                _gradient[3 * (a - 1) + 2][e] = gradients[e][a].z;
+            }
+        }
+        _tile_energy.assign(detail::MICROMAG_TERMS * tiles, 0.0);
+
+        _positions = mesh.nodes();
+        _moments.resize(_nodes);
+        _field.resize(_nodes);
+        _demag.resize(_nodes);
+        _potential.assign(_nodes, 0.0);
+        if (_nodes > options.demag_direct_limit) {
+            std::vector<Vector3<double>> points = _positions.to_aos();
+            std::vector<double> charges(_nodes, 0.0);
+            _fmm = std::make_unique<Fmm<SphericalOperators>>(SphericalOperators(options.demag_order), points,
+                                                             charges, options.fmm, pool);
+            _moments_aos.resize(_nodes);
+            _field_aos.resize(_nodes);
+        }
+    }
+
+    [[nodiscard]] size_t node_count() const { return _nodes; }
+
+    [[nodiscard]] size_t element_count() const { return _elements; }
+
+    [[nodiscard]] const MicromagMaterial &material() const { return _material; }
+
+    /**
+     * @brief Changes the material constants or the applied field (for a
+     *        hysteresis loop, say); the geometry is kept.
+     */
+    void set_material(const MicromagMaterial &material) { _material = material; }
+
+    [[nodiscard]] const MicromagTerms &terms() const { return _options.terms; }
+
+    /**
+     * @brief Switches terms on or off.
+     */
+    void set_terms(const MicromagTerms &terms) { _options.terms = terms; }
+
+    /**
+     * @brief The volume w_i of each node (a quarter of each of its elements).
+     */
+    [[nodiscard]] std::span<const double> nodal_volumes() const { return _weights; }
+
+    /**
+     * @brief The energy of m (one vector per node).
+     *
+     * @throws std::invalid_argument if m does not have one vector per node.
+     */
+    double energy(const Vector3Array<double> &m) {
+        if (m.size() != _nodes) throw std::invalid_argument("MicromagEvaluator size mismatch");
+        return run<false>(m, nullptr);
+    }
+
+    /**
+     * @brief The energy of m, and its gradient dE/dm_i in gradient
+     *        (overwritten).
+     *
+     * @throws std::invalid_argument if m or gradient does not have one vector
+     *         per node.
+     */
+    double evaluate(const Vector3Array<double> &m, Vector3Array<double> &gradient) {
+        if (m.size() != _nodes || gradient.size() != _nodes) {
+            throw std::invalid_argument("MicromagEvaluator size mismatch");
+        }
+        return run<true>(m, &gradient);
+    }
+
+    /**
+     * @brief The effective field H_i = -dE/dm_i / (mu0 Ms w_i) (A/m) from a
+     *        gradient given by evaluate.
+     *
+     * @throws std::invalid_argument if the sizes do not match or Ms is 0.
+     */
+    void effective_field(const Vector3Array<double> &gradient, Vector3Array<double> &field) const {
+        if (gradient.size() != _nodes || field.size() != _nodes) {
+            throw std::invalid_argument("MicromagEvaluator size mismatch");
+        }
+        if (_material.ms == 0.0) throw std::invalid_argument("MicromagEvaluator effective field needs Ms > 0");
+        const double scale = -1.0 / (MU0 * _material.ms);
+        parallel_for(0, _nodes, 1 << 14, [&](size_t b, size_t e) {
+            const double *gx = gradient.x(), *gy = gradient.y(), *gz = gradient.z();
+            double *hx = field.x(), *hy = field.y(), *hz = field.z();
+            for (size_t i = b; i < e; ++i) {
+                const double s = scale / _weights[i];
+                hx[i] = s * gx[i];
+                hy[i] = s * gy[i];
+                hz[i] = s * gz[i];
+            }
+        }, _pool);
+    }
+
+    /**
+     * @brief The energies of the last evaluation.
+     */
+    [[nodiscard]] const MicromagEnergies &energies() const { return _energies; }
+
+    /**
+     * @brief The timings of the last evaluation.
+     */
+    [[nodiscard]] const MicromagTimings &timings() const { return _timings; }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    static double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    [[nodiscard]] unsigned enabled() const {
+        const MicromagTerms &t = _options.terms;
+        return (t.exchange ? detail::MICROMAG_EXCHANGE : 0u) | (t.uniaxial ? detail::MICROMAG_UNIAXIAL : 0u) |
+               (t.cubic ? detail::MICROMAG_CUBIC : 0u) | (t.zeeman ? detail::MICROMAG_ZEEMAN : 0u) |
+               (t.demag ? detail::MICROMAG_DEMAG : 0u);
+    }
+
+    template <bool Gradient>
+    double run(const Vector3Array<double> &m, Vector3Array<double> *gradient) {
+        auto start = Clock::now();
+        _timings = {};
+        std::fill(_tile_energy.begin(), _tile_energy.end(), 0.0);
+        if constexpr (Gradient) {
+            parallel_for(0, _nodes, 1 << 14, [&](size_t b, size_t e) {
+                std::fill(gradient->x() + b, gradient->x() + e, 0.0);
+                std::fill(gradient->y() + b, gradient->y() + e, 0.0);
+                std::fill(gradient->z() + b, gradient->z() + e, 0.0);
+            }, _pool);
+        }
+
+        const unsigned terms = enabled();
+        if (terms & detail::MICROMAG_DEMAG) {
+            auto phase = Clock::now();
+            demag_field(m);
+            _timings.demag = seconds_since(phase);
+        }
+        if (_options.fused) {
+            auto phase = Clock::now();
+            if (terms) pass<Gradient>(terms, m, gradient);
+            _timings.fused = seconds_since(phase);
+        } else {
+            double *slot[detail::MICROMAG_TERMS] = {&_timings.exchange, &_timings.uniaxial, &_timings.cubic,
+                                                    &_timings.zeeman, &_timings.demag};
+            for (size_t t = 0; t < detail::MICROMAG_TERMS; ++t) {
+                if (!(terms & (1u << t))) continue;
+                auto phase = Clock::now();
+                pass<Gradient>(1u << t, m, gradient);
+                *slot[t] += seconds_since(phase);
+            }
+        }
+
+        double sums[detail::MICROMAG_TERMS] = {};
+        for (size_t k = 0; k < _tile_energy.size(); k += detail::MICROMAG_TERMS) {
+            for (size_t t = 0; t < detail::MICROMAG_TERMS; ++t) sums[t] += _tile_energy[k + t];
+        }
+        _energies = {sums[0], sums[1], sums[2], sums[3], sums[4], sums[0] + sums[1] + sums[2] + sums[3] + sums[4]};
+        _timings.total = seconds_since(start);
+        return _energies.total;
+    }
+
+    /**
+     * @brief The demagnetizing field at each node (the other nodes' dipoles
+     *        and the node's own sphere term), into _demag.
+     */
+    void demag_field(const Vector3Array<double> &m) {
+        const double ms = _material.ms;
+        parallel_for(0, _nodes, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) _moments.set(i, (ms * _weights[i]) * m[i]);
+        }, _pool);
+
+        if (_fmm) {
+            for (size_t i = 0; i < _nodes; ++i) _moments_aos[i] = _moments[i];
+            _fmm->use_dipoles(_moments_aos);
+            _fmm->evaluate(_potential, _field_aos);
+            for (size_t i = 0; i < _nodes; ++i) _field.set(i, _field_aos[i]);
+        } else {
+            std::fill(_potential.begin(), _potential.end(), 0.0);
+            parallel_for(0, _nodes, 1 << 14, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) _field.set(i, {0.0, 0.0, 0.0});
+            }, _pool);
+            dipole_field(_positions, _moments, _positions, _potential, _field, P2PMode::self, _pool);
+        }
+
+        const double coupling = 1.0 / (4.0 * std::numbers::pi), self = -ms / 3.0;
+        parallel_for(0, _nodes, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                _demag.x()[i] = coupling * _field.x()[i] + self * m.x()[i];
+                _demag.y()[i] = coupling * _field.y()[i] + self * m.y()[i];
+                _demag.z()[i] = coupling * _field.z()[i] + self * m.z()[i];
+            }
+        }, _pool);
+    }
+
+    /**
+     * @brief One element pass over the given terms: with a gradient colour
+     *        by colour, the blocks of a colour in parallel and the tiles of a
+     *        block in order; without, all tiles in parallel.
+     */
+    template <bool Gradient>
+    void pass(unsigned terms, const Vector3Array<double> &m, Vector3Array<double> *gradient) {
+        if constexpr (Gradient) {
+            for (size_t c = 0; c < _coloring.colors(); ++c) {
+                std::span<const uint32_t> blocks = _coloring.color(c);
+                parallel_for(0, blocks.size(), 1, [&](size_t lo, size_t hi) {
+                    for (size_t k = lo; k < hi; ++k) {
+                        auto [first, last] = _coloring.block(blocks[k]);
+                        for (size_t e = first; e < last; e += TILE) tile<true>(e / TILE, terms, m, gradient);
+                    }
+                }, _pool);
+            }
+        } else {
+            const size_t tiles = _tile_energy.size() / detail::MICROMAG_TERMS;
+            parallel_for(0, tiles, 1, [&](size_t lo, size_t hi) {
+                for (size_t t = lo; t < hi; ++t) tile<false>(t, terms, m, gradient);
+            }, _pool);
+        }
+    }
+
+    /**
+     * @brief The terms' energies of tile t into _tile_energy and, with a
+     *        gradient, their nodal gradients added to it.
+     *
+     * Every loop over the tile's elements is straight line code on arrays
+     * indexed by the element, so it vectorizes; per element energies go to
+     * an array and are summed after the loop, in order.
+     */
+    template <bool Gradient>
+    void tile(size_t t, unsigned terms, const Vector3Array<double> &m, Vector3Array<double> *gradient) {
+        constexpr size_t n = TILE;
+        const size_t e0 = t * n;
+        const uint32_t *conn = _connectivity.data() + 4 * e0;
+        const double *vol = _volume.data() + e0;
+        const MicromagMaterial &mat = _material;
+
+        // mv[3 a + c][k]: component c of node a of element e0 + k.
+        alignas(SOA_ALIGNMENT) double mv[12][n];
+        alignas(SOA_ALIGNMENT) double gv[12][n];
+        alignas(SOA_ALIGNMENT) double ev[n];
+        const double *mx = m.x(), *my = m.y(), *mz = m.z();
+        for (size_t k = 0; k < n; ++k) {
+            for (size_t a = 0; a < 4; ++a) {
+                const uint32_t v = conn[4 * k + a];
+                mv[3 * a][k] = mx[v];
+                mv[3 * a + 1][k] = my[v];
+                mv[3 * a + 2][k] = mz[v];
+            }
+        }
+        if constexpr (Gradient) {
+            for (auto &row: gv) std::fill(row, row + n, 0.0);
+        }
+        double *energy = _tile_energy.data() + detail::MICROMAG_TERMS * t;
+        auto sum = [&]() {
+            double s = 0.0;
+            for (size_t k = 0; k < n; ++k) s += ev[k];
+            return s;
+        };
+
+        if (terms & detail::MICROMAG_EXCHANGE) {
+            const double aex = mat.exchange;
+            const double *g[9];
+            for (size_t i = 0; i < 9; ++i) g[i] = _gradient[i].data() + e0;
+            for (size_t k = 0; k < n; ++k) {
+                const double g1x = g[0][k], g1y = g[1][k], g1z = g[2][k];
+                const double g2x = g[3][k], g2y = g[4][k], g2z = g[5][k];
+                const double g3x = g[6][k], g3y = g[7][k], g3z = g[8][k];
+                const double g0x = -(g1x + g2x + g3x), g0y = -(g1y + g2y + g3y), g0z = -(g1z + g2z + g3z);
+                const double s = 2.0 * aex * vol[k];
+                double e = 0.0;
+                for (size_t c = 0; c < 3; ++c) {
+                    // t = grad m_c.
+                    const double m0 = mv[c][k], m1 = mv[3 + c][k], m2 = mv[6 + c][k], m3 = mv[9 + c][k];
+                    const double tx = g0x * m0 + g1x * m1 + g2x * m2 + g3x * m3;
+                    const double ty = g0y * m0 + g1y * m1 + g2y * m2 + g3y * m3;
+                    const double tz = g0z * m0 + g1z * m1 + g2z * m2 + g3z * m3;
+                    e += tx * tx + ty * ty + tz * tz;
+                    if constexpr (Gradient) {
+                        gv[c][k] += s * (g0x * tx + g0y * ty + g0z * tz);
+                        gv[3 + c][k] += s * (g1x * tx + g1y * ty + g1z * tz);
+                        gv[6 + c][k] += s * (g2x * tx + g2y * ty + g2z * tz);
+                        gv[9 + c][k] += s * (g3x * tx + g3y * ty + g3z * tz);
+                    }
+                }
+                ev[k] = aex * vol[k] * e;
+            }
+            energy[0] = sum();
+        }
+
+        if (terms & detail::MICROMAG_UNIAXIAL) {
+            const double ku = mat.uniaxial;
+            const Vector3<double> u = mat.easy_axis;
+            for (size_t k = 0; k < n; ++k) {
+                const double w = 0.25 * vol[k];
+                double e = 0.0;
+                for (size_t a = 0; a < 4; ++a) {
+                    const double p = mv[3 * a][k] * u.x + mv[3 * a + 1][k] * u.y + mv[3 * a + 2][k] * u.z;
+                    e += p * p;
+                    if constexpr (Gradient) {
+                        const double s = -2.0 * ku * w * p;
+                        gv[3 * a][k] += s * u.x;
+                        gv[3 * a + 1][k] += s * u.y;
+                        gv[3 * a + 2][k] += s * u.z;
+                    }
+                }
+                ev[k] = -ku * w * e;
+            }
+            energy[1] = sum();
+        }
+
+        if (terms & detail::MICROMAG_CUBIC) {
+            const double kc = mat.cubic;
+            const auto &r = mat.cubic_axes.m;
+            for (size_t k = 0; k < n; ++k) {
+                const double w = 0.25 * vol[k];
+                double e = 0.0;
+                for (size_t a = 0; a < 4; ++a) {
+                    const double x = mv[3 * a][k], y = mv[3 * a + 1][k], z = mv[3 * a + 2][k];
+                    const double a1 = r[0][0] * x + r[0][1] * y + r[0][2] * z;
+                    const double a2 = r[1][0] * x + r[1][1] * y + r[1][2] * z;
+                    const double a3 = r[2][0] * x + r[2][1] * y + r[2][2] * z;
+                    const double s1 = a1 * a1, s2 = a2 * a2, s3 = a3 * a3;
+                    e += s1 * s2 + s2 * s3 + s3 * s1;
+                    if constexpr (Gradient) {
+                        // dE/dm = R^T dE/da.
+                        const double s = 2.0 * kc * w;
+                        const double d1 = s * a1 * (s2 + s3), d2 = s * a2 * (s3 + s1), d3 = s * a3 * (s1 + s2);
+                        gv[3 * a][k] += r[0][0] * d1 + r[1][0] * d2 + r[2][0] * d3;
+                        gv[3 * a + 1][k] += r[0][1] * d1 + r[1][1] * d2 + r[2][1] * d3;
+                        gv[3 * a + 2][k] += r[0][2] * d1 + r[1][2] * d2 + r[2][2] * d3;
+                    }
+                }
+                ev[k] = kc * w * e;
+            }
+            energy[2] = sum();
+        }
+
+        if (terms & detail::MICROMAG_ZEEMAN) {
+            const double scale = -MU0 * mat.ms;
+            const Vector3<double> h = mat.applied;
+            for (size_t k = 0; k < n; ++k) {
+                const double w = 0.25 * vol[k];
+                double e = 0.0;
+                for (size_t a = 0; a < 4; ++a) {
+                    e += mv[3 * a][k] * h.x + mv[3 * a + 1][k] * h.y + mv[3 * a + 2][k] * h.z;
+                    if constexpr (Gradient) {
+                        gv[3 * a][k] += scale * w * h.x;
+                        gv[3 * a + 1][k] += scale * w * h.y;
+                        gv[3 * a + 2][k] += scale * w * h.z;
+                    }
+                }
+                ev[k] = scale * w * e;
+            }
+            energy[3] = sum();
+        }
+
+        if (terms & detail::MICROMAG_DEMAG) {
+            // The nodal fields are gathered as m was.
+            alignas(SOA_ALIGNMENT) double hv[12][n];
+            const double *hx = _demag.x(), *hy = _demag.y(), *hz = _demag.z();
+            for (size_t k = 0; k < n; ++k) {
+                for (size_t a = 0; a < 4; ++a) {
+                    const uint32_t v = conn[4 * k + a];
+                    hv[3 * a][k] = hx[v];
+                    hv[3 * a + 1][k] = hy[v];
+                    hv[3 * a + 2][k] = hz[v];
+                }
+            }
+            const double scale = -MU0 * mat.ms;
+            for (size_t k = 0; k < n; ++k) {
+                const double w = 0.25 * scale * vol[k];
+                double e = 0.0;
+                for (size_t i = 0; i < 12; ++i) {
+                    e += mv[i][k] * hv[i][k];
+                    if constexpr (Gradient) gv[i][k] += w * hv[i][k];
+                }
+                ev[k] = 0.5 * w * e;
+            }
+            energy[4] = sum();
+        }
+
+        if constexpr (Gradient) {
+            double *gx = gradient->x(), *gy = gradient->y(), *gz = gradient->z();
+            const size_t count = std::min(n, _elements - e0);
+            for (size_t k = 0; k < count; ++k) {
+                for (size_t a = 0; a < 4; ++a) {
+                    const uint32_t v = conn[4 * k + a];
+                    gx[v] += gv[3 * a][k];
+                    gy[v] += gv[3 * a + 1][k];
+                    gz[v] += gv[3 * a + 2][k];
+                }
+            }
+        }
+    }
+
+    MicromagMaterial _material;
+    MicromagOptions _options;
+    ThreadPool &_pool;
+    size_t _nodes;
+    size_t _elements;
+    ElementColoring _coloring;
+
+    AlignedVector<uint32_t> _connectivity;
+    AlignedVector<double> _volume;
+    std::array<AlignedVector<double>, 9> _gradient;
+    std::vector<double> _weights;
+    std::vector<double> _tile_energy;
+
+    Vector3Array<double> _positions, _moments, _field, _demag;
+    std::vector<double> _potential;
+    std::unique_ptr<Fmm<SphericalOperators>> _fmm;
+    std::vector<Vector3<double>> _moments_aos, _field_aos;
+
+    MicromagEnergies _energies;
+    MicromagTimings _timings;
+};
+
+#endif //FMM_MICROMAGNETICS_HPP
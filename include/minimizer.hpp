@@ -0,0 +1,750 @@
+/**
+ * @file minimizer.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief LBFGS and nonlinear conjugate gradient minimization of energies
+ *        of unit vector fields (|m_i| = 1 at every node), on SoA
+ *        Vector3Array data.
+ *
+ * The constraint is handled by projection and retraction: the search
+ * direction lies in the tangent space (d_i . m_i = 0), found from the
+ * tangent gradient g_i - (g_i . m_i) m_i, and a step takes m_i to
+ * (m_i + a d_i) / |m_i + a d_i|. LBFGS keeps its last `history` step and
+ * gradient change pairs, projected onto the tangent space at the end of
+ * their step, in a ring buffer allocated once; as the pairs come from
+ * earlier tangent spaces, the two loop recursion's result is projected onto
+ * the current one. Nonlinear CG is Polak-Ribiere+ with the previous
+ * direction projected onto the new tangent space.
+ *
+ * The line search starts from a step capped so that no vector turns by more
+ * than about max_angle. For LBFGS it backtracks (by quadratic interpolation)
+ * until the Armijo condition holds; CG, which needs steps near the minimum
+ * along its direction, also asks for the strong Wolfe curvature condition.
+ * Every trial is evaluated with its gradient, which gives the slope there
+ * too, and the accepted trial's gradient is the next iteration's: an
+ * iteration usually costs one energy evaluation. All other work is a few
+ * passes over the field, each fusing its vector updates with the dot
+ * products that follow them; reductions sum fixed blocks in a fixed order,
+ * so results do not depend on the number of threads.
+ */
+
+#ifndef FMM_MINIMIZER_HPP
+#define FMM_MINIMIZER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief The search direction of a UnitVectorMinimizer.
+ */
+enum class MinimizeMethod {
+    lbfgs,  /**< Limited memory BFGS. */
+    cg      /**< Polak-Ribiere+ nonlinear conjugate gradients. */
+};
+
+/**
+ * @brief Parameters of a UnitVectorMinimizer: it stops when the largest
+ *        tangent gradient |g_i - (g_i . m_i) m_i| is at most tolerance times
+ *        its initial value, after max_iterations iterations, or when the
+ *        line search fails.
+ */
+struct MinimizeOptions {
+    MinimizeMethod method = MinimizeMethod::lbfgs;
+    size_t history = 8;            /**< The LBFGS pairs kept. */
+    double tolerance = 1.0e-6;     /**< The relative tangent gradient at which to stop. */
+    size_t max_iterations = 5000;  /**< The most iterations. */
+    double max_angle = 0.5;        /**< The most any vector turns (radians, roughly) in the first trial of a step. */
+    double armijo = 1.0e-4;        /**< The sufficient decrease constant. */
+    double curvature = 0.1;        /**< The strong Wolfe curvature constant of the CG line search. */
+    size_t max_backtracks = 30;    /**< The most trials in one line search, past the first. */
+};
+
+/**
+ * @brief Seconds spent in the energy and gradient evaluations, in finding
+ *        directions (including the history update), in the line search's
+ *        retractions, and the wall time `total`.
+ */
+struct MinimizeTimings {
+    double evaluate = 0.0;
+    double direction = 0.0;
+    double retraction = 0.0;
+    double total = 0.0;
+};
+
+/**
+ * @brief The outcome of a minimization. `history` holds the energy after
+ *        each iteration, history[0] being that of the (normalized) start;
+ *        `gradient_norm` is the final largest tangent gradient.
+ */
+struct MinimizeStats {
+    bool converged = false;
+    size_t iterations = 0;
+    size_t evaluations = 0;
+    double energy = 0.0;
+    double gradient_norm = 0.0;
+    double evaluations_per_second = 0.0;
+    std::vector<double> history;
+    MinimizeTimings timings;
+};
+
+namespace detail {
+
+/**
+ * @brief The vectors per block of the minimizer's passes; reductions sum
+ *        per block, then over the blocks in order.
+ */
+inline constexpr size_t MINIMIZE_BLOCK = 2048;
+
+/**
+ * @brief The largest |a d_i| a line search expands to (a turn of about 83
+ *        degrees).
+ */
+inline constexpr double MINIMIZE_MAX_STEP = 8.0;
+
+/**
+ * @brief o_i = v_i / |v_i| with v_i = a_i + alpha d_i, for i in [first,
+ *        last), leaving zero vectors at zero. std::sqrt keeps a branch (for
+ *        errno) that stops the compiler vectorizing the loop, so the square
+ *        roots and divisions are explicit: four vectors at a time with AVX
+ *        (see the FIGUEROA_NATIVE CMake option), otherwise two with SSE2,
+ *        which every x86-64 target has.
+ */
+inline void unit_range(const double *ax, const double *ay, const double *az, const double *dx, const double *dy,
+                       const double *dz, double alpha, double *ox, double *oy, double *oz, size_t first,
+                       size_t last) {
+    size_t i = first;
+#if defined(__AVX__)
+    const __m256d a = _mm256_set1_pd(alpha), one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+    for (; i + 4 <= last; i += 4) {
+        const __m256d x = _mm256_add_pd(_mm256_loadu_pd(ax + i), _mm256_mul_pd(a, _mm256_loadu_pd(dx + i)));
+        const __m256d y = _mm256_add_pd(_mm256_loadu_pd(ay + i), _mm256_mul_pd(a, _mm256_loadu_pd(dy + i)));
+        const __m256d z = _mm256_add_pd(_mm256_loadu_pd(az + i), _mm256_mul_pd(a, _mm256_loadu_pd(dz + i)));
+        const __m256d r2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)),
+                                         _mm256_mul_pd(z, z));
+        const __m256d s = _mm256_blendv_pd(one, _mm256_div_pd(one, _mm256_sqrt_pd(r2)),
+                                           _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+        _mm256_storeu_pd(ox + i, _mm256_mul_pd(s, x));
+        _mm256_storeu_pd(oy + i, _mm256_mul_pd(s, y));
+        _mm256_storeu_pd(oz + i, _mm256_mul_pd(s, z));
+    }
+#elif defined(__SSE2__)
+    const __m128d a = _mm_set1_pd(alpha), one = _mm_set1_pd(1.0), zero = _mm_setzero_pd();
+    for (; i + 2 <= last; i += 2) {
+        const __m128d x = _mm_add_pd(_mm_loadu_pd(ax + i), _mm_mul_pd(a, _mm_loadu_pd(dx + i)));
+        const __m128d y = _mm_add_pd(_mm_loadu_pd(ay + i), _mm_mul_pd(a, _mm_loadu_pd(dy + i)));
+        const __m128d z = _mm_add_pd(_mm_loadu_pd(az + i), _mm_mul_pd(a, _mm_loadu_pd(dz + i)));
+        const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)), _mm_mul_pd(z, z));
+        // No blendv before SSE4.1: select with and/andnot.
+        const __m128d nonzero = _mm_cmpgt_pd(r2, zero);
+        const __m128d s = _mm_or_pd(_mm_and_pd(nonzero, _mm_div_pd(one, _mm_sqrt_pd(r2))),
+                                    _mm_andnot_pd(nonzero, one));
+        _mm_storeu_pd(ox + i, _mm_mul_pd(s, x));
+        _mm_storeu_pd(oy + i, _mm_mul_pd(s, y));
+        _mm_storeu_pd(oz + i, _mm_mul_pd(s, z));
+    }
+#endif
+    for (; i < last; ++i) {
+        const double x = ax[i] + alpha * dx[i], y = ay[i] + alpha * dy[i], z = az[i] + alpha * dz[i];
+        const double r2 = x * x + y * y + z * z;
+        const double s = r2 > 0.0 ? 1.0 / std::sqrt(r2) : 1.0;
+        ox[i] = s * x;
+        oy[i] = s * y;
+        oz[i] = s * z;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Scales every vector of a field to unit length (zero vectors are
+ *        left alone).
+ */
+inline void normalize_vectors(Vector3Array<double> &v, ThreadPool &pool = ThreadPool::global()) {
+    const size_t blocks = (v.size() + detail::MINIMIZE_BLOCK - 1) / detail::MINIMIZE_BLOCK;
+    parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+        double *x = v.x(), *y = v.y(), *z = v.z();
+        for (size_t b = lo; b < hi; ++b) {
+            detail::unit_range(x, y, z, x, y, z, 0.0, x, y, z, b * detail::MINIMIZE_BLOCK,
+                               std::min(v.size(), (b + 1) * detail::MINIMIZE_BLOCK));
+        }
+    }, pool);
+}
+
+/**
+ * @brief Minimizes energies of unit vector fields of a fixed size, with all
+ *        workspace (the LBFGS ring buffer included) allocated at
+ *        construction.
+ */
+class UnitVectorMinimizer {
+public:
+
+    /**
+     * @param n the number of vectors in the fields minimized.
+     * @param options the method and stopping criteria.
+     * @param pool the pool for the vector passes.
+     *
+     * @throws std::invalid_argument if LBFGS is asked for with no history.
+     */
+    explicit UnitVectorMinimizer(size_t n, const MinimizeOptions &options = {},
+                                 ThreadPool &pool = ThreadPool::global())
+            : _n(n), _options(options), _pool(pool), _trial_gradient(n), _tangent(n), _direction(n),
+              _trial(n), _partial(((n + detail::MINIMIZE_BLOCK - 1) / detail::MINIMIZE_BLOCK) * 5) {
+        if (options.method == MinimizeMethod::lbfgs) {
+            if (options.history == 0) throw std::invalid_argument("UnitVectorMinimizer LBFGS needs a history");
+            _s.assign(options.history, Vector3Array<double>(n));
+            _y.assign(options.history, Vector3Array<double>(n));
+            _rho.assign(options.history, 0.0);
+            _alpha.assign(options.history, 0.0);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return _n; }
+
+    [[nodiscard]] const MinimizeOptions &options() const { return _options; }
+
+    /**
+     * @brief Minimizes an energy from m (normalized first), leaving the
+     *        minimizer in m.
+     *
+     * @tparam Energy a callable `energy(m, gradient)` returning the energy of
+     *                m and overwriting gradient with dE/dm (a
+     *                MicromagEvaluator's evaluate, say).
+     *
+     * @throws std::invalid_argument if m does not have size() vectors.
+     */
+    template <typename Energy>
+    MinimizeStats minimize(Energy &&energy, Vector3Array<double> &m) {
+        if (m.size() != _n) throw std::invalid_argument("UnitVectorMinimizer size mismatch");
+        MinimizeStats stats;
+        stats.history.reserve(_options.max_iterations + 1);
+        auto start = Clock::now();
+        _count = 0;
+        _head = 0;
+
+        normalize_vectors(m, _pool);
+        auto evaluate = [&](const Vector3Array<double> &x, Vector3Array<double> &g) {
+            auto phase = Clock::now();
+            const double e = energy(x, g);
+            stats.timings.evaluate += seconds_since(phase);
+            ++stats.evaluations;
+            return e;
+        };
+
+        double e = evaluate(m, _trial_gradient);
+        double slope_old = 0.0, step = 0.0;
+        auto phase = Clock::now();
+        double norm = tangent(m, _trial_gradient, _tangent);
+        const double target = _options.tolerance * norm;
+        stats.history.push_back(e);
+        stats.timings.direction += seconds_since(phase);
+
+        while (norm > target && stats.iterations < _options.max_iterations) {
+            // The direction, and the slope of the energy along it.
+            phase = Clock::now();
+            bool first = stats.iterations == 0;
+            double slope = _options.method == MinimizeMethod::lbfgs ? lbfgs_direction(m) : cg_direction(m, first);
+            if (!(slope < 0.0)) {
+                // Not a descent direction: restart from steepest descent.
+                _count = 0;
+                slope = steepest_direction();
+                first = true;
+            }
+            stats.timings.direction += seconds_since(phase);
+
+            // The first trial: from steepest descent, the largest turn
+            // (gradients may have any scale); past that a unit step for
+            // LBFGS and the previous decrease's step for CG; never more than
+            // the largest turn.
+            const double longest = max_norm(_direction);
+            double alpha = _options.max_angle / longest;
+            if (!first) {
+                alpha = std::min(alpha, _options.method == MinimizeMethod::lbfgs ? 1.0 : step * slope_old / slope);
+            }
+
+            double trial = 0.0;
+            if (!line_search(evaluate, m, e, slope, longest, alpha, trial, stats)) break;
+
+            phase = Clock::now();
+            slope_old = slope;
+            step = alpha;
+            norm = accept(m);
+            e = trial;
+            stats.timings.direction += seconds_since(phase);
+            ++stats.iterations;
+            stats.history.push_back(e);
+        }
+
+        stats.converged = norm <= target;
+        stats.energy = e;
+        stats.gradient_norm = norm;
+        stats.timings.total = seconds_since(start);
+        stats.evaluations_per_second = double(stats.evaluations) / stats.timings.total;
+        return stats;
+    }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    static double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief Sums f(first, last, acc) (adding to acc[0, count)) over fixed
+     *        blocks of nodes in parallel, then over the blocks in order, into
+     *        sums; the partial sums (count at most 5) live in preallocated
+     *        space.
+     */
+    template <typename F>
+    void reduce(size_t count, double *sums, F &&f) {
+        const size_t blocks = (_n + detail::MINIMIZE_BLOCK - 1) / detail::MINIMIZE_BLOCK;
+        std::fill(_partial.begin(), _partial.begin() + std::ptrdiff_t(blocks * count), 0.0);
+        parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                f(b * detail::MINIMIZE_BLOCK, std::min(_n, (b + 1) * detail::MINIMIZE_BLOCK),
+                  _partial.data() + b * count);
+            }
+        }, _pool);
+        std::fill(sums, sums + count, 0.0);
+        for (size_t b = 0; b < blocks; ++b) {
+            for (size_t c = 0; c < count; ++c) sums[c] += _partial[b * count + c];
+        }
+    }
+
+    /**
+     * @brief Finds a step along _direction from m (energy e, slope < 0),
+     *        starting from alpha, that decreases the energy enough, leaving
+     *        it in alpha, the point in _trial and its energy and gradient in
+     *        trial and _trial_gradient. LBFGS backtracks; CG also asks for
+     *        the strong Wolfe curvature condition, expanding the step until
+     *        the minimum is bracketed and then zooming in, with slopes taken
+     *        from the trials' gradients. Returns false if no step decreases
+     *        the energy enough.
+     */
+    template <typename Evaluate>
+    bool line_search(Evaluate &evaluate, const Vector3Array<double> &m, double e, double slope, double longest,
+                     double &alpha, double &trial, MinimizeStats &stats) {
+        const bool wolfe = _options.method == MinimizeMethod::cg && _options.curvature > 0.0;
+        const double widest = detail::MINIMIZE_MAX_STEP / longest;
+        // lo is the best step yet that decreases the energy enough (0 at
+        // first); once bracketed the minimum lies between lo and hi.
+        double lo = 0.0, e_lo = e, s_lo = slope, hi = 0.0, e_hi = 0.0, last = 0.0;
+        bool bracketed = false;
+        for (size_t k = 0; k <= _options.max_backtracks; ++k) {
+            auto phase = Clock::now();
+            retract(m, alpha, _trial);
+            stats.timings.retraction += seconds_since(phase);
+            trial = evaluate(_trial, _trial_gradient);
+            last = alpha;
+            if (trial > e + _options.armijo * alpha * slope || (lo > 0.0 && trial >= e_lo)) {
+                hi = alpha;
+                e_hi = trial;
+                bracketed = true;
+            } else {
+                if (!wolfe) return true;
+                phase = Clock::now();
+                const double s = trial_slope(m, alpha);
+                stats.timings.retraction += seconds_since(phase);
+                if (std::abs(s) <= -_options.curvature * slope) return true;
+                if (bracketed ? s * (hi - alpha) >= 0.0 : s > 0.0) {
+                    hi = lo;
+                    e_hi = e_lo;
+                    bracketed = true;
+                }
+                lo = alpha;
+                e_lo = trial;
+                s_lo = s;
+            }
+            if (!bracketed) {
+                if (alpha >= widest) break;
+                alpha = std::min(2.0 * alpha, widest);
+            } else {
+                // The minimum of the quadratic with lo's energy and slope
+                // through hi's energy, kept within [0.1, 0.5] of the way
+                // from lo to hi.
+                const double d = hi - lo, c = e_hi - e_lo - s_lo * d;
+                const double f = c > 0.0 ? -s_lo * d / (2.0 * c) : 0.5;
+                alpha = lo + std::clamp(f, 0.1, 0.5) * d;
+            }
+        }
+        // Out of trials: settle for lo, if any step decreased the energy
+        // enough.
+        if (lo == 0.0) return false;
+        if (last != lo) {
+            auto phase = Clock::now();
+            retract(m, lo, _trial);
+            stats.timings.retraction += seconds_since(phase);
+            trial = evaluate(_trial, _trial_gradient);
+        }
+        alpha = lo;
+        return true;
+    }
+
+    /**
+     * @brief The slope at the trial step alpha along the retraction curve
+     *        from m: the sum of (t_i . d_i) / |m_i + alpha d_i| with t the
+     *        trial's tangent gradient.
+     */
+    double trial_slope(const Vector3Array<double> &m, double alpha) {
+        double slope = 0.0;
+        reduce(1, &slope, [&](size_t b, size_t e, double *acc) {
+            const double *mx = m.x(), *my = m.y(), *mz = m.z();
+            const double *nx = _trial.x(), *ny = _trial.y(), *nz = _trial.z();
+            const double *gx = _trial_gradient.x(), *gy = _trial_gradient.y(), *gz = _trial_gradient.z();
+            const double *dx = _direction.x(), *dy = _direction.y(), *dz = _direction.z();
+            double sum = 0.0;
+            for (size_t i = b; i < e; ++i) {
+                const double x = mx[i] + alpha * dx[i], y = my[i] + alpha * dy[i], z = mz[i] + alpha * dz[i];
+                const double gd = gx[i] * dx[i] + gy[i] * dy[i] + gz[i] * dz[i];
+                const double gn = gx[i] * nx[i] + gy[i] * ny[i] + gz[i] * nz[i];
+                const double nd = nx[i] * dx[i] + ny[i] * dy[i] + nz[i] * dz[i];
+                sum += (gd - gn * nd) / std::sqrt(x * x + y * y + z * z);
+            }
+            acc[0] = sum;
+        });
+        return slope;
+    }
+
+    /**
+     * @brief The largest |v_i|.
+     */
+    double max_norm(const Vector3Array<double> &v) {
+        double unused;
+        reduce(1, &unused, [&](size_t b, size_t e, double *acc) {
+            const double *x = v.x(), *y = v.y(), *z = v.z();
+            double r = 0.0;
+            for (size_t i = b; i < e; ++i) r = std::max(r, x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+            acc[0] = r;
+        });
+        return block_max(0, 1);
+    }
+
+    /**
+     * @brief t = g - (g . m) m; returns the largest |t_i|.
+     */
+    double tangent(const Vector3Array<double> &m, const Vector3Array<double> &g, Vector3Array<double> &t) {
+        double sums[2];
+        reduce(2, sums, [&](size_t b, size_t e, double *acc) {
+            const double *mx = m.x(), *my = m.y(), *mz = m.z(), *gx = g.x(), *gy = g.y(), *gz = g.z();
+            double *tx = t.x(), *ty = t.y(), *tz = t.z();
+            double sum = 0.0, largest = 0.0;
+            for (size_t i = b; i < e; ++i) {
+                const double p = gx[i] * mx[i] + gy[i] * my[i] + gz[i] * mz[i];
+                tx[i] = gx[i] - p * mx[i];
+                ty[i] = gy[i] - p * my[i];
+                tz[i] = gz[i] - p * mz[i];
+                const double r = tx[i] * tx[i] + ty[i] * ty[i] + tz[i] * tz[i];
+                sum += r;
+                largest = std::max(largest, r);
+            }
+            acc[0] = sum;
+            acc[1] = largest;
+        });
+        _tt = sums[0];
+        return block_max(1, 2);
+    }
+
+    /**
+     * @brief The largest of the per block values in slot `slot` of `count`
+     *        left in _partial by the last reduce.
+     */
+    [[nodiscard]] double block_max(size_t slot, size_t count) const {
+        const size_t blocks = (_n + detail::MINIMIZE_BLOCK - 1) / detail::MINIMIZE_BLOCK;
+        double largest = 0.0;
+        for (size_t b = 0; b < blocks; ++b) largest = std::max(largest, _partial[b * count + slot]);
+        return std::sqrt(largest);
+    }
+
+    /**
+     * @brief d = -t; returns the slope t . d.
+     */
+    double steepest_direction() {
+        double slope = 0.0;
+        reduce(1, &slope, [&](size_t b, size_t e, double *acc) {
+            const double *tx = _tangent.x(), *ty = _tangent.y(), *tz = _tangent.z();
+            double *dx = _direction.x(), *dy = _direction.y(), *dz = _direction.z();
+            double sum = 0.0;
+            for (size_t i = b; i < e; ++i) {
+                dx[i] = -tx[i];
+                dy[i] = -ty[i];
+                dz[i] = -tz[i];
+                sum -= tx[i] * tx[i] + ty[i] * ty[i] + tz[i] * tz[i];
+            }
+            acc[0] = sum;
+        });
+        return slope;
+    }
+
+    /**
+     * @brief d = -P H t by the two loop recursion over the history (newest
+     *        first, then oldest first), each update fused with the next dot
+     *        product, and projected onto the tangent space at m; returns the
+     *        slope t . d.
+     */
+    double lbfgs_direction(const Vector3Array<double> &m) {
+        const size_t h = _options.history;
+        auto pair = [&](size_t k) { return (_head + h - 1 - k) % h; };  // k = 0 is the newest.
+        Vector3Array<double> &q = _direction;
+
+        // q = t, with the first dot product s . q.
+        double dot = 0.0;
+        {
+            const Vector3Array<double> *s = _count > 0 ? &_s[pair(0)] : nullptr;
+            reduce(1, &dot, [&](size_t b, size_t e, double *acc) {
+                const double *tx = _tangent.x(), *ty = _tangent.y(), *tz = _tangent.z();
+                double *qx = q.x(), *qy = q.y(), *qz = q.z();
+                double sum = 0.0;
+                for (size_t i = b; i < e; ++i) {
+                    qx[i] = tx[i];
+                    qy[i] = ty[i];
+                    qz[i] = tz[i];
+                }
+                if (s) {
+                    const double *sx = s->x(), *sy = s->y(), *sz = s->z();
+                    for (size_t i = b; i < e; ++i) sum += sx[i] * qx[i] + sy[i] * qy[i] + sz[i] * qz[i];
+                }
+                acc[0] = sum;
+            });
+        }
+        for (size_t k = 0; k < _count; ++k) {
+            const size_t p = pair(k);
+            _alpha[p] = _rho[p] * dot;
+            // q -= alpha y_k, then s_(k+1) . q.
+            const Vector3Array<double> &y = _y[p];
+            const Vector3Array<double> *s = k + 1 < _count ? &_s[pair(k + 1)] : nullptr;
+            const double a = _alpha[p];
+            reduce(1, &dot, [&](size_t b, size_t e, double *acc) {
+                double *qx = q.x(), *qy = q.y(), *qz = q.z();
+                const double *yx = y.x(), *yy = y.y(), *yz = y.z();
+                for (size_t i = b; i < e; ++i) {
+                    qx[i] -= a * yx[i];
+                    qy[i] -= a * yy[i];
+                    qz[i] -= a * yz[i];
+                }
+                double sum = 0.0;
+                if (s) {
+                    const double *sx = s->x(), *sy = s->y(), *sz = s->z();
+                    for (size_t i = b; i < e; ++i) sum += sx[i] * qx[i] + sy[i] * qy[i] + sz[i] * qz[i];
+                }
+                acc[0] = sum;
+            });
+        }
+
+        // r = gamma q, with the first y . r; gamma = s . y / y . y of the
+        // newest pair (1 with no history, scaled by the line search).
+        const double gamma = _count > 0 ? _gamma : 1.0;
+        {
+            const Vector3Array<double> *y = _count > 0 ? &_y[pair(_count - 1)] : nullptr;
+            reduce(1, &dot, [&](size_t b, size_t e, double *acc) {
+                double *qx = q.x(), *qy = q.y(), *qz = q.z();
+                double sum = 0.0;
+                for (size_t i = b; i < e; ++i) {
+                    qx[i] *= gamma;
+                    qy[i] *= gamma;
+                    qz[i] *= gamma;
+                }
+                if (y) {
+                    const double *yx = y->x(), *yy = y->y(), *yz = y->z();
+                    for (size_t i = b; i < e; ++i) sum += yx[i] * qx[i] + yy[i] * qy[i] + yz[i] * qz[i];
+                }
+                acc[0] = sum;
+            });
+        }
+        for (size_t j = _count; j-- > 0;) {
+            const size_t p = pair(j);
+            const double c = _alpha[p] - _rho[p] * dot;
+            // r += (alpha - beta) s_k, then y_(k-1) . r.
+            const Vector3Array<double> &s = _s[p];
+            const Vector3Array<double> *y = j > 0 ? &_y[pair(j - 1)] : nullptr;
+            reduce(1, &dot, [&](size_t b, size_t e, double *acc) {
+                double *qx = q.x(), *qy = q.y(), *qz = q.z();
+                const double *sx = s.x(), *sy = s.y(), *sz = s.z();
+                for (size_t i = b; i < e; ++i) {
+                    qx[i] += c * sx[i];
+                    qy[i] += c * sy[i];
+                    qz[i] += c * sz[i];
+                }
+                double sum = 0.0;
+                if (y) {
+                    const double *yx = y->x(), *yy = y->y(), *yz = y->z();
+                    for (size_t i = b; i < e; ++i) sum += yx[i] * qx[i] + yy[i] * qy[i] + yz[i] * qz[i];
+                }
+                acc[0] = sum;
+            });
+        }
+
+        // d = -P r: the pairs lie in earlier tangent spaces, so r has a
+        // component along m that the retraction would waste. The slope t . d
+        // is that of the unprojected direction, as t is in this space.
+        double slope = 0.0;
+        reduce(1, &slope, [&](size_t b, size_t e, double *acc) {
+            const double *mx = m.x(), *my = m.y(), *mz = m.z();
+            double *dx = q.x(), *dy = q.y(), *dz = q.z();
+            const double *tx = _tangent.x(), *ty = _tangent.y(), *tz = _tangent.z();
+            double sum = 0.0;
+            for (size_t i = b; i < e; ++i) {
+                const double p = dx[i] * mx[i] + dy[i] * my[i] + dz[i] * mz[i];
+                dx[i] = p * mx[i] - dx[i];
+                dy[i] = p * my[i] - dy[i];
+                dz[i] = p * mz[i] - dz[i];
+                sum += tx[i] * dx[i] + ty[i] * dy[i] + tz[i] * dz[i];
+            }
+            acc[0] = sum;
+        });
+        return slope;
+    }
+
+    /**
+     * @brief d = -t + beta P d_old (Polak-Ribiere+, beta from accept); returns
+     *        the slope t . d.
+     */
+    double cg_direction(const Vector3Array<double> &m, bool first) {
+        const double beta = first ? 0.0 : _beta;
+        double slope = 0.0;
+        reduce(1, &slope, [&](size_t b, size_t e, double *acc) {
+            const double *mx = m.x(), *my = m.y(), *mz = m.z();
+            const double *tx = _tangent.x(), *ty = _tangent.y(), *tz = _tangent.z();
+            double *dx = _direction.x(), *dy = _direction.y(), *dz = _direction.z();
+            double sum = 0.0;
+            for (size_t i = b; i < e; ++i) {
+                const double p = dx[i] * mx[i] + dy[i] * my[i] + dz[i] * mz[i];
+                dx[i] = beta * (dx[i] - p * mx[i]) - tx[i];
+                dy[i] = beta * (dy[i] - p * my[i]) - ty[i];
+                dz[i] = beta * (dz[i] - p * mz[i]) - tz[i];
+                sum += tx[i] * dx[i] + ty[i] * dy[i] + tz[i] * dz[i];
+            }
+            acc[0] = sum;
+        });
+        return slope;
+    }
+
+    /**
+     * @brief out = (m + alpha d) / |m + alpha d|, vector by vector.
+     */
+    void retract(const Vector3Array<double> &m, double alpha, Vector3Array<double> &out) {
+        // Fixed blocks, so that the scalar remainder of the vector loop
+        // falls on the same vectors for any number of threads.
+        const size_t blocks = (_n + detail::MINIMIZE_BLOCK - 1) / detail::MINIMIZE_BLOCK;
+        parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                detail::unit_range(m.x(), m.y(), m.z(), _direction.x(), _direction.y(), _direction.z(), alpha,
+                                   out.x(), out.y(), out.z(), b * detail::MINIMIZE_BLOCK,
+                                   std::min(_n, (b + 1) * detail::MINIMIZE_BLOCK));
+            }
+        }, _pool);
+    }
+
+    /**
+     * @brief Moves to the accepted trial in one pass: the new tangent
+     *        gradient, the history pair (s, y) projected onto the new
+     *        tangent space (LBFGS) or the Polak-Ribiere+ beta (CG), and m.
+     *        Returns the largest tangent gradient.
+     */
+    double accept(Vector3Array<double> &m) {
+        const bool lbfgs = _options.method == MinimizeMethod::lbfgs;
+        const size_t h = lbfgs ? _options.history : 1;
+        double *s[3] = {}, *y[3] = {};
+        if (lbfgs) {
+            // With a full history pair _head is the oldest one: drop it before
+            // it is overwritten, whether or not the new pair is kept.
+            if (_count == h) --_count;
+            s[0] = _s[_head].x(), s[1] = _s[_head].y(), s[2] = _s[_head].z();
+            y[0] = _y[_head].x(), y[1] = _y[_head].y(), y[2] = _y[_head].z();
+        }
+        // sums: t . t, max |t|^2, s . y, y . y (LBFGS) or t . (t - P t_old) (CG).
+        double sums[5];
+        reduce(5, sums, [&](size_t b, size_t e, double *acc) {
+            double *mx = m.x(), *my = m.y(), *mz = m.z();
+            const double *nx = _trial.x(), *ny = _trial.y(), *nz = _trial.z();
+            const double *gx = _trial_gradient.x(), *gy = _trial_gradient.y(), *gz = _trial_gradient.z();
+            double *tx = _tangent.x(), *ty = _tangent.y(), *tz = _tangent.z();
+            double tt_sum = 0.0, largest = 0.0, sy = 0.0, yy = 0.0, pr = 0.0;
+            for (size_t i = b; i < e; ++i) {
+                const double p = gx[i] * nx[i] + gy[i] * ny[i] + gz[i] * nz[i];
+                const double ux = gx[i] - p * nx[i], uy = gy[i] - p * ny[i], uz = gz[i] - p * nz[i];
+                // The old tangent gradient and the step, projected.
+                const double q = tx[i] * nx[i] + ty[i] * ny[i] + tz[i] * nz[i];
+                const double ox = tx[i] - q * nx[i], oy = ty[i] - q * ny[i], oz = tz[i] - q * nz[i];
+                const double wx = ux - ox, wy = uy - oy, wz = uz - oz;
+                if (lbfgs) {
+                    const double dx = nx[i] - mx[i], dy = ny[i] - my[i], dz = nz[i] - mz[i];
+                    const double r = dx * nx[i] + dy * ny[i] + dz * nz[i];
+                    const double sx = dx - r * nx[i], sy_ = dy - r * ny[i], sz = dz - r * nz[i];
+                    s[0][i] = sx;
+                    s[1][i] = sy_;
+                    s[2][i] = sz;
+                    y[0][i] = wx;
+                    y[1][i] = wy;
+                    y[2][i] = wz;
+                    sy += sx * wx + sy_ * wy + sz * wz;
+                    yy += wx * wx + wy * wy + wz * wz;
+                } else {
+                    pr += ux * wx + uy * wy + uz * wz;
+                }
+                tx[i] = ux;
+                ty[i] = uy;
+                tz[i] = uz;
+                mx[i] = nx[i];
+                my[i] = ny[i];
+                mz[i] = nz[i];
+                const double r2 = ux * ux + uy * uy + uz * uz;
+                tt_sum += r2;
+                largest = std::max(largest, r2);
+            }
+            acc[0] = tt_sum;
+            acc[1] = largest;
+            acc[2] = sy;
+            acc[3] = yy;
+            acc[4] = pr;
+        });
+        const double largest = block_max(1, 5);
+        if (lbfgs) {
+            // Keep the pair only if it has positive curvature.
+            if (sums[2] > 1.0e-300 && sums[3] > 0.0) {
+                _rho[_head] = 1.0 / sums[2];
+                _gamma = sums[2] / sums[3];
+                _head = (_head + 1) % h;
+                _count = std::min(_count + 1, h);
+            }
+        } else {
+            _beta = _tt > 0.0 ? std::max(0.0, sums[4] / _tt) : 0.0;
+        }
+        _tt = sums[0];
+        return largest;
+    }
+
+    size_t _n;
+    MinimizeOptions _options;
+    ThreadPool &_pool;
+
+    Vector3Array<double> _trial_gradient, _tangent, _direction, _trial;
+    std::vector<double> _partial;
+
+    // The LBFGS ring buffer: pair _head is written next, and _count pairs
+    // precede it.
+    std::vector<Vector3Array<double>> _s, _y;
+    std::vector<double> _rho, _alpha;
+    size_t _head = 0;
+    size_t _count = 0;
+    double _gamma = 1.0;
+
+    // t . t of the current tangent gradient, and the CG beta.
+    double _tt = 0.0;
+    double _beta = 0.0;
+};
+
+#endif //FMM_MINIMIZER_HPP
@@ -0,0 +1,193 @@
+/**
+ * @file morton.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief 63-bit Morton (Z-order) keys of points quantised to a 2^21 grid.
+ */
+
+#ifndef FMM_MORTON_HPP
+#define FMM_MORTON_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief The number of bits per coordinate in a Morton key.
+ */
+inline constexpr unsigned MORTON_BITS = 21;
+
+/**
+ * @brief The number of grid cells along each axis at the finest level.
+ */
+inline constexpr uint32_t MORTON_CELLS = uint32_t{1} << MORTON_BITS;
+
+// ######################################################################### //
+// # Bit interleaving.                                                     # //
+// ######################################################################### //
+
+/**
+ * @brief Spreads the low 21 bits of v so that bit i moves to bit 3i, using
+ *        shift-and-mask ("magic bits") steps.
+ */
+inline uint64_t morton_spread3_magic(uint32_t v) {
+    uint64_t x = v & 0x1fffff;
+    x = (x | x << 32) & 0x001f00000000ffffull;
+    x = (x | x << 16) & 0x001f0000ff0000ffull;
+    x = (x | x << 8)  & 0x100f00f00f00f00full;
+    x = (x | x << 4)  & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2)  & 0x1249249249249249ull;
+    return x;
+}
+
+/**
+ * @brief The inverse of morton_spread3_magic: gathers bits 0, 3, 6, ... of x.
+ */
+inline uint32_t morton_compact3_magic(uint64_t x) {
+    x &= 0x1249249249249249ull;
+    x = (x ^ (x >> 2))  & 0x10c30c30c30c30c3ull;
+    x = (x ^ (x >> 4))  & 0x100f00f00f00f00full;
+    x = (x ^ (x >> 8))  & 0x001f0000ff0000ffull;
+    x = (x ^ (x >> 16)) & 0x001f00000000ffffull;
+    x = (x ^ (x >> 32)) & 0x00000000001fffffull;
+    return static_cast<uint32_t>(x);
+}
+
+/**
+ * @brief Spreads the low 21 bits of v so that bit i moves to bit 3i.
+ *
+ * Uses BMI2 pdep when the target has it. pdep is microcoded and slow on AMD
+ * processors before Zen 3; define FMM_NO_PDEP to use the magic bits there.
+ */
+inline uint64_t morton_spread3(uint32_t v) {
+#if defined(__BMI2__) && !defined(FMM_NO_PDEP)
+    return _pdep_u64(v, 0x1249249249249249ull);
+#else
+    return morton_spread3_magic(v);
+#endif
+}
+
+/**
+ * @brief Gathers bits 0, 3, 6, ... of x (the inverse of morton_spread3).
+ */
+inline uint32_t morton_compact3(uint64_t x) {
+#if defined(__BMI2__) && !defined(FMM_NO_PDEP)
+    return static_cast<uint32_t>(_pext_u64(x, 0x1249249249249249ull));
+#else
+    return morton_compact3_magic(x);
+#endif
+}
+
+/**
+ * @brief The Morton key of a grid cell: bit 3i+k of the key is bit i of
+ *        coordinate k (x = 0, y = 1, z = 2).
+ */
+inline uint64_t morton_encode(uint32_t x, uint32_t y, uint32_t z) {
+    return morton_spread3(x) | morton_spread3(y) << 1 | morton_spread3(z) << 2;
+}
+
+/**
+ * @brief The grid cell of a Morton key.
+ */
+inline void morton_decode(uint64_t key, uint32_t &x, uint32_t &y, uint32_t &z) {
+    x = morton_compact3(key);
+    y = morton_compact3(key >> 1);
+    z = morton_compact3(key >> 2);
+}
+
+// ######################################################################### //
+// # Quantisation.                                                         # //
+// ######################################################################### //
+
+/**
+ * @brief An axis aligned cube [min, min + size]^3.
+ *
+ * @tparam T the base data type.
+ */
+template <typename T>
+struct BoundingCube {
+    Vector3<T> min; /**< The lower corner. */
+    T size;         /**< The edge length. */
+};
+
+/**
+ * @brief The smallest cube (slightly enlarged, so that the upper faces
+ *        quantise inside the grid) containing the points, found in parallel.
+ */
+template <typename T>
+BoundingCube<T> bounding_cube(std::span<const Vector3<T>> points,
+                              ThreadPool &pool = ThreadPool::global()) {
+    if (points.empty()) return {{T(0), T(0), T(0)}, T(1)};
+
+    constexpr T inf = std::numeric_limits<T>::infinity();
+    std::vector<Vector3<T>> lo(pool.size(), {inf, inf, inf}), hi(pool.size(), {-inf, -inf, -inf});
+    parallel_for_worker(0, points.size(), 1 << 16, [&](size_t b, size_t e, size_t w) {
+        Vector3<T> l = lo[w], h = hi[w];
+        for (size_t i = b; i < e; ++i) {
+            const Vector3<T> &p = points[i];
+            l = {std::min(l.x, p.x), std::min(l.y, p.y), std::min(l.z, p.z)};
+            h = {std::max(h.x, p.x), std::max(h.y, p.y), std::max(h.z, p.z)};
+        }
+        lo[w] = l;
+        hi[w] = h;
+    }, pool);
+
+    Vector3<T> l = lo[0], h = hi[0];
+    for (size_t w = 1; w < lo.size(); ++w) {
+        l = {std::min(l.x, lo[w].x), std::min(l.y, lo[w].y), std::min(l.z, lo[w].z)};
+        h = {std::max(h.x, hi[w].x), std::max(h.y, hi[w].y), std::max(h.z, hi[w].z)};
+    }
+    T size = std::max({h.x - l.x, h.y - l.y, h.z - l.z});
+    if (!(size > T(0))) size = T(1);
+    return {l, size * (T(1) + T(16) * std::numeric_limits<T>::epsilon())};
+}
+
+/**
+ * @brief The finest level grid cell of a point, clamped to the grid.
+ */
+template <typename T>
+inline void morton_cell(const BoundingCube<T> &cube, const Vector3<T> &p,
+                        uint32_t &x, uint32_t &y, uint32_t &z) {
+    const T scale = T(MORTON_CELLS) / cube.size;
+    auto q = [&](T v) {
+        T c = v * scale;
+        if (!(c > T(0))) return uint32_t{0};
+        return std::min(static_cast<uint32_t>(c), MORTON_CELLS - 1);
+    };
+    x = q(p.x - cube.min.x);
+    y = q(p.y - cube.min.y);
+    z = q(p.z - cube.min.z);
+}
+
+/**
+ * @brief The Morton key of a point in a bounding cube.
+ */
+template <typename T>
+inline uint64_t morton_key(const BoundingCube<T> &cube, const Vector3<T> &p) {
+    uint32_t x, y, z;
+    morton_cell(cube, p, x, y, z);
+    return morton_encode(x, y, z);
+}
+
+/**
+ * @brief The Morton keys of a set of points, computed in parallel.
+ */
+template <typename T>
+void morton_keys(std::span<uint64_t> keys, std::span<const Vector3<T>> points,
+                 const BoundingCube<T> &cube, ThreadPool &pool = ThreadPool::global()) {
+    parallel_for(0, points.size(), 1 << 14, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) keys[i] = morton_key(cube, points[i]);
+    }, pool);
+}
+
+#endif //FMM_MORTON_HPP
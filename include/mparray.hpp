@@ -0,0 +1,456 @@
+/**
+ * @file mparray.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Contiguous arrays of MPFR values and batch kernels over them.
+ */
+
+#ifndef FMM_MPARRAY_HPP
+#define FMM_MPARRAY_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <mpfr.h>
+
+#include "linalg.hpp"
+#include "mpreal.hpp"
+#include "parallel.hpp"
+
+// ######################################################################### //
+// # Array.                                                                # //
+// ######################################################################### //
+
+/**
+ * @brief An array of N MPFR values sharing one precision.
+ *
+ * The significands (limbs) of all values live in a single contiguous slab and
+ * the mpfr headers in a second contiguous array, so that walking the array
+ * touches memory sequentially. Each element is exposed as an ordinary mpfr_t
+ * view; the views must not be passed to functions that change precision
+ * (mpfr_set_prec, mpfr_swap, mpfr_clear).
+ */
+class MpArray {
+public:
+
+    MpArray() = default;
+
+    /**
+     * @brief Creates an array of zeros.
+     *
+     * @param n the number of values.
+     * @param prec the precision in bits of every value.
+     */
+    explicit MpArray(size_t n, mpfr_prec_t prec = mpfr_get_default_prec()) {
+        allocate(n, prec);
+    }
+
+    MpArray(const MpArray &other) {
+        allocate(other._n, other._prec);
+        for (size_t i = 0; i < _n; ++i) mpfr_set(&_heads[i], &other._heads[i], MP_RND);
+    }
+
+    MpArray(MpArray &&other) noexcept
+            : _n(std::exchange(other._n, 0)), _prec(other._prec),
+              _nlimbs(std::exchange(other._nlimbs, 0)),
+              _limbs(std::move(other._limbs)), _heads(std::move(other._heads)) {}
+
+    MpArray &operator=(const MpArray &other) {
+        if (this != &other) {
+            MpArray tmp(other);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    MpArray &operator=(MpArray &&other) noexcept {
+        _n = std::exchange(other._n, 0);
+        _prec = other._prec;
+        _nlimbs = std::exchange(other._nlimbs, 0);
+        _limbs = std::move(other._limbs);
+        _heads = std::move(other._heads);
+        return *this;
+    }
+
+    /**
+     * @brief The number of values.
+     */
+    [[nodiscard]] size_t size() const { return _n; }
+
+    /**
+     * @brief The precision in bits shared by all values.
+     */
+    [[nodiscard]] mpfr_prec_t precision() const { return _prec; }
+
+    /**
+     * @brief The number of limbs reserved per value in the slab.
+     */
+    [[nodiscard]] size_t limbs_per_value() const { return _nlimbs; }
+
+    /**
+     * @brief A view of the i-th value.
+     */
+    mpfr_ptr operator[](size_t i) { return &_heads[i]; }
+
+    /**
+     * @brief A view of the i-th value.
+     */
+    mpfr_srcptr operator[](size_t i) const { return &_heads[i]; }
+
+    /**
+     * @brief The limb slab.
+     */
+    [[nodiscard]] const mp_limb_t *limbs() const { return _limbs.data(); }
+
+    /**
+     * @brief Sets the i-th value from an MpReal (rounding to this precision).
+     */
+    void set(size_t i, const MpReal &v) { mpfr_set(&_heads[i], v.mpfr(), MP_RND); }
+
+    /**
+     * @brief Sets the i-th value from a double.
+     */
+    void set(size_t i, double v) { mpfr_set_d(&_heads[i], v, MP_RND); }
+
+    /**
+     * @brief Copies the i-th value out as an MpReal at this precision.
+     */
+    [[nodiscard]] MpReal get(size_t i) const { return MpReal(&_heads[i]); }
+
+private:
+
+    void allocate(size_t n, mpfr_prec_t prec) {
+        _n = n;
+        _prec = prec;
+        size_t bytes = mpfr_custom_get_size(prec);
+        _nlimbs = (bytes + sizeof(mp_limb_t) - 1) / sizeof(mp_limb_t);
+        _limbs.assign(_n * _nlimbs, 0);
+        _heads.resize(_n);
+        for (size_t i = 0; i < _n; ++i) {
+            mp_limb_t *significand = _limbs.data() + i * _nlimbs;
+            mpfr_custom_init(significand, prec);
+            mpfr_custom_init_set(&_heads[i], MPFR_ZERO_KIND, 0, prec, significand);
+        }
+    }
+
+    size_t _n = 0;
+    mpfr_prec_t _prec = MPFR_PREC_MIN;
+    size_t _nlimbs = 0;
+    std::vector<mp_limb_t> _limbs;
+    std::vector<__mpfr_struct> _heads;
+};
+
+// ######################################################################### //
+// # Packing.                                                              # //
+// ######################################################################### //
+
+/**
+ * @brief Stores a Vector3 as the three values starting at 3*i.
+ */
+inline void mp_store(MpArray &dst, size_t i, const Vector3<MpReal> &v) {
+    dst.set(3 * i + 0, v.x);
+    dst.set(3 * i + 1, v.y);
+    dst.set(3 * i + 2, v.z);
+}
+
+/**
+ * @brief Loads the Vector3 stored at 3*i.
+ */
+inline Vector3<MpReal> mp_load_vector3(const MpArray &src, size_t i) {
+    return {src.get(3 * i + 0), src.get(3 * i + 1), src.get(3 * i + 2)};
+}
+
+/**
+ * @brief Stores a row-major Matrix3x3 as the nine values starting at 9*i.
+ */
+inline void mp_store(MpArray &dst, size_t i, const Matrix3x3<MpReal> &a) {
+    for (size_t r = 0; r < 3; ++r)
+        for (size_t c = 0; c < 3; ++c) dst.set(9 * i + 3 * r + c, a.m[r][c]);
+}
+
+/**
+ * @brief Loads the Matrix3x3 stored at 9*i.
+ */
+inline Matrix3x3<MpReal> mp_load_matrix3x3(const MpArray &src, size_t i) {
+    Matrix3x3<MpReal> a;
+    for (size_t r = 0; r < 3; ++r)
+        for (size_t c = 0; c < 3; ++c) a.m[r][c] = src.get(9 * i + 3 * r + c);
+    return a;
+}
+
+/**
+ * @brief Stores a row-major Matrix4x4 as the sixteen values starting at 16*i.
+ */
+inline void mp_store(MpArray &dst, size_t i, const Matrix4x4<MpReal> &a) {
+    for (size_t r = 0; r < 4; ++r)
+        for (size_t c = 0; c < 4; ++c) dst.set(16 * i + 4 * r + c, a.m[r][c]);
+}
+
+/**
+ * @brief Loads the Matrix4x4 stored at 16*i.
+ */
+inline Matrix4x4<MpReal> mp_load_matrix4x4(const MpArray &src, size_t i) {
+    Matrix4x4<MpReal> a;
+    for (size_t r = 0; r < 4; ++r)
+        for (size_t c = 0; c < 4; ++c) a.m[r][c] = src.get(16 * i + 4 * r + c);
+    return a;
+}
+
+// ######################################################################### //
+// # Batch kernels.                                                        # //
+// ######################################################################### //
+
+/**
+ * @brief Minimum number of results per thread in the batch kernels; below
+ *        this the kernels run on the calling thread.
+ */
+inline constexpr size_t MP_BATCH_GRAIN = 512;
+
+/**
+ * @brief A scratch mpfr value that lives for the duration of one chunk.
+ */
+class MpScratch {
+public:
+    explicit MpScratch(mpfr_prec_t prec) { mpfr_init2(_v, prec); }
+    MpScratch(const MpScratch &) = delete;
+    MpScratch &operator=(const MpScratch &) = delete;
+    ~MpScratch() { mpfr_clear(_v); }
+    operator mpfr_ptr() { return _v; }
+private:
+    mpfr_t _v;
+};
+
+namespace detail {
+
+inline void mp_check_sizes(size_t r, size_t a, size_t b) {
+    if (r != a || r != b) throw std::invalid_argument("MpArray size mismatch");
+}
+
+template <typename Op>
+void mp_batch_elementwise(MpArray &r, const MpArray &a, const MpArray &b, Op op) {
+    mp_check_sizes(r.size(), a.size(), b.size());
+    parallel_for(0, r.size(), 4 * MP_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) op(r[i], a[i], b[i], MP_RND);
+    });
+}
+
+} // namespace detail
+
+/**
+ * @brief Elementwise r[i] = a[i] + b[i].
+ */
+inline void mp_batch_add(MpArray &r, const MpArray &a, const MpArray &b) {
+    detail::mp_batch_elementwise(r, a, b, mpfr_add);
+}
+
+/**
+ * @brief Elementwise r[i] = a[i] - b[i].
+ */
+inline void mp_batch_sub(MpArray &r, const MpArray &a, const MpArray &b) {
+    detail::mp_batch_elementwise(r, a, b, mpfr_sub);
+}
+
+/**
+ * @brief Elementwise r[i] = a[i] * b[i].
+ */
+inline void mp_batch_mul(MpArray &r, const MpArray &a, const MpArray &b) {
+    detail::mp_batch_elementwise(r, a, b, mpfr_mul);
+}
+
+/**
+ * @brief Elementwise r[i] = a[i] / b[i].
+ */
+inline void mp_batch_div(MpArray &r, const MpArray &a, const MpArray &b) {
+    detail::mp_batch_elementwise(r, a, b, mpfr_div);
+}
+
+/**
+ * @brief Inner products of packed N-vectors, r[i] = <a_i, b_i>.
+ *
+ * The products are accumulated with fused multiply-adds directly into r, so
+ * each result is rounded once per term at r's precision.
+ *
+ * @tparam N the vector dimension (2, 3 or 4).
+ *
+ * @param r the results (n values).
+ * @param a the first operands, packed (N*n values).
+ * @param b the second operands, packed (N*n values).
+ */
+template <size_t N>
+void mp_batch_inner(MpArray &r, const MpArray &a, const MpArray &b) {
+    detail::mp_check_sizes(N * r.size(), a.size(), b.size());
+    parallel_for(0, r.size(), MP_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t k = N * i;
+            mpfr_mul(r[i], a[k], b[k], MP_RND);
+            for (size_t j = 1; j < N; ++j) mpfr_fma(r[i], a[k + j], b[k + j], r[i], MP_RND);
+        }
+    });
+}
+
+/**
+ * @brief Determinants of packed row-major Matrix3x3 instances.
+ *
+ * @param r the results (n values).
+ * @param a the matrices, packed (9*n values).
+ */
+inline void mp_batch_det3(MpArray &r, const MpArray &a) {
+    detail::mp_check_sizes(9 * r.size(), a.size(), a.size());
+    parallel_for(0, r.size(), MP_BATCH_GRAIN / 4, [&](size_t begin, size_t end) {
+        MpScratch t(r.precision()), u(r.precision());
+        for (size_t i = begin; i < end; ++i) {
+            size_t k = 9 * i;
+            auto e = [&](size_t row, size_t col) { return a[k + 3 * row + col]; };
+            // r = a00 (a11 a22 - a12 a21)
+            mpfr_mul(t, e(1, 2), e(2, 1), MP_RND);
+            mpfr_fms(t, e(1, 1), e(2, 2), t, MP_RND);
+            mpfr_mul(r[i], e(0, 0), t, MP_RND);
+            // r -= a01 (a10 a22 - a12 a20)
+            mpfr_mul(t, e(1, 2), e(2, 0), MP_RND);
+            mpfr_fms(t, e(1, 0), e(2, 2), t, MP_RND);
+            mpfr_mul(u, e(0, 1), t, MP_RND);
+            mpfr_sub(r[i], r[i], u, MP_RND);
+            // r += a02 (a10 a21 - a11 a20)
+            mpfr_mul(t, e(1, 1), e(2, 0), MP_RND);
+            mpfr_fms(t, e(1, 0), e(2, 1), t, MP_RND);
+            mpfr_fma(r[i], e(0, 2), t, r[i], MP_RND);
+        }
+    });
+}
+
+namespace detail {
+
+/**
+ * @brief The body of mp_batch_det4 for results [begin, end), on the calling
+ *        thread.
+ */
+inline void mp_det4_range(MpArray &r, const MpArray &a, size_t begin, size_t end) {
+    mpfr_prec_t prec = r.precision();
+    MpScratch s0(prec), s1(prec), s2(prec), s3(prec), s4(prec), s5(prec);
+    MpScratch c(prec), t(prec);
+    mpfr_ptr s[6] = {s0, s1, s2, s3, s4, s5};
+    static constexpr size_t pairs[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+    static constexpr int sign[6] = {1, -1, 1, 1, -1, 1};
+    for (size_t i = begin; i < end; ++i) {
+        size_t k = 16 * i;
+        auto e = [&](size_t row, size_t col) { return a[k + 4 * row + col]; };
+        for (size_t p = 0; p < 6; ++p) {
+            size_t j0 = pairs[p][0], j1 = pairs[p][1];
+            mpfr_mul(t, e(0, j1), e(1, j0), MP_RND);
+            mpfr_fms(s[p], e(0, j0), e(1, j1), t, MP_RND);
+        }
+        mpfr_set_zero(r[i], 1);
+        for (size_t p = 0; p < 6; ++p) {
+            // The complementary column pair of pairs[p] is pairs[5 - p].
+            size_t j0 = pairs[5 - p][0], j1 = pairs[5 - p][1];
+            mpfr_mul(t, e(2, j1), e(3, j0), MP_RND);
+            mpfr_fms(c, e(2, j0), e(3, j1), t, MP_RND);
+            if (sign[p] > 0) {
+                mpfr_fma(r[i], s[p], c, r[i], MP_RND);
+            } else {
+                mpfr_mul(t, s[p], c, MP_RND);
+                mpfr_sub(r[i], r[i], t, MP_RND);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Determinants of packed row-major Matrix4x4 instances, using the
+ *        Laplace expansion over complementary 2x2 minors of the top and
+ *        bottom row pairs.
+ *
+ * @param r the results (n values).
+ * @param a the matrices, packed (16*n values).
+ */
+inline void mp_batch_det4(MpArray &r, const MpArray &a) {
+    detail::mp_check_sizes(16 * r.size(), a.size(), a.size());
+    parallel_for(0, r.size(), MP_BATCH_GRAIN / 8, [&](size_t begin, size_t end) {
+        detail::mp_det4_range(r, a, begin, end);
+    });
+}
+
+namespace detail {
+
+/**
+ * @brief The body of mp_batch_adj4 for matrices [begin, end), on the calling
+ *        thread.
+ */
+inline void mp_adj4_range(MpArray &r, const MpArray &a, size_t begin, size_t end) {
+    // Minor indices 0-5 are the top row pair minors s0..s5, 6-11 the bottom
+    // row pair minors c0..c5 (column pairs 01, 02, 03, 12, 13, 23).
+    struct Term { int sign; unsigned char row, col, minor; };
+    static constexpr Term terms[16][3] = {
+        {{ 1, 1, 1, 11}, {-1, 1, 2, 10}, { 1, 1, 3,  9}},
+        {{-1, 0, 1, 11}, { 1, 0, 2, 10}, {-1, 0, 3,  9}},
+        {{ 1, 3, 1,  5}, {-1, 3, 2,  4}, { 1, 3, 3,  3}},
+        {{-1, 2, 1,  5}, { 1, 2, 2,  4}, {-1, 2, 3,  3}},
+        {{-1, 1, 0, 11}, { 1, 1, 2,  8}, {-1, 1, 3,  7}},
+        {{ 1, 0, 0, 11}, {-1, 0, 2,  8}, { 1, 0, 3,  7}},
+        {{-1, 3, 0,  5}, { 1, 3, 2,  2}, {-1, 3, 3,  1}},
+        {{ 1, 2, 0,  5}, {-1, 2, 2,  2}, { 1, 2, 3,  1}},
+        {{ 1, 1, 0, 10}, {-1, 1, 1,  8}, { 1, 1, 3,  6}},
+        {{-1, 0, 0, 10}, { 1, 0, 1,  8}, {-1, 0, 3,  6}},
+        {{ 1, 3, 0,  4}, {-1, 3, 1,  2}, { 1, 3, 3,  0}},
+        {{-1, 2, 0,  4}, { 1, 2, 1,  2}, {-1, 2, 3,  0}},
+        {{-1, 1, 0,  9}, { 1, 1, 1,  7}, {-1, 1, 2,  6}},
+        {{ 1, 0, 0,  9}, {-1, 0, 1,  7}, { 1, 0, 2,  6}},
+        {{-1, 3, 0,  3}, { 1, 3, 1,  1}, {-1, 3, 2,  0}},
+        {{ 1, 2, 0,  3}, {-1, 2, 1,  1}, { 1, 2, 2,  0}},
+    };
+    static constexpr size_t pairs[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+
+    mpfr_prec_t prec = r.precision();
+    MpArray minors(12, prec);
+    MpScratch t(prec);
+    for (size_t i = begin; i < end; ++i) {
+        size_t k = 16 * i;
+        auto e = [&](size_t row, size_t col) { return a[k + 4 * row + col]; };
+        for (size_t p = 0; p < 6; ++p) {
+            size_t j0 = pairs[p][0], j1 = pairs[p][1];
+            mpfr_mul(t, e(0, j1), e(1, j0), MP_RND);
+            mpfr_fms(minors[p], e(0, j0), e(1, j1), t, MP_RND);
+            mpfr_mul(t, e(2, j1), e(3, j0), MP_RND);
+            mpfr_fms(minors[6 + p], e(2, j0), e(3, j1), t, MP_RND);
+        }
+        for (size_t q = 0; q < 16; ++q) {
+            mpfr_ptr out = r[k + q];
+            const Term *term = terms[q];
+            mpfr_mul(out, e(term[0].row, term[0].col), minors[term[0].minor], MP_RND);
+            if (term[0].sign < 0) mpfr_neg(out, out, MP_RND);
+            for (size_t j = 1; j < 3; ++j) {
+                if (term[j].sign > 0) {
+                    mpfr_fma(out, e(term[j].row, term[j].col), minors[term[j].minor], out, MP_RND);
+                } else {
+                    mpfr_mul(t, e(term[j].row, term[j].col), minors[term[j].minor], MP_RND);
+                    mpfr_sub(out, out, t, MP_RND);
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Adjugates of packed row-major Matrix4x4 instances.
+ *
+ * Each entry is a signed sum of three products of a matrix element and one of
+ * the twelve complementary 2x2 minors used by mp_batch_det4.
+ *
+ * @param r the results, packed (16*n values); must not alias a.
+ * @param a the matrices, packed (16*n values).
+ */
+inline void mp_batch_adj4(MpArray &r, const MpArray &a) {
+    detail::mp_check_sizes(r.size(), a.size(), a.size());
+    if (r.size() % 16 != 0) throw std::invalid_argument("MpArray size is not a multiple of 16");
+    parallel_for(0, r.size() / 16, MP_BATCH_GRAIN / 16, [&](size_t begin, size_t end) {
+        detail::mp_adj4_range(r, a, begin, end);
+    });
+}
+
+#endif //FMM_MPARRAY_HPP
@@ -0,0 +1,206 @@
+/**
+ * @file mpbatch.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A thread parallel engine for batches of high precision evaluations.
+ */
+
+#ifndef FMM_MPBATCH_HPP
+#define FMM_MPBATCH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <mpfr.h>
+
+#include "linalg.hpp"
+#include "mparray.hpp"
+#include "mpreal.hpp"
+#include "parallel.hpp"
+
+// ######################################################################### //
+// # Per-thread MPFR state.                                                # //
+// ######################################################################### //
+
+/**
+ * @brief RAII installation of the MPFR state a batch thread works with.
+ *
+ * On construction the thread's default precision is set (and the previous
+ * value remembered). On destruction the previous precision is restored and,
+ * for threads that are about to exit, MPFR's own thread-local caches (the
+ * constants it computes on demand, among others) are released with
+ * mpfr_free_cache2(MPFR_FREE_LOCAL_CACHE).
+ */
+class MpThreadState {
+public:
+
+    /**
+     * @param prec the working precision for this thread.
+     * @param release_caches whether to free the thread-local caches on
+     *                       destruction (true for threads that exit).
+     */
+    MpThreadState(mpfr_prec_t prec, bool release_caches)
+            : _saved(mpfr_get_default_prec()), _release(release_caches) {
+        mpfr_set_default_prec(prec);
+    }
+
+    MpThreadState(const MpThreadState &) = delete;
+    MpThreadState &operator=(const MpThreadState &) = delete;
+
+    ~MpThreadState() {
+        mpfr_set_default_prec(_saved);
+        if (_release) mpfr_free_cache2(MPFR_FREE_LOCAL_CACHE);
+    }
+
+private:
+    mpfr_prec_t _saved;
+    bool _release;
+};
+
+// ######################################################################### //
+// # Batch engine.                                                         # //
+// ######################################################################### //
+
+/**
+ * @brief Evaluates batches of MpReal computations over a pool of workers.
+ *
+ * Every worker thread runs with its own MPFR state (MpThreadState) at the
+ * engine precision. Inputs are cut into shards of a fixed size that does not
+ * depend on the number of threads, and each shard is evaluated and reduced in
+ * index order, so results are bit-identical whatever the thread count.
+ *
+ * If the MPFR library was built without thread-local storage it is not safe
+ * to use from several threads and the engine falls back to one thread.
+ */
+class MpBatchEngine {
+public:
+
+    /**
+     * @param prec the working precision in bits.
+     * @param nthreads the number of threads (including the caller).
+     * @param shard the number of items per shard.
+     */
+    explicit MpBatchEngine(mpfr_prec_t prec,
+                           size_t nthreads = ThreadPool::default_concurrency(),
+                           size_t shard = 64)
+            : _prec(prec), _shard(std::max<size_t>(shard, 1)),
+              _pool(std::make_unique<ThreadPool>(
+                      mpfr_buildopt_tls_p() ? nthreads : 1,
+                      [prec](size_t) { thread_state() = std::make_unique<MpThreadState>(prec, true); },
+                      [](size_t) { thread_state().reset(); })) {}
+
+    /**
+     * @brief The working precision.
+     */
+    [[nodiscard]] mpfr_prec_t precision() const { return _prec; }
+
+    /**
+     * @brief The number of threads used.
+     */
+    [[nodiscard]] size_t threads() const { return _pool->size(); }
+
+    /**
+     * @brief Applies a function to every item, in parallel.
+     *
+     * @tparam In the input type.
+     * @tparam F a callable `f(const In&)`.
+     *
+     * @param in the inputs.
+     * @param f the function.
+     *
+     * @return the results, in input order.
+     */
+    template <typename In, typename F>
+    auto map(std::span<const In> in, F f) {
+        using Out = std::invoke_result_t<F &, const In &>;
+        std::vector<Out> out(in.size());
+        for_each_shard(in.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) out[i] = f(in[i]);
+        });
+        return out;
+    }
+
+    /**
+     * @brief Determinants of a batch of matrices.
+     *
+     * Each shard is packed into a contiguous MpArray at the engine precision
+     * and evaluated by mp_batch_det4's kernel, serially on the engine worker
+     * that owns the shard (not split again over the global pool).
+     */
+    std::vector<MpReal> det(std::span<const Matrix4x4<MpReal>> in) {
+        std::vector<MpReal> out(in.size());
+        for_each_shard(in.size(), [&](size_t begin, size_t end) {
+            size_t n = end - begin;
+            MpArray a(16 * n, _prec), r(n, _prec);
+            for (size_t i = 0; i < n; ++i) mp_store(a, i, in[begin + i]);
+            detail::mp_det4_range(r, a, 0, n);
+            for (size_t i = 0; i < n; ++i) out[begin + i] = r.get(i);
+        });
+        return out;
+    }
+
+    /**
+     * @brief Adjugates of a batch of matrices, each shard evaluated serially
+     *        by mp_batch_adj4's kernel as in det.
+     */
+    std::vector<Matrix4x4<MpReal>> adj(std::span<const Matrix4x4<MpReal>> in) {
+        std::vector<Matrix4x4<MpReal>> out(in.size());
+        for_each_shard(in.size(), [&](size_t begin, size_t end) {
+            size_t n = end - begin;
+            MpArray a(16 * n, _prec), r(16 * n, _prec);
+            for (size_t i = 0; i < n; ++i) mp_store(a, i, in[begin + i]);
+            detail::mp_adj4_range(r, a, 0, n);
+            for (size_t i = 0; i < n; ++i) out[begin + i] = mp_load_matrix4x4(r, i);
+        });
+        return out;
+    }
+
+    /**
+     * @brief Sums a batch of values with a fixed reduction order: values are
+     *        summed per shard, then the shard sums are added in shard order.
+     */
+    MpReal sum(std::span<const MpReal> in) {
+        size_t nshards = (in.size() + _shard - 1) / _shard;
+        MpArray partial(nshards, _prec);
+        for_each_shard(in.size(), [&](size_t begin, size_t end) {
+            mpfr_ptr acc = partial[begin / _shard];
+            for (size_t i = begin; i < end; ++i) mpfr_add(acc, acc, in[i].mpfr(), MP_RND);
+        });
+        MpReal total(0.0, _prec);
+        for (size_t s = 0; s < nshards; ++s) mpfr_add(total.mpfr(), total.mpfr(), partial[s], MP_RND);
+        return total;
+    }
+
+    /**
+     * @brief Runs `body(begin, end)` for every shard of [0, n) with the MPFR
+     *        state installed on the executing thread.
+     */
+    template <typename F>
+    void for_each_shard(size_t n, F &&body) {
+        size_t nshards = (n + _shard - 1) / _shard;
+        // The calling thread takes part in the batch as worker 0; give it the
+        // engine state for the duration and restore its own afterwards.
+        MpThreadState caller(_prec, false);
+        _pool->run(nshards, [&](size_t s, size_t) {
+            size_t begin = s * _shard;
+            body(begin, std::min(begin + _shard, n));
+        });
+    }
+
+private:
+
+    static std::unique_ptr<MpThreadState> &thread_state() {
+        static thread_local std::unique_ptr<MpThreadState> state;
+        return state;
+    }
+
+    mpfr_prec_t _prec;
+    size_t _shard;
+    std::unique_ptr<ThreadPool> _pool;
+};
+
+#endif //FMM_MPBATCH_HPP
@@ -0,0 +1,90 @@
+/**
+ * @file mpinterval.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief An MPFR backed interval type (in the style of MPFI) built on the
+ *        generic Interval of interval.hpp.
+ */
+
+#ifndef FMM_MPINTERVAL_HPP
+#define FMM_MPINTERVAL_HPP
+
+#include <mpfr.h>
+
+#include "interval.hpp"
+#include "mpreal.hpp"
+
+/**
+ * @brief Directed rounding for MpReal bounds: each bound is computed by MPFR
+ *        rounded towards -inf (lower) or +inf (upper), at the larger of the
+ *        operand precisions. No floating point environment state is needed.
+ */
+template <>
+struct IntervalRounding<MpReal> {
+
+    struct Scope {};
+
+    static MpReal add_down(const MpReal &a, const MpReal &b) { return apply(mpfr_add, a, b, MPFR_RNDD); }
+    static MpReal add_up(const MpReal &a, const MpReal &b) { return apply(mpfr_add, a, b, MPFR_RNDU); }
+    static MpReal sub_down(const MpReal &a, const MpReal &b) { return apply(mpfr_sub, a, b, MPFR_RNDD); }
+    static MpReal sub_up(const MpReal &a, const MpReal &b) { return apply(mpfr_sub, a, b, MPFR_RNDU); }
+    static MpReal mul_down(const MpReal &a, const MpReal &b) { return apply(mpfr_mul, a, b, MPFR_RNDD); }
+    static MpReal mul_up(const MpReal &a, const MpReal &b) { return apply(mpfr_mul, a, b, MPFR_RNDU); }
+    static MpReal div_down(const MpReal &a, const MpReal &b) { return apply(mpfr_div, a, b, MPFR_RNDD); }
+    static MpReal div_up(const MpReal &a, const MpReal &b) { return apply(mpfr_div, a, b, MPFR_RNDU); }
+
+    static MpReal sqrt_down(const MpReal &a) {
+        MpReal r = MpReal::with_precision(a.precision());
+        mpfr_sqrt(r.mpfr(), a.mpfr(), MPFR_RNDD);
+        return r;
+    }
+
+    static MpReal sqrt_up(const MpReal &a) {
+        MpReal r = MpReal::with_precision(a.precision());
+        mpfr_sqrt(r.mpfr(), a.mpfr(), MPFR_RNDU);
+        return r;
+    }
+
+    static MpReal from_down(double x) { return from(x, MPFR_RNDD); }
+    static MpReal from_up(double x) { return from(x, MPFR_RNDU); }
+
+    static MpReal infinity() {
+        MpReal r;
+        mpfr_set_inf(r.mpfr(), 1);
+        return r;
+    }
+
+private:
+
+    using Op = int (*)(mpfr_ptr, mpfr_srcptr, mpfr_srcptr, mpfr_rnd_t);
+
+    static MpReal apply(Op op, const MpReal &a, const MpReal &b, mpfr_rnd_t rnd) {
+        MpReal r = MpReal::with_precision(result_precision(a, b));
+        op(r.mpfr(), a.mpfr(), b.mpfr(), rnd);
+        return r;
+    }
+
+    static MpReal from(double x, mpfr_rnd_t rnd) {
+        MpReal r = MpReal::with_precision(mpfr_get_default_prec());
+        mpfr_set_d(r.mpfr(), x, rnd);
+        return r;
+    }
+};
+
+/**
+ * @brief An interval with MPFR bounds.
+ */
+using MpInterval = Interval<MpReal>;
+
+/**
+ * @brief The interval [lo, hi] enclosing the decimal string s (which need
+ *        not be exactly representable) at precision prec.
+ */
+inline MpInterval mp_interval(const std::string &s, mpfr_prec_t prec) {
+    MpReal lo = MpReal::with_precision(prec), hi = MpReal::with_precision(prec);
+    mpfr_set_str(lo.mpfr(), s.c_str(), 10, MPFR_RNDD);
+    mpfr_set_str(hi.mpfr(), s.c_str(), 10, MPFR_RNDU);
+    return {lo, hi};
+}
+
+#endif //FMM_MPINTERVAL_HPP
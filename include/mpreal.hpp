@@ -0,0 +1,291 @@
+/**
+ * @file mpreal.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief An MPFR backed scalar type usable with the linalg.hpp templates.
+ */
+
+#ifndef FMM_MPREAL_HPP
+#define FMM_MPREAL_HPP
+
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include <mpfr.h>
+
+/**
+ * @brief The rounding mode used by MpReal arithmetic.
+ */
+inline constexpr mpfr_rnd_t MP_RND = MPFR_RNDN;
+
+// ######################################################################### //
+// # Scalar.                                                               # //
+// ######################################################################### //
+
+/**
+ * @brief A value semantic wrapper around an mpfr_t.
+ *
+ * New values are created at the (per-thread) MPFR default precision unless a
+ * precision is given explicitly; the result of a binary operation carries the
+ * larger of the two operand precisions.
+ */
+class MpReal {
+public:
+
+    /**
+     * @brief Creates a zero at the default precision.
+     */
+    MpReal() {
+        mpfr_init2(_v, mpfr_get_default_prec());
+        mpfr_set_zero(_v, 1);
+    }
+
+    /**
+     * @brief Creates a value from a double at the default precision.
+     *
+     * @param d the value.
+     */
+    MpReal(double d) {
+        mpfr_init2(_v, mpfr_get_default_prec());
+        mpfr_set_d(_v, d, MP_RND);
+    }
+
+    /**
+     * @brief Creates a value from a double at the given precision.
+     *
+     * @param d the value.
+     * @param prec the precision in bits.
+     */
+    MpReal(double d, mpfr_prec_t prec) {
+        mpfr_init2(_v, prec);
+        mpfr_set_d(_v, d, MP_RND);
+    }
+
+    /**
+     * @brief Creates a value from a decimal string at the given precision.
+     *
+     * @param s the value as a base 10 string.
+     * @param prec the precision in bits.
+     */
+    explicit MpReal(const std::string &s, mpfr_prec_t prec = mpfr_get_default_prec()) {
+        mpfr_init2(_v, prec);
+        mpfr_set_str(_v, s.c_str(), 10, MP_RND);
+    }
+
+    /**
+     * @brief Copies an existing mpfr value, keeping its precision.
+     *
+     * @param x the value.
+     */
+    explicit MpReal(mpfr_srcptr x) {
+        mpfr_init2(_v, mpfr_get_prec(x));
+        mpfr_set(_v, x, MP_RND);
+    }
+
+    /**
+     * @brief Creates an uninitialised value at the given precision (for use as
+     *        a result).
+     */
+    static MpReal with_precision(mpfr_prec_t prec) {
+        return MpReal(prec, Uninitialised{});
+    }
+
+    MpReal(const MpReal &other) {
+        mpfr_init2(_v, mpfr_get_prec(other._v));
+        mpfr_set(_v, other._v, MP_RND);
+    }
+
+    MpReal(MpReal &&other) noexcept {
+        *_v = *other._v;
+        other._v->_mpfr_d = nullptr;
+    }
+
+    MpReal &operator=(const MpReal &other) {
+        if (this != &other) {
+            if (!_v->_mpfr_d) {
+                mpfr_init2(_v, mpfr_get_prec(other._v));
+            } else if (mpfr_get_prec(_v) != mpfr_get_prec(other._v)) {
+                mpfr_set_prec(_v, mpfr_get_prec(other._v));
+            }
+            mpfr_set(_v, other._v, MP_RND);
+        }
+        return *this;
+    }
+
+    MpReal &operator=(MpReal &&other) noexcept {
+        std::swap(*_v, *other._v);
+        return *this;
+    }
+
+    ~MpReal() {
+        if (_v->_mpfr_d) mpfr_clear(_v);
+    }
+
+    /**
+     * @brief The underlying mpfr value.
+     */
+    mpfr_ptr mpfr() { return _v; }
+
+    /**
+     * @brief The underlying mpfr value.
+     */
+    [[nodiscard]] mpfr_srcptr mpfr() const { return _v; }
+
+    /**
+     * @brief The precision of this value in bits.
+     */
+    [[nodiscard]] mpfr_prec_t precision() const { return mpfr_get_prec(_v); }
+
+    /**
+     * @brief Rounds this value to a double.
+     */
+    [[nodiscard]] double to_double() const { return mpfr_get_d(_v, MP_RND); }
+
+    /**
+     * @brief Rounds this value to a long double.
+     */
+    [[nodiscard]] long double to_long_double() const { return mpfr_get_ld(_v, MP_RND); }
+
+    explicit operator double() const { return to_double(); }
+
+    MpReal &operator+=(const MpReal &b) {
+        widen(b);
+        mpfr_add(_v, _v, b._v, MP_RND);
+        return *this;
+    }
+
+    MpReal &operator-=(const MpReal &b) {
+        widen(b);
+        mpfr_sub(_v, _v, b._v, MP_RND);
+        return *this;
+    }
+
+    MpReal &operator*=(const MpReal &b) {
+        widen(b);
+        mpfr_mul(_v, _v, b._v, MP_RND);
+        return *this;
+    }
+
+    MpReal &operator/=(const MpReal &b) {
+        widen(b);
+        mpfr_div(_v, _v, b._v, MP_RND);
+        return *this;
+    }
+
+private:
+
+    struct Uninitialised {};
+
+    MpReal(mpfr_prec_t prec, Uninitialised) {
+        mpfr_init2(_v, prec);
+    }
+
+    void widen(const MpReal &b) {
+        if (mpfr_get_prec(b._v) > mpfr_get_prec(_v)) {
+            MpReal tmp = with_precision(mpfr_get_prec(b._v));
+            mpfr_set(tmp._v, _v, MP_RND);
+            *this = std::move(tmp);
+        }
+    }
+
+    mpfr_t _v;
+};
+
+// ######################################################################### //
+// # Arithmetic operators.                                                 # //
+// ######################################################################### //
+
+/**
+ * @brief The precision of the result of a binary operation on a and b.
+ */
+inline mpfr_prec_t result_precision(const MpReal &a, const MpReal &b) {
+    return a.precision() > b.precision() ? a.precision() : b.precision();
+}
+
+/**
+ * @brief Adds two MpReal instances.
+ */
+inline MpReal operator+(const MpReal &a, const MpReal &b) {
+    MpReal r = MpReal::with_precision(result_precision(a, b));
+    mpfr_add(r.mpfr(), a.mpfr(), b.mpfr(), MP_RND);
+    return r;
+}
+
+/**
+ * @brief Subtracts two MpReal instances.
+ */
+inline MpReal operator-(const MpReal &a, const MpReal &b) {
+    MpReal r = MpReal::with_precision(result_precision(a, b));
+    mpfr_sub(r.mpfr(), a.mpfr(), b.mpfr(), MP_RND);
+    return r;
+}
+
+/**
+ * @brief Multiplies two MpReal instances.
+ */
+inline MpReal operator*(const MpReal &a, const MpReal &b) {
+    MpReal r = MpReal::with_precision(result_precision(a, b));
+    mpfr_mul(r.mpfr(), a.mpfr(), b.mpfr(), MP_RND);
+    return r;
+}
+
+/**
+ * @brief Divides two MpReal instances.
+ */
+inline MpReal operator/(const MpReal &a, const MpReal &b) {
+    MpReal r = MpReal::with_precision(result_precision(a, b));
+    mpfr_div(r.mpfr(), a.mpfr(), b.mpfr(), MP_RND);
+    return r;
+}
+
+/**
+ * @brief Negates an MpReal instance.
+ */
+inline MpReal operator-(const MpReal &a) {
+    MpReal r = MpReal::with_precision(a.precision());
+    mpfr_neg(r.mpfr(), a.mpfr(), MP_RND);
+    return r;
+}
+
+// ######################################################################### //
+// # Comparison operators.                                                 # //
+// ######################################################################### //
+
+inline bool operator==(const MpReal &a, const MpReal &b) { return mpfr_cmp(a.mpfr(), b.mpfr()) == 0; }
+inline bool operator!=(const MpReal &a, const MpReal &b) { return mpfr_cmp(a.mpfr(), b.mpfr()) != 0; }
+inline bool operator< (const MpReal &a, const MpReal &b) { return mpfr_cmp(a.mpfr(), b.mpfr()) <  0; }
+inline bool operator> (const MpReal &a, const MpReal &b) { return mpfr_cmp(a.mpfr(), b.mpfr()) >  0; }
+inline bool operator<=(const MpReal &a, const MpReal &b) { return mpfr_cmp(a.mpfr(), b.mpfr()) <= 0; }
+inline bool operator>=(const MpReal &a, const MpReal &b) { return mpfr_cmp(a.mpfr(), b.mpfr()) >= 0; }
+
+// ######################################################################### //
+// # Functions.                                                            # //
+// ######################################################################### //
+
+/**
+ * @brief The square root of an MpReal instance.
+ */
+inline MpReal sqrt(const MpReal &a) {
+    MpReal r = MpReal::with_precision(a.precision());
+    mpfr_sqrt(r.mpfr(), a.mpfr(), MP_RND);
+    return r;
+}
+
+/**
+ * @brief The absolute value of an MpReal instance.
+ */
+inline MpReal abs(const MpReal &a) {
+    MpReal r = MpReal::with_precision(a.precision());
+    mpfr_abs(r.mpfr(), a.mpfr(), MP_RND);
+    return r;
+}
+
+/**
+ * @brief Writes an MpReal instance (rounded to a double) to a stream.
+ */
+inline std::ostream &operator<<(std::ostream &os, const MpReal &a) {
+    return os << a.to_double();
+}
+
+#endif //FMM_MPREAL_HPP
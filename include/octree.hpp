@@ -0,0 +1,505 @@
+/**
+ * @file octree.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A linear (Morton ordered) octree over a set of points, with an
+ *        incremental update for points that move.
+ */
+
+#ifndef FMM_OCTREE_HPP
+#define FMM_OCTREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+
+/**
+ * @brief A node of a LinearOctree.
+ *
+ * The points of a node are the contiguous range [begin, end) of the tree's
+ * sorted points, and the children of a node are contiguous in the node array.
+ */
+struct OctreeNode {
+    uint64_t key;         /**< The Morton key of the node's cell at its level (3 * level bits). */
+    uint32_t level;       /**< The level (0 is the root). */
+    uint32_t parent;      /**< The parent node index (the root is its own parent). */
+    uint32_t first_child; /**< The index of the first child. */
+    uint32_t nchildren;   /**< The number of (non-empty) children; 0 for a leaf. */
+    uint32_t begin;       /**< The first sorted point in the node. */
+    uint32_t end;         /**< One past the last sorted point in the node. */
+
+    [[nodiscard]] bool is_leaf() const { return nchildren == 0; }
+
+    [[nodiscard]] uint32_t size() const { return end - begin; }
+
+    /**
+     * @brief The octant (0 - 7) of the node in its parent.
+     */
+    [[nodiscard]] unsigned octant() const { return static_cast<unsigned>(key & 7); }
+};
+
+/**
+ * @brief When LinearOctree::update restructures or rebuilds the tree for
+ *        moved points instead of refitting it.
+ */
+struct OctreeRefitPolicy {
+    double max_displaced = 0.25;   /**< The largest fraction of points that may leave their place in Morton order. */
+    double max_leaf_growth = 2.0;  /**< The largest leaf, as a multiple of max_leaf. */
+    double max_empty = 0.25;       /**< The largest fraction of empty leaves. */
+    double padding = 0.05;         /**< The margin added to each side of the cube on a rebuild, relative to its size. */
+};
+
+/**
+ * @brief What LinearOctree::update did.
+ */
+enum class OctreeUpdate {
+    refit,        /**< The points were re-sorted in place and the nodes' point ranges refitted. */
+    restructure,  /**< The points were re-sorted in place and the nodes rebuilt on them. */
+    rebuild       /**< The tree was built from scratch. */
+};
+
+/**
+ * @brief A linear octree.
+ *
+ * Points are keyed with 63-bit Morton keys in their bounding cube, sorted
+ * with a parallel radix sort, and the tree is built breadth first, one
+ * level at a time, splitting every node that holds more than `max_leaf`
+ * points (down to level MORTON_BITS). Only non-empty children are created.
+ * Nodes are stored level by level, and within a level in Morton order.
+ *
+ * @tparam T the base data type.
+ */
+template <typename T>
+class LinearOctree {
+public:
+
+    /**
+     * @brief The value returned by find() for a missing node.
+     */
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * @brief Builds the tree.
+     *
+     * @param points the points (at most 2^32 - 1).
+     * @param max_leaf the maximum number of points in a leaf (unless the leaf
+     *                 is at the finest level).
+     * @param pool the pool to run on.
+     */
+    explicit LinearOctree(std::span<const Vector3<T>> points, size_t max_leaf = 64,
+                          ThreadPool &pool = ThreadPool::global())
+            : _max_leaf(std::max<size_t>(max_leaf, 1)) {
+        build(points, bounding_cube(points, pool), pool);
+    }
+
+    /**
+     * @brief Builds the tree in a given cube (a periodic box, say), which
+     *        should contain the points: the keys of points outside it are
+     *        clamped to its faces.
+     */
+    LinearOctree(std::span<const Vector3<T>> points, const BoundingCube<T> &cube, size_t max_leaf = 64,
+                 ThreadPool &pool = ThreadPool::global())
+            : _max_leaf(std::max<size_t>(max_leaf, 1)) {
+        build(points, cube, pool);
+    }
+
+    /**
+     * @brief Updates the tree to the new positions of the same points (in
+     *        the same input order), refitting it if possible.
+     *
+     * The cube is kept and the keys recomputed in the current sorted order,
+     * where small motions leave them almost sorted: a single pass sets aside
+     * the points that are out of place, which are sorted on their own and
+     * merged back, for O(n + d log d) work with d displaced points instead
+     * of a full radix sort. Each leaf's point range is then found from its
+     * key, searching from its old range, and each parent's from its
+     * children.
+     *
+     * If a point entered a cell that has no leaf, or the leaves degraded
+     * (one holds more than policy.max_leaf_growth max_leaf points, or more
+     * than policy.max_empty of them are empty), the nodes are rebuilt on the
+     * re-sorted points, giving the tree a full build would in this cube. The
+     * tree is built from scratch, with the cube padded by policy.padding so
+     * that later steps can refit, if the number of points changed, a point
+     * left the cube or more than policy.max_displaced of the points are
+     * displaced.
+     */
+    OctreeUpdate update(std::span<const Vector3<T>> points, const OctreeRefitPolicy &policy = {},
+                        ThreadPool &pool = ThreadPool::global()) {
+        if (points.size() == _keys.size() && resort(points, policy, pool)) {
+            if (refit_nodes(policy, pool)) return OctreeUpdate::refit;
+            build_nodes(pool);
+            return OctreeUpdate::restructure;
+        }
+        BoundingCube<T> cube = bounding_cube(points, pool);
+        const T margin = static_cast<T>(policy.padding) * cube.size;
+        cube.min = {cube.min.x - margin, cube.min.y - margin, cube.min.z - margin};
+        cube.size += 2 * margin;
+        build(points, cube, pool);
+        return OctreeUpdate::rebuild;
+    }
+
+    /**
+     * @brief The bounding cube of the root.
+     */
+    [[nodiscard]] const BoundingCube<T> &cube() const { return _cube; }
+
+    /**
+     * @brief The maximum number of points per leaf.
+     */
+    [[nodiscard]] size_t max_leaf() const { return _max_leaf; }
+
+    /**
+     * @brief All nodes, level by level.
+     */
+    [[nodiscard]] std::span<const OctreeNode> nodes() const { return _nodes; }
+
+    [[nodiscard]] const OctreeNode &node(size_t i) const { return _nodes[i]; }
+
+    /**
+     * @brief The leaf node indices, in Morton (sorted point) order.
+     */
+    [[nodiscard]] std::span<const uint32_t> leaves() const { return _leaves; }
+
+    /**
+     * @brief The number of levels (the deepest level is depth() - 1).
+     */
+    [[nodiscard]] size_t depth() const { return _level_offsets.size() - 1; }
+
+    /**
+     * @brief The node indices [first, second) of a level.
+     */
+    [[nodiscard]] std::pair<size_t, size_t> level_range(size_t level) const {
+        return {_level_offsets[level], _level_offsets[level + 1]};
+    }
+
+    /**
+     * @brief The points in sorted (Morton) order.
+     */
+    [[nodiscard]] std::span<const Vector3<T>> points() const { return _points; }
+
+    /**
+     * @brief The sorted Morton keys of the points.
+     */
+    [[nodiscard]] std::span<const uint64_t> keys() const { return _keys; }
+
+    /**
+     * @brief For each sorted point, the index of the point in the input.
+     */
+    [[nodiscard]] std::span<const uint32_t> permutation() const { return _perm; }
+
+    /**
+     * @brief The edge length of a cell at a level.
+     */
+    [[nodiscard]] T cell_size(size_t level) const {
+        return _cube.size / static_cast<T>(uint64_t{1} << level);
+    }
+
+    /**
+     * @brief The centre of a node's cell.
+     */
+    [[nodiscard]] Vector3<T> center(size_t i) const {
+        const OctreeNode &n = _nodes[i];
+        uint32_t x, y, z;
+        morton_decode(n.key, x, y, z);
+        T h = cell_size(n.level);
+        return {
+            _cube.min.x + (static_cast<T>(x) + T(0.5)) * h,
+            _cube.min.y + (static_cast<T>(y) + T(0.5)) * h,
+            _cube.min.z + (static_cast<T>(z) + T(0.5)) * h
+        };
+    }
+
+    /**
+     * @brief Half the edge length of a node's cell.
+     */
+    [[nodiscard]] T half_width(size_t i) const {
+        return T(0.5) * cell_size(_nodes[i].level);
+    }
+
+    /**
+     * @brief The index of the node with a key at a level, or npos.
+     */
+    [[nodiscard]] uint32_t find(uint64_t key, size_t level) const {
+        if (level >= depth()) return npos;
+        auto [b, e] = level_range(level);
+        auto it = std::lower_bound(_nodes.begin() + b, _nodes.begin() + e, key,
+                                   [](const OctreeNode &n, uint64_t k) { return n.key < k; });
+        if (it == _nodes.begin() + e || it->key != key) return npos;
+        return static_cast<uint32_t>(it - _nodes.begin());
+    }
+
+private:
+
+    void build(std::span<const Vector3<T>> points, const BoundingCube<T> &cube, ThreadPool &pool) {
+        const size_t n = points.size();
+        _cube = cube;
+
+        _keys.resize(n);
+        _perm.resize(n);
+        morton_keys<T>(_keys, points, _cube, pool);
+        std::iota(_perm.begin(), _perm.end(), uint32_t{0});
+        radix_sort(_keys, _perm, 3 * MORTON_BITS, pool);
+
+        _points.resize(n);
+        parallel_for(0, n, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) _points[i] = points[_perm[i]];
+        }, pool);
+
+        build_nodes(pool);
+    }
+
+    void build_nodes(ThreadPool &pool) {
+        const uint32_t n = static_cast<uint32_t>(_keys.size());
+        _nodes.assign(1, OctreeNode{0, 0, 0, 0, 0, 0, n});
+        _level_offsets.assign({0, 1});
+
+        std::vector<uint32_t> bounds, counts;
+        for (uint32_t level = 0; level < MORTON_BITS; ++level) {
+            size_t fb = _level_offsets[level], fe = _level_offsets[level + 1];
+            size_t nf = fe - fb;
+            bounds.assign(9 * nf, 0);
+            counts.assign(nf + 1, 0);
+
+            // Child boundaries of every node at this level.
+            const unsigned shift = 3 * (MORTON_BITS - level - 1);
+            parallel_for(0, nf, 64, [&](size_t b, size_t e) {
+                for (size_t f = b; f < e; ++f) {
+                    const OctreeNode &node = _nodes[fb + f];
+                    if (node.size() <= _max_leaf) continue;
+                    uint32_t *bd = &bounds[9 * f];
+                    const uint64_t prefix = node.key << (shift + 3);
+                    auto first = _keys.begin() + node.begin, last = _keys.begin() + node.end;
+                    bd[0] = node.begin;
+                    for (uint64_t o = 1; o < 8; ++o) {
+                        first = std::lower_bound(first, last, prefix | (o << shift));
+                        bd[o] = static_cast<uint32_t>(first - _keys.begin());
+                    }
+                    bd[8] = node.end;
+                    uint32_t c = 0;
+                    for (size_t o = 0; o < 8; ++o) c += bd[o + 1] > bd[o];
+                    counts[f] = c;
+                }
+            }, pool);
+
+            std::exclusive_scan(counts.begin(), counts.end(), counts.begin(), uint32_t{0});
+            size_t nnew = counts[nf];
+            if (nnew == 0) break;
+
+            _nodes.resize(fe + nnew);
+            parallel_for(0, nf, 64, [&](size_t b, size_t e) {
+                for (size_t f = b; f < e; ++f) {
+                    uint32_t c = counts[f];
+                    if (counts[f + 1] == c) continue;
+                    OctreeNode &node = _nodes[fb + f];
+                    node.first_child = static_cast<uint32_t>(fe + c);
+                    node.nchildren = counts[f + 1] - c;
+                    const uint32_t *bd = &bounds[9 * f];
+                    for (uint64_t o = 0; o < 8; ++o) {
+                        if (bd[o + 1] == bd[o]) continue;
+                        _nodes[fe + c++] = OctreeNode{(node.key << 3) | o, level + 1,
+                                                      static_cast<uint32_t>(fb + f), 0, 0, bd[o], bd[o + 1]};
+                    }
+                }
+            }, pool);
+            _level_offsets.push_back(fe + nnew);
+        }
+
+        _leaves.clear();
+        for (size_t i = 0; i < _nodes.size(); ++i) {
+            if (_nodes[i].is_leaf()) _leaves.push_back(static_cast<uint32_t>(i));
+        }
+        std::sort(_leaves.begin(), _leaves.end(), [&](uint32_t a, uint32_t b) {
+            return _nodes[a].begin < _nodes[b].begin;
+        });
+    }
+
+    // ##################################################################### //
+    // # Refit.                                                            # //
+    // ##################################################################### //
+
+    /**
+     * @brief Sorts the moved points in place, or returns false (leaving the
+     *        tree to be rebuilt) if the policy calls for a rebuild.
+     */
+    bool resort(std::span<const Vector3<T>> points, const OctreeRefitPolicy &policy, ThreadPool &pool) {
+        const size_t n = points.size();
+
+        // New points and keys in the current order; all must be in the cube.
+        // (Two passes: the gather is bound by memory latency and overlaps
+        // its loads best on its own.)
+        parallel_for(0, n, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) _points[i] = points[_perm[i]];
+        }, pool);
+        std::vector<char> outside(pool.size(), 0);
+        const T scale = T(MORTON_CELLS) / _cube.size;
+        parallel_for_worker(0, n, 1 << 14, [&](size_t b, size_t e, size_t w) {
+            bool out = false;
+            for (size_t i = b; i < e; ++i) {
+                const Vector3<T> &p = _points[i];
+                const T x = (p.x - _cube.min.x) * scale, y = (p.y - _cube.min.y) * scale,
+                        z = (p.z - _cube.min.z) * scale;
+                out |= !(x >= T(0) && y >= T(0) && z >= T(0) && x < T(MORTON_CELLS) && y < T(MORTON_CELLS)
+                         && z < T(MORTON_CELLS));
+                _keys[i] = morton_key(_cube, p);
+            }
+            if (out) outside[w] = 1;
+        }, pool);
+        if (std::find(outside.begin(), outside.end(), 1) != outside.end()) return false;
+
+        return merge_displaced(static_cast<size_t>(policy.max_displaced * static_cast<double>(n)));
+    }
+
+    /**
+     * @brief Restores the sorted order of the keys after a small motion, or
+     *        returns false if more than max_displaced points are out of place.
+     *
+     * Points are kept, and compacted in place, while their keys are
+     * non-decreasing. A point below the last kept key either displaces the
+     * kept points above it, if they are a short run (points that jumped
+     * ahead), or is itself displaced. The displaced points are sorted and
+     * merged in from the back.
+     */
+    bool merge_displaced(size_t max_displaced) {
+        struct Moved {
+            uint64_t key;
+            uint32_t perm;
+            Vector3<T> point;
+        };
+        constexpr size_t run = 16;
+        const size_t n = _keys.size();
+        std::vector<Moved> moved;
+        size_t w = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t key = _keys[i];
+            if (w > 0 && key < _keys[w - 1]) {
+                size_t above = 1;
+                while (above <= run && above < w && _keys[w - 1 - above] > key) ++above;
+                if (above > run) {
+                    moved.push_back({key, _perm[i], _points[i]});
+                    if (moved.size() > max_displaced) return false;
+                    continue;
+                }
+                for (; above > 0; --above) {
+                    --w;
+                    moved.push_back({_keys[w], _perm[w], _points[w]});
+                }
+                if (moved.size() > max_displaced) return false;
+            }
+            if (w != i) {
+                _keys[w] = key;
+                _perm[w] = _perm[i];
+                _points[w] = _points[i];
+            }
+            ++w;
+        }
+        if (moved.empty()) return true;
+        std::stable_sort(moved.begin(), moved.end(), [](const Moved &a, const Moved &b) { return a.key < b.key; });
+
+        // From the back, the larger key first (a displaced point after an
+        // equal kept one).
+        size_t j = moved.size();
+        for (size_t out = n; j > 0;) {
+            --out;
+            if (w > 0 && _keys[w - 1] > moved[j - 1].key) {
+                --w;
+                _keys[out] = _keys[w];
+                _perm[out] = _perm[w];
+                _points[out] = _points[w];
+            } else {
+                --j;
+                _keys[out] = moved[j].key;
+                _perm[out] = moved[j].perm;
+                _points[out] = moved[j].point;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief The first index whose key is not below a value (lower_bound),
+     *        searching outwards from a guess near it.
+     */
+    size_t gallop(uint64_t value, size_t guess) const {
+        const size_t n = _keys.size();
+        guess = std::min(guess, n);
+        size_t lo = guess, hi = guess, step = 1;
+        if (guess < n && _keys[guess] < value) {
+            // The answer is in (guess, n]: double the step until past it.
+            while (hi < n && _keys[hi] < value) {
+                lo = hi + 1;
+                hi = std::min(n, hi + step);
+                step *= 2;
+            }
+        } else {
+            // The answer is in [0, guess].
+            while (lo > 0 && _keys[lo - 1] >= value) {
+                hi = lo - 1;
+                lo = lo > step ? lo - step : 0;
+                step *= 2;
+            }
+        }
+        return static_cast<size_t>(std::lower_bound(_keys.begin() + lo, _keys.begin() + hi, value) - _keys.begin());
+    }
+
+    /**
+     * @brief Finds every node's point range from its key, bottom up, or
+     *        returns false if the leaves no longer cover the points or fail
+     *        the policy.
+     */
+    bool refit_nodes(const OctreeRefitPolicy &policy, ThreadPool &pool) {
+        const uint32_t n = static_cast<uint32_t>(_keys.size());
+        parallel_for(0, _leaves.size(), 256, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                OctreeNode &leaf = _nodes[_leaves[i]];
+                const unsigned shift = 3 * (MORTON_BITS - leaf.level);
+                const uint64_t lo = leaf.key << shift, hi = (leaf.key + 1) << shift;
+                leaf.begin = static_cast<uint32_t>(gallop(lo, leaf.begin));
+                leaf.end = static_cast<uint32_t>(gallop(hi, std::max(leaf.end, leaf.begin)));
+            }
+        }, pool);
+
+        size_t empty = 0, next = 0;
+        const double largest = policy.max_leaf_growth * static_cast<double>(_max_leaf);
+        for (uint32_t l: _leaves) {
+            const OctreeNode &leaf = _nodes[l];
+            if (leaf.begin != next) return false;
+            if (leaf.level < MORTON_BITS && static_cast<double>(leaf.size()) > largest) return false;
+            empty += leaf.size() == 0;
+            next = leaf.end;
+        }
+        if (next != n) return false;
+        if (static_cast<double>(empty) > policy.max_empty * static_cast<double>(_leaves.size())) return false;
+
+        for (size_t level = depth() - 1; level-- > 0;) {
+            auto [b, e] = level_range(level);
+            for (size_t i = b; i < e; ++i) {
+                OctreeNode &node = _nodes[i];
+                if (node.is_leaf()) continue;
+                node.begin = _nodes[node.first_child].begin;
+                node.end = _nodes[node.first_child + node.nchildren - 1].end;
+            }
+        }
+        return true;
+    }
+
+    size_t _max_leaf;
+    BoundingCube<T> _cube{};
+    std::vector<uint64_t> _keys;
+    std::vector<uint32_t> _perm;
+    std::vector<Vector3<T>> _points;
+    std::vector<OctreeNode> _nodes;
+    std::vector<size_t> _level_offsets;
+    std::vector<uint32_t> _leaves;
+};
+
+#endif //FMM_OCTREE_HPP
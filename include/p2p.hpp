@@ -0,0 +1,285 @@
+/**
+ * @file p2p.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Direct (particle to particle) summation of the Laplace potential
+ *        1/|r| and field r/|r|^3, vectorised over targets.
+ */
+
+#ifndef FMM_P2P_HPP
+#define FMM_P2P_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "parallel.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief The number of sources per tile: four arrays of 512 doubles (16 KiB)
+ *        stay resident in a 32 KiB L1 data cache while every target block
+ *        streams over them.
+ */
+inline constexpr size_t P2P_TILE = 512;
+
+/**
+ * @brief The flops counted per pairwise interaction when reporting Gflop/s
+ *        (the customary figure for potential plus field; rsqrt and its
+ *        refinement are counted as one operation each).
+ */
+inline constexpr double P2P_FLOPS_PER_INTERACTION = 20.0;
+
+/**
+ * @brief Whether the sources and targets are the same particles.
+ *
+ * The kernel gives pairs at zero distance (in particular i == j in self mode)
+ * no contribution with a compare and a mask rather than a branch, for every
+ * pair, so self interaction costs nothing extra; coincident distinct
+ * particles are excluded too. The mode only selects the argument checks.
+ */
+enum class P2PMode {
+    distinct,
+    self
+};
+
+namespace detail {
+
+// ######################################################################### //
+// # SIMD lanes.                                                           # //
+// ######################################################################### //
+
+/**
+ * @brief One double per "vector"; also the reference for the SIMD lanes.
+ */
+struct P2PScalar {
+    using V = double;
+    static constexpr size_t width = 1;
+
+    static V load(const double *p) { return *p; }
+    static void store(double *p, V v) { *p = v; }
+    static V set1(double x) { return x; }
+    static V zero() { return 0.0; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V fmadd(V a, V b, V c) { return a * b + c; }
+
+    /**
+     * @brief 1/sqrt(r2), or 0 where r2 is 0.
+     */
+    static V rsqrt_masked(V r2) { return r2 > 0.0 ? 1.0 / std::sqrt(r2) : 0.0; }
+};
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+/**
+ * @brief Four doubles per vector. There is no double precision rsqrt in AVX2:
+ *        the single precision estimate (12 bits) is refined with three
+ *        Newton steps (about 48 bits, then rounding limited). Lanes whose r2
+ *        is outside the normal float range, where that estimate would be
+ *        inf or 0, take a full precision sqrt and divide instead.
+ */
+struct P2PAvx2 {
+    using V = __m256d;
+    static constexpr size_t width = 4;
+
+    static V load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, V v) { _mm256_storeu_pd(p, v); }
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static V zero() { return _mm256_setzero_pd(); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+
+    static V newton(V y, V r2) {
+        V t = _mm256_mul_pd(_mm256_mul_pd(r2, y), y);
+        return _mm256_mul_pd(y, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), t, _mm256_set1_pd(1.5)));
+    }
+
+    static V rsqrt_masked(V r2) {
+        V y = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2)));
+        y = newton(newton(newton(y, r2), r2), r2);
+        V in_range = _mm256_and_pd(_mm256_cmp_pd(r2, _mm256_set1_pd(FLT_MIN), _CMP_GE_OQ),
+                                   _mm256_cmp_pd(r2, _mm256_set1_pd(FLT_MAX), _CMP_LE_OQ));
+        if (_mm256_movemask_pd(in_range) != 0xf) {
+            V exact = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(r2));
+            y = _mm256_blendv_pd(exact, y, in_range);
+        }
+        return _mm256_and_pd(y, _mm256_cmp_pd(r2, _mm256_setzero_pd(), _CMP_GT_OQ));
+    }
+};
+
+#endif
+
+#if defined(__AVX512F__)
+
+/**
+ * @brief Eight doubles per vector; the 14 bit rsqrt14 estimate is refined
+ *        with two Newton steps.
+ */
+struct P2PAvx512 {
+    using V = __m512d;
+    static constexpr size_t width = 8;
+
+    static V load(const double *p) { return _mm512_loadu_pd(p); }
+    static void store(double *p, V v) { _mm512_storeu_pd(p, v); }
+    static V set1(double x) { return _mm512_set1_pd(x); }
+    static V zero() { return _mm512_setzero_pd(); }
+    static V add(V a, V b) { return _mm512_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+
+    static V newton(V y, V r2) {
+        V t = _mm512_mul_pd(_mm512_mul_pd(r2, y), y);
+        return _mm512_mul_pd(y, _mm512_fnmadd_pd(_mm512_set1_pd(0.5), t, _mm512_set1_pd(1.5)));
+    }
+
+    static V rsqrt_masked(V r2) {
+        // Zero lanes start (and so stay) at 0 through the Newton steps.
+        __mmask8 nonzero = _mm512_cmp_pd_mask(r2, _mm512_setzero_pd(), _CMP_GT_OQ);
+        return newton(newton(_mm512_maskz_rsqrt14_pd(nonzero, r2), r2), r2);
+    }
+};
+
+using P2PLanes = P2PAvx512;
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+using P2PLanes = P2PAvx2;
+
+#else
+
+using P2PLanes = P2PScalar;
+
+#endif
+
+/**
+ * @brief Adds the contribution of sources [0, ns) to one block of S::width
+ *        targets held in registers.
+ */
+template <typename S>
+inline void p2p_block(const double *sx, const double *sy, const double *sz, const double *q, size_t ns,
+                      typename S::V tx, typename S::V ty, typename S::V tz,
+                      typename S::V &phi, typename S::V &ex, typename S::V &ey, typename S::V &ez) {
+    for (size_t j = 0; j < ns; ++j) {
+        typename S::V dx = S::sub(tx, S::set1(sx[j]));
+        typename S::V dy = S::sub(ty, S::set1(sy[j]));
+        typename S::V dz = S::sub(tz, S::set1(sz[j]));
+        typename S::V r2 = S::fmadd(dz, dz, S::fmadd(dy, dy, S::mul(dx, dx)));
+        typename S::V inv = S::rsqrt_masked(r2);
+        typename S::V qinv = S::mul(S::set1(q[j]), inv);
+        phi = S::add(phi, qinv);
+        typename S::V qinv3 = S::mul(qinv, S::mul(inv, inv));
+        ex = S::fmadd(dx, qinv3, ex);
+        ey = S::fmadd(dy, qinv3, ey);
+        ez = S::fmadd(dz, qinv3, ez);
+    }
+}
+
+/**
+ * @brief The serial tiled kernel over lanes S.
+ */
+template <typename S>
+void p2p_tiled(const double *sx, const double *sy, const double *sz, const double *q, size_t ns,
+               const double *tx, const double *ty, const double *tz, size_t nt,
+               double *phi, double *ex, double *ey, double *ez) {
+    constexpr size_t w = S::width;
+    for (size_t s0 = 0; s0 < ns; s0 += P2P_TILE) {
+        size_t ts = std::min(P2P_TILE, ns - s0);
+        size_t i = 0;
+        for (; i + w <= nt; i += w) {
+            typename S::V p = S::load(phi + i), fx = S::load(ex + i), fy = S::load(ey + i), fz = S::load(ez + i);
+            p2p_block<S>(sx + s0, sy + s0, sz + s0, q + s0, ts,
+                         S::load(tx + i), S::load(ty + i), S::load(tz + i), p, fx, fy, fz);
+            S::store(phi + i, p);
+            S::store(ex + i, fx);
+            S::store(ey + i, fy);
+            S::store(ez + i, fz);
+        }
+        if (i < nt) {
+            // Pad the remaining targets into one full block (repeating the
+            // last target) and store only the real lanes.
+            alignas(64) double buf[7][w];
+            for (size_t l = 0; l < w; ++l) {
+                size_t k = std::min(i + l, nt - 1);
+                buf[0][l] = tx[k];
+                buf[1][l] = ty[k];
+                buf[2][l] = tz[k];
+                buf[3][l] = buf[4][l] = buf[5][l] = buf[6][l] = 0.0;
+            }
+            typename S::V p = S::zero(), fx = S::zero(), fy = S::zero(), fz = S::zero();
+            p2p_block<S>(sx + s0, sy + s0, sz + s0, q + s0, ts,
+                         S::load(buf[0]), S::load(buf[1]), S::load(buf[2]), p, fx, fy, fz);
+            S::store(buf[3], p);
+            S::store(buf[4], fx);
+            S::store(buf[5], fy);
+            S::store(buf[6], fz);
+            for (size_t k = i; k < nt; ++k) {
+                phi[k] += buf[3][k - i];
+                ex[k] += buf[4][k - i];
+                ey[k] += buf[5][k - i];
+                ez[k] += buf[6][k - i];
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// ######################################################################### //
+// # Kernels.                                                              # //
+// ######################################################################### //
+
+/**
+ * @brief Adds to every target t the potential sum_s q_s / |t - s| and the
+ *        field sum_s q_s (t - s) / |t - s|^3 of the sources (serial, raw
+ *        arrays; the building block for FMM near-field interactions).
+ *
+ * Pairs at zero distance contribute nothing.
+ */
+inline void p2p_kernel(const double *sx, const double *sy, const double *sz, const double *q, size_t ns,
+                       const double *tx, const double *ty, const double *tz, size_t nt,
+                       double *phi, double *ex, double *ey, double *ez) {
+    detail::p2p_tiled<detail::P2PLanes>(sx, sy, sz, q, ns, tx, ty, tz, nt, phi, ex, ey, ez);
+}
+
+/**
+ * @brief Adds the potential and field of the sources to every target, in
+ *        parallel over blocks of targets.
+ *
+ * @param sources the source positions.
+ * @param charges the source charges (or masses).
+ * @param targets the target positions.
+ * @param potential the potentials to add to (one per target).
+ * @param field the fields to add to (one per target).
+ * @param mode P2PMode::self if targets are the sources.
+ * @param pool the pool to run on.
+ */
+inline void p2p(const Vector3Array<double> &sources, std::span<const double> charges,
+                const Vector3Array<double> &targets, std::span<double> potential,
+                Vector3Array<double> &field, P2PMode mode = P2PMode::distinct,
+                ThreadPool &pool = ThreadPool::global()) {
+    if (charges.size() != sources.size() || potential.size() != targets.size() || field.size() != targets.size()) {
+        throw std::invalid_argument("p2p size mismatch");
+    }
+    if (mode == P2PMode::self && sources.size() != targets.size()) {
+        throw std::invalid_argument("p2p self mode needs targets == sources");
+    }
+    parallel_for(0, targets.size(), 256, [&](size_t b, size_t e) {
+        p2p_kernel(sources.x(), sources.y(), sources.z(), charges.data(), sources.size(),
+                   targets.x() + b, targets.y() + b, targets.z() + b, e - b,
+                   potential.data() + b, field.x() + b, field.y() + b, field.z() + b);
+    }, pool);
+}
+
+#endif //FMM_P2P_HPP
@@ -0,0 +1,301 @@
+/**
+ * @file parallel.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A small worker pool and parallel loop helpers.
+ */
+
+#ifndef FMM_PARALLEL_HPP
+#define FMM_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ######################################################################### //
+// # Worker pool.                                                          # //
+// ######################################################################### //
+
+/**
+ * @brief A fixed size pool of worker threads.
+ *
+ * Work is submitted as a batch of `ntasks` independent tasks; the workers
+ * (and the calling thread) pull task indices from a shared counter until the
+ * batch is exhausted. The calling thread blocks until every task of the batch
+ * has finished.
+ *
+ * Batches submitted from inside a task of the same pool run inline. A thread
+ * taking part in another pool's batch submits like any other caller, so pools
+ * may be nested but not cyclically (a task of A waiting on B waiting on A).
+ */
+class ThreadPool {
+public:
+
+    /**
+     * @brief Creates a pool with the given number of threads.
+     *
+     * @param nthreads the total number of threads taking part in a batch,
+     *                 including the calling thread (at least 1).
+     */
+    explicit ThreadPool(size_t nthreads = default_concurrency())
+            : ThreadPool(nthreads, nullptr, nullptr) {}
+
+    /**
+     * @brief Creates a pool whose worker threads run set-up and tear-down
+     *        hooks, e.g. to install and release thread-local library state.
+     *
+     * The hooks run on each worker thread (indices 1 .. nthreads-1) when it
+     * starts and just before it exits; they are not run on the calling thread.
+     *
+     * @param nthreads the total number of threads taking part in a batch.
+     * @param on_start called as `on_start(worker_index)` on thread start.
+     * @param on_stop called as `on_stop(worker_index)` on thread exit.
+     */
+    ThreadPool(size_t nthreads,
+               std::function<void(size_t)> on_start,
+               std::function<void(size_t)> on_stop)
+            : _on_start(std::move(on_start)), _on_stop(std::move(on_stop)) {
+        nthreads = std::max<size_t>(nthreads, 1);
+        _workers.reserve(nthreads - 1);
+        for (size_t w = 1; w < nthreads; ++w) {
+            _workers.emplace_back([this, w]() { worker_loop(w); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &t: _workers) t.join();
+    }
+
+    /**
+     * @brief The number of threads that take part in a batch.
+     */
+    [[nodiscard]] size_t size() const { return _workers.size() + 1; }
+
+    /**
+     * @brief Runs `ntasks` tasks and waits for their completion.
+     *
+     * @param ntasks the number of tasks in the batch.
+     * @param task the task body, called as `task(task_index, worker_index)`;
+     *        worker indices are in [0, size()) and the caller is worker 0.
+     */
+    void run(size_t ntasks, const std::function<void(size_t, size_t)> &task) {
+        if (ntasks == 0) return;
+        // Nested batches (a task submitting work to its own pool) run inline
+        // on the caller, which keeps its worker index.
+        if (member().pool == this) {
+            for (size_t t = 0; t < ntasks; ++t) task(t, member().worker);
+            return;
+        }
+
+        // Any other thread, including a worker of a different pool, owns this
+        // pool for the duration of the batch and takes part as worker 0.
+        std::lock_guard<std::mutex> batch_lock(_batch_mutex);
+        Membership outer = std::exchange(member(), Membership{this, 0});
+        if (ntasks == 1 || _workers.empty()) {
+            try {
+                for (size_t t = 0; t < ntasks; ++t) task(t, 0);
+            } catch (...) {
+                member() = outer;
+                throw;
+            }
+            member() = outer;
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _ntasks = ntasks;
+            _next.store(0);
+            _active = _workers.size();
+            _error = nullptr;
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        drain(0);
+        member() = outer;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return _active == 0; });
+        _task = nullptr;
+        if (_error) std::rethrow_exception(_error);
+    }
+
+    /**
+     * @brief The index of the calling thread within this pool: its worker
+     *        index when it is running a task of this pool, 0 otherwise.
+     */
+    [[nodiscard]] size_t worker_index() const {
+        return member().pool == this ? member().worker : 0;
+    }
+
+    /**
+     * @brief A process wide pool sized to the hardware concurrency.
+     */
+    static ThreadPool &global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief The default number of threads: the hardware concurrency, or the
+     *        value of the FMM_NUM_THREADS environment variable when set.
+     */
+    static size_t default_concurrency() {
+        if (const char *env = std::getenv("FMM_NUM_THREADS")) {
+            long n = std::strtol(env, nullptr, 10);
+            if (n > 0) return static_cast<size_t>(n);
+        }
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+private:
+
+    void drain(size_t worker) {
+        for (;;) {
+            size_t t = _next.fetch_add(1);
+            if (t >= _ntasks) break;
+            try {
+                (*_task)(t, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error) _error = std::current_exception();
+            }
+        }
+    }
+
+    /**
+     * @brief The pool whose batch the calling thread is taking part in, and
+     *        its worker index there; nested batches consult this so that an
+     *        index is only ever reused within the pool it was issued by.
+     */
+    struct Membership {
+        const ThreadPool *pool = nullptr;
+        size_t worker = 0;
+    };
+
+    static Membership &member() {
+        static thread_local Membership m;
+        return m;
+    }
+
+    void worker_loop(size_t worker) {
+        member() = Membership{this, worker};
+        if (_on_start) _on_start(worker);
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&]() { return _stop || _generation != seen; });
+                if (_stop) break;
+                seen = _generation;
+            }
+            drain(worker);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (--_active == 0) _done.notify_one();
+            }
+        }
+        if (_on_stop) _on_stop(worker);
+    }
+
+    std::function<void(size_t)> _on_start;
+    std::function<void(size_t)> _on_stop;
+    std::vector<std::thread> _workers;
+    std::mutex _batch_mutex;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(size_t, size_t)> *_task = nullptr;
+    size_t _ntasks = 0;
+    std::atomic<size_t> _next{0};
+    size_t _active = 0;
+    size_t _generation = 0;
+    bool _stop = false;
+    std::exception_ptr _error;
+};
+
+// ######################################################################### //
+// # Parallel loops.                                                       # //
+// ######################################################################### //
+
+/**
+ * @brief Splits [begin, end) into contiguous chunks of at least `grain`
+ *        elements and processes them on a pool.
+ *
+ * The chunk boundaries depend only on the range, the grain and the pool size,
+ * never on scheduling, so a body that writes disjoint outputs per index is
+ * deterministic.
+ *
+ * @tparam F a callable `f(chunk_begin, chunk_end)`.
+ *
+ * @param begin the start of the range.
+ * @param end one past the end of the range.
+ * @param grain the minimum number of indices per chunk.
+ * @param f the chunk body.
+ * @param pool the pool to run on.
+ */
+template <typename F>
+void parallel_for(size_t begin, size_t end, size_t grain, F &&f,
+                  ThreadPool &pool = ThreadPool::global()) {
+    if (end <= begin) return;
+    size_t n = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    size_t nchunks = std::min((n + grain - 1) / grain, 4 * pool.size());
+    if (nchunks <= 1) {
+        f(begin, end);
+        return;
+    }
+    size_t chunk = (n + nchunks - 1) / nchunks;
+    nchunks = (n + chunk - 1) / chunk;
+    pool.run(nchunks, [&](size_t c, size_t) {
+        size_t b = begin + c * chunk;
+        f(b, std::min(b + chunk, end));
+    });
+}
+
+/**
+ * @brief As parallel_for, but the body also receives the worker index so that
+ *        per-thread scratch space can be indexed without locking.
+ *
+ * @tparam F a callable `f(chunk_begin, chunk_end, worker)`.
+ */
+template <typename F>
+void parallel_for_worker(size_t begin, size_t end, size_t grain, F &&f,
+                         ThreadPool &pool = ThreadPool::global()) {
+    if (end <= begin) return;
+    size_t n = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    size_t nchunks = std::min((n + grain - 1) / grain, 4 * pool.size());
+    if (nchunks <= 1) {
+        // Through the pool, so the body gets the caller's own worker index
+        // (or exclusive use of index 0) rather than racing worker 0's scratch.
+        pool.run(1, [&](size_t, size_t worker) { f(begin, end, worker); });
+        return;
+    }
+    size_t chunk = (n + nchunks - 1) / nchunks;
+    nchunks = (n + chunk - 1) / chunk;
+    pool.run(nchunks, [&](size_t c, size_t worker) {
+        size_t b = begin + c * chunk;
+        f(b, std::min(b + chunk, end), worker);
+    });
+}
+
+#endif //FMM_PARALLEL_HPP
@@ -0,0 +1,125 @@
+/**
+ * @file permutation.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A permutation of particle indices with its inverse, applied in
+ *        parallel to any number of per-particle arrays.
+ */
+
+#ifndef FMM_PERMUTATION_HPP
+#define FMM_PERMUTATION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+/**
+ * @brief A reordering of n items: item i of the reordered sequence is item
+ *        forward()[i] of the original one, and original item j ends up at
+ *        inverse()[j].
+ */
+class Permutation {
+public:
+
+    Permutation() = default;
+
+    /**
+     * @brief A permutation from its forward map (which must be a bijection
+     *        on [0, n)); the inverse is computed in parallel.
+     */
+    explicit Permutation(std::vector<uint32_t> forward, ThreadPool &pool = ThreadPool::global())
+            : _forward(std::move(forward)), _inverse(_forward.size()) {
+        parallel_for(0, _forward.size(), 1 << 16, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) _inverse[_forward[i]] = static_cast<uint32_t>(i);
+        }, pool);
+    }
+
+    [[nodiscard]] size_t size() const { return _forward.size(); }
+
+    /**
+     * @brief For each new position, the original index.
+     */
+    [[nodiscard]] std::span<const uint32_t> forward() const { return _forward; }
+
+    /**
+     * @brief For each original index, the new position.
+     */
+    [[nodiscard]] std::span<const uint32_t> inverse() const { return _inverse; }
+
+    /**
+     * @brief Gathers: out[i] = in[forward()[i]].
+     */
+    template <typename A>
+    void gather(std::span<const A> in, std::span<A> out, ThreadPool &pool = ThreadPool::global()) const {
+        check(in.size(), out.size());
+        parallel_for(0, size(), 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) out[i] = in[_forward[i]];
+        }, pool);
+    }
+
+    /**
+     * @brief Scatters results back to the original order:
+     *        out[forward()[i]] = in[i].
+     */
+    template <typename A>
+    void scatter(std::span<const A> in, std::span<A> out, ThreadPool &pool = ThreadPool::global()) const {
+        check(in.size(), out.size());
+        parallel_for(0, size(), 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) out[_forward[i]] = in[i];
+        }, pool);
+    }
+
+    /**
+     * @brief Reorders arrays in place (through a scratch copy of each).
+     */
+    template <typename... A>
+    void apply(ThreadPool &pool, std::vector<A> &...arrays) const {
+        (permute_in_place(arrays, false, pool), ...);
+    }
+
+    template <typename... A>
+    void apply(std::vector<A> &...arrays) const {
+        apply(ThreadPool::global(), arrays...);
+    }
+
+    /**
+     * @brief Restores arrays reordered with apply() to the original order.
+     */
+    template <typename... A>
+    void unapply(ThreadPool &pool, std::vector<A> &...arrays) const {
+        (permute_in_place(arrays, true, pool), ...);
+    }
+
+    template <typename... A>
+    void unapply(std::vector<A> &...arrays) const {
+        unapply(ThreadPool::global(), arrays...);
+    }
+
+private:
+
+    void check(size_t in, size_t out) const {
+        if (in != size() || out != size()) throw std::invalid_argument("permutation size mismatch");
+    }
+
+    template <typename A>
+    void permute_in_place(std::vector<A> &a, bool back, ThreadPool &pool) const {
+        std::vector<A> tmp(a.size());
+        if (back) {
+            scatter<A>(a, tmp, pool);
+        } else {
+            gather<A>(a, tmp, pool);
+        }
+        a.swap(tmp);
+    }
+
+    std::vector<uint32_t> _forward;
+    std::vector<uint32_t> _inverse;
+};
+
+#endif //FMM_PERMUTATION_HPP
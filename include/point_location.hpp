@@ -0,0 +1,446 @@
+/**
+ * @file point_location.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Point location in a TetMesh: the element containing a point and
+ *        its barycentric coordinates there, and interpolation of nodal
+ *        fields at arbitrary points.
+ *
+ * Two searches share the barycentric test. A bounding volume hierarchy over
+ * the elements finds the element of any point in logarithmic time: since
+ * TetMesh stores its elements in Morton order, the hierarchy is a balanced
+ * binary tree over ranges of consecutive elements, built without sorting,
+ * and refitted in place when the nodes move. A walk starts from a nearby
+ * element and crosses the face with the most negative barycentric
+ * coordinate until it reaches the point; it costs a few steps when the
+ * start is close, and falls back to the hierarchy at the boundary (the mesh
+ * need not be convex) or after LOCATE_MAX_WALK steps.
+ *
+ * Batched queries sort the points by Morton key and walk from each point to
+ * the next, so most points cost one or two barycentric tests and the
+ * elements visited stay in cache. The sorted points are cut into fixed
+ * blocks, located in parallel, and each block starts with a search; so
+ * results do not depend on the number of threads.
+ */
+
+#ifndef FMM_POINT_LOCATION_HPP
+#define FMM_POINT_LOCATION_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+
+/**
+ * @brief The element index meaning "no element": a point outside the mesh,
+ *        or the far side of a boundary face.
+ */
+inline constexpr uint32_t TET_NONE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief How far outside an element (as a barycentric coordinate) a point
+ *        may be and still be found in it; points on faces and edges belong
+ *        to one of the elements that share them.
+ */
+inline constexpr double LOCATE_TOLERANCE = 1.0e-12;
+
+/**
+ * @brief The most elements a walk visits before it falls back to a search.
+ */
+inline constexpr size_t LOCATE_MAX_WALK = 128;
+
+/**
+ * @brief The element of a point and the point's barycentric coordinates,
+ *        ordered as the element's nodes.
+ */
+struct TetLocation {
+    uint32_t element = TET_NONE;       /**< The element, or TET_NONE outside the mesh. */
+    std::array<double, 4> weights{};   /**< The barycentric coordinates (zero outside). */
+
+    [[nodiscard]] bool found() const { return element != TET_NONE; }
+};
+
+/**
+ * @brief The work of a batch of queries.
+ */
+struct LocateStats {
+    size_t searches = 0;     /**< Hierarchy searches (one per block, plus fallbacks). */
+    size_t walk_steps = 0;   /**< Elements tested by walks. */
+    size_t outside = 0;      /**< Points outside the mesh. */
+};
+
+/**
+ * @brief The barycentric coordinates of p in the tetrahedron (x0, x1, x2,
+ *        x3), by Cramer's rule on x - x0 = J xi: xi_k is det J with column k
+ *        replaced by p - x0, over det J, and the weight of x0 is
+ *        1 - xi_1 - xi_2 - xi_3. Either orientation gives the same result.
+ */
+inline std::array<double, 4> barycentric(const Vector3<double> &x0, const Vector3<double> &x1,
+                                         const Vector3<double> &x2, const Vector3<double> &x3,
+                                         const Vector3<double> &p) {
+    const Vector3<double> a = x1 - x0, b = x2 - x0, c = x3 - x0, d = p - x0;
+    const double scale = 1.0 / det(Matrix3x3<double>{a.x, b.x, c.x, a.y, b.y, c.y, a.z, b.z, c.z});
+    const double l1 = det(Matrix3x3<double>{d.x, b.x, c.x, d.y, b.y, c.y, d.z, b.z, c.z}) * scale;
+    const double l2 = det(Matrix3x3<double>{a.x, d.x, c.x, a.y, d.y, c.y, a.z, d.z, c.z}) * scale;
+    const double l3 = det(Matrix3x3<double>{a.x, b.x, d.x, a.y, b.y, d.y, a.z, b.z, d.z}) * scale;
+    return {1.0 - l1 - l2 - l3, l1, l2, l3};
+}
+
+/**
+ * @brief The barycentric coordinates of p in element e of a mesh.
+ */
+inline std::array<double, 4> barycentric(const TetMesh &mesh, size_t e, const Vector3<double> &p) {
+    auto v = mesh.element(e);
+    return barycentric(mesh.node(v[0]), mesh.node(v[1]), mesh.node(v[2]), mesh.node(v[3]), p);
+}
+
+namespace detail {
+
+/**
+ * @brief The points per block of a batched query.
+ */
+inline constexpr size_t LOCATE_BLOCK = 256;
+
+/**
+ * @brief The most elements in a leaf of the hierarchy.
+ */
+inline constexpr size_t LOCATE_LEAF = 8;
+
+/**
+ * @brief A hierarchy node: its box and either a range of elements (a leaf)
+ *        or its children, the left one next in the array.
+ */
+struct LocateNode {
+    Vector3<double> lo;
+    Vector3<double> hi;
+    uint32_t first = 0;   /**< The first element of a leaf. */
+    uint32_t count = 0;   /**< The elements of a leaf; 0 for an inner node. */
+    uint32_t right = 0;   /**< The right child of an inner node. */
+};
+
+} // namespace detail
+
+/**
+ * @brief Locates points in a TetMesh and interpolates nodal fields there.
+ *
+ * The locator keeps a reference to the mesh. Moving the nodes (with the
+ * element order and connectivity kept) needs refit() before the next
+ * query.
+ */
+class TetLocator {
+public:
+
+    /**
+     * @brief Builds the face adjacency and the bounding volume hierarchy.
+     *
+     * @param mesh the mesh.
+     * @param pool the pool for the build and batched queries.
+     */
+    explicit TetLocator(const TetMesh &mesh, ThreadPool &pool = ThreadPool::global())
+            : _mesh(mesh), _pool(pool) {
+        build_neighbours();
+        if (mesh.element_count() > 0) build_tree(0, mesh.element_count());
+        refit();
+    }
+
+    /**
+     * @brief For each element, four element indices: the element across the
+     *        face opposite each of its nodes, or TET_NONE at the boundary.
+     */
+    [[nodiscard]] std::span<const uint32_t> neighbours() const { return _neighbours; }
+
+    /**
+     * @brief Recomputes the hierarchy's boxes after the nodes have moved.
+     */
+    void refit() {
+        parallel_for(0, _tree.size(), 1 << 10, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                detail::LocateNode &node = _tree[i];
+                if (node.count == 0) continue;
+                constexpr double inf = std::numeric_limits<double>::infinity();
+                Vector3<double> lo{inf, inf, inf}, hi{-inf, -inf, -inf};
+                for (uint32_t v: _mesh.connectivity().subspan(4 * size_t(node.first), 4 * size_t(node.count))) {
+                    const Vector3<double> p = _mesh.node(v);
+                    lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+                    hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+                }
+                // Points just outside an element still belong to it.
+                const double pad = 4.0 * LOCATE_TOLERANCE * std::max({hi.x - lo.x, hi.y - lo.y, hi.z - lo.z});
+                node.lo = lo - Vector3<double>{pad, pad, pad};
+                node.hi = hi + Vector3<double>{pad, pad, pad};
+            }
+        }, _pool);
+        // Children follow their parent.
+        for (size_t i = _tree.size(); i-- > 0;) {
+            detail::LocateNode &node = _tree[i];
+            if (node.count != 0) continue;
+            const detail::LocateNode &l = _tree[i + 1], &r = _tree[node.right];
+            node.lo = {std::min(l.lo.x, r.lo.x), std::min(l.lo.y, r.lo.y), std::min(l.lo.z, r.lo.z)};
+            node.hi = {std::max(l.hi.x, r.hi.x), std::max(l.hi.y, r.hi.y), std::max(l.hi.z, r.hi.z)};
+        }
+    }
+
+    /**
+     * @brief The element of p, found by searching the hierarchy.
+     */
+    [[nodiscard]] TetLocation locate(const Vector3<double> &p) const {
+        return search(p);
+    }
+
+    /**
+     * @brief The element of p, found by walking from the element hint (a
+     *        search if hint is TET_NONE).
+     */
+    [[nodiscard]] TetLocation locate(const Vector3<double> &p, uint32_t hint) const {
+        LocateStats stats;
+        return walk(p, hint, stats);
+    }
+
+    /**
+     * @brief Locates a batch of points, walking from each to the next in
+     *        Morton order.
+     *
+     * @param points the points.
+     * @param out the locations, one per point.
+     *
+     * @return The work done.
+     *
+     * @throws std::invalid_argument if out is not one location per point.
+     */
+    LocateStats locate(std::span<const Vector3<double>> points, std::span<TetLocation> out) const {
+        if (out.size() != points.size()) throw std::invalid_argument("TetLocator size mismatch");
+        const size_t n = points.size();
+        std::vector<uint64_t> keys(n);
+        std::vector<uint32_t> order(n);
+        morton_keys<double>(keys, points, bounding_cube<double>(points, _pool), _pool);
+        std::iota(order.begin(), order.end(), uint32_t{0});
+        radix_sort(keys, order, 3 * MORTON_BITS, _pool);
+
+        const size_t blocks = (n + detail::LOCATE_BLOCK - 1) / detail::LOCATE_BLOCK;
+        std::vector<LocateStats> partial(blocks);
+        parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                LocateStats &stats = partial[b];
+                uint32_t hint = TET_NONE;
+                const size_t last = std::min(n, (b + 1) * detail::LOCATE_BLOCK);
+                for (size_t k = b * detail::LOCATE_BLOCK; k < last; ++k) {
+                    TetLocation &location = out[order[k]];
+                    location = walk(points[order[k]], hint, stats);
+                    if (location.found()) {
+                        hint = location.element;
+                    } else {
+                        ++stats.outside;
+                    }
+                }
+            }
+        }, _pool);
+
+        LocateStats total;
+        for (const LocateStats &s: partial) {
+            total.searches += s.searches;
+            total.walk_steps += s.walk_steps;
+            total.outside += s.outside;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Interpolates a nodal field at located points: out_k is the
+     *        weighted sum of the field at the nodes of location k's element,
+     *        and zero for a point outside the mesh.
+     *
+     * @return The number of points outside the mesh.
+     *
+     * @throws std::invalid_argument if the field is not one vector per node
+     *         or out not one per location.
+     */
+    size_t interpolate(const Vector3Array<double> &field, std::span<const TetLocation> locations,
+                       Vector3Array<double> &out) const {
+        if (field.size() != _mesh.node_count() || out.size() != locations.size()) {
+            throw std::invalid_argument("TetLocator size mismatch");
+        }
+        std::vector<size_t> outside(_pool.size(), 0);
+        parallel_for_worker(0, locations.size(), 1 << 12, [&](size_t b, size_t e, size_t w) {
+            const double *fx = field.x(), *fy = field.y(), *fz = field.z();
+            size_t missing = 0;
+            for (size_t k = b; k < e; ++k) {
+                const TetLocation &location = locations[k];
+                if (!location.found()) {
+                    out.set(k, {0.0, 0.0, 0.0});
+                    ++missing;
+                    continue;
+                }
+                auto v = _mesh.element(location.element);
+                const std::array<double, 4> &l = location.weights;
+                out.set(k, {l[0] * fx[v[0]] + l[1] * fx[v[1]] + l[2] * fx[v[2]] + l[3] * fx[v[3]],
+                            l[0] * fy[v[0]] + l[1] * fy[v[1]] + l[2] * fy[v[2]] + l[3] * fy[v[3]],
+                            l[0] * fz[v[0]] + l[1] * fz[v[1]] + l[2] * fz[v[2]] + l[3] * fz[v[3]]});
+            }
+            outside[w] += missing;
+        }, _pool);
+        return std::accumulate(outside.begin(), outside.end(), size_t{0});
+    }
+
+    /**
+     * @brief Locates the points and interpolates a nodal field there (to
+     *        probe a changing field at fixed points, locate once and
+     *        interpolate from the locations).
+     *
+     * @return The number of points outside the mesh.
+     */
+    size_t interpolate(const Vector3Array<double> &field, std::span<const Vector3<double>> points,
+                       Vector3Array<double> &out) const {
+        if (field.size() != _mesh.node_count() || out.size() != points.size()) {
+            throw std::invalid_argument("TetLocator size mismatch");
+        }
+        std::vector<TetLocation> locations(points.size());
+        locate(points, locations);
+        return interpolate(field, locations, out);
+    }
+
+private:
+
+    /**
+     * @brief The location of p in element e if p is in it; otherwise
+     *        nothing, with the face across which p lies furthest in face.
+     */
+    [[nodiscard]] bool test(const Vector3<double> &p, uint32_t e, TetLocation &location, size_t &face) const {
+        const std::array<double, 4> l = barycentric(_mesh, e, p);
+        face = size_t(std::min_element(l.begin(), l.end()) - l.begin());
+        if (!(l[face] >= -LOCATE_TOLERANCE)) return false;
+        location = {e, l};
+        return true;
+    }
+
+    /**
+     * @brief Searches the hierarchy: the first element (in element order)
+     *        of the first leaf whose box holds p that contains p.
+     */
+    [[nodiscard]] TetLocation search(const Vector3<double> &p) const {
+        TetLocation location;
+        if (_tree.empty()) return location;
+        std::array<uint32_t, 64> stack;
+        size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            uint32_t i = stack[--top];
+            while (true) {
+                const detail::LocateNode &node = _tree[i];
+                if (p.x < node.lo.x || p.y < node.lo.y || p.z < node.lo.z ||
+                    p.x > node.hi.x || p.y > node.hi.y || p.z > node.hi.z) {
+                    break;
+                }
+                if (node.count != 0) {
+                    size_t face;
+                    for (uint32_t e = node.first; e < node.first + node.count; ++e) {
+                        if (test(p, e, location, face)) return location;
+                    }
+                    break;
+                }
+                stack[top++] = node.right;
+                ++i;
+            }
+        }
+        return location;
+    }
+
+    /**
+     * @brief Walks from hint towards p, searching instead when the walk
+     *        leaves the mesh or takes too long.
+     */
+    [[nodiscard]] TetLocation walk(const Vector3<double> &p, uint32_t hint, LocateStats &stats) const {
+        TetLocation location;
+        size_t face;
+        for (size_t k = 0; k < LOCATE_MAX_WALK && hint != TET_NONE; ++k) {
+            ++stats.walk_steps;
+            if (test(p, hint, location, face)) return location;
+            hint = _neighbours[4 * size_t(hint) + face];
+        }
+        ++stats.searches;
+        return search(p);
+    }
+
+    /**
+     * @brief Matches faces: every face is filed under its smallest node,
+     *        and faces under a node are paired by their other two nodes.
+     */
+    void build_neighbours() {
+        const size_t ne = _mesh.element_count(), nn = _mesh.node_count();
+        auto conn = _mesh.connectivity();
+        _neighbours.assign(4 * ne, TET_NONE);
+
+        // Face 4 e + i is opposite node i of element e.
+        auto face = [&](size_t f) {
+            const uint32_t *v = conn.data() + 4 * (f / 4);
+            std::array<uint32_t, 3> nodes;
+            for (size_t j = 0, k = 0; j < 4; ++j) {
+                if (j != f % 4) nodes[k++] = v[j];
+            }
+            std::sort(nodes.begin(), nodes.end());
+            return nodes;
+        };
+
+        std::vector<size_t> offsets(nn + 1, 0);
+        for (size_t f = 0; f < 4 * ne; ++f) ++offsets[face(f)[0] + 1];
+        for (size_t i = 0; i < nn; ++i) offsets[i + 1] += offsets[i];
+        std::vector<uint32_t> faces(4 * ne);
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (size_t f = 0; f < 4 * ne; ++f) faces[next[face(f)[0]]++] = uint32_t(f);
+
+        parallel_for(0, nn, 1 << 12, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                for (size_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+                    const uint32_t f = faces[j];
+                    if (_neighbours[f] != TET_NONE) continue;
+                    const std::array<uint32_t, 3> key = face(f);
+                    for (size_t k = j + 1; k < offsets[i + 1]; ++k) {
+                        const uint32_t g = faces[k];
+                        if (_neighbours[g] == TET_NONE && face(g) == key) {
+                            _neighbours[f] = g / 4;
+                            _neighbours[g] = f / 4;
+                            break;
+                        }
+                    }
+                }
+            }
+        }, _pool);
+    }
+
+    /**
+     * @brief Appends the subtree over elements [first, last) in preorder;
+     *        returns its root.
+     */
+    uint32_t build_tree(size_t first, size_t last) {
+        const uint32_t i = uint32_t(_tree.size());
+        _tree.emplace_back();
+        if (last - first <= detail::LOCATE_LEAF) {
+            _tree[i].first = uint32_t(first);
+            _tree[i].count = uint32_t(last - first);
+            return i;
+        }
+        const size_t mid = first + (last - first) / 2;
+        build_tree(first, mid);
+        const uint32_t right = build_tree(mid, last);
+        _tree[i].right = right;
+        return i;
+    }
+
+    const TetMesh &_mesh;
+    ThreadPool &_pool;
+    std::vector<uint32_t> _neighbours;
+    std::vector<detail::LocateNode> _tree;
+};
+
+#endif //FMM_POINT_LOCATION_HPP
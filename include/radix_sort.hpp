@@ -0,0 +1,104 @@
+/**
+ * @file radix_sort.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A parallel, stable LSD radix sort of 64-bit keys with 32-bit
+ *        payloads (typically spatial keys and particle indices).
+ */
+
+#ifndef FMM_RADIX_SORT_HPP
+#define FMM_RADIX_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "parallel.hpp"
+
+/**
+ * @brief The number of key bits consumed per radix sort pass.
+ */
+inline constexpr unsigned RADIX_SORT_DIGIT_BITS = 11;
+
+/**
+ * @brief Sorts keys (stably) and applies the same permutation to values.
+ *
+ * Each pass cuts the input into a fixed set of chunks; every chunk builds a
+ * digit histogram, the histograms are scanned (digit major, chunk minor) into
+ * scatter offsets, and every chunk then scatters its items. Passes in which
+ * every key has the same digit are skipped. The result does not depend on
+ * the number of threads.
+ *
+ * @param keys the keys.
+ * @param values the payloads, one per key.
+ * @param key_bits the number of low key bits that may be non-zero.
+ * @param pool the pool to run on.
+ */
+inline void radix_sort(std::span<uint64_t> keys, std::span<uint32_t> values,
+                       unsigned key_bits = 64, ThreadPool &pool = ThreadPool::global()) {
+    if (keys.size() != values.size()) throw std::invalid_argument("radix_sort size mismatch");
+
+    constexpr size_t buckets = size_t{1} << RADIX_SORT_DIGIT_BITS;
+    constexpr uint64_t mask = buckets - 1;
+    const size_t n = keys.size();
+    if (n < 2) return;
+
+    const size_t grain = 1 << 15;
+    const size_t nchunks = std::clamp<size_t>((n + grain - 1) / grain, 1, 4 * pool.size());
+    const size_t chunk = (n + nchunks - 1) / nchunks;
+
+    std::vector<uint64_t> key_tmp(n);
+    std::vector<uint32_t> value_tmp(n);
+    std::vector<size_t> offsets(nchunks * buckets);
+
+    uint64_t *ksrc = keys.data(), *kdst = key_tmp.data();
+    uint32_t *vsrc = values.data(), *vdst = value_tmp.data();
+
+    for (unsigned shift = 0; shift < key_bits; shift += RADIX_SORT_DIGIT_BITS) {
+        pool.run(nchunks, [&](size_t c, size_t) {
+            size_t *h = &offsets[c * buckets];
+            std::fill(h, h + buckets, size_t{0});
+            size_t e = std::min(n, (c + 1) * chunk);
+            for (size_t i = c * chunk; i < e; ++i) ++h[(ksrc[i] >> shift) & mask];
+        });
+
+        size_t total = 0;
+        bool trivial = false;
+        for (size_t d = 0; d < buckets; ++d) {
+            size_t count = 0;
+            for (size_t c = 0; c < nchunks; ++c) {
+                size_t &o = offsets[c * buckets + d];
+                size_t k = o;
+                o = total + count;
+                count += k;
+            }
+            if (count == n) trivial = true;
+            total += count;
+        }
+        if (trivial) continue;
+
+        pool.run(nchunks, [&](size_t c, size_t) {
+            size_t *o = &offsets[c * buckets];
+            size_t e = std::min(n, (c + 1) * chunk);
+            for (size_t i = c * chunk; i < e; ++i) {
+                size_t j = o[(ksrc[i] >> shift) & mask]++;
+                kdst[j] = ksrc[i];
+                vdst[j] = vsrc[i];
+            }
+        });
+        std::swap(ksrc, kdst);
+        std::swap(vsrc, vdst);
+    }
+
+    if (ksrc != keys.data()) {
+        parallel_for(0, n, 1 << 16, [&](size_t b, size_t e) {
+            std::copy(ksrc + b, ksrc + e, keys.data() + b);
+            std::copy(vsrc + b, vsrc + e, values.data() + b);
+        }, pool);
+    }
+}
+
+#endif //FMM_RADIX_SORT_HPP
@@ -0,0 +1,120 @@
+/**
+ * @file soa.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Structure-of-arrays storage for Vector3 data, aligned for SIMD.
+ */
+
+#ifndef FMM_SOA_HPP
+#define FMM_SOA_HPP
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <vector>
+
+#include "linalg.hpp"
+
+/**
+ * @brief The alignment (in bytes) of SoA arrays: one cache line, which is
+ *        also the width of an AVX-512 register.
+ */
+inline constexpr size_t SOA_ALIGNMENT = 64;
+
+/**
+ * @brief A standard allocator returning SOA_ALIGNMENT aligned storage.
+ */
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{SOA_ALIGNMENT}));
+    }
+
+    void deallocate(T *p, size_t) {
+        ::operator delete(p, std::align_val_t{SOA_ALIGNMENT});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U> &) const { return true; }
+};
+
+/**
+ * @brief A std::vector with SOA_ALIGNMENT aligned storage.
+ */
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * @brief An array of Vector3 values stored as three separate, aligned
+ *        coordinate arrays.
+ *
+ * @tparam T the base data type.
+ */
+template <typename T>
+class Vector3Array {
+public:
+
+    Vector3Array() = default;
+
+    /**
+     * @brief n zero vectors.
+     */
+    explicit Vector3Array(size_t n) : _x(n), _y(n), _z(n) {}
+
+    /**
+     * @brief A copy of an array of Vector3 values.
+     */
+    explicit Vector3Array(std::span<const Vector3<T>> v) : Vector3Array(v.size()) {
+        for (size_t i = 0; i < v.size(); ++i) set(i, v[i]);
+    }
+
+    [[nodiscard]] size_t size() const { return _x.size(); }
+
+    void resize(size_t n) {
+        _x.resize(n);
+        _y.resize(n);
+        _z.resize(n);
+    }
+
+    /**
+     * @brief The vector at index i.
+     */
+    [[nodiscard]] Vector3<T> operator[](size_t i) const { return {_x[i], _y[i], _z[i]}; }
+
+    /**
+     * @brief Sets the vector at index i.
+     */
+    void set(size_t i, const Vector3<T> &v) {
+        _x[i] = v.x;
+        _y[i] = v.y;
+        _z[i] = v.z;
+    }
+
+    [[nodiscard]] T *x() { return _x.data(); }
+    [[nodiscard]] T *y() { return _y.data(); }
+    [[nodiscard]] T *z() { return _z.data(); }
+    [[nodiscard]] const T *x() const { return _x.data(); }
+    [[nodiscard]] const T *y() const { return _y.data(); }
+    [[nodiscard]] const T *z() const { return _z.data(); }
+
+    /**
+     * @brief The contents as an array of Vector3 values.
+     */
+    [[nodiscard]] std::vector<Vector3<T>> to_aos() const {
+        std::vector<Vector3<T>> r(size());
+        for (size_t i = 0; i < size(); ++i) r[i] = (*this)[i];
+        return r;
+    }
+
+private:
+    AlignedVector<T> _x, _y, _z;
+};
+
+#endif //FMM_SOA_HPP
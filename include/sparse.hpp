@@ -0,0 +1,647 @@
+/**
+ * @file sparse.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Compressed sparse row (CSR) and 3 x 3 block sparse row (BSR)
+ *        matrices, with parallel matrix-vector (SpMV), matrix-multivector
+ *        (SpMM) and sparse matrix-matrix (SpGEMM) products.
+ *
+ * The products split the rows into contiguous ranges of about equal numbers
+ * of stored entries (not of rows), one task each, so a few long rows do not
+ * leave the other threads idle. Each task streams its values and column
+ * indices once; the CSR row sums gather x with SIMD loads where the target
+ * has them, and the next rows' entries are prefetched.
+ */
+
+#ifndef FMM_SPARSE_HPP
+#define FMM_SPARSE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief The fewest stored entries per SpMV task: smaller products are not
+ *        worth splitting.
+ */
+inline constexpr size_t SPMV_GRAIN = 16384;
+
+/**
+ * @brief How far ahead (in entries) the products prefetch values and column
+ *        indices: about a dozen cache lines of values.
+ */
+inline constexpr size_t SPMV_PREFETCH = 96;
+
+/**
+ * @brief A real sparse matrix in compressed sparse row form: the entries of
+ *        row i are values[row_ptr[i], row_ptr[i + 1]) in columns col_idx[...]
+ *        (sorted, without repeats, within each row).
+ *
+ * The sparsity pattern is fixed at construction; the values may be
+ * rewritten in place (by FemAssembler, say) any number of times.
+ */
+class CsrMatrix {
+public:
+
+    /**
+     * @brief The value of find for an entry outside the pattern.
+     */
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    CsrMatrix() = default;
+
+    /**
+     * @brief A matrix with a given pattern, and zero values if none are
+     *        given.
+     *
+     * @throws std::invalid_argument if the pattern is malformed (row
+     *         pointers not ascending from 0 to the entry count, columns out
+     *         of range or not ascending within a row) or the values do not
+     *         match it.
+     */
+    CsrMatrix(size_t rows, size_t cols, std::vector<size_t> row_ptr, std::vector<uint32_t> col_idx,
+              std::span<const double> values = {})
+            : _rows(rows), _cols(cols), _row_ptr(std::move(row_ptr)), _col_idx(std::move(col_idx)),
+              _values(_col_idx.size(), 0.0) {
+        if (_row_ptr.size() != rows + 1 || _row_ptr[0] != 0 || _row_ptr[rows] != _col_idx.size()) {
+            throw std::invalid_argument("CsrMatrix row pointers do not match the entries");
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            if (_row_ptr[i] > _row_ptr[i + 1]) throw std::invalid_argument("CsrMatrix row pointers descend");
+            for (size_t k = _row_ptr[i]; k < _row_ptr[i + 1]; ++k) {
+                if (_col_idx[k] >= cols || (k > _row_ptr[i] && _col_idx[k] <= _col_idx[k - 1])) {
+                    throw std::invalid_argument("CsrMatrix columns out of range or order");
+                }
+            }
+        }
+        if (!values.empty()) {
+            if (values.size() != _values.size()) throw std::invalid_argument("CsrMatrix value count mismatch");
+            std::copy(values.begin(), values.end(), _values.begin());
+        }
+    }
+
+    [[nodiscard]] size_t rows() const { return _rows; }
+
+    [[nodiscard]] size_t cols() const { return _cols; }
+
+    /**
+     * @brief The number of stored entries.
+     */
+    [[nodiscard]] size_t nnz() const { return _col_idx.size(); }
+
+    [[nodiscard]] std::span<const size_t> row_ptr() const { return _row_ptr; }
+
+    [[nodiscard]] std::span<const uint32_t> col_idx() const { return _col_idx; }
+
+    [[nodiscard]] std::span<const double> values() const { return _values; }
+
+    [[nodiscard]] std::span<double> values() { return _values; }
+
+    /**
+     * @brief The position of entry (i, j) in values(), or npos if it is not
+     *        in the pattern.
+     */
+    [[nodiscard]] size_t find(size_t i, size_t j) const {
+        auto b = _col_idx.begin() + std::ptrdiff_t(_row_ptr[i]), e = _col_idx.begin() + std::ptrdiff_t(_row_ptr[i + 1]);
+        auto it = std::lower_bound(b, e, uint32_t(j));
+        return it != e && *it == j ? size_t(it - _col_idx.begin()) : npos;
+    }
+
+    /**
+     * @brief Entry (i, j), zero outside the pattern.
+     */
+    [[nodiscard]] double operator()(size_t i, size_t j) const {
+        size_t k = find(i, j);
+        return k == npos ? 0.0 : _values[k];
+    }
+
+private:
+
+    size_t _rows = 0;
+    size_t _cols = 0;
+    std::vector<size_t> _row_ptr{0};
+    std::vector<uint32_t> _col_idx;
+    AlignedVector<double> _values;
+};
+
+/**
+ * @brief A real sparse matrix of 3 x 3 blocks in block compressed sparse row
+ *        form: block row i holds blocks[row_ptr[i], row_ptr[i + 1]) in block
+ *        columns col_idx[...] (sorted, without repeats, within each row).
+ *
+ * Suits vector fields (three unknowns per node): one column index serves
+ * nine entries and a block product is nine multiply-adds on three
+ * contiguous entries of x.
+ */
+class BsrMatrix {
+public:
+
+    BsrMatrix() = default;
+
+    /**
+     * @brief A matrix with a given block pattern, and zero blocks if none are
+     *        given.
+     *
+     * @throws std::invalid_argument as the CsrMatrix constructor.
+     */
+    BsrMatrix(size_t block_rows, size_t block_cols, std::vector<size_t> row_ptr, std::vector<uint32_t> col_idx,
+              std::span<const Matrix3x3<double>> blocks = {})
+            : _rows(block_rows), _cols(block_cols), _row_ptr(std::move(row_ptr)), _col_idx(std::move(col_idx)),
+              _blocks(_col_idx.size(), Matrix3x3<double>{}) {
+        if (_row_ptr.size() != block_rows + 1 || _row_ptr[0] != 0 || _row_ptr[block_rows] != _col_idx.size()) {
+            throw std::invalid_argument("BsrMatrix row pointers do not match the blocks");
+        }
+        for (size_t i = 0; i < block_rows; ++i) {
+            if (_row_ptr[i] > _row_ptr[i + 1]) throw std::invalid_argument("BsrMatrix row pointers descend");
+            for (size_t k = _row_ptr[i]; k < _row_ptr[i + 1]; ++k) {
+                if (_col_idx[k] >= block_cols || (k > _row_ptr[i] && _col_idx[k] <= _col_idx[k - 1])) {
+                    throw std::invalid_argument("BsrMatrix columns out of range or order");
+                }
+            }
+        }
+        if (!blocks.empty()) {
+            if (blocks.size() != _blocks.size()) throw std::invalid_argument("BsrMatrix block count mismatch");
+            std::copy(blocks.begin(), blocks.end(), _blocks.begin());
+        }
+    }
+
+    /**
+     * @brief The blocks of a CSR matrix with 3 x 3 block structure (a
+     *        FemAssembler matrix with three dofs per node, say); entries of
+     *        a block missing from the CSR pattern are zero.
+     *
+     * @throws std::invalid_argument if the dimensions are not multiples of 3.
+     */
+    static BsrMatrix from_csr(const CsrMatrix &a) {
+        if (a.rows() % 3 != 0 || a.cols() % 3 != 0) {
+            throw std::invalid_argument("BsrMatrix::from_csr needs dimensions divisible by 3");
+        }
+        const size_t rows = a.rows() / 3;
+        auto ptr = a.row_ptr();
+        auto col = a.col_idx();
+        std::vector<size_t> row_ptr(rows + 1, 0);
+        std::vector<uint32_t> col_idx;
+        for (size_t i = 0; i < rows; ++i) {
+            // The union of the block columns of the three scalar rows.
+            size_t first = col_idx.size();
+            for (size_t r = 3 * i; r < 3 * i + 3; ++r) {
+                for (size_t k = ptr[r]; k < ptr[r + 1]; ++k) col_idx.push_back(col[k] / 3);
+            }
+            std::sort(col_idx.begin() + std::ptrdiff_t(first), col_idx.end());
+            col_idx.erase(std::unique(col_idx.begin() + std::ptrdiff_t(first), col_idx.end()), col_idx.end());
+            row_ptr[i + 1] = col_idx.size();
+        }
+        BsrMatrix b(rows, a.cols() / 3, std::move(row_ptr), std::move(col_idx));
+        auto values = a.values();
+        for (size_t r = 0; r < a.rows(); ++r) {
+            const size_t i = r / 3;
+            for (size_t k = ptr[r], q = b._row_ptr[i]; k < ptr[r + 1]; ++k) {
+                while (b._col_idx[q] != col[k] / 3) ++q;
+                b._blocks[q].m[r % 3][col[k] % 3] = values[k];
+            }
+        }
+        return b;
+    }
+
+    /**
+     * @brief The number of block rows (a third of the scalar rows).
+     */
+    [[nodiscard]] size_t block_rows() const { return _rows; }
+
+    /**
+     * @brief The number of block columns (a third of the scalar columns).
+     */
+    [[nodiscard]] size_t block_cols() const { return _cols; }
+
+    [[nodiscard]] size_t rows() const { return 3 * _rows; }
+
+    [[nodiscard]] size_t cols() const { return 3 * _cols; }
+
+    /**
+     * @brief The number of stored blocks.
+     */
+    [[nodiscard]] size_t nnzb() const { return _col_idx.size(); }
+
+    [[nodiscard]] std::span<const size_t> row_ptr() const { return _row_ptr; }
+
+    [[nodiscard]] std::span<const uint32_t> col_idx() const { return _col_idx; }
+
+    [[nodiscard]] std::span<const Matrix3x3<double>> blocks() const { return _blocks; }
+
+    [[nodiscard]] std::span<Matrix3x3<double>> blocks() { return _blocks; }
+
+    /**
+     * @brief Scalar entry (i, j), zero outside the pattern.
+     */
+    [[nodiscard]] double operator()(size_t i, size_t j) const {
+        auto b = _col_idx.begin() + std::ptrdiff_t(_row_ptr[i / 3]);
+        auto e = _col_idx.begin() + std::ptrdiff_t(_row_ptr[i / 3 + 1]);
+        auto it = std::lower_bound(b, e, uint32_t(j / 3));
+        return it != e && *it == j / 3 ? _blocks[size_t(it - _col_idx.begin())](i % 3, j % 3) : 0.0;
+    }
+
+private:
+
+    size_t _rows = 0;
+    size_t _cols = 0;
+    std::vector<size_t> _row_ptr{0};
+    std::vector<uint32_t> _col_idx;
+    AlignedVector<Matrix3x3<double>> _blocks;
+};
+
+namespace detail {
+
+// ######################################################################### //
+// # Row partitioning.                                                     # //
+// ######################################################################### //
+
+/**
+ * @brief Splits rows [0, rows) into contiguous ranges of about equal numbers
+ *        of entries: range t is [bounds[t], bounds[t + 1]). Entries count
+ *        weight each, every row one more, so empty rows are not free.
+ */
+inline std::vector<size_t> balanced_rows(std::span<const size_t> row_ptr, size_t weight, ThreadPool &pool) {
+    const size_t rows = row_ptr.size() - 1;
+    const size_t work = row_ptr[rows] * weight + rows;
+    const size_t parts = std::clamp<size_t>(work / SPMV_GRAIN, 1, pool.size() == 1 ? 1 : 4 * pool.size());
+    std::vector<size_t> bounds(parts + 1, rows);
+    bounds[0] = 0;
+    for (size_t t = 1; t < parts; ++t) {
+        // The first row whose cumulative work reaches t / parts of the total.
+        const size_t target = work * t / parts;
+        size_t lo = bounds[t - 1], hi = rows;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (row_ptr[mid] * weight + mid < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[t] = lo;
+    }
+    return bounds;
+}
+
+/**
+ * @brief Runs f(first_row, last_row) over the balanced row ranges.
+ */
+template <typename F>
+inline void for_row_ranges(std::span<const size_t> row_ptr, size_t weight, ThreadPool &pool, F &&f) {
+    std::vector<size_t> bounds = balanced_rows(row_ptr, weight, pool);
+    pool.run(bounds.size() - 1, [&](size_t t, size_t) { f(bounds[t], bounds[t + 1]); });
+}
+
+// ######################################################################### //
+// # Row kernels.                                                          # //
+// ######################################################################### //
+
+/**
+ * @brief Prefetches the entries SPMV_PREFETCH ahead of position k (which
+ *        may run past the end: prefetches do not fault).
+ */
+inline void spmv_prefetch(const void *values, const uint32_t *col, size_t k, size_t value_size) {
+#if defined(__GNUC__)
+    __builtin_prefetch(static_cast<const char *>(values) + (k + SPMV_PREFETCH) * value_size);
+    __builtin_prefetch(col + k + SPMV_PREFETCH);
+#else
+    (void) values, (void) col, (void) k, (void) value_size;
+#endif
+}
+
+/**
+ * @brief sum_k v[k] x[c[k]] over [0, n), one entry at a time.
+ */
+inline double csr_row_dot_scalar(const double *v, const uint32_t *c, size_t n, const double *x) {
+    double sum = 0.0;
+    for (size_t k = 0; k < n; ++k) sum += v[k] * x[c[k]];
+    return sum;
+}
+
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+
+/**
+ * @brief csr_row_dot_scalar with eight entries per gather; the last partial
+ *        group is a masked load and gather.
+ */
+inline double csr_row_dot_avx512(const double *v, const uint32_t *c, size_t n, const double *x) {
+    size_t k = 0;
+    __m512d acc = _mm512_setzero_pd();
+    for (; k + 8 <= n; k += 8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + k));
+        __m512d xv = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(0xff), idx, x, 8);
+        acc = _mm512_fmadd_pd(_mm512_loadu_pd(v + k), xv, acc);
+    }
+    if (k < n) {
+        __mmask8 rest = __mmask8((1u << (n - k)) - 1);
+        __m256i idx = _mm256_maskz_loadu_epi32(rest, c + k);
+        __m512d xv = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), rest, idx, x, 8);
+        acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(rest, v + k), xv, acc);
+    }
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, acc);
+    return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+/**
+ * @brief csr_row_dot_scalar with four entries per gather; the last n % 4
+ *        entries are summed one at a time.
+ */
+inline double csr_row_dot_avx2(const double *v, const uint32_t *c, size_t n, const double *x) {
+    size_t k = 0;
+    __m256d acc = _mm256_setzero_pd();
+    for (; k + 4 <= n; k += 4) {
+        __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c + k));
+        __m256d xv = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, idx, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+        acc = _mm256_fmadd_pd(_mm256_loadu_pd(v + k), xv, acc);
+    }
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; k < n; ++k) sum += v[k] * x[c[k]];
+    return sum;
+}
+
+#endif
+
+/**
+ * @brief sum_k v[k] x[c[k]] over [0, n), with the widest gathers the build
+ *        targets (see the FIGUEROA_NATIVE CMake option).
+ */
+inline double csr_row_dot(const double *v, const uint32_t *c, size_t n, const double *x) {
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+    return csr_row_dot_avx512(v, c, n, x);
+#elif defined(__AVX2__) && defined(__FMA__)
+    return csr_row_dot_avx2(v, c, n, x);
+#else
+    return csr_row_dot_scalar(v, c, n, x);
+#endif
+}
+
+/**
+ * @brief The number of right-hand sides an SpMM row pass keeps in
+ *        registers: a fixed trip count the compiler unrolls and vectorises.
+ */
+inline constexpr size_t SPMM_LANES = 8;
+
+} // namespace detail
+
+// ######################################################################### //
+// # Products.                                                             # //
+// ######################################################################### //
+
+/**
+ * @brief y = A x.
+ *
+ * @throws std::invalid_argument if x has not cols() or y not rows() entries.
+ */
+inline void spmv(const CsrMatrix &a, std::span<const double> x, std::span<double> y,
+                 ThreadPool &pool = ThreadPool::global()) {
+    if (x.size() != a.cols() || y.size() != a.rows()) throw std::invalid_argument("spmv size mismatch");
+    auto ptr = a.row_ptr();
+    const double *v = a.values().data();
+    const uint32_t *c = a.col_idx().data();
+    detail::for_row_ranges(ptr, 1, pool, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            detail::spmv_prefetch(v, c, ptr[i], sizeof(double));
+            y[i] = detail::csr_row_dot(v + ptr[i], c + ptr[i], ptr[i + 1] - ptr[i], x.data());
+        }
+    });
+}
+
+/**
+ * @brief y = A x for 3 x 3 blocks.
+ *
+ * @throws std::invalid_argument if x has not cols() or y not rows() entries.
+ */
+inline void spmv(const BsrMatrix &a, std::span<const double> x, std::span<double> y,
+                 ThreadPool &pool = ThreadPool::global()) {
+    if (x.size() != a.cols() || y.size() != a.rows()) throw std::invalid_argument("spmv size mismatch");
+    auto ptr = a.row_ptr();
+    const Matrix3x3<double> *blocks = a.blocks().data();
+    const uint32_t *c = a.col_idx().data();
+    detail::for_row_ranges(ptr, 9, pool, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            detail::spmv_prefetch(blocks, c, ptr[i], sizeof(Matrix3x3<double>));
+            double y0 = 0.0, y1 = 0.0, y2 = 0.0;
+            for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                const double (&m)[3][3] = blocks[k].m;
+                const double *xj = x.data() + 3 * size_t(c[k]);
+                y0 += m[0][0] * xj[0] + m[0][1] * xj[1] + m[0][2] * xj[2];
+                y1 += m[1][0] * xj[0] + m[1][1] * xj[1] + m[1][2] * xj[2];
+                y2 += m[2][0] * xj[0] + m[2][1] * xj[1] + m[2][2] * xj[2];
+            }
+            y[3 * i] = y0;
+            y[3 * i + 1] = y1;
+            y[3 * i + 2] = y2;
+        }
+    });
+}
+
+/**
+ * @brief Y = A X for nrhs right-hand sides at once: X is cols() x nrhs and
+ *        Y is rows() x nrhs, both row major (the nrhs values of a row are
+ *        contiguous), so each stored entry is read once for all of them.
+ *
+ * @throws std::invalid_argument if X or Y has the wrong size.
+ */
+inline void spmm(const CsrMatrix &a, std::span<const double> x, std::span<double> y, size_t nrhs,
+                 ThreadPool &pool = ThreadPool::global()) {
+    if (x.size() != a.cols() * nrhs || y.size() != a.rows() * nrhs) {
+        throw std::invalid_argument("spmm size mismatch");
+    }
+    constexpr size_t L = detail::SPMM_LANES;
+    auto ptr = a.row_ptr();
+    const double *v = a.values().data();
+    const uint32_t *c = a.col_idx().data();
+    detail::for_row_ranges(ptr, nrhs, pool, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            detail::spmv_prefetch(v, c, ptr[i], sizeof(double));
+            double *yi = y.data() + i * nrhs;
+            size_t r = 0;
+            for (; r + L <= nrhs; r += L) {
+                double acc[L] = {};
+                for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                    const double *xj = x.data() + size_t(c[k]) * nrhs + r;
+                    for (size_t l = 0; l < L; ++l) acc[l] += v[k] * xj[l];
+                }
+                for (size_t l = 0; l < L; ++l) yi[r + l] = acc[l];
+            }
+            for (; r < nrhs; ++r) {
+                double acc = 0.0;
+                for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) acc += v[k] * x[size_t(c[k]) * nrhs + r];
+                yi[r] = acc;
+            }
+        }
+    });
+}
+
+/**
+ * @brief Y = A X for 3 x 3 blocks and nrhs right-hand sides, laid out as for
+ *        the CSR spmm.
+ *
+ * @throws std::invalid_argument if X or Y has the wrong size.
+ */
+inline void spmm(const BsrMatrix &a, std::span<const double> x, std::span<double> y, size_t nrhs,
+                 ThreadPool &pool = ThreadPool::global()) {
+    if (x.size() != a.cols() * nrhs || y.size() != a.rows() * nrhs) {
+        throw std::invalid_argument("spmm size mismatch");
+    }
+    constexpr size_t L = detail::SPMM_LANES;
+    auto ptr = a.row_ptr();
+    const Matrix3x3<double> *blocks = a.blocks().data();
+    const uint32_t *c = a.col_idx().data();
+    detail::for_row_ranges(ptr, 9 * nrhs, pool, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            detail::spmv_prefetch(blocks, c, ptr[i], sizeof(Matrix3x3<double>));
+            double *yi = y.data() + 3 * i * nrhs;
+            size_t r = 0;
+            for (; r + L <= nrhs; r += L) {
+                double acc[3][L] = {};
+                for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                    const double (&m)[3][3] = blocks[k].m;
+                    const double *xj = x.data() + 3 * size_t(c[k]) * nrhs + r;
+                    for (size_t q = 0; q < 3; ++q) {
+                        const double *in = xj + q * nrhs;
+                        for (size_t l = 0; l < L; ++l) {
+                            acc[0][l] += m[0][q] * in[l];
+                            acc[1][l] += m[1][q] * in[l];
+                            acc[2][l] += m[2][q] * in[l];
+                        }
+                    }
+                }
+                for (size_t p = 0; p < 3; ++p) {
+                    for (size_t l = 0; l < L; ++l) yi[p * nrhs + r + l] = acc[p][l];
+                }
+            }
+            for (; r < nrhs; ++r) {
+                double acc[3] = {};
+                for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                    const double (&m)[3][3] = blocks[k].m;
+                    const double *xj = x.data() + 3 * size_t(c[k]) * nrhs + r;
+                    for (size_t p = 0; p < 3; ++p) {
+                        acc[p] += m[p][0] * xj[0] + m[p][1] * xj[nrhs] + m[p][2] * xj[2 * nrhs];
+                    }
+                }
+                for (size_t p = 0; p < 3; ++p) yi[p * nrhs + r] = acc[p];
+            }
+        }
+    });
+}
+
+/**
+ * @brief The transpose of a CSR matrix: one counting pass, serial (it is
+ *        as cheap as reading the matrix).
+ */
+inline CsrMatrix transpose(const CsrMatrix &a) {
+    auto ptr = a.row_ptr();
+    auto col = a.col_idx();
+    auto val = a.values();
+    std::vector<size_t> row_ptr(a.cols() + 1, 0);
+    for (uint32_t j: col) ++row_ptr[j + 1];
+    for (size_t j = 0; j < a.cols(); ++j) row_ptr[j + 1] += row_ptr[j];
+
+    // Rows of a are visited in order, so each column of the transpose comes
+    // out sorted.
+    std::vector<uint32_t> col_idx(a.nnz());
+    std::vector<double> values(a.nnz());
+    std::vector<size_t> next(row_ptr.begin(), row_ptr.end() - 1);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+            size_t p = next[col[k]]++;
+            col_idx[p] = uint32_t(i);
+            values[p] = val[k];
+        }
+    }
+    return {a.cols(), a.rows(), std::move(row_ptr), std::move(col_idx), values};
+}
+
+/**
+ * @brief C = A B for CSR matrices, rows of C in parallel.
+ *
+ * A symbolic pass counts the entries of each row of C, then a numeric pass
+ * fills them; each worker keeps a marker per column of B, so neither pass
+ * needs a hash table or a lock.
+ *
+ * @throws std::invalid_argument if A has not as many columns as B has rows.
+ */
+inline CsrMatrix spgemm(const CsrMatrix &a, const CsrMatrix &b, ThreadPool &pool = ThreadPool::global()) {
+    if (a.cols() != b.rows()) throw std::invalid_argument("spgemm size mismatch");
+    auto aptr = a.row_ptr();
+    auto acol = a.col_idx();
+    auto aval = a.values();
+    auto bptr = b.row_ptr();
+    auto bcol = b.col_idx();
+    auto bval = b.values();
+    const size_t rows = a.rows();
+    constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    // marker[w][j]: the last row of C in which worker w met column j, then
+    // where that entry is stored.
+    std::vector<std::vector<size_t>> marker(pool.size());
+    auto markers = [&](size_t worker) -> std::vector<size_t> & {
+        if (marker[worker].empty()) marker[worker].assign(b.cols(), none);
+        return marker[worker];
+    };
+
+    std::vector<size_t> row_ptr(rows + 1, 0);
+    parallel_for_worker(0, rows, 256, [&](size_t first, size_t last, size_t worker) {
+        std::vector<size_t> &seen = markers(worker);
+        for (size_t i = first; i < last; ++i) {
+            size_t count = 0;
+            for (size_t k = aptr[i]; k < aptr[i + 1]; ++k) {
+                for (size_t q = bptr[acol[k]]; q < bptr[acol[k] + 1]; ++q) {
+                    if (seen[bcol[q]] != i) {
+                        seen[bcol[q]] = i;
+                        ++count;
+                    }
+                }
+            }
+            row_ptr[i + 1] = count;
+        }
+    }, pool);
+    for (size_t i = 0; i < rows; ++i) row_ptr[i + 1] += row_ptr[i];
+
+    std::vector<uint32_t> col_idx(row_ptr[rows]);
+    std::vector<double> values(row_ptr[rows], 0.0);
+    for (auto &m: marker) std::fill(m.begin(), m.end(), none);
+    parallel_for_worker(0, rows, 256, [&](size_t first, size_t last, size_t worker) {
+        std::vector<size_t> &where = markers(worker);
+        for (size_t i = first; i < last; ++i) {
+            // The columns of row i, sorted, then the products summed into
+            // them.
+            size_t end = row_ptr[i];
+            for (size_t k = aptr[i]; k < aptr[i + 1]; ++k) {
+                for (size_t q = bptr[acol[k]]; q < bptr[acol[k] + 1]; ++q) {
+                    if (where[bcol[q]] == none) {
+                        where[bcol[q]] = 0;
+                        col_idx[end++] = bcol[q];
+                    }
+                }
+            }
+            std::sort(col_idx.begin() + std::ptrdiff_t(row_ptr[i]), col_idx.begin() + std::ptrdiff_t(end));
+            for (size_t p = row_ptr[i]; p < end; ++p) where[col_idx[p]] = p;
+            for (size_t k = aptr[i]; k < aptr[i + 1]; ++k) {
+                const double aik = aval[k];
+                for (size_t q = bptr[acol[k]]; q < bptr[acol[k] + 1]; ++q) values[where[bcol[q]]] += aik * bval[q];
+            }
+            for (size_t p = row_ptr[i]; p < end; ++p) where[col_idx[p]] = none;
+        }
+    }, pool);
+    return {rows, b.cols(), std::move(row_ptr), std::move(col_idx), values};
+}
+
+#endif //FMM_SPARSE_HPP
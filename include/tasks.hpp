@@ -0,0 +1,320 @@
+/**
+ * @file tasks.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A work-stealing task pool for recursive (spawned) work, and task
+ *        dependency graphs run on it.
+ */
+
+#ifndef FMM_TASKS_HPP
+#define FMM_TASKS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+// ######################################################################### //
+// # Work-stealing pool.                                                   # //
+// ######################################################################### //
+
+/**
+ * @brief A fixed size pool of worker threads with one task deque each.
+ *
+ * Unlike ThreadPool, whose batches are fixed up front, tasks here may spawn
+ * further tasks. A worker pushes and pops spawned tasks at the back of its
+ * own deque (depth first, so recent, cache warm work runs next) and, when it
+ * runs dry, steals from the front of another worker's deque (the oldest and
+ * usually largest pieces of work). A run ends when no task is queued or
+ * executing.
+ */
+class TaskPool {
+public:
+
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Creates a pool with the given number of threads.
+     *
+     * @param nthreads the total number of threads taking part in a run,
+     *                 including the calling thread (at least 1).
+     */
+    explicit TaskPool(size_t nthreads = ThreadPool::default_concurrency())
+            : _queues(std::max<size_t>(nthreads, 1)) {
+        _workers.reserve(_queues.size() - 1);
+        for (size_t w = 1; w < _queues.size(); ++w) {
+            _workers.emplace_back([this, w]() { worker_loop(w); });
+        }
+    }
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &t: _workers) t.join();
+    }
+
+    /**
+     * @brief The number of threads that take part in a run.
+     */
+    [[nodiscard]] size_t size() const { return _queues.size(); }
+
+    /**
+     * @brief Runs a task and every task spawned from it (transitively), and
+     *        waits for them all.
+     *
+     * If tasks throw, the first exception is rethrown once the run has
+     * drained; tasks still queued at that point are skipped.
+     */
+    void run(Task root) {
+        if (current() == this) throw std::logic_error("TaskPool::run called from one of its own tasks");
+
+        std::lock_guard<std::mutex> run_lock(_run_mutex);
+        _error = nullptr;
+        _failed.store(false);
+        _pending.store(1);
+        {
+            std::lock_guard<std::mutex> q(_queues[0].mutex);
+            _queues[0].tasks.push_back(std::move(root));
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _active = _workers.size();
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        // A task of another pool may call run; its membership (and worker
+        // index) is restored once this run has been drained.
+        TaskPool *outer = std::exchange(current(), this);
+        size_t outer_worker = std::exchange(worker_index(), 0);
+        try {
+            work(0);
+        } catch (...) {
+            current() = outer;
+            worker_index() = outer_worker;
+            throw;
+        }
+        current() = outer;
+        worker_index() = outer_worker;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return _active == 0; });
+        if (_error) std::rethrow_exception(_error);
+    }
+
+    /**
+     * @brief Queues a task on the calling worker; only valid inside a run,
+     *        from one of this pool's tasks.
+     */
+    void spawn(Task task) {
+        if (current() != this) throw std::logic_error("TaskPool::spawn called outside a run");
+        _pending.fetch_add(1, std::memory_order_relaxed);
+        Queue &q = _queues[worker_index()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+
+    /**
+     * @brief The index in [0, size()) of the worker running the calling
+     *        task (the thread that called run() is worker 0).
+     */
+    [[nodiscard]] static size_t current_worker() { return worker_index(); }
+
+    /**
+     * @brief A process wide pool sized like ThreadPool::global().
+     */
+    static TaskPool &global() {
+        static TaskPool pool;
+        return pool;
+    }
+
+private:
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    static TaskPool *&current() {
+        static thread_local TaskPool *pool = nullptr;
+        return pool;
+    }
+
+    static size_t &worker_index() {
+        static thread_local size_t worker = 0;
+        return worker;
+    }
+
+    bool pop(size_t worker, Task &task) {
+        Queue &q = _queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t worker, Task &task) {
+        const size_t n = _queues.size();
+        for (size_t k = 1; k < n; ++k) {
+            Queue &q = _queues[(worker + k) % n];
+            std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || q.tasks.empty()) continue;
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void execute(Task &task) {
+        if (!_failed.load(std::memory_order_relaxed)) {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error) _error = std::current_exception();
+                _failed.store(true);
+            }
+        }
+        task = nullptr;
+        _pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void work(size_t worker) {
+        Task task;
+        unsigned idle = 0;
+        while (_pending.load(std::memory_order_acquire) != 0) {
+            if (pop(worker, task) || steal(worker, task)) {
+                execute(task);
+                idle = 0;
+            } else if (++idle > 16) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void worker_loop(size_t worker) {
+        current() = this;
+        worker_index() = worker;
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&]() { return _stop || _generation != seen; });
+                if (_stop) break;
+                seen = _generation;
+            }
+            work(worker);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (--_active == 0) _done.notify_one();
+            }
+        }
+    }
+
+    std::vector<Queue> _queues;
+    std::vector<std::thread> _workers;
+    std::mutex _run_mutex;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::atomic<size_t> _pending{0};
+    std::atomic<bool> _failed{false};
+    size_t _active = 0;
+    size_t _generation = 0;
+    bool _stop = false;
+    std::exception_ptr _error;
+};
+
+// ######################################################################### //
+// # Dependency graphs.                                                    # //
+// ######################################################################### //
+
+/**
+ * @brief A set of tasks with "runs before" edges, run on a TaskPool.
+ *
+ * Each task is spawned as soon as the last of its predecessors finishes, so
+ * independent chains of the graph overlap without barriers between them.
+ */
+class TaskGraph {
+public:
+
+    /**
+     * @brief Adds a task; returns its id.
+     */
+    size_t add(std::function<void()> f) {
+        _nodes.push_back({std::move(f), {}, 0});
+        return _nodes.size() - 1;
+    }
+
+    /**
+     * @brief Makes task `after` wait for task `before`.
+     */
+    void precede(size_t before, size_t after) {
+        _nodes[before].successors.push_back(after);
+        ++_nodes[after].npredecessors;
+    }
+
+    [[nodiscard]] size_t size() const { return _nodes.size(); }
+
+    /**
+     * @brief Runs every task, respecting the edges, and waits for them.
+     *
+     * @throws std::logic_error if the edges contain a cycle.
+     */
+    void run(TaskPool &pool = TaskPool::global()) {
+        const size_t n = _nodes.size();
+        _remaining = std::make_unique<std::atomic<size_t>[]>(n);
+        for (size_t i = 0; i < n; ++i) _remaining[i].store(_nodes[i].npredecessors);
+        _executed.store(0);
+
+        pool.run([&]() {
+            for (size_t i = 0; i < n; ++i) {
+                if (_nodes[i].npredecessors == 0) pool.spawn([this, &pool, i]() { execute(pool, i); });
+            }
+        });
+        if (_executed.load() != n) throw std::logic_error("TaskGraph has a cycle");
+    }
+
+private:
+
+    struct Node {
+        std::function<void()> f;
+        std::vector<size_t> successors;
+        size_t npredecessors;
+    };
+
+    void execute(TaskPool &pool, size_t i) {
+        _nodes[i].f();
+        _executed.fetch_add(1, std::memory_order_relaxed);
+        for (size_t s: _nodes[i].successors) {
+            if (_remaining[s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                pool.spawn([this, &pool, s]() { execute(pool, s); });
+            }
+        }
+    }
+
+    std::vector<Node> _nodes;
+    std::unique_ptr<std::atomic<size_t>[]> _remaining;
+    std::atomic<size_t> _executed{0};
+};
+
+#endif //FMM_TASKS_HPP
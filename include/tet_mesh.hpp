@@ -0,0 +1,286 @@
+/**
+ * @file tet_mesh.hpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief A tetrahedral mesh with lazily cached per-element geometry (volumes,
+ *        inverse Jacobians and shape function gradients) for linear finite
+ *        elements.
+ *
+ * Element e with nodes (x0, x1, x2, x3) is the image of the reference
+ * tetrahedron under x = x0 + J xi, where J has the edge vectors x1 - x0,
+ * x2 - x0, x3 - x0 as its columns. The linear shape functions are
+ * N_i = xi_i (i = 1, 2, 3) and N_0 = 1 - xi_1 - xi_2 - xi_3, so grad N_i is
+ * row i - 1 of J^-1 and grad N_0 = -(grad N_1 + grad N_2 + grad N_3); the
+ * volume is |det J| / 6.
+ */
+
+#ifndef FMM_TET_MESH_HPP
+#define FMM_TET_MESH_HPP
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "soa.hpp"
+
+/**
+ * @brief The gradients of the four linear shape functions of an element.
+ */
+using TetGradients = std::array<Vector3<double>, 4>;
+
+/**
+ * @brief A tetrahedral mesh: SoA node coordinates and a flat connectivity
+ *        array of four uint32 node indices per element.
+ *
+ * Elements are stored in the Morton order of their centroids (the mapping
+ * to the input order is element_permutation()), so that loops over
+ * elements touch nearby nodes in turn; the node numbering, which is the
+ * caller's degree of freedom numbering, is kept.
+ *
+ * Volumes, inverse Jacobians and shape function gradients are computed (in
+ * parallel) the first time they are asked for and kept until the nodes
+ * move. The accessors are thread safe; the spans they return stay valid
+ * until the next set_nodes or move_nodes.
+ */
+class TetMesh {
+public:
+
+    /**
+     * @brief Builds a mesh.
+     *
+     * @param nodes the node coordinates.
+     * @param connectivity four node indices per element.
+     * @param pool the pool for the sort and the geometry caches.
+     *
+     * @throws std::invalid_argument if the connectivity is not a whole
+     *         number of elements or names a node that does not exist.
+     */
+    TetMesh(std::span<const Vector3<double>> nodes, std::span<const uint32_t> connectivity,
+            ThreadPool &pool = ThreadPool::global())
+            : _nodes(nodes), _pool(&pool), _lock(std::make_unique<std::mutex>()) {
+        if (connectivity.size() % 4 != 0) throw std::invalid_argument("TetMesh connectivity is not 4 per element");
+        for (uint32_t v: connectivity) {
+            if (v >= nodes.size()) throw std::invalid_argument("TetMesh connectivity names a missing node");
+        }
+        sort_elements(connectivity);
+    }
+
+    [[nodiscard]] size_t node_count() const { return _nodes.size(); }
+
+    [[nodiscard]] size_t element_count() const { return _elements.size() / 4; }
+
+    [[nodiscard]] const Vector3Array<double> &nodes() const { return _nodes; }
+
+    [[nodiscard]] Vector3<double> node(size_t i) const { return _nodes[i]; }
+
+    /**
+     * @brief The node indices of all elements, four per element.
+     */
+    [[nodiscard]] std::span<const uint32_t> connectivity() const { return _elements; }
+
+    /**
+     * @brief The node indices of element e.
+     */
+    [[nodiscard]] std::span<const uint32_t, 4> element(size_t e) const {
+        return std::span<const uint32_t, 4>(_elements.data() + 4 * e, 4);
+    }
+
+    /**
+     * @brief For each element, the index of the element in the input.
+     */
+    [[nodiscard]] std::span<const uint32_t> element_permutation() const { return _perm; }
+
+    /**
+     * @brief The Jacobian of element e: the columns are its edge vectors
+     *        from node 0.
+     */
+    [[nodiscard]] Matrix3x3<double> jacobian(size_t e) const {
+        auto v = element(e);
+        const Vector3<double> x0 = node(v[0]), a = node(v[1]) - x0, b = node(v[2]) - x0, c = node(v[3]) - x0;
+        return {a.x, b.x, c.x, a.y, b.y, c.y, a.z, b.z, c.z};
+    }
+
+    [[nodiscard]] Vector3<double> centroid(size_t e) const {
+        auto v = element(e);
+        return 0.25 * (node(v[0]) + node(v[1]) + node(v[2]) + node(v[3]));
+    }
+
+    /**
+     * @brief The element volumes |det J| / 6.
+     *
+     * @throws std::invalid_argument if an element is degenerate (zero
+     *         volume).
+     */
+    [[nodiscard]] std::span<const double> volumes() const {
+        std::lock_guard<std::mutex> lock(*_lock);
+        build_volumes();
+        return _volumes;
+    }
+
+    /**
+     * @brief The inverse Jacobians adj(J) / det(J).
+     */
+    [[nodiscard]] std::span<const Matrix3x3<double>> inverse_jacobians() const {
+        std::lock_guard<std::mutex> lock(*_lock);
+        build_inverses();
+        return _inverses;
+    }
+
+    /**
+     * @brief The shape function gradients of every element.
+     */
+    [[nodiscard]] std::span<const TetGradients> gradients() const {
+        std::lock_guard<std::mutex> lock(*_lock);
+        if (!_gradients_valid) {
+            build_inverses();
+            _gradients.resize(element_count());
+            parallel_for(0, element_count(), 1 << 12, [&](size_t b, size_t e) {
+                for (size_t k = b; k < e; ++k) {
+                    const Matrix3x3<double> &inv = _inverses[k];
+                    TetGradients &g = _gradients[k];
+                    for (size_t i = 0; i < 3; ++i) g[i + 1] = {inv.m[i][0], inv.m[i][1], inv.m[i][2]};
+                    g[0] = {-(g[1].x + g[2].x + g[3].x), -(g[1].y + g[2].y + g[3].y), -(g[1].z + g[2].z + g[3].z)};
+                }
+            }, *_pool);
+            _gradients_valid = true;
+            ++_builds;
+        }
+        return _gradients;
+    }
+
+    /**
+     * @brief Replaces the node coordinates (the element order is kept) and
+     *        invalidates the geometry caches.
+     *
+     * @throws std::invalid_argument if the node count changes.
+     */
+    void set_nodes(std::span<const Vector3<double>> nodes) {
+        if (nodes.size() != _nodes.size()) throw std::invalid_argument("TetMesh node count mismatch");
+        parallel_for(0, nodes.size(), 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) _nodes.set(i, nodes[i]);
+        }, *_pool);
+        invalidate();
+    }
+
+    /**
+     * @brief Adds a displacement to every node and invalidates the geometry
+     *        caches.
+     *
+     * @throws std::invalid_argument if there is not one displacement per
+     *         node.
+     */
+    void move_nodes(std::span<const Vector3<double>> displacement) {
+        if (displacement.size() != _nodes.size()) throw std::invalid_argument("TetMesh node count mismatch");
+        parallel_for(0, displacement.size(), 1 << 14, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) _nodes.set(i, _nodes[i] + displacement[i]);
+        }, *_pool);
+        invalidate();
+    }
+
+    /**
+     * @brief The number of times a geometry cache has been built.
+     */
+    [[nodiscard]] size_t cache_builds() const {
+        std::lock_guard<std::mutex> lock(*_lock);
+        return _builds;
+    }
+
+private:
+
+    /**
+     * @brief Stores the elements in the Morton order of their centroids.
+     */
+    void sort_elements(std::span<const uint32_t> connectivity) {
+        const size_t ne = connectivity.size() / 4;
+        std::vector<Vector3<double>> centroids(ne);
+        parallel_for(0, ne, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) {
+                const uint32_t *v = connectivity.data() + 4 * k;
+                centroids[k] = 0.25 * (_nodes[v[0]] + _nodes[v[1]] + _nodes[v[2]] + _nodes[v[3]]);
+            }
+        }, *_pool);
+
+        std::vector<uint64_t> keys(ne);
+        morton_keys<double>(keys, centroids, bounding_cube<double>(centroids, *_pool), *_pool);
+        _perm.resize(ne);
+        std::iota(_perm.begin(), _perm.end(), uint32_t{0});
+        radix_sort(keys, _perm, 3 * MORTON_BITS, *_pool);
+
+        _elements.resize(connectivity.size());
+        parallel_for(0, ne, 1 << 14, [&](size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) {
+                for (size_t i = 0; i < 4; ++i) _elements[4 * k + i] = connectivity[4 * size_t(_perm[k]) + i];
+            }
+        }, *_pool);
+    }
+
+    void invalidate() {
+        std::lock_guard<std::mutex> lock(*_lock);
+        _volumes_valid = _inverses_valid = _gradients_valid = false;
+    }
+
+    /**
+     * @brief Builds the volumes (with the lock held).
+     */
+    void build_volumes() const {
+        if (_volumes_valid) return;
+        _volumes.resize(element_count());
+        std::atomic<bool> degenerate = false;
+        parallel_for(0, element_count(), 1 << 12, [&](size_t b, size_t e) {
+            bool bad = false;
+            for (size_t k = b; k < e; ++k) {
+                _volumes[k] = std::abs(det(jacobian(k))) / 6.0;
+                bad |= !(_volumes[k] > 0.0);
+            }
+            if (bad) degenerate = true;
+        }, *_pool);
+        if (degenerate) throw std::invalid_argument("TetMesh has a degenerate element");
+        _volumes_valid = true;
+        ++_builds;
+    }
+
+    /**
+     * @brief Builds the inverse Jacobians (with the lock held).
+     */
+    void build_inverses() const {
+        if (_inverses_valid) return;
+        build_volumes();
+        _inverses.resize(element_count());
+        parallel_for(0, element_count(), 1 << 12, [&](size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) {
+                Matrix3x3<double> j = jacobian(k);
+                _inverses[k] = adj(j) / det(j);
+            }
+        }, *_pool);
+        _inverses_valid = true;
+        ++_builds;
+    }
+
+    Vector3Array<double> _nodes;
+    std::vector<uint32_t> _elements;
+    std::vector<uint32_t> _perm;
+    ThreadPool *_pool;
+
+    std::unique_ptr<std::mutex> _lock;
+    mutable std::vector<double> _volumes;
+    mutable std::vector<Matrix3x3<double>> _inverses;
+    mutable std::vector<TetGradients> _gradients;
+    mutable bool _volumes_valid = false;
+    mutable bool _inverses_valid = false;
+    mutable bool _gradients_valid = false;
+    mutable size_t _builds = 0;
+};
+
+#endif //FMM_TET_MESH_HPP
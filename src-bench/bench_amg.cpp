@@ -0,0 +1,168 @@
+/*
+ * @file bench_amg.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Setup and cycle cost of the AMG preconditioner, against simpler
+ *        preconditioners for CG
+ *
+ * On a structured tetrahedral mesh of the unit cube (n^3 cells of six
+ * elements) this solves the Laplacian plus a small mass term (one unknown
+ * per node) and linear elasticity plus a small mass term (three per node)
+ * to a relative residual of 1e-8 with CG, preconditioned by AMG, Jacobi
+ * (block Jacobi for elasticity) and ILU(0). For AMG it reports the levels,
+ * operator complexity, setup time (by phase) and the time in cycles
+ * separately.
+ *
+ * Usage: bench_amg [--format csv|json] [--n cells]
+ */
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "amg.hpp"
+#include "fem_assembly.hpp"
+#include "krylov.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "sparse.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 40;
+};
+
+struct Record {
+    std::string system;
+    std::string preconditioner;
+    size_t unknowns;
+    size_t levels;
+    double complexity;
+    size_t iterations;
+    bool converged;
+    double setup;
+    double aggregation;
+    double galerkin;
+    double apply;
+    double solve;
+};
+
+/**
+ * @brief Builds a preconditioner (timed) and solves with CG.
+ */
+template <typename Build>
+static Record measure(const std::string &system, const std::string &name, const CsrMatrix &a, Build &&build) {
+    auto start = std::chrono::steady_clock::now();
+    auto m = build();
+    double setup = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<double> b(a.rows(), 1.0), x(a.rows(), 0.0);
+    KrylovStats stats = cg(a, b, x, m);
+    Record r{system, name, a.rows(), 1, 1.0, stats.iterations, stats.converged, setup, 0.0, 0.0,
+             stats.timings.preconditioner, stats.timings.total};
+    if constexpr (std::is_same_v<decltype(m), AmgPreconditioner>) {
+        r.levels = m.levels();
+        r.complexity = m.operator_complexity();
+        r.aggregation = m.timings().aggregation;
+        r.galerkin = m.timings().galerkin;
+        r.apply = m.timings().cycle;
+    }
+    return r;
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "system,preconditioner,unknowns,levels,complexity,iterations,converged,setup,aggregation,"
+                 "galerkin,apply,solve\n";
+    for (auto &r: records) {
+        std::cout << r.system << "," << r.preconditioner << "," << r.unknowns << "," << r.levels << ","
+                  << r.complexity << "," << r.iterations << "," << r.converged << "," << r.setup << ","
+                  << r.aggregation << "," << r.galerkin << "," << r.apply << "," << r.solve << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"system\": \"" << r.system << "\", \"preconditioner\": \"" << r.preconditioner
+                  << "\", \"unknowns\": " << r.unknowns << ", \"levels\": " << r.levels << ", \"complexity\": "
+                  << r.complexity << ", \"iterations\": " << r.iterations << ", \"converged\": "
+                  << (r.converged ? "true" : "false") << ", \"setup\": " << r.setup << ", \"aggregation\": "
+                  << r.aggregation << ", \"galerkin\": " << r.galerkin << ", \"apply\": " << r.apply
+                  << ", \"solve\": " << r.solve << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n cells]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(opts.n, 1.0, nodes, elements);
+    TetMesh mesh(nodes, elements);
+    auto volumes = mesh.volumes();
+    auto gradients = mesh.gradients();
+
+    FemAssembler scalar(mesh, 1);
+    CsrMatrix laplace = scalar.matrix();
+    scalar.assemble(laplace, [&](size_t e, double *ke) {
+        laplace_element(volumes[e], gradients[e], ke);
+        double me[16] = {};
+        mass_element(volumes[e], me);
+        for (size_t i = 0; i < 16; ++i) ke[i] += me[i];
+    });
+
+    FemAssembler vector(mesh, 3);
+    CsrMatrix elasticity = vector.matrix();
+    vector.assemble(elasticity, [&](size_t e, double *ke) {
+        elasticity_element(volumes[e], gradients[e], 1.0, 1.0, ke);
+        double me[16] = {};
+        mass_element(volumes[e], me);
+        for (size_t p = 0; p < 4; ++p) {
+            for (size_t q = 0; q < 4; ++q) {
+                for (size_t c = 0; c < 3; ++c) ke[(3 * p + c) * 12 + 3 * q + c] += me[p * 4 + q];
+            }
+        }
+    });
+
+    std::vector<Record> records;
+    records.push_back(measure("laplace", "amg", laplace, [&]() { return AmgPreconditioner(laplace); }));
+    records.push_back(measure("laplace", "jacobi", laplace, [&]() { return JacobiPreconditioner(laplace); }));
+    records.push_back(measure("laplace", "ilu0", laplace, [&]() { return Ilu0Preconditioner(laplace); }));
+
+    AmgOptions blocks;
+    blocks.block_size = 3;
+    records.push_back(measure("elasticity", "amg", elasticity, [&]() {
+        return AmgPreconditioner(elasticity, blocks);
+    }));
+    records.push_back(measure("elasticity", "block_jacobi", elasticity, [&]() {
+        return BlockJacobiPreconditioner(elasticity);
+    }));
+    records.push_back(measure("elasticity", "ilu0", elasticity, [&]() { return Ilu0Preconditioner(elasticity); }));
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,166 @@
+/*
+ * @file bench_barnes_hut.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Barnes-Hut treecode timings and accuracy against the opening angle
+ *
+ * For a uniform cloud of n random charges this builds a BarnesHut solver
+ * (the octree and its moments) once and evaluates potentials and fields for
+ * each opening angle. The error is the relative 2-norm error of the
+ * potential and of the field at a random sample of targets, against a
+ * direct sum over all n charges.
+ *
+ * Usage: bench_barnes_hut [--format csv|json] [--n particles]
+ *                         [--thetas t,t,...] [--max-leaf m] [--samples s]
+ *                         [--threads t]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "barnes_hut.hpp"
+#include "parallel.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 1000000;
+    std::vector<double> thetas = {0.3, 0.5, 0.7};
+    size_t max_leaf = 64;
+    size_t samples = 1000;
+    size_t threads = ThreadPool::default_concurrency();
+};
+
+struct Record {
+    size_t n;
+    double theta;
+    size_t threads;
+    double build;
+    double far_field;
+    double near_field;
+    double evaluate;
+    double potential_error;
+    double field_error;
+};
+
+/**
+ * @brief The direct potential and field of all charges at point i.
+ */
+static void direct(const std::vector<Vector3<double>> &points, const std::vector<double> &charges, size_t i,
+                   double &phi, Vector3<double> &field) {
+    phi = 0.0;
+    field = {0.0, 0.0, 0.0};
+    for (size_t j = 0; j < points.size(); ++j) {
+        if (j == i) continue;
+        Vector3<double> r = points[i] - points[j];
+        double inv = 1.0 / std::sqrt(inner(r, r));
+        phi += charges[j] * inv;
+        field = field + (charges[j] * inv * inv * inv) * r;
+    }
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "n,theta,threads,build,far_field,near_field,evaluate,potential_error,field_error\n";
+    for (auto &r: records) {
+        std::cout << r.n << "," << r.theta << "," << r.threads << "," << r.build << "," << r.far_field << ","
+                  << r.near_field << "," << r.evaluate << "," << r.potential_error << "," << r.field_error << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"n\": " << r.n << ", \"theta\": " << r.theta << ", \"threads\": " << r.threads
+                  << ", \"build\": " << r.build << ", \"far_field\": " << r.far_field
+                  << ", \"near_field\": " << r.near_field << ", \"evaluate\": " << r.evaluate
+                  << ", \"potential_error\": " << r.potential_error << ", \"field_error\": " << r.field_error << "}"
+                  << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--thetas") && i + 1 < argc) {
+            opts.thetas.clear();
+            std::stringstream list(argv[++i]);
+            for (std::string item; std::getline(list, item, ',');) opts.thetas.push_back(std::stod(item));
+        } else if (!std::strcmp(argv[i], "--max-leaf") && i + 1 < argc) {
+            opts.max_leaf = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--samples") && i + 1 < argc) {
+            opts.samples = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            opts.threads = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n particles] [--thetas t,t,...]"
+                      << " [--max-leaf m] [--samples s] [--threads t]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(38);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Vector3<double>> points(opts.n);
+    std::vector<double> charges(opts.n);
+    for (size_t i = 0; i < opts.n; ++i) {
+        points[i] = {u(rng), u(rng), u(rng)};
+        charges[i] = u(rng);
+    }
+
+    std::vector<size_t> sample(std::min(opts.samples, opts.n));
+    std::uniform_int_distribution<size_t> pick(0, opts.n - 1);
+    for (auto &s: sample) s = pick(rng);
+    std::vector<double> ref(sample.size());
+    std::vector<Vector3<double>> fref(sample.size());
+    parallel_for(0, sample.size(), 1, [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; ++k) direct(points, charges, sample[k], ref[k], fref[k]);
+    });
+
+    ThreadPool pool(opts.threads);
+    auto start = std::chrono::steady_clock::now();
+    BarnesHut bh(points, charges, {opts.thetas.front(), opts.max_leaf}, pool);
+    double build = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> phi(opts.n);
+    std::vector<Vector3<double>> field(opts.n);
+    std::vector<Record> records;
+    for (double theta: opts.thetas) {
+        bh.set_theta(theta);
+        bh.evaluate(phi, field);
+        double pn = 0.0, pd = 0.0, fn = 0.0, fd = 0.0;
+        for (size_t k = 0; k < sample.size(); ++k) {
+            pn += (phi[sample[k]] - ref[k]) * (phi[sample[k]] - ref[k]);
+            pd += ref[k] * ref[k];
+            Vector3<double> d = field[sample[k]] - fref[k];
+            fn += inner(d, d);
+            fd += inner(fref[k], fref[k]);
+        }
+        const BarnesHutTimings &t = bh.timings();
+        records.push_back({opts.n, theta, pool.size(), build, t.far_field, t.near_field, t.total,
+                           std::sqrt(pn / pd), std::sqrt(fn / fd)});
+    }
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,153 @@
+/*
+ * @file bench_dipole.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Throughput of the direct dipole field kernels
+ *
+ * For a cloud of n dipoles interacting with themselves this measures the
+ * pairwise interactions per second and Gflop/s (DIPOLE_FLOPS_PER_INTERACTION
+ * flops per pair) of a loop that forms each pair's interaction tensor
+ * (dipole_tensor), of the scalar reference lanes, of the vectorised kernel
+ * and of the kernel fused with the energy, on one thread.
+ *
+ * Usage: bench_dipole [--format csv|json] [--n particles] [--min-time seconds]
+ */
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dipole.hpp"
+#include "linalg.hpp"
+#include "soa.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 8192;
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string kernel;
+    size_t n;
+    double interactions_per_sec;
+    double gflops;
+    double energy;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+static Record measure(const std::string &kernel, size_t n, const std::function<double()> &run, double min_time) {
+    double energy = 0.0;
+    double seconds = time_runs([&]() { energy = run(); }, min_time);
+    double pairs = static_cast<double>(n) * static_cast<double>(n);
+    return {kernel, n, pairs / seconds, pairs * DIPOLE_FLOPS_PER_INTERACTION / seconds * 1.0e-9, energy};
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "kernel,n,interactions_per_sec,gflops,energy\n";
+    for (auto &r: records) {
+        std::cout << r.kernel << "," << r.n << "," << r.interactions_per_sec << "," << r.gflops << ","
+                  << r.energy << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"kernel\": \"" << r.kernel << "\", \"n\": " << r.n
+                  << ", \"interactions_per_sec\": " << r.interactions_per_sec << ", \"gflops\": " << r.gflops
+                  << ", \"energy\": " << r.energy << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n particles] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    const size_t n = opts.n;
+    std::mt19937_64 rng(41);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Vector3<double>> points(n), moments(n), field(n);
+    for (size_t i = 0; i < n; ++i) {
+        points[i] = {u(rng), u(rng), u(rng)};
+        moments[i] = {u(rng), u(rng), u(rng)};
+    }
+    Vector3Array<double> p(points), m(moments), h(n);
+    std::vector<double> phi(n);
+
+    std::vector<Record> records;
+    records.push_back(measure("tensor", n, [&]() {
+        for (size_t i = 0; i < n; ++i) {
+            Vector3<double> acc{0.0, 0.0, 0.0};
+            for (size_t j = 0; j < n; ++j) {
+                if (j != i) acc = acc + dipole_tensor(points[i] - points[j]) * moments[j];
+            }
+            field[i] = acc;
+        }
+        return dipole_energy(moments, field);
+    }, opts.min_time));
+    records.push_back(measure("scalar", n, [&]() {
+        std::fill(phi.begin(), phi.end(), 0.0);
+        h = Vector3Array<double>(n);
+        return 0.5 * detail::dipole_tiled<detail::P2PScalar, true>(p.x(), p.y(), p.z(), m.x(), m.y(), m.z(), n,
+                                                                   p.x(), p.y(), p.z(), m.x(), m.y(), m.z(), n,
+                                                                   phi.data(), h.x(), h.y(), h.z());
+    }, opts.min_time));
+    records.push_back(measure("simd", n, [&]() {
+        std::fill(phi.begin(), phi.end(), 0.0);
+        h = Vector3Array<double>(n);
+        dipole_kernel(p.x(), p.y(), p.z(), m.x(), m.y(), m.z(), n, p.x(), p.y(), p.z(), n,
+                      phi.data(), h.x(), h.y(), h.z());
+        return dipole_energy(moments, h.to_aos());
+    }, opts.min_time));
+    records.push_back(measure("simd_fused", n, [&]() {
+        std::fill(phi.begin(), phi.end(), 0.0);
+        h = Vector3Array<double>(n);
+        return 0.5 * dipole_kernel_energy(p.x(), p.y(), p.z(), m.x(), m.y(), m.z(), n,
+                                          p.x(), p.y(), p.z(), m.x(), m.y(), m.z(), n,
+                                          phi.data(), h.x(), h.y(), h.z());
+    }, opts.min_time));
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,139 @@
+/*
+ * @file bench_fem_assembly.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Cost of the symbolic and numeric phases of FEM assembly
+ *
+ * On a structured tetrahedral mesh of the unit cube (n^3 cells of six
+ * elements) this measures building the colouring and CSR pattern, and then
+ * re-assembling the Laplacian (4 x 4 elements, one dof per node) and linear
+ * elasticity (12 x 12 elements, three dofs per node) into it, on one thread
+ * and on the whole pool.
+ *
+ * Usage: bench_fem_assembly [--format csv|json] [--n cells] [--min-time seconds]
+ */
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fem_assembly.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 40;
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string phase;
+    size_t threads;
+    size_t elements;
+    size_t colors;
+    size_t nnz;
+    double seconds;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+static void measure(const TetMesh &mesh, ThreadPool &pool, const Options &opts, std::vector<Record> &records) {
+    auto volumes = mesh.volumes();
+    auto gradients = mesh.gradients();
+    const size_t ne = mesh.element_count();
+
+    std::unique_ptr<FemAssembler> scalar;
+    double symbolic = time_runs([&]() { scalar = std::make_unique<FemAssembler>(mesh, 1, pool); }, opts.min_time);
+    const size_t colors = scalar->coloring().colors();
+    records.push_back({"symbolic", pool.size(), ne, colors, scalar->matrix().nnz(), symbolic});
+
+    CsrMatrix k = scalar->matrix();
+    double laplace = time_runs([&]() {
+        scalar->assemble(k, [&](size_t e, double *ke) { laplace_element(volumes[e], gradients[e], ke); });
+    }, opts.min_time);
+    records.push_back({"laplace", pool.size(), ne, colors, k.nnz(), laplace});
+
+    FemAssembler vector(mesh, 3, pool);
+    CsrMatrix a = vector.matrix();
+    double elasticity = time_runs([&]() {
+        vector.assemble(a, [&](size_t e, double *ke) { elasticity_element(volumes[e], gradients[e], 1.0, 1.0, ke); });
+    }, opts.min_time);
+    records.push_back({"elasticity", pool.size(), ne, colors, a.nnz(), elasticity});
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "phase,threads,elements,colors,nnz,seconds\n";
+    for (auto &r: records) {
+        std::cout << r.phase << "," << r.threads << "," << r.elements << "," << r.colors << "," << r.nnz << ","
+                  << r.seconds << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"phase\": \"" << r.phase << "\", \"threads\": " << r.threads
+                  << ", \"elements\": " << r.elements << ", \"colors\": " << r.colors << ", \"nnz\": " << r.nnz
+                  << ", \"seconds\": " << r.seconds << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n cells] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(opts.n, 1.0, nodes, elements);
+    TetMesh mesh(nodes, elements);
+
+    std::vector<Record> records;
+    ThreadPool single(1);
+    measure(mesh, single, opts, records);
+    if (ThreadPool::global().size() > 1) measure(mesh, ThreadPool::global(), opts, records);
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,226 @@
+/*
+ * @file bench_fft_m2l.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief FFT based M2L against the direct and rotation based translations
+ *
+ * For a uniform cloud of n particles this builds the octree, forms the
+ * multipole expansions of one level by P2M, and times every M2L of that
+ * level's uniform interaction lists three ways: the O(p^4) direct sum, the
+ * O(p^3) rotation based translation and FftM2L (including the multipole
+ * transforms; the kernel setup is reported separately). Each runs on the
+ * whole pool for at least --min-time seconds. The error is the maximum
+ * difference of the resulting potentials at the level's particles from
+ * those of the direct sum, relative to the largest potential.
+ *
+ * Usage: bench_fft_m2l [--format csv|json] [--n particles] [--level l]
+ *                      [--orders p,p,...] [--min-time seconds]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fft_m2l.hpp"
+#include "fmm_spherical.hpp"
+#include "octree.hpp"
+#include "parallel.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 100000;
+    size_t level = 3;
+    std::vector<size_t> orders = {8, 12, 16};
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string method;
+    size_t order;
+    size_t level;
+    size_t interactions;
+    double setup;
+    double seconds;
+    double ns_per_interaction;
+    double speedup;
+    double max_rel_error;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+/**
+ * @brief The potentials at the particles of a level from its local
+ *        expansions.
+ */
+static std::vector<double> potentials(const SphericalOperators &ops, const LinearOctree<double> &tree,
+                                      size_t level, const std::vector<Complex> &local) {
+    std::vector<double> phi(tree.points().size(), 0.0);
+    std::vector<Vector3<double>> field(tree.points().size());
+    auto [lb, le] = tree.level_range(level);
+    for (size_t i = lb; i < le; ++i) {
+        const OctreeNode &node = tree.node(i);
+        ops.l2p(local.data() + i * ops.size(), tree.center(i), tree.points().subspan(node.begin, node.size()),
+                std::span<double>(phi).subspan(node.begin, node.size()),
+                std::span<Vector3<double>>(field).subspan(node.begin, node.size()));
+    }
+    return phi;
+}
+
+static double max_rel_error(const std::vector<double> &ref, const std::vector<double> &phi) {
+    double scale = 0.0, diff = 0.0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+        scale = std::max(scale, std::abs(ref[i]));
+        diff = std::max(diff, std::abs(ref[i] - phi[i]));
+    }
+    return diff / scale;
+}
+
+static void measure(size_t p, const LinearOctree<double> &tree, const std::vector<double> &charges,
+                    const Options &opts, std::vector<Record> &records) {
+    const size_t level = opts.level;
+    SphericalOperators direct_ops(p, false), rotated_ops(p, true);
+    const size_t n = direct_ops.size();
+    auto [lb, le] = tree.level_range(level);
+
+    std::vector<Complex> multipole(tree.nodes().size() * n);
+    for (size_t i = lb; i < le; ++i) {
+        const OctreeNode &node = tree.node(i);
+        direct_ops.p2m(tree.center(i), tree.points().subspan(node.begin, node.size()),
+                       std::span<const double>(charges).subspan(node.begin, node.size()), multipole.data() + i * n);
+    }
+    size_t interactions = 0;
+    for (size_t t = lb; t < le; ++t) {
+        uniform_interaction_list(tree, uint32_t(t), [&](uint32_t, int, int, int) { ++interactions; });
+    }
+
+    std::vector<Complex> local(multipole.size());
+    auto translate = [&](const SphericalOperators &ops) {
+        std::fill(local.begin(), local.end(), Complex(0.0));
+        parallel_for(lb, le, 4, [&](size_t b, size_t e) {
+            for (size_t t = b; t < e; ++t) {
+                uniform_interaction_list(tree, uint32_t(t), [&](uint32_t s, int, int, int) {
+                    ops.m2l(multipole.data() + s * n, tree.center(s), tree.center(t), local.data() + t * n);
+                });
+            }
+        });
+    };
+
+    double direct = time_runs([&]() { translate(direct_ops); }, opts.min_time);
+    auto ref = potentials(direct_ops, tree, level, local);
+    records.push_back({"direct", p, level, interactions, 0.0, direct, 0.0, 1.0, 0.0});
+
+    double rotated = time_runs([&]() { translate(rotated_ops); }, opts.min_time);
+    records.push_back({"rotated", p, level, interactions, 0.0, rotated, 0.0, direct / rotated,
+                       max_rel_error(ref, potentials(direct_ops, tree, level, local))});
+
+    auto start = std::chrono::steady_clock::now();
+    FftM2L fft(p);
+    double setup = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double seconds = time_runs([&]() {
+        std::fill(local.begin(), local.end(), Complex(0.0));
+        fft.translate_level(tree, level, multipole.data(), local.data());
+    }, opts.min_time);
+    records.push_back({"fft", p, level, interactions, setup, seconds, 0.0, direct / seconds,
+                       max_rel_error(ref, potentials(direct_ops, tree, level, local))});
+
+    for (size_t i = records.size() - 3; i < records.size(); ++i) {
+        records[i].ns_per_interaction = records[i].seconds / double(interactions) * 1.0e9;
+    }
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "method,order,level,interactions,setup,seconds,ns_per_interaction,speedup,max_rel_error\n";
+    for (auto &r: records) {
+        std::cout << r.method << "," << r.order << "," << r.level << "," << r.interactions << "," << r.setup << ","
+                  << r.seconds << "," << r.ns_per_interaction << "," << r.speedup << "," << r.max_rel_error << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"method\": \"" << r.method << "\", \"order\": " << r.order << ", \"level\": " << r.level
+                  << ", \"interactions\": " << r.interactions << ", \"setup\": " << r.setup
+                  << ", \"seconds\": " << r.seconds << ", \"ns_per_interaction\": " << r.ns_per_interaction
+                  << ", \"speedup\": " << r.speedup << ", \"max_rel_error\": " << r.max_rel_error << "}"
+                  << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--level") && i + 1 < argc) {
+            opts.level = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--orders") && i + 1 < argc) {
+            opts.orders.clear();
+            std::stringstream list(argv[++i]);
+            for (std::string item; std::getline(list, item, ',');) opts.orders.push_back(std::stoul(item));
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n particles] [--level l]"
+                      << " [--orders p,p,...] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(37);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Vector3<double>> points(opts.n);
+    std::vector<double> charges(opts.n);
+    for (size_t i = 0; i < opts.n; ++i) {
+        points[i] = {u(rng), u(rng), u(rng)};
+        charges[i] = u(rng);
+    }
+    LinearOctree<double> tree(points, 32);
+    if (opts.level < 2 || opts.level >= tree.depth()) {
+        std::cerr << "level must be in [2, " << tree.depth() << ") for this tree\n";
+        return 1;
+    }
+    std::vector<double> sorted(opts.n);
+    auto perm = tree.permutation();
+    for (size_t i = 0; i < opts.n; ++i) sorted[i] = charges[perm[i]];
+
+    std::vector<Record> records;
+    for (size_t p: opts.orders) measure(p, tree, sorted, opts, records);
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,140 @@
+/*
+ * @file bench_fmm.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Per-phase strong scaling of the FMM
+ *
+ * For a uniform cloud of n particles this times the interaction list
+ * traversal and one evaluation (after a warm-up evaluation) with 1, 2, 4, ...
+ * up to --max-threads threads, under both schedules: level synchronous
+ * phases, where each pass time is a wall time, and the task graph, where
+ * passes overlap and each pass time is the summed task time over all
+ * threads. Speedup and parallel efficiency are relative to one thread of
+ * the same schedule. Thread counts beyond the hardware concurrency are run
+ * oversubscribed.
+ *
+ * Usage: bench_fmm [--format csv|json] [--n particles] [--order p]
+ *                  [--max-threads t]
+ */
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fmm.hpp"
+#include "fmm_spherical.hpp"
+#include "parallel.hpp"
+#include "tasks.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 50000;
+    size_t order = 6;
+    size_t max_threads = 64;
+};
+
+struct Record {
+    std::string schedule;
+    size_t threads;
+    size_t n;
+    size_t order;
+    FmmTimings timings;
+    double speedup;
+    double efficiency;
+};
+
+static Record measure(FmmSchedule schedule, size_t nthreads, const std::vector<Vector3<double>> &points,
+                      const std::vector<double> &charges, const Options &opts) {
+    ThreadPool pool(nthreads);
+    TaskPool tasks(nthreads);
+    FmmOptions options;
+    options.schedule = schedule;
+    Fmm<SphericalOperators> fmm(SphericalOperators(opts.order), points, charges, options, pool, tasks);
+
+    std::vector<double> phi(points.size());
+    std::vector<Vector3<double>> field(points.size());
+    fmm.evaluate(phi, field);
+    fmm.evaluate(phi, field);
+
+    return {schedule == FmmSchedule::phases ? "phases" : "task_graph", nthreads, points.size(), opts.order,
+            fmm.timings(), 1.0, 1.0};
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "schedule,threads,n,order,traversal,upward,far_field,downward,near_field,total,speedup,efficiency\n";
+    for (auto &r: records) {
+        const FmmTimings &t = r.timings;
+        std::cout << r.schedule << "," << r.threads << "," << r.n << "," << r.order << "," << t.traversal << ","
+                  << t.upward << "," << t.far_field << "," << t.downward << "," << t.near_field << ","
+                  << t.total << "," << r.speedup << "," << r.efficiency << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        const FmmTimings &t = r.timings;
+        std::cout << "  {\"schedule\": \"" << r.schedule << "\", \"threads\": " << r.threads
+                  << ", \"n\": " << r.n << ", \"order\": " << r.order
+                  << ", \"traversal\": " << t.traversal << ", \"upward\": " << t.upward
+                  << ", \"far_field\": " << t.far_field << ", \"downward\": " << t.downward
+                  << ", \"near_field\": " << t.near_field << ", \"total\": " << t.total
+                  << ", \"speedup\": " << r.speedup << ", \"efficiency\": " << r.efficiency << "}"
+                  << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--order") && i + 1 < argc) {
+            opts.order = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-threads") && i + 1 < argc) {
+            opts.max_threads = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--format csv|json] [--n particles] [--order p] [--max-threads t]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(35);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Vector3<double>> points(opts.n);
+    std::vector<double> charges(opts.n);
+    for (size_t i = 0; i < opts.n; ++i) {
+        points[i] = {u(rng), u(rng), u(rng)};
+        charges[i] = u(rng);
+    }
+
+    std::vector<Record> records;
+    for (FmmSchedule schedule: {FmmSchedule::phases, FmmSchedule::task_graph}) {
+        size_t first = records.size();
+        for (size_t t = 1; t <= opts.max_threads; t *= 2) {
+            records.push_back(measure(schedule, t, points, charges, opts));
+            Record &r = records.back();
+            r.speedup = records[first].timings.total / r.timings.total;
+            r.efficiency = r.speedup / static_cast<double>(t);
+        }
+    }
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,431 @@
+/*
+ * @file bench_linalg.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Throughput and accuracy of the linalg.hpp operations per scalar type
+ *
+ * For every operation (`*`, inner, cross, outer, adj, det), scalar type
+ * (float, double, long double, DdReal, MpReal at several precisions) and
+ * input family (random, ill-conditioned) this measures operations per second
+ * and the normwise relative error against an MpReal reference computed at
+ * high precision from the same (rounded) inputs.
+ *
+ * Usage: bench_linalg [--format csv|json] [--n items] [--min-time seconds]
+ *
+ * Results are written to stdout, one record per (scalar, operation, input).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ddreal.hpp"
+#include "linalg.hpp"
+#include "mpreal.hpp"
+
+// ######################################################################### //
+// # Scalar traits.                                                        # //
+// ######################################################################### //
+
+static constexpr mpfr_prec_t REFERENCE_PRECISION = 2048;
+
+template <typename T>
+struct ScalarTraits;
+
+template <>
+struct ScalarTraits<float> {
+    static std::string name() { return "float"; }
+    static long bits() { return 24; }
+    static float from_double(double x) { return static_cast<float>(x); }
+    static MpReal to_mp(float x) { return MpReal(static_cast<double>(x), REFERENCE_PRECISION); }
+};
+
+template <>
+struct ScalarTraits<double> {
+    static std::string name() { return "double"; }
+    static long bits() { return 53; }
+    static double from_double(double x) { return x; }
+    static MpReal to_mp(double x) { return MpReal(x, REFERENCE_PRECISION); }
+};
+
+template <>
+struct ScalarTraits<long double> {
+    static std::string name() { return "long double"; }
+    static long bits() { return std::numeric_limits<long double>::digits; }
+    static long double from_double(double x) { return x; }
+    static MpReal to_mp(long double x) {
+        MpReal r = MpReal::with_precision(REFERENCE_PRECISION);
+        mpfr_set_ld(r.mpfr(), x, MP_RND);
+        return r;
+    }
+};
+
+template <>
+struct ScalarTraits<DdReal> {
+    static std::string name() { return "double-double"; }
+    static long bits() { return 106; }
+    static DdReal from_double(double x) { return x; }
+    static MpReal to_mp(const DdReal &x) {
+        return MpReal(x.hi, REFERENCE_PRECISION) + MpReal(x.lo, REFERENCE_PRECISION);
+    }
+};
+
+template <>
+struct ScalarTraits<MpReal> {
+    static std::string name() { return "mpfr"; }
+    static long bits() { return mpfr_get_default_prec(); }
+    static MpReal from_double(double x) { return MpReal(x); }
+    static MpReal to_mp(const MpReal &x) {
+        MpReal r = MpReal::with_precision(REFERENCE_PRECISION);
+        mpfr_set(r.mpfr(), x.mpfr(), MP_RND);
+        return r;
+    }
+};
+
+// ######################################################################### //
+// # Components of results.                                                # //
+// ######################################################################### //
+
+template <typename T>
+void components(const T &a, std::vector<T> &out) { out.push_back(a); }
+
+template <typename T>
+void components(const Vector3<T> &a, std::vector<T> &out) {
+    out.push_back(a.x); out.push_back(a.y); out.push_back(a.z);
+}
+
+template <typename T>
+void components(const Matrix3x3<T> &a, std::vector<T> &out) {
+    for (auto &row: a.m) for (auto &e: row) out.push_back(e);
+}
+
+template <typename T>
+void components(const Matrix4x4<T> &a, std::vector<T> &out) {
+    for (auto &row: a.m) for (auto &e: row) out.push_back(e);
+}
+
+// ######################################################################### //
+// # Inputs.                                                               # //
+// ######################################################################### //
+
+/**
+ * @brief One benchmark item: the operands of an operation as doubles.
+ */
+struct Item {
+    std::vector<double> a;
+    std::vector<double> b;
+};
+
+enum class InputKind { Random, IllConditioned };
+
+static const char *input_name(InputKind kind) {
+    return kind == InputKind::Random ? "random" : "ill-conditioned";
+}
+
+/**
+ * @brief Random vectors, or (ill-conditioned) a vector and a second one that
+ *        is nearly parallel, so that cross products cancel.
+ */
+static Item vector_pair(std::mt19937_64 &rng, size_t dim, InputKind kind) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    Item item{std::vector<double>(dim), std::vector<double>(dim)};
+    for (size_t i = 0; i < dim; ++i) item.a[i] = u(rng);
+    for (size_t i = 0; i < dim; ++i) {
+        item.b[i] = kind == InputKind::Random ? u(rng) : item.a[i] * 1.5 + 1.0e-10 * u(rng);
+    }
+    return item;
+}
+
+/**
+ * @brief A random vector and a second vector that is orthogonal to it up to
+ *        a tiny perturbation, so that inner products cancel.
+ */
+static Item orthogonal_pair(std::mt19937_64 &rng, size_t dim, InputKind kind) {
+    if (kind == InputKind::Random) return vector_pair(rng, dim, kind);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    Item item = vector_pair(rng, dim, InputKind::Random);
+    double aa = 0.0, ab = 0.0;
+    for (size_t i = 0; i < dim; ++i) { aa += item.a[i] * item.a[i]; ab += item.a[i] * item.b[i]; }
+    for (size_t i = 0; i < dim; ++i) item.b[i] = 1.0e6 * (item.b[i] - ab / aa * item.a[i]) + 1.0e-8 * u(rng);
+    return item;
+}
+
+/**
+ * @brief Random matrices, or (ill-conditioned) matrices whose last row is a
+ *        combination of the others plus a tiny perturbation.
+ */
+static Item matrix_pair(std::mt19937_64 &rng, size_t dim, InputKind kind) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    Item item{std::vector<double>(dim * dim), std::vector<double>(dim * dim)};
+    for (auto *m: {&item.a, &item.b}) {
+        for (auto &e: *m) e = u(rng);
+        if (kind == InputKind::IllConditioned) {
+            for (size_t j = 0; j < dim; ++j) {
+                double s = 0.0;
+                for (size_t i = 0; i + 1 < dim; ++i) s += (*m)[i * dim + j] * (0.5 + 0.25 * i);
+                (*m)[(dim - 1) * dim + j] = s + 1.0e-12 * u(rng);
+            }
+        }
+    }
+    return item;
+}
+
+template <typename T>
+Vector3<T> make_vector3(const std::vector<double> &v, std::function<T(double)> f) {
+    return {f(v[0]), f(v[1]), f(v[2])};
+}
+
+template <typename T>
+Matrix3x3<T> make_matrix3x3(const std::vector<double> &v, std::function<T(double)> f) {
+    return {f(v[0]), f(v[1]), f(v[2]), f(v[3]), f(v[4]), f(v[5]), f(v[6]), f(v[7]), f(v[8])};
+}
+
+template <typename T>
+Matrix4x4<T> make_matrix4x4(const std::vector<double> &v, std::function<T(double)> f) {
+    return {f(v[0]),  f(v[1]),  f(v[2]),  f(v[3]),  f(v[4]),  f(v[5]),  f(v[6]),  f(v[7]),
+            f(v[8]),  f(v[9]),  f(v[10]), f(v[11]), f(v[12]), f(v[13]), f(v[14]), f(v[15])};
+}
+
+// ######################################################################### //
+// # Measurement.                                                          # //
+// ######################################################################### //
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 2000;
+    double min_time = 0.05;
+};
+
+struct Record {
+    std::string scalar;
+    long bits;
+    std::string operation;
+    std::string input;
+    double ops_per_sec;
+    double max_rel_error;
+    double mean_rel_error;
+};
+
+/**
+ * @brief The normwise relative error max|r - ref| / max|ref| of a result.
+ */
+static double relative_error(const std::vector<MpReal> &r, const std::vector<MpReal> &ref) {
+    MpReal num(0.0, REFERENCE_PRECISION), den(0.0, REFERENCE_PRECISION);
+    for (size_t i = 0; i < r.size(); ++i) {
+        MpReal d = abs(r[i] - ref[i]);
+        MpReal a = abs(ref[i]);
+        if (d > num) num = d;
+        if (a > den) den = a;
+    }
+    if (den.to_double() == 0.0) return num.to_double();
+    return (num / den).to_double();
+}
+
+/**
+ * @brief Times an operation over a set of prepared operands and measures its
+ *        error against the reference operation.
+ *
+ * @tparam T the scalar type under test.
+ * @tparam A the first operand type (for T).
+ * @tparam B the second operand type (for T).
+ */
+template <typename T, typename A, typename B, typename Op, typename RefOp, typename MakeA, typename MakeB>
+Record measure(const std::string &operation, InputKind kind, const std::vector<Item> &items,
+               const Options &opts, MakeA make_a, MakeB make_b, Op op, RefOp ref_op) {
+    using Traits = ScalarTraits<T>;
+    std::function<T(double)> to_t = [](double x) { return Traits::from_double(x); };
+
+    std::vector<A> as;
+    std::vector<B> bs;
+    for (auto &item: items) {
+        as.push_back(make_a(item.a, to_t));
+        bs.push_back(make_b(item.b, to_t));
+    }
+
+    using R = decltype(op(as[0], bs[0]));
+    std::vector<R> results(items.size());
+
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        for (size_t i = 0; i < items.size(); ++i) results[i] = op(as[i], bs[i]);
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < opts.min_time);
+
+    double max_err = 0.0, sum_err = 0.0;
+    std::vector<T> comps;
+    std::vector<MpReal> r_mp, ref_mp;
+    for (size_t i = 0; i < items.size(); ++i) {
+        comps.clear();
+        components(results[i], comps);
+        r_mp.clear();
+        for (auto &c: comps) r_mp.push_back(Traits::to_mp(c));
+
+        std::vector<MpReal> ref_comps;
+        components(ref_op(as[i], bs[i]), ref_comps);
+
+        double err = relative_error(r_mp, ref_comps);
+        max_err = std::max(max_err, err);
+        sum_err += err;
+    }
+
+    return {Traits::name(), Traits::bits(), operation, input_name(kind),
+            static_cast<double>(reps * items.size()) / elapsed,
+            max_err, sum_err / static_cast<double>(items.size())};
+}
+
+/**
+ * @brief Converts an operand for T into the reference precision.
+ */
+template <typename T>
+MpReal ref(const T &x) { return ScalarTraits<T>::to_mp(x); }
+
+template <typename T>
+Vector3<MpReal> ref(const Vector3<T> &v) { return {ref(v.x), ref(v.y), ref(v.z)}; }
+
+template <typename T>
+Matrix3x3<MpReal> ref(const Matrix3x3<T> &a) {
+    Matrix3x3<MpReal> r;
+    for (size_t i = 0; i < 3; ++i) for (size_t j = 0; j < 3; ++j) r.m[i][j] = ref(a.m[i][j]);
+    return r;
+}
+
+template <typename T>
+Matrix4x4<MpReal> ref(const Matrix4x4<T> &a) {
+    Matrix4x4<MpReal> r;
+    for (size_t i = 0; i < 4; ++i) for (size_t j = 0; j < 4; ++j) r.m[i][j] = ref(a.m[i][j]);
+    return r;
+}
+
+/**
+ * @brief Runs every operation on both input families for one scalar type.
+ */
+template <typename T>
+void bench_scalar(const Options &opts, std::vector<Record> &records) {
+    for (InputKind kind: {InputKind::Random, InputKind::IllConditioned}) {
+        std::mt19937_64 rng(1234);
+        std::vector<Item> vectors, orthogonal, matrices3, matrices4;
+        for (size_t i = 0; i < opts.n; ++i) {
+            vectors.push_back(vector_pair(rng, 3, kind));
+            orthogonal.push_back(orthogonal_pair(rng, 3, kind));
+            matrices3.push_back(matrix_pair(rng, 3, kind));
+            matrices4.push_back(matrix_pair(rng, 4, kind));
+        }
+
+        auto v3 = make_vector3<T>;
+        auto m3 = make_matrix3x3<T>;
+        auto m4 = make_matrix4x4<T>;
+
+        records.push_back(measure<T, Matrix3x3<T>, Matrix3x3<T>>(
+                "mul3x3", kind, matrices3, opts, m3, m3,
+                [](const auto &a, const auto &b) { return a * b; },
+                [](const auto &a, const auto &b) { return ref(a) * ref(b); }));
+        records.push_back(measure<T, Matrix3x3<T>, Vector3<T>>(
+                "mul3x3_vector3", kind, matrices3, opts, m3, v3,
+                [](const auto &a, const auto &b) { return a * b; },
+                [](const auto &a, const auto &b) { return ref(a) * ref(b); }));
+        records.push_back(measure<T, Vector3<T>, Vector3<T>>(
+                "inner3", kind, orthogonal, opts, v3, v3,
+                [](const auto &a, const auto &b) { return inner(a, b); },
+                [](const auto &a, const auto &b) { return inner(ref(a), ref(b)); }));
+        records.push_back(measure<T, Vector3<T>, Vector3<T>>(
+                "cross3", kind, vectors, opts, v3, v3,
+                [](const auto &a, const auto &b) { return cross(a, b); },
+                [](const auto &a, const auto &b) { return cross(ref(a), ref(b)); }));
+        records.push_back(measure<T, Vector3<T>, Vector3<T>>(
+                "outer3", kind, vectors, opts, v3, v3,
+                [](const auto &a, const auto &b) { return outer(a, b); },
+                [](const auto &a, const auto &b) { return outer(ref(a), ref(b)); }));
+        records.push_back(measure<T, Matrix3x3<T>, Matrix3x3<T>>(
+                "adj3x3", kind, matrices3, opts, m3, m3,
+                [](const auto &a, const auto &) { return adj(a); },
+                [](const auto &a, const auto &) { return adj(ref(a)); }));
+        records.push_back(measure<T, Matrix4x4<T>, Matrix4x4<T>>(
+                "adj4x4", kind, matrices4, opts, m4, m4,
+                [](const auto &a, const auto &) { return adj(a); },
+                [](const auto &a, const auto &) { return adj(ref(a)); }));
+        records.push_back(measure<T, Matrix3x3<T>, Matrix3x3<T>>(
+                "det3x3", kind, matrices3, opts, m3, m3,
+                [](const auto &a, const auto &) { return det(a); },
+                [](const auto &a, const auto &) { return det(ref(a)); }));
+        records.push_back(measure<T, Matrix4x4<T>, Matrix4x4<T>>(
+                "det4x4", kind, matrices4, opts, m4, m4,
+                [](const auto &a, const auto &) { return det(a); },
+                [](const auto &a, const auto &) { return det(ref(a)); }));
+    }
+}
+
+// ######################################################################### //
+// # Output.                                                               # //
+// ######################################################################### //
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "scalar,bits,operation,input,ops_per_sec,max_rel_error,mean_rel_error\n";
+    std::cout.precision(6);
+    for (auto &r: records) {
+        std::cout << r.scalar << "," << r.bits << "," << r.operation << "," << r.input << ","
+                  << r.ops_per_sec << "," << r.max_rel_error << "," << r.mean_rel_error << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"scalar\": \"" << r.scalar << "\", \"bits\": " << r.bits
+                  << ", \"operation\": \"" << r.operation << "\", \"input\": \"" << r.input
+                  << "\", \"ops_per_sec\": " << r.ops_per_sec
+                  << ", \"max_rel_error\": " << r.max_rel_error
+                  << ", \"mean_rel_error\": " << r.mean_rel_error << "}"
+                  << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n items] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Record> records;
+
+    bench_scalar<float>(opts, records);
+    bench_scalar<double>(opts, records);
+    bench_scalar<long double>(opts, records);
+    bench_scalar<DdReal>(opts, records);
+    for (mpfr_prec_t prec: {64, 128, 256, 512}) {
+        mpfr_set_default_prec(prec);
+        bench_scalar<MpReal>(opts, records);
+    }
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
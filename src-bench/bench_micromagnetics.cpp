@@ -0,0 +1,165 @@
+/*
+ * @file bench_micromagnetics.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Time per energy and gradient evaluation of MicromagEvaluator, by
+ *        term, fused and per term
+ *
+ * On a cube of side 100 nm cut into n^3 cells of six tetrahedra, with a
+ * random unit magnetization, this times energy only and energy plus
+ * gradient evaluations for three sets of terms (exchange alone, the local
+ * terms, and all with the demagnetizing field), each with all terms in one
+ * element pass (fused) and with a pass per term. The phase times are those
+ * of the last evaluation; rate is millions of elements per second.
+ *
+ * Usage: bench_micromagnetics [--format csv|json] [--n cells] [--min-time seconds]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "linalg.hpp"
+#include "micromagnetics.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 24;
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string terms;
+    std::string mode;
+    bool gradient;
+    size_t nodes;
+    size_t elements;
+    MicromagTimings timings;
+    double seconds;
+    double rate;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "terms,mode,gradient,nodes,elements,exchange,uniaxial,cubic,zeeman,demag,fused,total,seconds,"
+                 "melements_per_second\n";
+    for (auto &r: records) {
+        std::cout << r.terms << "," << r.mode << "," << r.gradient << "," << r.nodes << "," << r.elements << ","
+                  << r.timings.exchange << "," << r.timings.uniaxial << "," << r.timings.cubic << ","
+                  << r.timings.zeeman << "," << r.timings.demag << "," << r.timings.fused << ","
+                  << r.timings.total << "," << r.seconds << "," << r.rate << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"terms\": \"" << r.terms << "\", \"mode\": \"" << r.mode << "\", \"gradient\": "
+                  << (r.gradient ? "true" : "false") << ", \"nodes\": " << r.nodes << ", \"elements\": "
+                  << r.elements << ", \"exchange\": " << r.timings.exchange << ", \"uniaxial\": "
+                  << r.timings.uniaxial << ", \"cubic\": " << r.timings.cubic << ", \"zeeman\": "
+                  << r.timings.zeeman << ", \"demag\": " << r.timings.demag << ", \"fused\": " << r.timings.fused
+                  << ", \"total\": " << r.timings.total << ", \"seconds\": " << r.seconds
+                  << ", \"melements_per_second\": " << r.rate << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n cells] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(opts.n, 100.0e-9, nodes, elements);
+    TetMesh mesh(nodes, elements);
+
+    std::mt19937 gen(3);
+    std::normal_distribution<double> normal;
+    Vector3Array<double> m(mesh.node_count()), gradient(mesh.node_count());
+    for (size_t i = 0; i < m.size(); ++i) {
+        Vector3<double> v{normal(gen), normal(gen), normal(gen)};
+        m.set(i, v / std::sqrt(inner(v, v)));
+    }
+
+    MicromagMaterial material;
+    material.uniaxial = 1.0e4;
+    material.applied = {0.0, 0.0, 2.0e4};
+
+    struct Set {
+        std::string name;
+        MicromagTerms terms;
+    };
+    const std::vector<Set> sets = {{"exchange", {true, false, false, false, false}},
+                                   {"local", {true, true, true, true, false}},
+                                   {"all", {true, true, true, true, true}}};
+
+    std::vector<Record> records;
+    for (const Set &set: sets) {
+        for (bool fused: {true, false}) {
+            MicromagOptions options;
+            options.terms = set.terms;
+            options.fused = fused;
+            MicromagEvaluator evaluator(mesh, material, options);
+            for (bool with_gradient: {false, true}) {
+                double seconds = time_runs([&]() {
+                    if (with_gradient) {
+                        evaluator.evaluate(m, gradient);
+                    } else {
+                        evaluator.energy(m);
+                    }
+                }, opts.min_time);
+                records.push_back({set.name, fused ? "fused" : "per_term", with_gradient, mesh.node_count(),
+                                   mesh.element_count(), evaluator.timings(), seconds,
+                                   double(mesh.element_count()) / seconds * 1.0e-6});
+            }
+        }
+    }
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,157 @@
+/*
+ * @file bench_octree_update.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Incremental octree updates against full rebuilds for moving points
+ *
+ * A uniform cloud of n points takes --steps random steps of up to --step
+ * (relative to the cloud's width) per coordinate. Each step is timed as a
+ * fresh LinearOctree build and as LinearOctree::update of a tree carried
+ * from step to step, counting the refits, restructures and rebuilds. The
+ * points are held either in their original random order or in the tree's
+ * order (as a simulation that reorders its particles would), which makes
+ * the gather of the points into sorted order sequential.
+ *
+ * Usage: bench_octree_update [--format csv|json] [--n points] [--steps s]
+ *                            [--step size] [--max-leaf m] [--threads t]
+ */
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "octree.hpp"
+#include "parallel.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 1000000;
+    size_t steps = 10;
+    double step = 1.0e-4;
+    size_t max_leaf = 64;
+    size_t threads = ThreadPool::default_concurrency();
+};
+
+struct Record {
+    std::string order;
+    size_t n;
+    size_t threads;
+    double step;
+    double build;
+    double update;
+    double speedup;
+    size_t refits;
+    size_t restructures;
+    size_t rebuilds;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Record measure(const std::string &order, std::vector<Vector3<double>> points, const Options &opts,
+                      ThreadPool &pool) {
+    std::mt19937_64 rng(39);
+    std::uniform_real_distribution<double> u(-opts.step, opts.step);
+    LinearOctree<double> tree(points, opts.max_leaf, pool);
+
+    // One update first, to pad the cube of the initial build.
+    for (auto &p: points) p = p + Vector3<double>{u(rng), u(rng), u(rng)};
+    tree.update(points, {}, pool);
+
+    Record r{order, opts.n, pool.size(), opts.step, 0.0, 0.0, 0.0, 0, 0, 0};
+    for (size_t s = 0; s < opts.steps; ++s) {
+        for (auto &p: points) p = p + Vector3<double>{u(rng), u(rng), u(rng)};
+
+        auto start = std::chrono::steady_clock::now();
+        LinearOctree<double> fresh(points, opts.max_leaf, pool);
+        r.build += seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        switch (tree.update(points, {}, pool)) {
+            case OctreeUpdate::refit: ++r.refits; break;
+            case OctreeUpdate::restructure: ++r.restructures; break;
+            case OctreeUpdate::rebuild: ++r.rebuilds; break;
+        }
+        r.update += seconds_since(start);
+    }
+    r.build /= double(opts.steps);
+    r.update /= double(opts.steps);
+    r.speedup = r.build / r.update;
+    return r;
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "order,n,threads,step,build,update,speedup,refits,restructures,rebuilds\n";
+    for (auto &r: records) {
+        std::cout << r.order << "," << r.n << "," << r.threads << "," << r.step << "," << r.build << ","
+                  << r.update << "," << r.speedup << "," << r.refits << "," << r.restructures << "," << r.rebuilds
+                  << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"order\": \"" << r.order << "\", \"n\": " << r.n << ", \"threads\": " << r.threads
+                  << ", \"step\": " << r.step << ", \"build\": " << r.build << ", \"update\": " << r.update
+                  << ", \"speedup\": " << r.speedup << ", \"refits\": " << r.refits
+                  << ", \"restructures\": " << r.restructures << ", \"rebuilds\": " << r.rebuilds << "}"
+                  << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--steps") && i + 1 < argc) {
+            opts.steps = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--step") && i + 1 < argc) {
+            opts.step = std::stod(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-leaf") && i + 1 < argc) {
+            opts.max_leaf = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            opts.threads = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n points] [--steps s] [--step size]"
+                      << " [--max-leaf m] [--threads t]\n";
+            return 1;
+        }
+    }
+    if (opts.steps == 0) opts.steps = 1;
+
+    std::mt19937_64 rng(38);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<Vector3<double>> points(opts.n);
+    for (auto &p: points) p = {u(rng), u(rng), u(rng)};
+
+    ThreadPool pool(opts.threads);
+    std::vector<Record> records;
+    records.push_back(measure("input", points, opts, pool));
+    {
+        LinearOctree<double> tree(points, opts.max_leaf, pool);
+        points.assign(tree.points().begin(), tree.points().end());
+    }
+    records.push_back(measure("tree", points, opts, pool));
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
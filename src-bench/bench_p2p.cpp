@@ -0,0 +1,175 @@
+/*
+ * @file bench_p2p.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Throughput of the direct summation (P2P) kernel
+ *
+ * For a cloud of n particles interacting with themselves this measures the
+ * pairwise interactions per second and Gflop/s (P2P_FLOPS_PER_INTERACTION
+ * flops per pair) of the vectorised kernel and of the scalar reference lanes,
+ * on one thread and on the whole pool, and the maximum relative potential
+ * error against a long double sum over a sample of targets.
+ *
+ * Usage: bench_p2p [--format csv|json] [--n particles] [--min-time seconds]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "p2p.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 8192;
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string lanes;
+    size_t threads;
+    size_t n;
+    double interactions_per_sec;
+    double gflops;
+    double max_rel_error;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+/**
+ * @brief The maximum relative error of the potential over a sample of
+ *        targets, against a long double sum.
+ */
+static double potential_error(const Vector3Array<double> &p, const std::vector<double> &q,
+                              const std::vector<double> &phi) {
+    double worst = 0.0;
+    size_t step = std::max<size_t>(p.size() / 64, 1);
+    for (size_t i = 0; i < p.size(); i += step) {
+        long double ref = 0.0L;
+        for (size_t j = 0; j < p.size(); ++j) {
+            if (j == i) continue;
+            long double dx = (long double) p.x()[i] - p.x()[j];
+            long double dy = (long double) p.y()[i] - p.y()[j];
+            long double dz = (long double) p.z()[i] - p.z()[j];
+            ref += q[j] / std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+        worst = std::max(worst, (double) std::abs((phi[i] - ref) / ref));
+    }
+    return worst;
+}
+
+template <typename S>
+static Record measure(const std::string &lanes, ThreadPool &pool, const Vector3Array<double> &p,
+                      const std::vector<double> &q, const Options &opts) {
+    const size_t n = p.size();
+    std::vector<double> phi(n);
+    Vector3Array<double> field(n);
+    auto run = [&]() {
+        std::fill(phi.begin(), phi.end(), 0.0);
+        parallel_for(0, n, 256, [&](size_t b, size_t e) {
+            detail::p2p_tiled<S>(p.x(), p.y(), p.z(), q.data(), n,
+                                 p.x() + b, p.y() + b, p.z() + b, e - b,
+                                 phi.data() + b, field.x() + b, field.y() + b, field.z() + b);
+        }, pool);
+    };
+    double seconds = time_runs(run, opts.min_time);
+    double pairs = static_cast<double>(n) * static_cast<double>(n);
+    return {lanes, pool.size(), n, pairs / seconds,
+            pairs * P2P_FLOPS_PER_INTERACTION / seconds * 1.0e-9, potential_error(p, q, phi)};
+}
+
+static std::string lane_name() {
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__) && defined(__FMA__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "lanes,threads,n,interactions_per_sec,gflops,max_rel_error\n";
+    for (auto &r: records) {
+        std::cout << r.lanes << "," << r.threads << "," << r.n << "," << r.interactions_per_sec << ","
+                  << r.gflops << "," << r.max_rel_error << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"lanes\": \"" << r.lanes << "\", \"threads\": " << r.threads
+                  << ", \"n\": " << r.n << ", \"interactions_per_sec\": " << r.interactions_per_sec
+                  << ", \"gflops\": " << r.gflops << ", \"max_rel_error\": " << r.max_rel_error << "}"
+                  << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n particles] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(32);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    Vector3Array<double> p(opts.n);
+    std::vector<double> q(opts.n);
+    for (size_t i = 0; i < opts.n; ++i) {
+        p.set(i, {u(rng), u(rng), u(rng)});
+        q[i] = u(rng);
+    }
+
+    std::vector<Record> records;
+    ThreadPool single(1);
+    records.push_back(measure<detail::P2PScalar>("scalar", single, p, q, opts));
+    records.push_back(measure<detail::P2PLanes>(lane_name(), single, p, q, opts));
+    if (ThreadPool::global().size() > 1) {
+        records.push_back(measure<detail::P2PLanes>(lane_name(), ThreadPool::global(), p, q, opts));
+    }
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,185 @@
+/*
+ * @file bench_point_location.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Points per second of point location and interpolation in a
+ *        tetrahedral mesh
+ *
+ * On a cube of side 100 nm cut into n^3 cells of six tetrahedra (interior
+ * nodes moved by up to a tenth of a cell), this locates random points in
+ * the cube by a scan of every element (on a few points), by a hierarchy
+ * search per point, by walking from each point's element to the next in
+ * the input order, and in a Morton sorted batch; and it interpolates a
+ * nodal field from stored locations. It reports seconds per pass,
+ * nanoseconds and walk steps per point, and points per second.
+ *
+ * Usage: bench_point_location [--format csv|json] [--n cells] [--points count] [--min-time seconds]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "point_location.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 24;
+    size_t points = 100000;
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string mode;
+    size_t elements;
+    size_t points;
+    double seconds;
+    double nanoseconds_per_point;
+    double steps_per_point;
+    size_t searches;
+    double points_per_second;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "mode,elements,points,seconds,ns_per_point,steps_per_point,searches,points_per_second\n";
+    for (auto &r: records) {
+        std::cout << r.mode << "," << r.elements << "," << r.points << "," << r.seconds << ","
+                  << r.nanoseconds_per_point << "," << r.steps_per_point << "," << r.searches << ","
+                  << r.points_per_second << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"mode\": \"" << r.mode << "\", \"elements\": " << r.elements << ", \"points\": "
+                  << r.points << ", \"seconds\": " << r.seconds << ", \"ns_per_point\": "
+                  << r.nanoseconds_per_point << ", \"steps_per_point\": " << r.steps_per_point
+                  << ", \"searches\": " << r.searches << ", \"points_per_second\": " << r.points_per_second
+                  << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--points") && i + 1 < argc) {
+            opts.points = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--format csv|json] [--n cells] [--points count] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    const double side = 100.0e-9;
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(opts.n, side, nodes, elements);
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> shift(-0.1 * side / double(opts.n), 0.1 * side / double(opts.n));
+    for (Vector3<double> &p: nodes) {
+        const Vector3<double> d{shift(gen), shift(gen), shift(gen)};
+        if (p.x > 0.0 && p.y > 0.0 && p.z > 0.0 && p.x < side && p.y < side && p.z < side) p = p + d;
+    }
+    TetMesh mesh(nodes, elements);
+    TetLocator locator(mesh);
+    const size_t ne = mesh.element_count();
+
+    std::uniform_real_distribution<double> u(0.0, side);
+    std::vector<Vector3<double>> points(opts.points);
+    for (auto &p: points) p = {u(gen), u(gen), u(gen)};
+    Vector3Array<double> field(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) field.set(i, {std::sin(1.0e8 * nodes[i].x), 1.0, 0.0});
+
+    std::vector<Record> records;
+    auto record = [&](const std::string &mode, size_t count, double seconds, size_t steps, size_t searches) {
+        records.push_back({mode, ne, count, seconds, seconds / double(count) * 1.0e9,
+                           double(steps) / double(count), searches, double(count) / seconds});
+    };
+
+    // The linear scan, on few points: it tests half the elements per point.
+    const size_t scanned = std::min<size_t>(points.size(), 200);
+    size_t found = 0;
+    double seconds = time_runs([&]() {
+        found = 0;
+        for (size_t k = 0; k < scanned; ++k) {
+            for (size_t e = 0; e < ne; ++e) {
+                auto l = barycentric(mesh, e, points[k]);
+                if (std::min({l[0], l[1], l[2], l[3]}) >= -LOCATE_TOLERANCE) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+    }, opts.min_time);
+    record("scan", scanned, seconds, 0, 0);
+
+    std::vector<TetLocation> out(points.size());
+    seconds = time_runs([&]() {
+        for (size_t k = 0; k < points.size(); ++k) out[k] = locator.locate(points[k]);
+    }, opts.min_time);
+    record("search", points.size(), seconds, 0, points.size());
+
+    seconds = time_runs([&]() {
+        uint32_t hint = TET_NONE;
+        for (size_t k = 0; k < points.size(); ++k) {
+            out[k] = locator.locate(points[k], hint);
+            hint = out[k].element;
+        }
+    }, opts.min_time);
+    record("walk", points.size(), seconds, 0, 0);
+
+    LocateStats stats;
+    seconds = time_runs([&]() { stats = locator.locate(points, out); }, opts.min_time);
+    record("batched", points.size(), seconds, stats.walk_steps, stats.searches);
+
+    Vector3Array<double> values(points.size());
+    seconds = time_runs([&]() { locator.interpolate(field, out, values); }, opts.min_time);
+    record("interpolate", points.size(), seconds, 0, 0);
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,159 @@
+/*
+ * @file bench_spmv.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Throughput of the sparse matrix-vector and matrix-multivector
+ *        products
+ *
+ * The matrix is the linear elasticity stiffness matrix of a structured
+ * tetrahedral mesh of the unit cube (n^3 cells of six elements, three dofs
+ * per node), stored as CSR and as 3 x 3 BSR. This measures a plain CSR
+ * loop (the reference), the library CSR and BSR products, and the products
+ * with eight right-hand sides at once, on one thread and on the whole pool.
+ * Gflop/s counts two flops per stored entry and right-hand side.
+ *
+ * Usage: bench_spmv [--format csv|json] [--n cells] [--min-time seconds]
+ */
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fem_assembly.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "sparse.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+struct Options {
+    std::string format = "csv";
+    size_t n = 30;
+    double min_time = 0.5;
+};
+
+struct Record {
+    std::string kernel;
+    size_t threads;
+    size_t rows;
+    size_t nnz;
+    size_t nrhs;
+    double seconds;
+    double gflops;
+};
+
+/**
+ * @brief Repeats a run until min_time has passed; returns seconds per run.
+ */
+static double time_runs(const std::function<void()> &run, double min_time) {
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        run();
+        ++reps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_time);
+    return elapsed / static_cast<double>(reps);
+}
+
+static void measure(const CsrMatrix &a, const BsrMatrix &b, ThreadPool &pool, const Options &opts,
+                    std::vector<Record> &records) {
+    constexpr size_t nrhs = 8;
+    const size_t n = a.rows();
+    std::vector<double> x(n * nrhs), y(n * nrhs);
+    for (size_t i = 0; i < x.size(); ++i) x[i] = 1.0 + double(i % 7);
+
+    auto record = [&](const std::string &kernel, size_t k, const std::function<void()> &run) {
+        double seconds = time_runs(run, opts.min_time);
+        records.push_back({kernel, pool.size(), n, a.nnz(), k, seconds,
+                           2.0 * double(a.nnz()) * double(k) / seconds * 1.0e-9});
+    };
+
+    std::span<const double> x1(x.data(), n);
+    std::span<double> y1(y.data(), n);
+    record("csr_scalar", 1, [&]() {
+        auto ptr = a.row_ptr();
+        auto col = a.col_idx();
+        auto val = a.values();
+        parallel_for(0, n, 1024, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                double sum = 0.0;
+                for (size_t k = ptr[i]; k < ptr[i + 1]; ++k) sum += val[k] * x1[col[k]];
+                y1[i] = sum;
+            }
+        }, pool);
+    });
+    record("csr", 1, [&]() { spmv(a, x1, y1, pool); });
+    record("bsr", 1, [&]() { spmv(b, x1, y1, pool); });
+    record("csr_spmm", nrhs, [&]() { spmm(a, x, y, nrhs, pool); });
+    record("bsr_spmm", nrhs, [&]() { spmm(b, x, y, nrhs, pool); });
+}
+
+static void write_csv(const std::vector<Record> &records) {
+    std::cout << "kernel,threads,rows,nnz,nrhs,seconds,gflops\n";
+    for (auto &r: records) {
+        std::cout << r.kernel << "," << r.threads << "," << r.rows << "," << r.nnz << "," << r.nrhs << ","
+                  << r.seconds << "," << r.gflops << "\n";
+    }
+}
+
+static void write_json(const std::vector<Record> &records) {
+    std::cout.precision(6);
+    std::cout << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        std::cout << "  {\"kernel\": \"" << r.kernel << "\", \"threads\": " << r.threads << ", \"rows\": " << r.rows
+                  << ", \"nnz\": " << r.nnz << ", \"nrhs\": " << r.nrhs << ", \"seconds\": " << r.seconds
+                  << ", \"gflops\": " << r.gflops << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+int
+main(int argc, char *argv[]) {
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            opts.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            opts.n = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opts.min_time = std::stod(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--format csv|json] [--n cells] [--min-time seconds]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(opts.n, 1.0, nodes, elements);
+    TetMesh mesh(nodes, elements);
+    auto volumes = mesh.volumes();
+    auto gradients = mesh.gradients();
+    FemAssembler assembler(mesh, 3);
+    CsrMatrix a = assembler.matrix();
+    assembler.assemble(a, [&](size_t e, double *ke) {
+        elasticity_element(volumes[e], gradients[e], 1.0, 1.0, ke);
+    });
+    BsrMatrix b = BsrMatrix::from_csr(a);
+
+    std::vector<Record> records;
+    ThreadPool single(1);
+    measure(a, b, single, opts, records);
+    if (ThreadPool::global().size() > 1) measure(a, b, ThreadPool::global(), opts, records);
+
+    if (opts.format == "json") {
+        write_json(records);
+    } else {
+        write_csv(records);
+    }
+
+    return 0;
+
+}
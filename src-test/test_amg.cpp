@@ -0,0 +1,209 @@
+/*
+ * @file test_amg.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the smoothed aggregation AMG hierarchy and preconditioner
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "amg.hpp"
+#include "fem_assembly.hpp"
+#include "krylov.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "sparse.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+/**
+ * @brief The five point Poisson matrix on an n x n grid.
+ */
+static CsrMatrix poisson(size_t n) {
+    std::vector<size_t> row_ptr{0};
+    std::vector<uint32_t> col_idx;
+    std::vector<double> values;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            auto add = [&](bool inside, size_t col, double v) {
+                if (inside) {
+                    col_idx.push_back(uint32_t(col));
+                    values.push_back(v);
+                }
+            };
+            const size_t row = i * n + j;
+            add(i > 0, row - n, -1.0);
+            add(j > 0, row - 1, -1.0);
+            add(true, row, 4.0);
+            add(j + 1 < n, row + 1, -1.0);
+            add(i + 1 < n, row + n, -1.0);
+            row_ptr.push_back(col_idx.size());
+        }
+    }
+    return {n * n, n * n, std::move(row_ptr), std::move(col_idx), values};
+}
+
+/**
+ * @brief Linear elasticity plus a small mass term on the unit cube cut into
+ *        n^3 cells of six tetrahedra, three unknowns per node.
+ */
+static CsrMatrix elasticity(size_t n) {
+    TetMesh mesh = cube_tet_mesh(n, 1.0);
+    auto volumes = mesh.volumes();
+    auto gradients = mesh.gradients();
+    FemAssembler assembler(mesh, 3);
+    CsrMatrix a = assembler.matrix();
+    assembler.assemble(a, [&](size_t e, double *ke) {
+        elasticity_element(volumes[e], gradients[e], 1.0, 1.0, ke);
+        double me[16] = {};
+        mass_element(volumes[e], me);
+        for (size_t p = 0; p < 4; ++p) {
+            for (size_t q = 0; q < 4; ++q) {
+                for (size_t c = 0; c < 3; ++c) ke[(3 * p + c) * 12 + 3 * q + c] += me[p * 4 + q];
+            }
+        }
+    });
+    return a;
+}
+
+static std::vector<double> wave(size_t n, double k) {
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = std::sin(k * double(i)) + 0.25;
+    return x;
+}
+
+// ######################################################################### //
+// # Hierarchy.                                                            # //
+// ######################################################################### //
+
+TEST_CASE("Aggregates cover every node", "[Amg]") {
+
+    ThreadPool pool(2);
+    CsrMatrix a = poisson(40);
+    size_t count = 0;
+    std::vector<uint32_t> aggregate = detail::amg_aggregate(detail::amg_node_norms(a, 1, pool), 0.08, count);
+    REQUIRE(aggregate.size() == a.rows());
+    std::vector<size_t> size(count, 0);
+    for (uint32_t g: aggregate) {
+        REQUIRE(g < count);
+        ++size[g];
+    }
+    // Aggregates are a node and (most of) its neighbours.
+    for (size_t s: size) REQUIRE(s >= 1);
+    REQUIRE(count < a.rows() / 3);
+    REQUIRE(count > a.rows() / 9);
+
+}
+
+TEST_CASE("Coarse matrices are Galerkin products", "[Amg]") {
+
+    ThreadPool pool(3);
+    CsrMatrix a = poisson(60);
+    AmgPreconditioner amg(a, {}, pool);
+    REQUIRE(amg.levels() >= 3);
+    REQUIRE(amg.matrix(amg.levels() - 1).rows() <= AmgOptions{}.coarse_size);
+    REQUIRE(amg.operator_complexity() > 1.0);
+    REQUIRE(amg.operator_complexity() < 2.0);
+
+    for (size_t l = 0; l + 1 < amg.levels(); ++l) {
+        const CsrMatrix &fine = amg.matrix(l), &coarse = amg.matrix(l + 1), &p = amg.prolongator(l);
+        REQUIRE(coarse.rows() < fine.rows() / 3);
+        std::vector<double> x = wave(coarse.rows(), 0.3), px(fine.rows()), apx(fine.rows()), expected(coarse.rows());
+        std::vector<double> got(coarse.rows());
+        spmv(p, x, px, pool);
+        spmv(fine, px, apx, pool);
+        spmv(transpose(p), apx, expected, pool);
+        spmv(coarse, x, got, pool);
+        for (size_t i = 0; i < got.size(); ++i) REQUIRE(got[i] == Approx(expected[i]).margin(1.0e-12));
+
+        // P stays a (scaled, smoothed) partition of unity: constants on the
+        // coarse level prolong to positive values everywhere.
+        std::vector<double> ones(coarse.rows(), 1.0), p1(fine.rows());
+        spmv(p, ones, p1, pool);
+        for (double v: p1) REQUIRE(v > 0.0);
+    }
+
+    REQUIRE_THROWS_AS(AmgPreconditioner(CsrMatrix(2, 3, {0, 1, 2}, {0, 1})), std::invalid_argument);
+    AmgOptions blocks;
+    blocks.block_size = 3;
+    REQUIRE_THROWS_AS(AmgPreconditioner(poisson(5), blocks), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # Preconditioning.                                                      # //
+// ######################################################################### //
+
+TEST_CASE("The V-cycle is symmetric, positive and deterministic", "[Amg]") {
+
+    ThreadPool one(1), three(3);
+    CsrMatrix a = poisson(50);
+    AmgPreconditioner amg(a, {}, three);
+    const size_t n = a.rows();
+    std::vector<double> x = wave(n, 0.1), y = wave(n, 0.37), mx(n), my(n), mx1(n);
+    amg.apply(x, mx, three);
+    amg.apply(y, my, three);
+    amg.apply(x, mx1, one);
+    REQUIRE(mx == mx1);
+    REQUIRE(amg.timings().cycles == 3);
+    REQUIRE(amg.timings().cycle > 0.0);
+    REQUIRE(amg.timings().setup >= amg.timings().aggregation + amg.timings().galerkin);
+
+    double ymx = 0.0, xmy = 0.0, xmx = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        ymx += y[i] * mx[i];
+        xmy += x[i] * my[i];
+        xmx += x[i] * mx[i];
+    }
+    REQUIRE(ymx == Approx(xmy).epsilon(1.0e-10));
+    REQUIRE(xmx > 0.0);
+
+}
+
+TEST_CASE("AMG preconditioned CG converges independently of the grid size", "[Amg]") {
+
+    KrylovOptions options;
+    options.tolerance = 1.0e-8;
+    size_t previous = 0;
+    for (size_t side: {size_t(64), size_t(128), size_t(256)}) {
+        CsrMatrix a = poisson(side);
+        std::vector<double> b = wave(a.rows(), 0.01), x(a.rows(), 0.0);
+        AmgPreconditioner amg(a);
+        KrylovStats stats = cg(a, b, x, amg, options);
+        REQUIRE(stats.converged);
+        REQUIRE(stats.iterations < 30);
+        if (previous > 0) REQUIRE(stats.iterations <= previous + 4);
+        previous = stats.iterations;
+
+        std::vector<double> y(a.rows(), 0.0);
+        KrylovStats jacobi = cg(a, b, y, JacobiPreconditioner(a), options);
+        REQUIRE(jacobi.iterations > 4 * stats.iterations);
+    }
+
+}
+
+TEST_CASE("Block aggregation preconditions elasticity", "[Amg]") {
+
+    CsrMatrix a = elasticity(10);
+    KrylovOptions options;
+    options.tolerance = 1.0e-8;
+    std::vector<double> b = wave(a.rows(), 0.05);
+
+    AmgOptions amg_options;
+    amg_options.block_size = 3;
+    AmgPreconditioner amg(a, amg_options);
+    for (size_t l = 0; l < amg.levels(); ++l) REQUIRE(amg.matrix(l).rows() % 3 == 0);
+
+    std::vector<double> x(a.rows(), 0.0), y(a.rows(), 0.0);
+    KrylovStats multigrid = cg(a, b, x, amg, options);
+    KrylovStats block = cg(a, b, y, BlockJacobiPreconditioner(a), options);
+    REQUIRE(multigrid.converged);
+    REQUIRE(block.converged);
+    REQUIRE(multigrid.iterations * 2 < block.iterations);
+
+}
@@ -0,0 +1,244 @@
+/*
+ * @file test_barnes_hut.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the Barnes-Hut treecode against direct summation
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "barnes_hut.hpp"
+#include "parallel.hpp"
+#include "test_lanes.hpp"
+
+static std::vector<Vector3<double>> uniform_points(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Vector3<double>> pts(n);
+    for (auto &x: pts) x = {u(rng), u(rng), u(rng)};
+    return pts;
+}
+
+static void direct(const std::vector<Vector3<double>> &pts, const std::vector<double> &q,
+                   std::vector<double> &phi, std::vector<Vector3<double>> &field) {
+    const size_t n = pts.size();
+    phi.assign(n, 0.0);
+    field.assign(n, {0.0, 0.0, 0.0});
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (i == j) continue;
+            Vector3<double> r = pts[i] - pts[j];
+            double inv = 1.0 / std::sqrt(inner(r, r));
+            phi[i] += q[j] * inv;
+            field[i] = field[i] + (q[j] * inv * inv * inv) * r;
+        }
+    }
+}
+
+/**
+ * @brief The relative 2-norm errors of the potential and the field.
+ */
+static std::pair<double, double> errors(const std::vector<double> &phi, const std::vector<Vector3<double>> &field,
+                                        const std::vector<double> &ref, const std::vector<Vector3<double>> &fref) {
+    double pn = 0.0, pd = 0.0, fn = 0.0, fd = 0.0;
+    for (size_t i = 0; i < phi.size(); ++i) {
+        pn += (phi[i] - ref[i]) * (phi[i] - ref[i]);
+        pd += ref[i] * ref[i];
+        Vector3<double> d = field[i] - fref[i];
+        fn += inner(d, d);
+        fd += inner(fref[i], fref[i]);
+    }
+    return {std::sqrt(pn / pd), std::sqrt(fn / fd)};
+}
+
+// ######################################################################### //
+// # Moments.                                                              # //
+// ######################################################################### //
+
+TEST_CASE("Barnes-Hut moments are those of the cell's charges", "[BarnesHut]") {
+
+    auto pts = uniform_points(3000, 38);
+    std::mt19937_64 rng(380);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> q(pts.size());
+    for (auto &c: q) c = u(rng);
+
+    BarnesHut bh(pts, q, {0.5, 16});
+    const auto &tree = bh.tree();
+    auto sorted = tree.points();
+    auto perm = tree.permutation();
+    for (uint32_t i: {0u, 1u, 5u, 40u}) {
+        const OctreeNode &node = tree.node(i);
+        const BarnesHutMoments &m = bh.moments(i);
+        double charge = 0.0, radius = 0.0;
+        Vector3<double> dipole{0.0, 0.0, 0.0};
+        std::array<double, 6> quad{};
+        for (uint32_t k = node.begin; k < node.end; ++k) {
+            double c = q[perm[k]];
+            Vector3<double> s = sorted[k] - m.center;
+            double a[3] = {s.x, s.y, s.z}, s2 = inner(s, s);
+            charge += c;
+            dipole = dipole + c * s;
+            radius = std::max(radius, std::sqrt(s2));
+            size_t j = 0;
+            for (size_t r = 0; r < 3; ++r) {
+                for (size_t col = r; col < 3; ++col, ++j) quad[j] += c * (3.0 * a[r] * a[col] - (r == col ? s2 : 0.0));
+            }
+        }
+        REQUIRE(m.charge == Approx(charge).margin(1.0e-10));
+        REQUIRE(m.dipole.x == Approx(dipole.x).margin(1.0e-10));
+        REQUIRE(m.dipole.y == Approx(dipole.y).margin(1.0e-10));
+        REQUIRE(m.dipole.z == Approx(dipole.z).margin(1.0e-10));
+        for (size_t j = 0; j < 6; ++j) REQUIRE(m.quadrupole[j] == Approx(quad[j]).margin(1.0e-9));
+        REQUIRE(m.quadrupole[0] + m.quadrupole[3] + m.quadrupole[5] == Approx(0.0).margin(1.0e-9));
+        // Shifted radii bound the true radius.
+        REQUIRE(m.radius >= radius - 1.0e-12);
+    }
+
+}
+
+// ######################################################################### //
+// # Evaluation.                                                           # //
+// ######################################################################### //
+
+TEST_CASE("The SIMD cell kernel agrees with the scalar lanes", "[BarnesHut]") {
+
+    std::mt19937_64 rng(381);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    detail::BarnesHutCells cells;
+    for (size_t j = 0; j < 37; ++j) {
+        BarnesHutMoments m;
+        m.center = {4.0 + u(rng), u(rng), u(rng)};
+        m.charge = u(rng);
+        m.dipole = {u(rng), u(rng), u(rng)};
+        for (auto &t: m.quadrupole) t = u(rng);
+        cells.push_back(m);
+    }
+    // An odd target count, so the padded last block is covered too.
+    const size_t nt = 21;
+    std::vector<double> tx(nt), ty(nt), tz(nt);
+    for (size_t i = 0; i < nt; ++i) {
+        tx[i] = u(rng);
+        ty[i] = u(rng);
+        tz[i] = u(rng);
+    }
+
+    for_each_simd_lanes([&](auto lanes) {
+        std::vector<double> a(4 * nt, 0.0), b(4 * nt, 0.0);
+        detail::barnes_hut_cells<decltype(lanes)>(cells, tx.data(), ty.data(), tz.data(), nt,
+                                                  a.data(), a.data() + nt, a.data() + 2 * nt, a.data() + 3 * nt);
+        detail::barnes_hut_cells<detail::P2PScalar>(cells, tx.data(), ty.data(), tz.data(), nt,
+                                                    b.data(), b.data() + nt, b.data() + 2 * nt, b.data() + 3 * nt);
+        for (size_t k = 0; k < a.size(); ++k) REQUIRE(a[k] == Approx(b[k]).epsilon(1.0e-12).margin(1.0e-12));
+    });
+
+}
+
+TEST_CASE("Barnes-Hut converges to direct summation as theta shrinks", "[BarnesHut]") {
+
+    auto pts = uniform_points(4000, 138);
+    std::mt19937_64 rng(381);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> q(pts.size());
+    for (auto &c: q) c = u(rng);
+
+    std::vector<double> ref, phi(pts.size());
+    std::vector<Vector3<double>> fref, field(pts.size());
+    direct(pts, q, ref, fref);
+
+    ThreadPool pool(3);
+    BarnesHut bh(pts, q, {0.7, 32}, pool);
+    double last = 1.0;
+    for (double theta: {0.7, 0.5, 0.3}) {
+        bh.set_theta(theta);
+        bh.evaluate(phi, field);
+        auto [ep, ef] = errors(phi, field, ref, fref);
+        REQUIRE(ep < last);
+        REQUIRE(ef < 0.05);
+        last = ep;
+    }
+    REQUIRE(last < 1.0e-3);
+
+    // theta = 0 opens every cell: a direct sum.
+    bh.set_theta(0.0);
+    bh.evaluate(phi, field);
+    auto [ep, ef] = errors(phi, field, ref, fref);
+    REQUIRE(ep < 1.0e-13);
+    REQUIRE(ef < 1.0e-13);
+
+    REQUIRE_THROWS_AS(bh.set_theta(-1.0), std::invalid_argument);
+
+}
+
+TEST_CASE("Barnes-Hut of positive masses and threads", "[BarnesHut]") {
+
+    auto pts = uniform_points(3000, 238);
+    std::vector<double> q(pts.size(), 1.0 / double(pts.size()));
+    std::vector<double> ref, a(pts.size()), b(pts.size());
+    std::vector<Vector3<double>> fref, fa(pts.size()), fb(pts.size());
+    direct(pts, q, ref, fref);
+
+    ThreadPool one(1), four(4);
+    BarnesHut serial(pts, q, {0.5, 24}, one), parallel(pts, q, {0.5, 24}, four);
+    serial.evaluate(a, fa);
+    parallel.evaluate(b, fb);
+    REQUIRE(a == b);
+    for (size_t i = 0; i < fa.size(); ++i) {
+        REQUIRE(fa[i].x == fb[i].x);
+        REQUIRE(fa[i].y == fb[i].y);
+        REQUIRE(fa[i].z == fb[i].z);
+    }
+
+    // One signed charges have no dipole about the centre of charge.
+    const BarnesHutMoments &root = serial.moments(0);
+    REQUIRE(std::abs(root.dipole.x) + std::abs(root.dipole.y) + std::abs(root.dipole.z) < 1.0e-14);
+    auto [ep, ef] = errors(a, fa, ref, fref);
+    REQUIRE(ep < 1.0e-4);
+    REQUIRE(ef < 1.0e-2);
+
+}
+
+TEST_CASE("Barnes-Hut updates for moved charges match a fresh solver", "[BarnesHut]") {
+
+    auto pts = uniform_points(3000, 338);
+    std::mt19937_64 rng(382);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> q(pts.size());
+    for (auto &c: q) c = u(rng);
+
+    BarnesHut moving(pts, q, {0.5, 24});
+    for (int step = 0; step < 3; ++step) {
+        for (auto &x: pts) x = x + Vector3<double>{1.0e-3 * u(rng), 1.0e-3 * u(rng), 1.0e-3 * u(rng)};
+        moving.update(pts);
+    }
+
+    BarnesHut fresh(pts, q, {0.5, 24});
+    std::vector<double> a(pts.size()), b(pts.size());
+    std::vector<Vector3<double>> fa(pts.size()), fb(pts.size());
+    moving.evaluate(a, fa);
+    fresh.evaluate(b, fb);
+    auto [ep, ef] = errors(a, fa, b, fb);
+    REQUIRE(ep < 1.0e-2);
+    REQUIRE(ef < 1.0e-2);
+
+    // With every cell opened, both are the same direct sum.
+    moving.set_theta(0.0);
+    fresh.set_theta(0.0);
+    moving.evaluate(a, fa);
+    fresh.evaluate(b, fb);
+    auto [dp, df] = errors(a, fa, b, fb);
+    REQUIRE(dp < 1.0e-13);
+    REQUIRE(df < 1.0e-13);
+
+    pts.pop_back();
+    REQUIRE_THROWS_AS(moving.update(pts), std::invalid_argument);
+
+}
@@ -0,0 +1,91 @@
+/*
+ * @file test_ddreal.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the double-double scalar type
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+
+#include "ddreal.hpp"
+#include "linalg.hpp"
+
+// ######################################################################### //
+// # Error free transformations.                                           # //
+// ######################################################################### //
+
+TEST_CASE("two_sum and two_prod are exact", "[DdReal]") {
+
+    double s, e;
+    two_sum(1.0, 1.0e-20, s, e);
+    REQUIRE(s == 1.0);
+    REQUIRE(e == 1.0e-20);
+
+    double p, f;
+    double a = 1.0 + std::ldexp(1.0, -30);
+    two_prod(a, a, p, f);
+    REQUIRE(p == 1.0 + std::ldexp(1.0, -29));
+    REQUIRE(f == std::ldexp(1.0, -60));
+
+}
+
+// ######################################################################### //
+// # Arithmetic.                                                           # //
+// ######################################################################### //
+
+TEST_CASE("DdReal keeps digits a double loses", "[DdReal]") {
+
+    DdReal one = 1.0;
+    DdReal tiny = 1.0e-20;
+
+    DdReal r = (one + tiny) - one;
+
+    REQUIRE(r.to_double() == 1.0e-20);
+
+}
+
+TEST_CASE("DdReal division and square root", "[DdReal]") {
+
+    DdReal third = DdReal(1.0) / DdReal(3.0);
+    DdReal err = third * DdReal(3.0) - DdReal(1.0);
+    REQUIRE(std::abs(err.to_double()) < 1.0e-31);
+
+    DdReal root2 = sqrt(DdReal(2.0));
+    DdReal err2 = root2 * root2 - DdReal(2.0);
+    REQUIRE(std::abs(err2.to_double()) < 1.0e-30);
+
+}
+
+TEST_CASE("DdReal comparisons", "[DdReal]") {
+
+    DdReal a(1.0, 1.0e-20);
+    DdReal b(1.0, 0.0);
+
+    REQUIRE(b < a);
+    REQUIRE(a > b);
+    REQUIRE(a != b);
+    REQUIRE(abs(-a) == a);
+
+}
+
+// ######################################################################### //
+// # Use with the linalg templates.                                        # //
+// ######################################################################### //
+
+TEST_CASE("Matrix3x3<DdReal> determinant of a nearly singular matrix", "[DdReal, Matrix3x3]") {
+
+    // Third row = first row + second row + 2^-60 in one entry, so the exact
+    // determinant is 2^-60 * cofactor.
+    double eps = std::ldexp(1.0, -60);
+    Matrix3x3<DdReal> m = {1.0, 2.0, 3.0,
+                           4.0, 5.0, 7.0,
+                           5.0, 7.0, 10.0};
+    m.m[2][2] = DdReal(10.0) + DdReal(eps);
+
+    // cofactor of (2,2) is 1*5 - 2*4 = -3.
+    REQUIRE(det(m).to_double() == -3.0 * eps);
+
+}
@@ -0,0 +1,213 @@
+/*
+ * @file test_dipole.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the dipole field kernels and dipole sources in the FMM
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "dipole.hpp"
+#include "fmm.hpp"
+#include "fmm_cartesian.hpp"
+#include "fmm_spherical.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tasks.hpp"
+#include "test_lanes.hpp"
+
+/**
+ * @brief Reference potential and field from the interaction tensor, in long
+ *        double.
+ */
+static void reference(const std::vector<Vector3<double>> &s, const std::vector<Vector3<double>> &m,
+                      const std::vector<Vector3<double>> &t,
+                      std::vector<long double> &phi, std::vector<Vector3<long double>> &h) {
+    phi.assign(t.size(), 0.0L);
+    h.assign(t.size(), {0.0L, 0.0L, 0.0L});
+    for (size_t i = 0; i < t.size(); ++i) {
+        for (size_t j = 0; j < s.size(); ++j) {
+            Vector3<long double> r{(long double) t[i].x - s[j].x, (long double) t[i].y - s[j].y,
+                                   (long double) t[i].z - s[j].z};
+            if (inner(r, r) == 0.0L) continue;
+            Vector3<long double> mj{m[j].x, m[j].y, m[j].z};
+            long double r2 = inner(r, r);
+            phi[i] += inner(mj, r) / (r2 * std::sqrt(r2));
+            h[i] = h[i] + dipole_tensor(r) * mj;
+        }
+    }
+}
+
+static void random_dipoles(size_t n, unsigned seed, std::vector<Vector3<double>> &pts,
+                           std::vector<Vector3<double>> &m) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    pts.resize(n);
+    m.resize(n);
+    for (auto &p: pts) p = {u(rng), u(rng), u(rng)};
+    for (auto &v: m) v = {u(rng), u(rng), u(rng)};
+}
+
+// ######################################################################### //
+// # Direct kernels.                                                       # //
+// ######################################################################### //
+
+TEST_CASE("The dipole tensor is symmetric and traceless", "[Dipole]") {
+
+    Matrix3x3<double> d = dipole_tensor(Vector3<double>{0.3, -1.2, 0.7});
+    REQUIRE(std::abs(d(0, 0) + d(1, 1) + d(2, 2)) < 1.0e-14);
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) REQUIRE(d(i, j) == d(j, i));
+    }
+
+    // On the axis of a moment the field is 2 m / r^3, across it -m / r^3.
+    Vector3<double> along = dipole_tensor(Vector3<double>{0.0, 0.0, 2.0}) * Vector3<double>{0.0, 0.0, 1.0};
+    Vector3<double> across = dipole_tensor(Vector3<double>{2.0, 0.0, 0.0}) * Vector3<double>{0.0, 0.0, 1.0};
+    REQUIRE(along.z == Approx(0.25));
+    REQUIRE(across.z == Approx(-0.125));
+
+}
+
+TEST_CASE("dipole_field matches the interaction tensor", "[Dipole]") {
+
+    std::vector<Vector3<double>> s, m, t, unused;
+    random_dipoles(1300, 41, s, m);
+    random_dipoles(203, 42, t, unused);
+
+    std::vector<long double> phi_ref;
+    std::vector<Vector3<long double>> h_ref;
+    reference(s, m, t, phi_ref, h_ref);
+
+    ThreadPool pool(3);
+    Vector3Array<double> sources(s), moments(m), targets(t), field(t.size());
+    std::vector<double> phi(t.size(), 0.0);
+    dipole_field(sources, moments, targets, phi, field, P2PMode::distinct, pool);
+
+    for (size_t i = 0; i < t.size(); ++i) {
+        Vector3<double> h = field[i];
+        const double scale = 1.0 + std::sqrt((double) inner(h_ref[i], h_ref[i]));
+        REQUIRE(std::abs(phi[i] - (double) phi_ref[i]) <= 1.0e-10 * (1.0 + std::abs((double) phi_ref[i])));
+        REQUIRE(std::abs(h.x - (double) h_ref[i].x) <= 1.0e-10 * scale);
+        REQUIRE(std::abs(h.y - (double) h_ref[i].y) <= 1.0e-10 * scale);
+        REQUIRE(std::abs(h.z - (double) h_ref[i].z) <= 1.0e-10 * scale);
+    }
+
+    Vector3Array<double> fewer(10);
+    REQUIRE_THROWS_AS(dipole_field(sources, fewer, targets, phi, field), std::invalid_argument);
+
+}
+
+TEST_CASE("The fused dipole energy matches the field", "[Dipole]") {
+
+    std::vector<Vector3<double>> p, m;
+    random_dipoles(1037, 43, p, m);
+    Vector3Array<double> points(p), moments(m), field(p.size()), fused(p.size());
+    std::vector<double> phi(p.size(), 0.0), phi_fused(p.size(), 0.0);
+
+    dipole_field(points, moments, points, phi, field, P2PMode::self);
+    const double energy = dipole_energy(m, field.to_aos());
+
+    ThreadPool one(1), three(3);
+    const double e1 = dipole_field_energy(points, moments, phi_fused, fused, one);
+    REQUIRE(e1 == Approx(energy).epsilon(1.0e-12));
+    for (size_t i = 0; i < p.size(); ++i) {
+        REQUIRE(phi_fused[i] == phi[i]);
+        REQUIRE(fused[i].x == field[i].x);
+    }
+
+    // The reduction does not depend on the thread count.
+    std::vector<double> phi3(p.size(), 0.0);
+    Vector3Array<double> field3(p.size());
+    REQUIRE(dipole_field_energy(points, moments, phi3, field3, three) == e1);
+
+    // A pair aligned head to tail attracts: E = -2 |m|^2 / r^3.
+    Vector3Array<double> pair(std::vector<Vector3<double>>{{0.0, 0.0, 0.0}, {0.0, 0.0, 2.0}});
+    Vector3Array<double> up(std::vector<Vector3<double>>{{0.0, 0.0, 1.0}, {0.0, 0.0, 1.0}});
+    std::vector<double> phi2(2, 0.0);
+    Vector3Array<double> field2(2);
+    REQUIRE(dipole_field_energy(pair, up, phi2, field2) == Approx(-0.25));
+
+}
+
+TEST_CASE("The SIMD dipole kernel agrees with the scalar lanes", "[Dipole]") {
+
+    std::vector<Vector3<double>> p, m;
+    random_dipoles(1037, 45, p, m);
+    const size_t n = p.size();
+    Vector3Array<double> points(p), moments(m);
+
+    for_each_simd_lanes([&](auto lanes) {
+        Vector3Array<double> ha(n), hb(n);
+        std::vector<double> pa(n, 0.0), pb(n, 0.0);
+        double ea = detail::dipole_tiled<decltype(lanes), true>(
+                points.x(), points.y(), points.z(), moments.x(), moments.y(), moments.z(), n,
+                points.x(), points.y(), points.z(), moments.x(), moments.y(), moments.z(), n,
+                pa.data(), ha.x(), ha.y(), ha.z());
+        double eb = detail::dipole_tiled<detail::P2PScalar, true>(
+                points.x(), points.y(), points.z(), moments.x(), moments.y(), moments.z(), n,
+                points.x(), points.y(), points.z(), moments.x(), moments.y(), moments.z(), n,
+                pb.data(), hb.x(), hb.y(), hb.z());
+        REQUIRE(ea == Approx(eb).epsilon(1.0e-11));
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(pa[i] == Approx(pb[i]).epsilon(1.0e-11).margin(1.0e-9));
+            REQUIRE(ha[i].x == Approx(hb[i].x).epsilon(1.0e-11).margin(1.0e-9));
+            REQUIRE(ha[i].y == Approx(hb[i].y).epsilon(1.0e-11).margin(1.0e-9));
+            REQUIRE(ha[i].z == Approx(hb[i].z).epsilon(1.0e-11).margin(1.0e-9));
+        }
+    });
+
+}
+
+// ######################################################################### //
+// # FMM.                                                                  # //
+// ######################################################################### //
+
+template <typename Ops>
+static void check_fmm(const Ops &ops, double tolerance) {
+    std::vector<Vector3<double>> p, m;
+    random_dipoles(4000, 44, p, m);
+    ThreadPool pool(2);
+    TaskPool tasks(2);
+
+    Vector3Array<double> points(p), moments(m), ref(p.size());
+    std::vector<double> phi_ref(p.size(), 0.0);
+    dipole_field(points, moments, points, phi_ref, ref, P2PMode::self, pool);
+
+    std::vector<double> charges(p.size(), 0.0);
+    Fmm<Ops> fmm(ops, p, charges, {0.5, 32}, pool, tasks);
+    fmm.use_dipoles(m);
+    std::vector<double> phi(p.size());
+    std::vector<Vector3<double>> field(p.size());
+    fmm.evaluate(phi, field);
+
+    double num = 0.0, den = 0.0, fnum = 0.0, fden = 0.0;
+    for (size_t i = 0; i < p.size(); ++i) {
+        num += (phi[i] - phi_ref[i]) * (phi[i] - phi_ref[i]);
+        den += phi_ref[i] * phi_ref[i];
+        Vector3<double> d = field[i] - ref[i];
+        fnum += inner(d, d);
+        fden += inner(ref[i], ref[i]);
+    }
+    REQUIRE(std::sqrt(num / den) < tolerance);
+    REQUIRE(std::sqrt(fnum / fden) < tolerance);
+
+    // An empty span restores the (zero) charges.
+    fmm.use_dipoles({});
+    fmm.evaluate(phi, field);
+    REQUIRE(phi[0] == 0.0);
+    REQUIRE_THROWS_AS(fmm.use_dipoles(std::vector<Vector3<double>>(3)), std::invalid_argument);
+}
+
+TEST_CASE("Fmm with dipole sources matches direct summation", "[Dipole]") {
+
+    check_fmm(SphericalOperators(10), 1.0e-5);
+    check_fmm(CartesianOperators<6>(), 1.0e-3);
+
+}
@@ -0,0 +1,183 @@
+/*
+ * @file test_fem_assembly.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test element colouring and parallel FEM assembly
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "fem_assembly.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "sparse.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+/**
+ * @brief Serial dense assembly, the reference.
+ */
+template <typename Element>
+static std::vector<double> dense_assembly(const TetMesh &mesh, size_t d, Element &&element) {
+    const size_t n = mesh.node_count() * d, l = 4 * d;
+    std::vector<double> a(n * n, 0.0), ke(l * l);
+    for (size_t e = 0; e < mesh.element_count(); ++e) {
+        std::fill(ke.begin(), ke.end(), 0.0);
+        element(e, ke.data());
+        auto v = mesh.element(e);
+        for (size_t p = 0; p < 4; ++p) {
+            for (size_t i = 0; i < d; ++i) {
+                for (size_t q = 0; q < 4; ++q) {
+                    for (size_t j = 0; j < d; ++j) {
+                        a[(v[p] * d + i) * n + v[q] * d + j] += ke[(p * d + i) * l + q * d + j];
+                    }
+                }
+            }
+        }
+    }
+    return a;
+}
+
+static void check_against_dense(const CsrMatrix &a, const std::vector<double> &dense) {
+    const size_t n = a.rows();
+    double scale = 0.0;
+    for (double v: dense) scale = std::max(scale, std::abs(v));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) REQUIRE(std::abs(a(i, j) - dense[i * n + j]) <= 1.0e-13 * scale);
+    }
+}
+
+// ######################################################################### //
+// # Colouring.                                                            # //
+// ######################################################################### //
+
+TEST_CASE("No two blocks of a colour share a node", "[FemAssembly]") {
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(8, 1.0, nodes, elements);
+    jitter_cube_nodes(8, 1.0, 43, nodes);
+    TetMesh mesh(nodes, elements);
+
+    for (size_t block_size: {size_t(1), size_t(5), size_t(64)}) {
+        ElementColoring coloring = color_elements(mesh, block_size);
+        REQUIRE(coloring.block_size == block_size);
+        REQUIRE(coloring.colors() > 1);
+        REQUIRE(coloring.colors() < 64);
+
+        std::vector<size_t> seen(mesh.element_count(), 0);
+        std::vector<size_t> owner(mesh.node_count());
+        for (size_t c = 0; c < coloring.colors(); ++c) {
+            std::fill(owner.begin(), owner.end(), size_t(-1));
+            auto color = coloring.color(c);
+            for (size_t k = 0; k < color.size(); ++k) {
+                if (k > 0) REQUIRE(color[k - 1] < color[k]);
+                auto [first, last] = coloring.block(color[k]);
+                for (size_t e = first; e < last; ++e) {
+                    ++seen[e];
+                    for (uint32_t v: mesh.element(e)) {
+                        REQUIRE((owner[v] == size_t(-1) || owner[v] == color[k]));
+                        owner[v] = color[k];
+                    }
+                }
+            }
+        }
+        for (size_t s: seen) REQUIRE(s == 1);
+    }
+    REQUIRE_THROWS_AS(color_elements(mesh, 0), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # Assembly.                                                             # //
+// ######################################################################### //
+
+TEST_CASE("Colour assembly matches serial assembly", "[FemAssembly]") {
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(4, 1.0, nodes, elements);
+    jitter_cube_nodes(4, 1.0, 43, nodes);
+    ThreadPool pool(3);
+    TetMesh mesh(nodes, elements, pool);
+    auto volumes = mesh.volumes();
+    auto gradients = mesh.gradients();
+
+    // A scalar Laplacian: symmetric, with constants in its kernel.
+    FemAssembler scalar(mesh, 1, pool);
+    auto laplace = [&](size_t e, double *ke) { laplace_element(volumes[e], gradients[e], ke); };
+    CsrMatrix k = scalar.matrix();
+    scalar.assemble(k, laplace);
+    check_against_dense(k, dense_assembly(mesh, 1, laplace));
+    for (size_t i = 0; i < k.rows(); ++i) {
+        double sum = 0.0;
+        for (size_t p = k.row_ptr()[i]; p < k.row_ptr()[i + 1]; ++p) sum += k.values()[p];
+        REQUIRE(std::abs(sum) < 1.0e-12);
+    }
+
+    // Linear elasticity, 12 x 12 element blocks: translations are in the
+    // kernel.
+    FemAssembler vector(mesh, 3, pool);
+    auto elasticity = [&](size_t e, double *ke) { elasticity_element(volumes[e], gradients[e], 1.5, 0.7, ke); };
+    CsrMatrix a = vector.matrix();
+    vector.assemble(a, elasticity);
+    check_against_dense(a, dense_assembly(mesh, 3, elasticity));
+    for (size_t i = 0; i < a.rows(); ++i) {
+        double sum[3] = {0.0, 0.0, 0.0};
+        for (size_t p = a.row_ptr()[i]; p < a.row_ptr()[i + 1]; ++p) sum[a.col_idx()[p] % 3] += a.values()[p];
+        for (double s: sum) REQUIRE(std::abs(s) < 1.0e-12);
+    }
+
+    // A load vector: the shape functions of each element integrate to V / 4.
+    std::vector<double> b(scalar.size());
+    scalar.assemble_vector(b, [&](size_t e, double *fe) {
+        for (size_t p = 0; p < 4; ++p) fe[p] = 0.25 * volumes[e];
+    });
+    double total = 0.0;
+    for (double v: b) total += v;
+    REQUIRE(total == Approx(1.0));
+
+    REQUIRE_THROWS_AS(vector.assemble(k, elasticity), std::invalid_argument);
+    REQUIRE_THROWS_AS(FemAssembler(mesh, 0), std::invalid_argument);
+
+}
+
+TEST_CASE("Re-assembly reuses the pattern and is deterministic", "[FemAssembly]") {
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(6, 1.0, nodes, elements);
+    jitter_cube_nodes(6, 1.0, 43, nodes);
+    ThreadPool one(1), three(3);
+    TetMesh mesh(nodes, elements, three);
+
+    FemAssembler serial(mesh, 1, one), parallel(mesh, 1, three);
+    auto mass = [&](size_t e, double *ke) { mass_element(mesh.volumes()[e], ke); };
+    CsrMatrix m1 = serial.matrix(), m3 = parallel.matrix();
+    serial.assemble(m1, mass);
+    parallel.assemble(m3, mass);
+    REQUIRE(std::equal(m1.values().begin(), m1.values().end(), m3.values().begin()));
+
+    // The mass matrix integrates 1 * 1 over the cube.
+    double total = 0.0;
+    for (double v: m3.values()) total += v;
+    REQUIRE(total == Approx(1.0));
+
+    // After the nodes move, the same matrix takes the new values.
+    std::vector<Vector3<double>> stretch(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) stretch[i] = {nodes[i].x, 0.0, 0.0};
+    mesh.move_nodes(stretch);
+    const double *before = m3.values().data();
+    parallel.assemble(m3, mass);
+    REQUIRE(m3.values().data() == before);
+    total = 0.0;
+    for (double v: m3.values()) total += v;
+    REQUIRE(total == Approx(2.0));
+
+}
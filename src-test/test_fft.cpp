@@ -0,0 +1,133 @@
+/*
+ * @file test_fft.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the mixed radix FFT against the direct discrete transform
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "fft.hpp"
+
+using Complex = std::complex<double>;
+
+/**
+ * @brief The direct O(n^2) transform of x, with sign -1 (forward) or +1.
+ */
+static std::vector<Complex> dft(const std::vector<Complex> &x, double sign) {
+    const size_t n = x.size();
+    std::vector<Complex> y(n);
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t j = 0; j < n; ++j) {
+            y[k] += x[j] * std::polar(1.0, sign * 2.0 * std::numbers::pi * double(j * k % n) / double(n));
+        }
+    }
+    return y;
+}
+
+static std::vector<Complex> random_vector(size_t n, std::mt19937_64 &rng) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Complex> x(n);
+    for (auto &c: x) c = {u(rng), u(rng)};
+    return x;
+}
+
+static double max_diff(const std::vector<Complex> &a, const std::vector<Complex> &b) {
+    double d = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) d = std::max(d, std::abs(a[i] - b[i]));
+    return d;
+}
+
+// ######################################################################### //
+// # One dimension.                                                        # //
+// ######################################################################### //
+
+TEST_CASE("Fft matches the direct transform for mixed radix lengths", "[Fft]") {
+
+    std::mt19937_64 rng(37);
+    for (size_t n = 1; n <= 64; ++n) {
+        Fft fft(n);
+        REQUIRE(fft.size() == n);
+        auto x = random_vector(n, rng);
+
+        auto y = x;
+        fft.forward(y.data());
+        REQUIRE(max_diff(y, dft(x, -1.0)) < 1.0e-13 * double(n));
+
+        auto z = x;
+        fft.inverse(z.data());
+        REQUIRE(max_diff(z, dft(x, 1.0)) < 1.0e-13 * double(n));
+
+        fft.inverse(y.data());
+        for (auto &c: y) c /= double(n);
+        REQUIRE(max_diff(y, x) < 1.0e-14 * double(n));
+    }
+
+    // Strided data, and a length with a large prime factor.
+    Fft fft(97);
+    auto x = random_vector(97, rng);
+    std::vector<Complex> strided(3 * 97);
+    for (size_t i = 0; i < 97; ++i) strided[3 * i] = x[i];
+    fft.forward(strided.data(), 3);
+    auto y = dft(x, -1.0);
+    for (size_t i = 0; i < 97; ++i) REQUIRE(std::abs(strided[3 * i] - y[i]) < 1.0e-11);
+
+    REQUIRE_THROWS_AS(Fft(0), std::invalid_argument);
+
+}
+
+TEST_CASE("fft_size rounds up to 5-smooth lengths", "[Fft]") {
+
+    REQUIRE(fft_size(0) == 1);
+    REQUIRE(fft_size(1) == 1);
+    REQUIRE(fft_size(7) == 8);
+    REQUIRE(fft_size(17) == 18);
+    REQUIRE(fft_size(25) == 25);
+    REQUIRE(fft_size(33) == 36);
+    REQUIRE(fft_size(49) == 50);
+
+}
+
+// ######################################################################### //
+// # Two dimensions.                                                       # //
+// ######################################################################### //
+
+TEST_CASE("Fft2d matches row then column direct transforms", "[Fft]") {
+
+    std::mt19937_64 rng(38);
+    const size_t rows = 18, cols = 25;
+    Fft2d fft(rows, cols);
+    REQUIRE(fft.size() == rows * cols);
+    auto x = random_vector(rows * cols, rng);
+
+    std::vector<Complex> expected(x);
+    for (size_t i = 0; i < rows; ++i) {
+        std::vector<Complex> row(expected.begin() + i * cols, expected.begin() + (i + 1) * cols);
+        row = dft(row, -1.0);
+        std::copy(row.begin(), row.end(), expected.begin() + i * cols);
+    }
+    for (size_t j = 0; j < cols; ++j) {
+        std::vector<Complex> col(rows);
+        for (size_t i = 0; i < rows; ++i) col[i] = expected[i * cols + j];
+        col = dft(col, -1.0);
+        for (size_t i = 0; i < rows; ++i) expected[i * cols + j] = col[i];
+    }
+
+    auto y = x;
+    fft.forward(y.data());
+    REQUIRE(max_diff(y, expected) < 1.0e-11);
+
+    fft.inverse(y.data());
+    for (auto &c: y) c /= double(rows * cols);
+    REQUIRE(max_diff(y, x) < 1.0e-13);
+
+}
@@ -0,0 +1,132 @@
+/*
+ * @file test_fft_m2l.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test FFT based M2L against the direct translation on a uniform tree
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "fft_m2l.hpp"
+#include "fmm_spherical.hpp"
+#include "octree.hpp"
+#include "parallel.hpp"
+
+static std::vector<Vector3<double>> uniform_points(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Vector3<double>> pts(n);
+    for (auto &x: pts) x = {u(rng), u(rng), u(rng)};
+    return pts;
+}
+
+/**
+ * @brief The potentials at the points of every node of a level from the
+ *        nodes' local expansions.
+ */
+static std::vector<double> potentials(const SphericalOperators &ops, const LinearOctree<double> &tree,
+                                      size_t level, const std::vector<Complex> &local) {
+    std::vector<double> phi(tree.points().size(), 0.0);
+    std::vector<Vector3<double>> field(tree.points().size());
+    auto [lb, le] = tree.level_range(level);
+    for (size_t i = lb; i < le; ++i) {
+        const OctreeNode &node = tree.node(i);
+        ops.l2p(local.data() + i * ops.size(), tree.center(i), tree.points().subspan(node.begin, node.size()),
+                std::span<double>(phi).subspan(node.begin, node.size()),
+                std::span<Vector3<double>>(field).subspan(node.begin, node.size()));
+    }
+    return phi;
+}
+
+// ######################################################################### //
+// # Interaction lists.                                                    # //
+// ######################################################################### //
+
+TEST_CASE("uniform_interaction_list is the classic symmetric list", "[FftM2L]") {
+
+    auto pts = uniform_points(40000, 39);
+    LinearOctree<double> tree(pts, 16);
+    REQUIRE(tree.depth() > 3);
+    auto [lb, le] = tree.level_range(3);
+    REQUIRE(le - lb == 512);
+
+    std::vector<std::vector<uint32_t>> lists(tree.nodes().size());
+    for (size_t t = lb; t < le; ++t) {
+        uniform_interaction_list(tree, uint32_t(t), [&](uint32_t s, int cx, int cy, int cz) {
+            REQUIRE(std::max({std::abs(cx), std::abs(cy), std::abs(cz)}) >= 2);
+            REQUIRE(std::max({std::abs(cx), std::abs(cy), std::abs(cz)}) <= FftM2L::REACH);
+            Vector3<double> d = tree.center(t) - tree.center(s);
+            REQUIRE(std::abs(d.x - cx * tree.cell_size(3)) < 1.0e-12);
+            REQUIRE(std::abs(d.z - cz * tree.cell_size(3)) < 1.0e-12);
+            lists[t].push_back(s);
+        });
+    }
+
+    // 189 sources for an interior cell, and the relation is symmetric.
+    size_t largest = 0;
+    for (size_t t = lb; t < le; ++t) {
+        largest = std::max(largest, lists[t].size());
+        for (uint32_t s: lists[t]) REQUIRE(std::count(lists[s].begin(), lists[s].end(), uint32_t(t)) == 1);
+    }
+    REQUIRE(largest == 189);
+
+}
+
+// ######################################################################### //
+// # Translation.                                                          # //
+// ######################################################################### //
+
+TEST_CASE("FftM2L matches direct M2L on a uniform tree", "[FftM2L]") {
+
+    auto pts = uniform_points(20000, 40);
+    std::mt19937_64 rng(41);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    LinearOctree<double> tree(pts, 16);
+    std::vector<double> charges(pts.size());
+    for (auto &q: charges) q = u(rng);
+
+    for (size_t p: {4, 8, 12}) {
+        SphericalOperators ops(p, false);
+        FftM2L fft(p);
+        REQUIRE(fft.rows() >= 2 * p + 1);
+        REQUIRE(fft.cols() >= 3 * p + 1);
+
+        const size_t level = 3, n = ops.size();
+        std::vector<Complex> multipole(tree.nodes().size() * n), direct(multipole.size()), fast(multipole.size());
+        auto [lb, le] = tree.level_range(level);
+        for (size_t i = lb; i < le; ++i) {
+            const OctreeNode &node = tree.node(i);
+            ops.p2m(tree.center(i), tree.points().subspan(node.begin, node.size()),
+                    std::span<const double>(charges).subspan(node.begin, node.size()), multipole.data() + i * n);
+        }
+        for (size_t t = lb; t < le; ++t) {
+            uniform_interaction_list(tree, uint32_t(t), [&](uint32_t s, int, int, int) {
+                ops.m2l_direct(multipole.data() + s * n, tree.center(s), tree.center(t), direct.data() + t * n);
+            });
+        }
+        fft.translate_level(tree, level, multipole.data(), fast.data());
+
+        auto a = potentials(ops, tree, level, direct), b = potentials(ops, tree, level, fast);
+        double scale = 0.0, diff = 0.0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            scale = std::max(scale, std::abs(a[i]));
+            diff = std::max(diff, std::abs(a[i] - b[i]));
+        }
+        REQUIRE(diff <= 1.0e-12 * scale);
+
+        // Results do not depend on the number of threads.
+        ThreadPool one(1);
+        std::vector<Complex> serial(multipole.size());
+        fft.translate_level(tree, level, multipole.data(), serial.data(), one);
+        REQUIRE(serial == fast);
+    }
+
+}
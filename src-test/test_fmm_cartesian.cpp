@@ -0,0 +1,215 @@
+/*
+ * @file test_fmm_cartesian.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the Cartesian Taylor expansion operators
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "fmm.hpp"
+#include "fmm_cartesian.hpp"
+#include "fmm_spherical.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief The potential and field of charges at x, by direct summation.
+ */
+static void direct(const std::vector<Vector3<double>> &s, const std::vector<double> &q, const Vector3<double> &x,
+                   double &phi, Vector3<double> &field) {
+    phi = 0.0;
+    field = {0.0, 0.0, 0.0};
+    for (size_t j = 0; j < s.size(); ++j) {
+        Vector3<double> d = x - s[j];
+        double r2 = inner(d, d);
+        if (r2 == 0.0) continue;
+        double r = std::sqrt(r2);
+        phi += q[j] / r;
+        field = field + (q[j] / (r2 * r)) * d;
+    }
+}
+
+/**
+ * @brief The relative error of the potential and field at x after the chain
+ *        P2M, M2M, M2L, L2L, L2P with order P operators.
+ */
+template <size_t P>
+static void chain_error(const std::vector<Vector3<double>> &s, const std::vector<double> &q,
+                        const Vector3<double> &x, double &err, double &ferr) {
+    const Vector3<double> cs{0.1, 0.2, -0.1}, cp{0.35, 0.45, 0.15}, ct{3.0, -1.9, 2.2}, cc{3.2, -1.8, 2.0};
+    CartesianOperators<P> ops;
+    std::vector<double> m(ops.size()), mp(ops.size()), l(ops.size()), lc(ops.size());
+    ops.p2m(cs, s, q, m.data());
+    ops.m2m(m.data(), cs, cp, mp.data());
+    ops.m2l(mp.data(), cp, ct, l.data());
+    ops.l2l(l.data(), ct, cc, lc.data());
+
+    double phi = 0.0;
+    Vector3<double> f{0.0, 0.0, 0.0};
+    ops.l2p(lc.data(), cc, std::span<const Vector3<double>>(&x, 1), std::span<double>(&phi, 1),
+            std::span<Vector3<double>>(&f, 1));
+
+    double ref;
+    Vector3<double> fref;
+    direct(s, q, x, ref, fref);
+    err = std::abs(phi - ref) / std::abs(ref);
+    Vector3<double> df = f - fref;
+    ferr = std::sqrt(inner(df, df) / inner(fref, fref));
+}
+
+// ######################################################################### //
+// # Tensors.                                                              # //
+// ######################################################################### //
+
+TEST_CASE("Packed multi-indices enumerate every degree once", "[Cartesian]") {
+
+    using Tables = detail::CartesianTables<7>;
+    REQUIRE(Tables::size == 120);
+    REQUIRE(cart_size(0) == 1);
+    for (size_t k = 0; k < Tables::size; ++k) {
+        const CartesianIndex &a = Tables::indices[k];
+        REQUIRE(cart_index(a) == k);
+        if (k > 0) REQUIRE(a.degree() >= Tables::indices[k - 1].degree());
+    }
+
+}
+
+TEST_CASE("Derivative tensors of 1/|r| are exact and trace free", "[Cartesian]") {
+
+    constexpr size_t P = 8;
+    const Vector3<double> r{0.7, -1.1, 0.4};
+    const double x = r.x, y = r.y, z = r.z, r2 = inner(r, r), rn = std::sqrt(r2);
+    std::vector<double> d(cart_size(P));
+    cart_derivatives<P>(r, d.data());
+
+    REQUIRE(d[cart_index(0, 0, 0)] == Approx(1.0 / rn));
+    REQUIRE(d[cart_index(1, 0, 0)] == Approx(-x / (r2 * rn)));
+    REQUIRE(d[cart_index(0, 2, 0)] == Approx(3.0 * y * y / (r2 * r2 * rn) - 1.0 / (r2 * rn)));
+    REQUIRE(d[cart_index(1, 1, 1)] == Approx(-15.0 * x * y * z / (r2 * r2 * r2 * rn)));
+
+    // 1/|r| is harmonic, so every derivative is too.
+    for (size_t k = 0; k < cart_size(P - 2); ++k) {
+        const CartesianIndex &a = detail::CartesianTables<P>::indices[k];
+        double trace = d[cart_index(a.x + 2, a.y, a.z)] + d[cart_index(a.x, a.y + 2, a.z)]
+                       + d[cart_index(a.x, a.y, a.z + 2)];
+        double scale = std::abs(d[cart_index(a.x + 2, a.y, a.z)]) + std::abs(d[cart_index(a.x, a.y + 2, a.z)])
+                       + std::abs(d[cart_index(a.x, a.y, a.z + 2)]);
+        REQUIRE(std::abs(trace) <= 1.0e-12 * scale);
+    }
+
+    // Central differences of the order P - 1 tensor.
+    std::vector<double> dp(cart_size(P)), dm(cart_size(P));
+    const double h = 1.0e-5;
+    cart_derivatives<P>(r + Vector3<double>{0.0, 0.0, h}, dp.data());
+    cart_derivatives<P>(r - Vector3<double>{0.0, 0.0, h}, dm.data());
+    for (size_t k = 0; k < cart_size(P - 1); ++k) {
+        const CartesianIndex &a = detail::CartesianTables<P>::indices[k];
+        double fd = (dp[k] - dm[k]) / (2.0 * h);
+        REQUIRE(fd == Approx(d[cart_index(a.x, a.y, a.z + 1)]).epsilon(1.0e-6).margin(1.0e-6));
+    }
+
+}
+
+// ######################################################################### //
+// # Operators.                                                            # //
+// ######################################################################### //
+
+TEST_CASE("The Cartesian operator chain converges with the order", "[Cartesian]") {
+
+    std::mt19937_64 rng(36);
+    std::uniform_real_distribution<double> u(-0.25, 0.25);
+    std::vector<Vector3<double>> s(40);
+    std::vector<double> q(40);
+    for (auto &x: s) x = Vector3<double>{0.1, 0.2, -0.1} + Vector3<double>{u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+    const Vector3<double> x{3.15, -1.75, 2.05};
+
+    double e2, f2, e4, f4, e6, f6;
+    chain_error<2>(s, q, x, e2, f2);
+    chain_error<4>(s, q, x, e4, f4);
+    chain_error<6>(s, q, x, e6, f6);
+    REQUIRE(e4 < e2);
+    REQUIRE(e6 < e4);
+    REQUIRE(f4 < f2);
+    REQUIRE(f6 < f4);
+    REQUIRE(e6 < 1.0e-5);
+
+}
+
+TEST_CASE("Cartesian and spherical M2L agree", "[Cartesian]") {
+
+    // Compare through the potential of the translated expansion near the
+    // target centre, where both truncations are accurate.
+    std::mt19937_64 rng(37);
+    std::uniform_real_distribution<double> u(-0.2, 0.2);
+    std::vector<Vector3<double>> s(20);
+    std::vector<double> q(20);
+    for (auto &x: s) x = {u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+    const Vector3<double> ct{4.0, 3.0, -5.0}, x = ct + Vector3<double>{0.05, -0.1, 0.08};
+
+    CartesianOperators<6> cart;
+    SphericalOperators sph(6);
+    std::vector<double> cm(cart.size()), cl(cart.size());
+    std::vector<Complex> sm(sph.size()), sl(sph.size());
+    cart.p2m({0, 0, 0}, s, q, cm.data());
+    cart.m2l(cm.data(), {0, 0, 0}, ct, cl.data());
+    sph.p2m({0, 0, 0}, s, q, sm.data());
+    sph.m2l(sm.data(), {0, 0, 0}, ct, sl.data());
+
+    double a = 0.0, b = 0.0;
+    Vector3<double> fa{0, 0, 0}, fb{0, 0, 0};
+    cart.l2p(cl.data(), ct, std::span<const Vector3<double>>(&x, 1), std::span<double>(&a, 1),
+             std::span<Vector3<double>>(&fa, 1));
+    sph.l2p(sl.data(), ct, std::span<const Vector3<double>>(&x, 1), std::span<double>(&b, 1),
+            std::span<Vector3<double>>(&fb, 1));
+    REQUIRE(a == Approx(b).epsilon(1.0e-9));
+    REQUIRE(fa.x == Approx(fb.x).epsilon(1.0e-7));
+    REQUIRE(fa.y == Approx(fb.y).epsilon(1.0e-7));
+    REQUIRE(fa.z == Approx(fb.z).epsilon(1.0e-7));
+
+}
+
+// ######################################################################### //
+// # FMM.                                                                  # //
+// ######################################################################### //
+
+TEST_CASE("Fmm with Cartesian operators matches direct summation", "[Fmm]") {
+
+    std::mt19937_64 rng(38);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 3000;
+    std::vector<Vector3<double>> pts(n);
+    std::vector<double> q(n);
+    for (auto &x: pts) x = {u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+
+    ThreadPool pool(3);
+    Fmm<CartesianOperators<6>> fmm(CartesianOperators<6>(), pts, q, {0.5, 32}, pool);
+    REQUIRE(fmm.m2l_count() > 0);
+
+    std::vector<double> phi(n);
+    std::vector<Vector3<double>> field(n);
+    fmm.evaluate(phi, field);
+
+    double num = 0.0, den = 0.0, fnum = 0.0, fden = 0.0;
+    for (size_t i = 0; i < n; i += 7) {
+        double ref;
+        Vector3<double> fref;
+        direct(pts, q, pts[i], ref, fref);
+        num += (phi[i] - ref) * (phi[i] - ref);
+        den += ref * ref;
+        Vector3<double> d = field[i] - fref;
+        fnum += inner(d, d);
+        fden += inner(fref, fref);
+    }
+    REQUIRE(std::sqrt(num / den) < 1.0e-4);
+    REQUIRE(std::sqrt(fnum / fden) < 1.0e-3);
+
+}
@@ -0,0 +1,182 @@
+/*
+ * @file test_fmm_periodic.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the FMM in a periodic box against direct image sums
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "fmm.hpp"
+#include "fmm_cartesian.hpp"
+#include "fmm_spherical.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "tasks.hpp"
+
+/**
+ * @brief Neutral random charges in the box [-0.5, 1.5)^3.
+ */
+static void neutral_charges(size_t n, unsigned seed, std::vector<Vector3<double>> &pts, std::vector<double> &q) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-0.5, 1.5), c(-1.0, 1.0);
+    pts.resize(n);
+    q.resize(n);
+    for (auto &x: pts) x = {u(rng), u(rng), u(rng)};
+    for (auto &v: q) v = c(rng);
+    double mean = 0.0;
+    for (double v: q) mean += v;
+    mean /= double(n);
+    for (double &v: q) v -= mean;
+}
+
+/**
+ * @brief The potential and field of the charges and their images n size,
+ *        |n|_inf <= shells, by direct summation.
+ */
+static void direct_images(const std::vector<Vector3<double>> &s, const std::vector<double> &q, double size,
+                          int shells, std::vector<double> &phi, std::vector<Vector3<double>> &field) {
+    phi.assign(s.size(), 0.0);
+    field.assign(s.size(), {0.0, 0.0, 0.0});
+    for (size_t i = 0; i < s.size(); ++i) {
+        for (int x = -shells; x <= shells; ++x) {
+            for (int y = -shells; y <= shells; ++y) {
+                for (int z = -shells; z <= shells; ++z) {
+                    const Vector3<double> shift{size * x, size * y, size * z};
+                    for (size_t j = 0; j < s.size(); ++j) {
+                        Vector3<double> d = s[i] - s[j] - shift;
+                        double r2 = inner(d, d);
+                        if (r2 == 0.0) continue;
+                        double r = std::sqrt(r2);
+                        phi[i] += q[j] / r;
+                        field[i] = field[i] + (q[j] / (r2 * r)) * d;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static double relative_error(const std::vector<double> &a, const std::vector<double> &ref) {
+    double num = 0.0, den = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        num += (a[i] - ref[i]) * (a[i] - ref[i]);
+        den += ref[i] * ref[i];
+    }
+    return std::sqrt(num / den);
+}
+
+static double relative_error(const std::vector<Vector3<double>> &a, const std::vector<Vector3<double>> &ref) {
+    double num = 0.0, den = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        Vector3<double> d = a[i] - ref[i];
+        num += inner(d, d);
+        den += inner(ref[i], ref[i]);
+    }
+    return std::sqrt(num / den);
+}
+
+/**
+ * @brief Compares a lattice M2L kernel of two translations with the sum of
+ *        the two M2Ls.
+ */
+template <typename Ops>
+static void check_kernel(const Ops &ops) {
+    std::mt19937_64 rng(40);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<typename Ops::Coefficient> m(ops.size());
+    for (auto &c: m) c = u(rng);
+    const Vector3<double> a{4.0, -1.0, 2.5}, b{-3.0, 0.0, -6.0};
+
+    std::vector<typename Ops::Coefficient> ref(ops.size()), l(ops.size());
+    ops.m2l(m.data(), {0.0, 0.0, 0.0}, a, ref.data());
+    ops.m2l(m.data(), {0.0, 0.0, 0.0}, b, ref.data());
+    std::vector<double> kernel(ops.m2l_kernel_size(), 0.0);
+    ops.add_m2l_kernel(a, kernel.data());
+    ops.add_m2l_kernel(b, kernel.data());
+    ops.m2l_kernel_apply(kernel.data(), m.data(), l.data());
+
+    double scale = 0.0;
+    for (auto &c: ref) scale = std::max(scale, std::abs(c));
+    for (size_t k = 0; k < ref.size(); ++k) REQUIRE(std::abs(l[k] - ref[k]) <= 1.0e-13 * scale);
+}
+
+// ######################################################################### //
+// # Lattice kernels.                                                      # //
+// ######################################################################### //
+
+TEST_CASE("Summed M2L kernels apply the sum of their translations", "[FmmPeriodic]") {
+
+    check_kernel(SphericalOperators(8));
+    check_kernel(CartesianOperators<5>());
+
+}
+
+// ######################################################################### //
+// # Periodic FMM.                                                         # //
+// ######################################################################### //
+
+TEST_CASE("Periodic FMM matches direct image sums", "[FmmPeriodic]") {
+
+    std::vector<Vector3<double>> pts;
+    std::vector<double> q;
+    neutral_charges(300, 41, pts, q);
+    ThreadPool pool(2);
+    TaskPool tasks(2);
+    const PeriodicBox box{{-0.5, -0.5, -0.5}, 2.0, 4};
+
+    std::vector<double> ref;
+    std::vector<Vector3<double>> fref;
+    direct_images(pts, q, box.size, int(box.shells), ref, fref);
+
+    std::vector<double> phi(pts.size());
+    std::vector<Vector3<double>> field(pts.size());
+
+    Fmm<SphericalOperators> sph(SphericalOperators(10), pts, q, box, {0.5, 16}, pool, tasks);
+    sph.evaluate(phi, field);
+    REQUIRE(relative_error(phi, ref) < 1.0e-5);
+    REQUIRE(relative_error(field, fref) < 1.0e-5);
+
+    Fmm<CartesianOperators<6>> cart(CartesianOperators<6>(), pts, q, box, {0.5, 16}, pool, tasks);
+    cart.evaluate(phi, field);
+    REQUIRE(relative_error(phi, ref) < 1.0e-3);
+    REQUIRE(relative_error(field, fref) < 1.0e-3);
+
+    // Without a lattice: every image is in the tree.
+    const PeriodicBox near{box.min, box.size, 1};
+    direct_images(pts, q, near.size, 1, ref, fref);
+    Fmm<SphericalOperators> one(SphericalOperators(10), pts, q, near, {0.5, 16}, pool, tasks);
+    one.evaluate(phi, field);
+    REQUIRE(relative_error(phi, ref) < 1.0e-5);
+    REQUIRE(relative_error(field, fref) < 1.0e-5);
+
+    // The schedules agree bitwise with images too.
+    std::vector<double> phases(pts.size());
+    Fmm<SphericalOperators> scheduled(SphericalOperators(10), pts, q, box, {0.5, 16, FmmSchedule::phases}, pool,
+                                      tasks);
+    scheduled.evaluate(phases, field);
+    sph.evaluate(phi, field);
+    REQUIRE(phases == phi);
+
+}
+
+TEST_CASE("Periodic FMM rejects points outside the box", "[FmmPeriodic]") {
+
+    std::vector<Vector3<double>> pts = {{0.25, 0.25, 0.25}, {1.0, 0.5, 0.5}};
+    std::vector<double> q = {1.0, -1.0};
+    const PeriodicBox box{{0.0, 0.0, 0.0}, 1.0, 2};
+    REQUIRE_THROWS_AS(Fmm<SphericalOperators>(SphericalOperators(4), pts, q, box), std::invalid_argument);
+    pts[1] = {0.75, 0.5, 0.5};
+    REQUIRE_NOTHROW(Fmm<SphericalOperators>(SphericalOperators(4), pts, q, box));
+    REQUIRE_THROWS_AS(Fmm<SphericalOperators>(SphericalOperators(4), pts, q, PeriodicBox{{0.0, 0.0, 0.0}, 0.0, 2}),
+                      std::invalid_argument);
+
+}
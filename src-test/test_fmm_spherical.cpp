@@ -0,0 +1,229 @@
+/*
+ * @file test_fmm_spherical.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the solid harmonic expansion operators and the FMM driver
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "fmm.hpp"
+#include "fmm_spherical.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief The potential and field of charges at x, by direct summation.
+ */
+static void direct(const std::vector<Vector3<double>> &s, const std::vector<double> &q, const Vector3<double> &x,
+                   double &phi, Vector3<double> &field) {
+    phi = 0.0;
+    field = {0.0, 0.0, 0.0};
+    for (size_t j = 0; j < s.size(); ++j) {
+        Vector3<double> d = x - s[j];
+        double r2 = inner(d, d);
+        if (r2 == 0.0) continue;
+        double r = std::sqrt(r2);
+        phi += q[j] / r;
+        field = field + (q[j] / (r2 * r)) * d;
+    }
+}
+
+// ######################################################################### //
+// # Solid harmonics.                                                      # //
+// ######################################################################### //
+
+TEST_CASE("Solid harmonics expand 1/|x - y|", "[Spherical]") {
+
+    const size_t p = 16;
+    std::vector<Complex> r(sh_size(p)), in(sh_size(p));
+    Vector3<double> x{1.5, -2.0, 2.5}, y{0.3, 0.2, -0.4};
+    regular_harmonics(p, y, r.data());
+    irregular_harmonics(p, x, in.data());
+
+    Complex sum = 0.0;
+    for (int l = 0; l <= int(p); ++l) {
+        for (int m = -l; m <= l; ++m) sum += std::conj(sh_get(r.data(), l, m)) * sh_get(in.data(), l, m);
+    }
+    Vector3<double> d = x - y;
+    REQUIRE(sum.real() == Approx(1.0 / std::sqrt(inner(d, d))).epsilon(1.0e-12));
+    REQUIRE(std::abs(sum.imag()) < 1.0e-14);
+
+}
+
+TEST_CASE("Wigner d matrices are orthogonal and compose", "[Spherical]") {
+
+    const size_t p = 10;
+    WignerD a(p, 0.4), b(p, 0.7), ab(p, 1.1), pole(p, M_PI);
+    for (int l = 0; l <= int(p); ++l) {
+        for (int m = -l; m <= l; ++m) {
+            for (int mp = -l; mp <= l; ++mp) {
+                double dot = 0.0, prod = 0.0;
+                for (int k = -l; k <= l; ++k) {
+                    dot += a(l, m, k) * a(l, mp, k);
+                    prod += a(l, m, k) * b(l, k, mp);
+                }
+                REQUIRE(dot == Approx(m == mp ? 1.0 : 0.0).margin(1.0e-12));
+                REQUIRE(prod == Approx(ab(l, m, mp)).margin(1.0e-12));
+                REQUIRE(std::isfinite(pole(l, m, mp)));
+            }
+        }
+    }
+
+}
+
+// ######################################################################### //
+// # Operators.                                                            # //
+// ######################################################################### //
+
+TEST_CASE("The operator chain P2M, M2M, M2L, L2L, L2P converges", "[Spherical]") {
+
+    std::mt19937_64 rng(33);
+    std::uniform_real_distribution<double> u(-0.25, 0.25);
+    std::vector<Vector3<double>> s(40);
+    std::vector<double> q(40);
+    const Vector3<double> cs{0.1, 0.2, -0.1}, cp{0.35, 0.45, 0.15}, ct{3.0, -1.9, 2.2}, cc{3.2, -1.8, 2.0};
+    for (auto &x: s) x = cs + Vector3<double>{u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+    const Vector3<double> x{3.15, -1.75, 2.05};
+
+    double ref;
+    Vector3<double> fref;
+    direct(s, q, x, ref, fref);
+
+    double previous = 1.0;
+    for (size_t p: {4, 8, 12}) {
+        for (bool rotate: {false, true}) {
+            SphericalOperators ops(p, rotate);
+            std::vector<Complex> m(ops.size()), mp(ops.size()), l(ops.size()), lc(ops.size());
+            ops.p2m(cs, s, q, m.data());
+            ops.m2m(m.data(), cs, cp, mp.data());
+            ops.m2l(mp.data(), cp, ct, l.data());
+            ops.l2l(l.data(), ct, cc, lc.data());
+
+            double phi = 0.0;
+            Vector3<double> f{0.0, 0.0, 0.0};
+            ops.l2p(lc.data(), cc, std::span<const Vector3<double>>(&x, 1), std::span<double>(&phi, 1),
+                    std::span<Vector3<double>>(&f, 1));
+
+            double err = std::abs(phi - ref) / std::abs(ref);
+            Vector3<double> df = f - fref;
+            REQUIRE(err < previous);
+            REQUIRE(std::sqrt(inner(df, df) / inner(fref, fref)) < 10.0 * previous);
+            if (rotate) previous = err;
+        }
+    }
+    REQUIRE(previous < 1.0e-8);
+
+}
+
+TEST_CASE("Rotated M2L matches direct M2L in every direction", "[Spherical]") {
+
+    const size_t p = 10;
+    SphericalOperators direct_ops(p, false), rotated_ops(p, true);
+    std::mt19937_64 rng(34);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Complex> m(direct_ops.size());
+    for (auto &c: m) c = {u(rng), u(rng)};
+    for (int l = 0; l <= int(p); ++l) m[sh_index(l, 0)] = m[sh_index(l, 0)].real();
+
+    std::vector<Vector3<double>> directions = {{0, 0, 3}, {0, 0, -3}, {3, 0, 0}, {0, -3, 0}, {2, 2, -2}, {-1, 2.5, 1}};
+    for (auto &d: directions) {
+        std::vector<Complex> a(direct_ops.size()), b(direct_ops.size());
+        direct_ops.m2l(m.data(), {0, 0, 0}, d, a.data());
+        rotated_ops.m2l(m.data(), {0, 0, 0}, d, b.data());
+        double scale = 0.0;
+        for (auto &c: a) scale = std::max(scale, std::abs(c));
+        for (size_t k = 0; k < a.size(); ++k) REQUIRE(std::abs(a[k] - b[k]) <= 1.0e-12 * scale);
+    }
+
+}
+
+// ######################################################################### //
+// # FMM.                                                                  # //
+// ######################################################################### //
+
+TEST_CASE("Fmm with spherical operators matches direct summation", "[Fmm]") {
+
+    std::mt19937_64 rng(35);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 3000;
+    std::vector<Vector3<double>> pts(n);
+    std::vector<double> q(n);
+    for (auto &x: pts) x = {u(rng), u(rng), 0.3 * u(rng)};
+    for (auto &c: q) c = u(rng);
+
+    ThreadPool pool(3);
+    Fmm<SphericalOperators> fmm(SphericalOperators(10), pts, q, {0.5, 32}, pool);
+    REQUIRE(fmm.m2l_count() > 0);
+    REQUIRE(fmm.p2p_count() > 0);
+
+    std::vector<double> phi(n);
+    std::vector<Vector3<double>> field(n);
+    fmm.evaluate(phi, field);
+
+    double num = 0.0, den = 0.0, fnum = 0.0, fden = 0.0;
+    for (size_t i = 0; i < n; i += 7) {
+        double ref;
+        Vector3<double> fref;
+        direct(pts, q, pts[i], ref, fref);
+        num += (phi[i] - ref) * (phi[i] - ref);
+        den += ref * ref;
+        Vector3<double> d = field[i] - fref;
+        fnum += inner(d, d);
+        fden += inner(fref, fref);
+    }
+    REQUIRE(std::sqrt(num / den) < 1.0e-6);
+    REQUIRE(std::sqrt(fnum / fden) < 1.0e-5);
+
+}
+
+TEST_CASE("Fmm results do not depend on the schedule or thread count", "[Fmm]") {
+
+    std::mt19937_64 rng(36);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 20000;
+    std::vector<Vector3<double>> pts(n);
+    std::vector<double> q(n);
+    for (auto &x: pts) x = {u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+
+    std::vector<double> ref_phi(n), phi(n);
+    std::vector<Vector3<double>> ref_field(n), field(n);
+    {
+        ThreadPool pool(1);
+        TaskPool tasks(1);
+        Fmm<SphericalOperators> fmm(SphericalOperators(4), pts, q, {0.5, 32, FmmSchedule::phases}, pool, tasks);
+        fmm.evaluate(ref_phi, ref_field);
+        REQUIRE(fmm.timings().total > 0.0);
+    }
+
+    for (size_t nthreads: {1, 3, 8}) {
+        for (FmmSchedule schedule: {FmmSchedule::phases, FmmSchedule::task_graph}) {
+            ThreadPool pool(nthreads);
+            TaskPool tasks(nthreads);
+            Fmm<SphericalOperators> fmm(SphericalOperators(4), pts, q, {0.5, 32, schedule}, pool, tasks);
+            fmm.evaluate(phi, field);
+            const FmmTimings &t = fmm.timings();
+            REQUIRE(t.upward > 0.0);
+            REQUIRE(t.far_field > 0.0);
+            REQUIRE(t.near_field > 0.0);
+            size_t mismatches = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (phi[i] != ref_phi[i] || field[i].x != ref_field[i].x || field[i].y != ref_field[i].y
+                    || field[i].z != ref_field[i].z) {
+                    ++mismatches;
+                }
+            }
+            INFO("threads " << nthreads << " schedule " << int(schedule));
+            REQUIRE(mismatches == 0);
+        }
+    }
+
+}
@@ -0,0 +1,95 @@
+/*
+ * @file test_hilbert.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test Hilbert keys and particle reordering
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "hilbert.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "permutation.hpp"
+
+// ######################################################################### //
+// # Keys.                                                                 # //
+// ######################################################################### //
+
+TEST_CASE("Consecutive Hilbert keys are face neighbours", "[Hilbert]") {
+
+    std::mt19937_64 rng(31);
+    const uint64_t max_key = (uint64_t{1} << 63) - 1;
+    for (int i = 0; i < 2000; ++i) {
+        uint64_t k = i < 1000 ? static_cast<uint64_t>(i) : rng() % max_key;
+        uint32_t x0, y0, z0, x1, y1, z1;
+        hilbert_decode(k, x0, y0, z0);
+        hilbert_decode(k + 1, x1, y1, z1);
+        REQUIRE(hilbert_encode(x0, y0, z0) == k);
+        long d = std::labs(long(x1) - long(x0)) + std::labs(long(y1) - long(y0)) + std::labs(long(z1) - long(z0));
+        REQUIRE(d == 1);
+    }
+
+    uint32_t x, y, z;
+    hilbert_decode(0, x, y, z);
+    REQUIRE((x == 0 && y == 0 && z == 0));
+
+}
+
+// ######################################################################### //
+// # Reordering.                                                           # //
+// ######################################################################### //
+
+TEST_CASE("hilbert_permutation reorders and restores attribute arrays", "[Hilbert]") {
+
+    std::mt19937_64 rng(32);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 20000;
+    std::vector<Vector3<double>> positions(n);
+    std::vector<double> charges(n);
+    std::vector<int> ids(n);
+    for (size_t i = 0; i < n; ++i) {
+        positions[i] = {u(rng), u(rng), u(rng)};
+        charges[i] = u(rng);
+        ids[i] = static_cast<int>(i);
+    }
+    const std::vector<Vector3<double>> original = positions;
+
+    ThreadPool pool(3);
+    Permutation order = hilbert_permutation<double>(positions, pool);
+    REQUIRE(order.size() == n);
+    order.apply(pool, positions, charges, ids);
+
+    // Reordered data travels together, and the inverse locates it.
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(static_cast<size_t>(ids[i]) == order.forward()[i]);
+        REQUIRE(order.inverse()[order.forward()[i]] == i);
+        REQUIRE(positions[i].x == original[ids[i]].x);
+    }
+
+    // Neighbouring particles in the new order are spatially close.
+    double jump = 0.0;
+    for (size_t i = 1; i < n; ++i) {
+        Vector3<double> d = positions[i] - positions[i - 1];
+        jump += std::sqrt(inner(d, d));
+    }
+    REQUIRE(jump / n < 0.1);
+
+    // Results computed in the new order scatter back to the input order.
+    std::vector<int> back(n);
+    order.scatter<int>(ids, back, pool);
+    for (size_t i = 0; i < n; ++i) REQUIRE(back[i] == static_cast<int>(i));
+
+    order.unapply(pool, positions, ids);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(ids[i] == static_cast<int>(i));
+        REQUIRE(positions[i].y == original[i].y);
+    }
+
+}
@@ -0,0 +1,179 @@
+/*
+ * @file test_interval.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the interval arithmetic scalar type
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "interval.hpp"
+#include "linalg.hpp"
+#include "mpinterval.hpp"
+
+// ######################################################################### //
+// # Directed rounding.                                                    # //
+// ######################################################################### //
+
+TEST_CASE("Interval bounds are rounded outwards", "[Interval]") {
+
+    Interval<double> a(1.0), b(1.0e-20);
+
+    Interval<double> s = a + b;
+    REQUIRE(s.lo == 1.0);
+    REQUIRE(s.hi == std::nextafter(1.0, 2.0));
+
+    Interval<double> d = a - b;
+    REQUIRE(d.lo == std::nextafter(1.0, 0.0));
+    REQUIRE(d.hi == 1.0);
+
+    Interval<double> third = Interval<double>(1.0) / Interval<double>(3.0);
+    REQUIRE(third.lo < third.hi);
+    REQUIRE(third.hi == std::nextafter(third.lo, 1.0));
+
+    // The caller's rounding mode is left untouched.
+    REQUIRE(std::fegetround() == FE_TONEAREST);
+
+}
+
+TEST_CASE("Interval<float> from a double encloses it", "[Interval]") {
+
+    Interval<float> a(0.1);
+    REQUIRE(static_cast<double>(a.lo) < 0.1);
+    REQUIRE(static_cast<double>(a.hi) > 0.1);
+
+}
+
+TEST_CASE("Interval multiplication and division handle signs", "[Interval]") {
+
+    Interval<double> a(-2.0, 3.0), b(-5.0, 4.0);
+
+    Interval<double> p = a * b;
+    REQUIRE(p.lo == -15.0);
+    REQUIRE(p.hi == 12.0);
+
+    Interval<double> q = Interval<double>(1.0, 2.0) / Interval<double>(-4.0, -2.0);
+    REQUIRE(q.lo == -1.0);
+    REQUIRE(q.hi == -0.25);
+
+    Interval<double> w = Interval<double>(1.0) / Interval<double>(-1.0, 1.0);
+    REQUIRE(std::isinf(w.lo));
+    REQUIRE(std::isinf(w.hi));
+
+    Interval<double> r = sqrt(Interval<double>(2.0));
+    REQUIRE(r.lo * r.lo <= 2.0);
+    REQUIRE(r.hi * r.hi >= 2.0);
+    REQUIRE(r.hi == std::nextafter(r.lo, 2.0));
+
+}
+
+// ######################################################################### //
+// # Linear algebra.                                                       # //
+// ######################################################################### //
+
+TEST_CASE("Interval determinant certifies the sign of a near singular matrix", "[Interval]") {
+
+    // The determinant is about 1e-14; the enclosure must stay that tight.
+    Matrix3x3<Interval<double>> m = {
+            1.0, 2.0, 3.0,
+            4.0, 5.0, 6.0,
+            7.0, 8.0, 9.0 + 1.0e-14 / -3.0
+    };
+    Interval<double> d = det(m);
+    REQUIRE(d.lo <= d.hi);
+    REQUIRE(width(d) < 1.0e-13);
+
+    Matrix3x3<Interval<double>> s = {
+            1.0, 2.0, 3.0,
+            4.0, 5.0, 6.0,
+            7.0, 8.0, 9.0
+    };
+    REQUIRE(contains(det(s), 0.0));
+
+    Matrix3x3<Interval<double>> r = {
+            2.0, 0.0, 0.0,
+            0.0, 3.0, 0.0,
+            0.0, 0.0, 0.5
+    };
+    REQUIRE(certainly_positive(det(r)));
+
+}
+
+// ######################################################################### //
+// # SIMD batch kernels.                                                   # //
+// ######################################################################### //
+
+TEST_CASE("Batch kernels match the scalar Interval operators", "[Interval]") {
+
+    std::mt19937_64 rng(29);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    auto iv = [&]() {
+        double a = u(rng), b = a + std::abs(u(rng)) * 1.0e-3;
+        return Interval<double>(a, b);
+    };
+
+    const size_t n = 37;
+    std::vector<Vector3<Interval<double>>> a(n), b(n);
+    std::vector<Matrix3x3<Interval<double>>> m(n);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = {iv(), iv(), iv()};
+        b[i] = {iv(), iv(), iv()};
+        for (auto &row: m[i].m) for (auto &x: row) x = iv();
+    }
+
+    std::vector<Interval<double>> ip(n), dt(n);
+    std::vector<Vector3<Interval<double>>> cr(n);
+    interval_batch_inner(ip, a, b);
+    interval_batch_cross(cr, a, b);
+    interval_batch_det(dt, m);
+
+    for (size_t i = 0; i < n; ++i) {
+        Interval<double> e = inner(a[i], b[i]);
+        REQUIRE(ip[i].lo == e.lo);
+        REQUIRE(ip[i].hi == e.hi);
+
+        Vector3<Interval<double>> c = cross(a[i], b[i]);
+        REQUIRE(cr[i].x.lo == c.x.lo);
+        REQUIRE(cr[i].y.hi == c.y.hi);
+        REQUIRE(cr[i].z.lo == c.z.lo);
+
+        Interval<double> d = det(m[i]);
+        REQUIRE(dt[i].lo == d.lo);
+        REQUIRE(dt[i].hi == d.hi);
+    }
+
+    REQUIRE_THROWS_AS(interval_batch_det(std::span<Interval<double>>(dt).first(3), m), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # MPFR bounds.                                                          # //
+// ######################################################################### //
+
+TEST_CASE("MpInterval encloses decimal constants and products", "[MpInterval]") {
+
+    MpInterval tenth = mp_interval("0.1", 200);
+    REQUIRE(tenth.lo < tenth.hi);
+    REQUIRE(tenth.lo.precision() == 200);
+
+    MpInterval p = tenth * MpInterval(10.0);
+    REQUIRE(p.lo <= MpReal(1.0));
+    REQUIRE(p.hi >= MpReal(1.0));
+
+    MpInterval r = sqrt(MpInterval(MpReal(2.0, 200)));
+    REQUIRE(r.lo * r.lo <= MpReal(2.0));
+    REQUIRE(r.hi * r.hi >= MpReal(2.0));
+
+    Matrix3x3<MpInterval> s = {
+            1.0, 2.0, 3.0,
+            4.0, 5.0, 6.0,
+            7.0, 8.0, 9.0
+    };
+    REQUIRE(possibly_zero(det(s)));
+
+}
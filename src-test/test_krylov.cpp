@@ -0,0 +1,284 @@
+/*
+ * @file test_krylov.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the Krylov solvers and their preconditioners
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "krylov.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "sparse.hpp"
+
+/**
+ * @brief -Laplace(u) + c . grad(u) on an n x n grid with Dirichlet
+ *        boundaries: five points, the convection upwinded. c = 0 gives the
+ *        symmetric positive definite Poisson matrix.
+ */
+static CsrMatrix grid_matrix(size_t n, double cx = 0.0, double cy = 0.0) {
+    std::vector<size_t> row_ptr{0};
+    std::vector<uint32_t> col_idx;
+    std::vector<double> values;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            // Neighbours in column order: (i-1, j), (i, j-1), self, (i, j+1), (i+1, j).
+            auto add = [&](bool inside, size_t col, double v) {
+                if (inside) {
+                    col_idx.push_back(uint32_t(col));
+                    values.push_back(v);
+                }
+            };
+            const size_t row = i * n + j;
+            add(i > 0, row - n, -1.0 - cx);
+            add(j > 0, row - 1, -1.0 - cy);
+            add(true, row, 4.0 + cx + cy);
+            add(j + 1 < n, row + 1, -1.0);
+            add(i + 1 < n, row + n, -1.0);
+            row_ptr.push_back(col_idx.size());
+        }
+    }
+    return {n * n, n * n, std::move(row_ptr), std::move(col_idx), values};
+}
+
+/**
+ * @brief Three components, each the Poisson matrix, coupled at every node
+ *        by a symmetric positive definite 3 x 3 block.
+ */
+static CsrMatrix coupled_matrix(size_t n) {
+    CsrMatrix poisson = grid_matrix(n);
+    const double coupling[3][3] = {{2.0, 0.9, 0.3}, {0.9, 3.0, -0.8}, {0.3, -0.8, 1.5}};
+    std::vector<size_t> row_ptr{0};
+    std::vector<uint32_t> col_idx;
+    std::vector<double> values;
+    for (size_t i = 0; i < poisson.rows(); ++i) {
+        for (size_t p = 0; p < 3; ++p) {
+            for (size_t k = poisson.row_ptr()[i]; k < poisson.row_ptr()[i + 1]; ++k) {
+                const size_t j = poisson.col_idx()[k];
+                for (size_t q = 0; q < 3; ++q) {
+                    if (i != j && p != q) continue;
+                    col_idx.push_back(uint32_t(3 * j + q));
+                    values.push_back((p == q ? poisson.values()[k] : 0.0) + (i == j ? 10.0 * coupling[p][q] : 0.0));
+                }
+            }
+            row_ptr.push_back(col_idx.size());
+        }
+    }
+    return {3 * poisson.rows(), 3 * poisson.rows(), std::move(row_ptr), std::move(col_idx), values};
+}
+
+static std::vector<double> rhs(size_t n) {
+    std::vector<double> b(n);
+    for (size_t i = 0; i < n; ++i) b[i] = std::sin(0.37 * double(i)) + 0.5;
+    return b;
+}
+
+/**
+ * @brief |b - A x| / |b|, computed afresh.
+ */
+template <typename Matrix>
+static double true_residual(const Matrix &a, const std::vector<double> &b, const std::vector<double> &x) {
+    std::vector<double> ax(b.size());
+    spmv(a, x, ax);
+    double rr = 0.0, bb = 0.0;
+    for (size_t i = 0; i < b.size(); ++i) {
+        rr += (b[i] - ax[i]) * (b[i] - ax[i]);
+        bb += b[i] * b[i];
+    }
+    return std::sqrt(rr / bb);
+}
+
+// ######################################################################### //
+// # Preconditioners.                                                      # //
+// ######################################################################### //
+
+TEST_CASE("Preconditioners invert what they should", "[Krylov]") {
+
+    // ILU(0) of a tridiagonal matrix has no fill to drop: it is exact.
+    CsrMatrix tri = grid_matrix(1);
+    {
+        std::vector<size_t> row_ptr{0};
+        std::vector<uint32_t> col_idx;
+        std::vector<double> values;
+        const size_t n = 50;
+        for (size_t i = 0; i < n; ++i) {
+            if (i > 0) col_idx.push_back(uint32_t(i - 1)), values.push_back(-1.0 - 0.1 * double(i % 3));
+            col_idx.push_back(uint32_t(i)), values.push_back(3.0);
+            if (i + 1 < n) col_idx.push_back(uint32_t(i + 1)), values.push_back(-1.2);
+            row_ptr.push_back(col_idx.size());
+        }
+        tri = CsrMatrix(n, n, std::move(row_ptr), std::move(col_idx), values);
+    }
+    Ilu0Preconditioner ilu(tri);
+    std::vector<double> x = rhs(tri.rows()), ax(tri.rows()), back(tri.rows());
+    spmv(tri, x, ax);
+    ilu.apply(ax, back);
+    for (size_t i = 0; i < x.size(); ++i) REQUIRE(back[i] == Approx(x[i]).margin(1.0e-12));
+
+    // The block inverses undo the diagonal blocks.
+    CsrMatrix a = coupled_matrix(4);
+    BsrMatrix blocks = BsrMatrix::from_csr(a);
+    BlockJacobiPreconditioner block_jacobi(blocks);
+    JacobiPreconditioner jacobi(blocks);
+    for (size_t node = 0; node < blocks.block_rows(); node += 5) {
+        std::vector<double> e(a.rows(), 0.0), z(a.rows()), d(a.rows());
+        for (size_t p = 0; p < 3; ++p) e[3 * node + p] = a(3 * node + p, 3 * node + 1);
+        block_jacobi.apply(e, z);
+        for (size_t p = 0; p < 3; ++p) REQUIRE(z[3 * node + p] == Approx(p == 1 ? 1.0 : 0.0).margin(1.0e-12));
+        jacobi.apply(e, d);
+        REQUIRE(d[3 * node + 1] == Approx(1.0));
+    }
+
+    CsrMatrix rectangular(2, 3, {0, 1, 2}, {0, 1});
+    REQUIRE_THROWS_AS(JacobiPreconditioner(rectangular), std::invalid_argument);
+    CsrMatrix hole(2, 2, {0, 1, 2}, {1, 0}, std::vector<double>{1.0, 1.0});
+    REQUIRE_THROWS_AS(JacobiPreconditioner(hole), std::invalid_argument);
+    REQUIRE_THROWS_AS(Ilu0Preconditioner(hole), std::invalid_argument);
+    REQUIRE_THROWS_AS(BlockJacobiPreconditioner(hole), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # Solvers.                                                              # //
+// ######################################################################### //
+
+TEST_CASE("CG solves the Poisson problem", "[Krylov]") {
+
+    ThreadPool one(1), three(3);
+    CsrMatrix a = grid_matrix(40);
+    std::vector<double> b = rhs(a.rows());
+    KrylovOptions options;
+    options.tolerance = 1.0e-10;
+
+    std::vector<double> x(a.rows(), 0.0);
+    KrylovStats plain = cg(a, b, x, IdentityPreconditioner{}, options, three);
+    REQUIRE(plain.converged);
+    REQUIRE(true_residual(a, b, x) < 1.0e-9);
+
+    // Statistics: one residual per iteration after the initial one, one
+    // product per iteration plus the initial residual.
+    REQUIRE(plain.history.size() == plain.iterations + 1);
+    REQUIRE(plain.history.front() == Approx(1.0));
+    REQUIRE(plain.residual == plain.history.back());
+    REQUIRE(plain.matvecs == plain.iterations + 1);
+    REQUIRE(plain.preconditioner_applications == plain.iterations);
+    const KrylovTimings &t = plain.timings;
+    REQUIRE(t.matvec > 0.0);
+    REQUIRE(t.matvec + t.preconditioner + t.vector <= t.total);
+
+    // A better preconditioner takes fewer iterations; the answer is the
+    // same however many threads compute it.
+    std::vector<double> x_ilu(a.rows(), 0.0), x_ilu1(a.rows(), 0.0);
+    Ilu0Preconditioner ilu(a);
+    KrylovStats preconditioned = cg(a, b, x_ilu, ilu, options, three);
+    REQUIRE(preconditioned.converged);
+    REQUIRE(preconditioned.iterations < plain.iterations / 2);
+    REQUIRE(true_residual(a, b, x_ilu) < 1.0e-9);
+    cg(a, b, x_ilu1, ilu, options, one);
+    REQUIRE(x_ilu == x_ilu1);
+
+    // The solution is a fixed point, and the iteration cap is respected.
+    KrylovStats again = cg(a, b, x_ilu, ilu, options, three);
+    REQUIRE(again.iterations <= 1);
+    std::vector<double> y(a.rows(), 0.0);
+    options.max_iterations = 5;
+    KrylovStats capped = cg(a, b, y, JacobiPreconditioner(a), options, three);
+    REQUIRE(!capped.converged);
+    REQUIRE(capped.iterations == 5);
+
+    std::vector<double> zero(a.rows(), 0.0);
+    x.assign(a.rows(), 1.0);
+    KrylovStats trivial = cg(a, zero, x, ilu);
+    REQUIRE(trivial.converged);
+    REQUIRE(trivial.iterations == 0);
+    REQUIRE(x == zero);
+
+    std::vector<double> short_b(a.rows() - 1);
+    REQUIRE_THROWS_AS(cg(a, short_b, x, ilu), std::invalid_argument);
+
+}
+
+TEST_CASE("CG with block Jacobi solves the coupled BSR system", "[Krylov]") {
+
+    CsrMatrix csr = coupled_matrix(20);
+    BsrMatrix a = BsrMatrix::from_csr(csr);
+    std::vector<double> b = rhs(a.rows());
+    KrylovOptions options;
+    options.tolerance = 1.0e-10;
+
+    std::vector<double> x_point(a.rows(), 0.0), x_block(a.rows(), 0.0);
+    KrylovStats point = cg(a, b, x_point, JacobiPreconditioner(a), options);
+    KrylovStats block = cg(a, b, x_block, BlockJacobiPreconditioner(a), options);
+    REQUIRE(point.converged);
+    REQUIRE(block.converged);
+    REQUIRE(block.iterations < point.iterations);
+    REQUIRE(true_residual(a, b, x_block) < 1.0e-9);
+    REQUIRE(true_residual(csr, b, x_block) < 1.0e-9);
+
+}
+
+TEST_CASE("BiCGStab and GMRES solve a nonsymmetric problem", "[Krylov]") {
+
+    ThreadPool one(1), three(3);
+    CsrMatrix a = grid_matrix(30, 2.0, 0.5);
+    std::vector<double> b = rhs(a.rows());
+    KrylovOptions options;
+    options.tolerance = 1.0e-10;
+    Ilu0Preconditioner ilu(a);
+    JacobiPreconditioner jacobi(a);
+
+    SECTION("BiCGStab") {
+        for (bool use_ilu: {false, true}) {
+            std::vector<double> x(a.rows(), 0.0);
+            KrylovStats stats = use_ilu ? bicgstab(a, b, x, ilu, options, three)
+                                        : bicgstab(a, b, x, jacobi, options, three);
+            REQUIRE(stats.converged);
+            REQUIRE(true_residual(a, b, x) < 1.0e-8);
+            REQUIRE(stats.history.size() == stats.iterations + 1);
+            REQUIRE(stats.matvecs <= 2 * stats.iterations + 1);
+        }
+        std::vector<double> x1(a.rows(), 0.0), x3(a.rows(), 0.0);
+        bicgstab(a, b, x1, jacobi, options, one);
+        bicgstab(a, b, x3, jacobi, options, three);
+        REQUIRE(x1 == x3);
+    }
+
+    SECTION("GMRES") {
+        size_t long_iterations = 0;
+        for (size_t restart: {size_t(10), size_t(200)}) {
+            options.restart = restart;
+            std::vector<double> x(a.rows(), 0.0);
+            KrylovStats stats = gmres(a, b, x, ilu, options, three);
+            REQUIRE(stats.converged);
+            REQUIRE(true_residual(a, b, x) < 1.0e-9);
+            REQUIRE(stats.residual == Approx(true_residual(a, b, x)).epsilon(1.0e-3).margin(1.0e-14));
+            REQUIRE(stats.history.size() == stats.iterations + 1);
+            // The residual GMRES minimises never grows within a cycle.
+            for (size_t i = 1; i < stats.history.size(); ++i) {
+                if (i % restart != 0) REQUIRE(stats.history[i] <= stats.history[i - 1] * (1.0 + 1.0e-12));
+            }
+            long_iterations = stats.iterations;
+        }
+        // Without restarts GMRES is optimal: no more iterations than
+        // BiCGStab takes products.
+        std::vector<double> x(a.rows(), 0.0);
+        KrylovStats bi = bicgstab(a, b, x, ilu, options, three);
+        REQUIRE(long_iterations <= bi.matvecs);
+
+        std::vector<double> x1(a.rows(), 0.0), x3(a.rows(), 0.0);
+        options.restart = 15;
+        gmres(a, b, x1, jacobi, options, one);
+        gmres(a, b, x3, jacobi, options, three);
+        REQUIRE(x1 == x3);
+
+        options.restart = 0;
+        REQUIRE_THROWS_AS(gmres(a, b, x, ilu, options), std::invalid_argument);
+    }
+
+}
@@ -0,0 +1,36 @@
+/*
+ * @file test_lanes.hpp
+ * @author Lesleis Nagy
+ * @date 19/10/2026
+ * @brief Run a test body for every SIMD lane type compiled into the build
+ */
+
+#ifndef FMM_TEST_LANES_HPP
+#define FMM_TEST_LANES_HPP
+
+#include <cstddef>
+
+#include <catch/catch.hpp>
+
+#include "p2p.hpp"
+
+/**
+ * @brief Calls `check(lanes)` with a value of each SIMD lane type that is
+ *        compiled into this build (see the FIGUEROA_NATIVE CMake option), so
+ *        that the body can compare it with detail::P2PScalar.
+ */
+template <typename F>
+void for_each_simd_lanes([[maybe_unused]] F &&check) {
+    size_t compiled = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    check(detail::P2PAvx2{});
+    ++compiled;
+#endif
+#if defined(__AVX512F__)
+    check(detail::P2PAvx512{});
+    ++compiled;
+#endif
+    if (compiled == 0) WARN("no SIMD lanes in this build, only the scalar lanes were tested");
+}
+
+#endif //FMM_TEST_LANES_HPP
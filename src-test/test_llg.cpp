@@ -0,0 +1,234 @@
+/*
+ * @file test_llg.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the adaptive Landau-Lifshitz-Gilbert integrators
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "llg.hpp"
+#include "micromagnetics.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+/**
+ * @brief Unit vectors at polar angles spread over (0, pi) and azimuths over
+ *        [0, 2 pi).
+ */
+static Vector3Array<double> spread(size_t n) {
+    Vector3Array<double> m(n);
+    for (size_t i = 0; i < n; ++i) {
+        const double theta = std::numbers::pi * (double(i) + 0.5) / double(n), phi = 0.7 * double(i);
+        m.set(i, {std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)});
+    }
+    return m;
+}
+
+/**
+ * @brief The largest distance of the field from the exact solution in a
+ *        constant field H z: with g = gamma / (1 + alpha^2) every vector
+ *        precesses at g H and tan(theta / 2) decays as exp(-alpha g H t).
+ */
+static double precession_error(const Vector3Array<double> &start, const Vector3Array<double> &m, double h,
+                               const LlgOptions &options, double t) {
+    const double g = options.gamma / (1.0 + options.damping * options.damping);
+    double largest = 0.0;
+    for (size_t i = 0; i < m.size(); ++i) {
+        const Vector3<double> s = start[i];
+        const double theta0 = std::acos(s.z), phi0 = std::atan2(s.y, s.x);
+        const double theta = 2.0 * std::atan(std::tan(0.5 * theta0) * std::exp(-options.damping * g * h * t));
+        const double phi = phi0 + g * h * t;
+        const Vector3<double> exact{std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi),
+                                    std::cos(theta)};
+        const Vector3<double> d = m[i] - exact;
+        largest = std::max(largest, std::sqrt(inner(d, d)));
+    }
+    return largest;
+}
+
+static double largest_length_error(const Vector3Array<double> &m) {
+    double largest = 0.0;
+    for (size_t i = 0; i < m.size(); ++i) largest = std::max(largest, std::abs(std::sqrt(inner(m[i], m[i])) - 1.0));
+    return largest;
+}
+
+// ######################################################################### //
+// # Precession.                                                           # //
+// ######################################################################### //
+
+TEST_CASE("Every method follows damped precession", "[LLG]") {
+
+    const size_t n = 300;
+    const double h = 1.0e5, t_end = 0.3e-9;
+    Vector3Array<double> start = spread(n);
+    auto field = [&](double, const Vector3Array<double> &, Vector3Array<double> &out) {
+        for (size_t i = 0; i < out.size(); ++i) out.set(i, {0.0, 0.0, h});
+    };
+
+    for (LlgMethod method: {LlgMethod::heun, LlgMethod::rk45, LlgMethod::cayley}) {
+        std::vector<double> errors;
+        std::vector<size_t> steps;
+        for (double tolerance: {1.0e-5, 1.0e-7}) {
+            LlgOptions options;
+            options.method = method;
+            options.tolerance = tolerance;
+            LlgIntegrator integrator(start, options);
+            integrator.advance(field, t_end);
+            REQUIRE(integrator.time() == t_end);
+            const LlgStats &stats = integrator.stats();
+            errors.push_back(precession_error(start, integrator.magnetization(), h, options, t_end));
+            steps.push_back(stats.steps);
+            REQUIRE(largest_length_error(integrator.magnetization()) < 1.0e-14);
+            REQUIRE(stats.largest_step <= options.max_step);
+            REQUIRE(stats.timings.total >= stats.timings.field + stats.timings.stages);
+
+            // The first slope is kept through rejections and, by FSAL,
+            // accepted Dormand-Prince steps.
+            if (method == LlgMethod::rk45) {
+                REQUIRE(stats.evaluations == 1 + 6 * (stats.steps + stats.rejected));
+            } else {
+                REQUIRE(stats.evaluations == 2 * stats.steps + stats.rejected);
+            }
+        }
+        // A global error of a few hundred local tolerances, falling with the
+        // tolerance.
+        REQUIRE(errors[0] < 500.0 * 1.0e-5);
+        REQUIRE(errors[1] < errors[0] / 10.0);
+        REQUIRE(steps[1] > steps[0]);
+    }
+
+}
+
+TEST_CASE("Dormand-Prince takes the longest steps", "[LLG]") {
+
+    const size_t n = 50;
+    Vector3Array<double> start = spread(n);
+    auto field = [&](double, const Vector3Array<double> &, Vector3Array<double> &out) {
+        for (size_t i = 0; i < out.size(); ++i) out.set(i, {2.0e4, 0.0, 1.0e5});
+    };
+    std::vector<size_t> steps;
+    for (LlgMethod method: {LlgMethod::heun, LlgMethod::rk45, LlgMethod::cayley}) {
+        LlgOptions options;
+        options.method = method;
+        options.tolerance = 1.0e-8;
+        LlgIntegrator integrator(start, options);
+        integrator.advance(field, 0.1e-9);
+        steps.push_back(integrator.stats().steps);
+    }
+    REQUIRE(steps[1] * 10 < steps[0]);
+    REQUIRE(steps[1] * 10 < steps[2]);
+
+}
+
+TEST_CASE("The Cayley method keeps unit length without renormalizing", "[LLG]") {
+
+    // Uniform, rotating field: a time dependent field with a large torque.
+    const size_t n = 200;
+    Vector3Array<double> start = spread(n);
+    const double omega = 2.0e10;
+    auto field = [&](double t, const Vector3Array<double> &, Vector3Array<double> &out) {
+        const Vector3<double> h{5.0e4 * std::cos(omega * t), 5.0e4 * std::sin(omega * t), 2.0e4};
+        for (size_t i = 0; i < out.size(); ++i) out.set(i, h);
+    };
+    LlgOptions options;
+    options.method = LlgMethod::cayley;
+    options.damping = 0.01;
+    options.tolerance = 1.0e-4;
+    LlgIntegrator integrator(start, options);
+    integrator.advance(field, 2.0e-9);
+    REQUIRE(integrator.stats().steps > 1000);
+    REQUIRE(largest_length_error(integrator.magnetization()) < 1.0e-13);
+
+    // Stepping by hand, with the step sizes the controller chooses.
+    const double t = integrator.time();
+    size_t accepted = 0;
+    while (accepted < 10) accepted += integrator.step(field);
+    REQUIRE(integrator.time() > t);
+
+}
+
+// ######################################################################### //
+// # Micromagnetics.                                                       # //
+// ######################################################################### //
+
+TEST_CASE("Damped micromagnetic dynamics lower the energy", "[LLG]") {
+
+    ThreadPool one(1), three(3);
+    TetMesh mesh = cube_tet_mesh(10, 40.0e-9);
+    const size_t n = mesh.node_count();
+    MicromagMaterial mat;
+    mat.uniaxial = 2.0e4;
+    mat.applied = {3.0e4, 0.0, 0.0};
+    MicromagOptions micromag;
+    micromag.terms.demag = false;
+    MicromagEvaluator evaluator(mesh, mat, micromag, one);
+    Vector3Array<double> gradient(n);
+    auto field = [&](double, const Vector3Array<double> &m, Vector3Array<double> &h) {
+        evaluator.evaluate(m, gradient);
+        evaluator.effective_field(gradient, h);
+    };
+
+    std::mt19937 gen(4);
+    std::normal_distribution<double> normal;
+    Vector3Array<double> start(n);
+    for (size_t i = 0; i < n; ++i) start.set(i, Vector3<double>{0.0, 0.0, 1.0} + 0.3 * Vector3<double>{
+            normal(gen), normal(gen), normal(gen)});
+
+    LlgOptions options;
+    options.damping = 0.5;
+    options.tolerance = 1.0e-5;
+    for (LlgMethod method: {LlgMethod::heun, LlgMethod::rk45, LlgMethod::cayley}) {
+        options.method = method;
+        LlgIntegrator serial(start, options, one), parallel(start, options, three);
+        double energy = evaluator.energy(serial.magnetization());
+        for (size_t k = 0; k < 5; ++k) {
+            const double t = serial.time() + 20.0e-12;
+            serial.advance(field, t);
+            parallel.advance(field, t);
+            const double next = evaluator.energy(serial.magnetization());
+            REQUIRE(next < energy);
+            energy = next;
+        }
+        REQUIRE(serial.stats().steps == parallel.stats().steps);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(serial.magnetization()[i].x == parallel.magnetization()[i].x);
+            REQUIRE(serial.magnetization()[i].y == parallel.magnetization()[i].y);
+            REQUIRE(serial.magnetization()[i].z == parallel.magnetization()[i].z);
+        }
+    }
+
+}
+
+TEST_CASE("LlgIntegrator rejects bad arguments", "[LLG]") {
+
+    Vector3Array<double> start = spread(10);
+    LlgOptions options;
+    options.tolerance = 0.0;
+    REQUIRE_THROWS_AS(LlgIntegrator(start, options), std::invalid_argument);
+
+    options = {};
+    LlgIntegrator integrator(start, options);
+    Vector3Array<double> wrong(9);
+    REQUIRE_THROWS_AS(integrator.set_magnetization(wrong), std::invalid_argument);
+
+    // A field no step can follow.
+    options.min_step = 1.0e-15;
+    options.initial_step = 1.0e-15;
+    LlgIntegrator stiff(start, options);
+    auto huge = [&](double, const Vector3Array<double> &, Vector3Array<double> &out) {
+        for (size_t i = 0; i < out.size(); ++i) out.set(i, {1.0e12, 0.0, 0.0});
+    };
+    REQUIRE_THROWS_AS(stiff.advance(huge, 1.0e-12), std::runtime_error);
+
+}
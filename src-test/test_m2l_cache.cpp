@@ -0,0 +1,219 @@
+/*
+ * @file test_m2l_cache.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the precomputed M2L operator cache and its file format
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fmm.hpp"
+#include "fmm_cartesian.hpp"
+#include "fmm_spherical.hpp"
+#include "m2l_cache.hpp"
+#include "parallel.hpp"
+#include "tasks.hpp"
+
+/**
+ * @brief A path in the temporary directory, removed on destruction.
+ */
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string &name)
+            : path((std::filesystem::temp_directory_path() / name).string()) {
+        std::remove(path.c_str());
+    }
+
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+template <typename Ops>
+static double max_abs(const std::vector<typename Ops::Coefficient> &v) {
+    double m = 0.0;
+    for (auto &c: v) m = std::max(m, std::abs(c));
+    return m;
+}
+
+/**
+ * @brief Compares cached and direct M2L for an offset at several scales.
+ */
+template <typename Ops>
+static void check_against_m2l(const Ops &ops, M2LCache<Ops> &cache, const M2LOffset &o) {
+    std::mt19937_64 rng(36);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<typename Ops::Coefficient> m(ops.size());
+    for (auto &c: m) c = u(rng);
+
+    const double *op = cache.get(o);
+    for (double unit: {1.0, 0.125, 3.5}) {
+        std::vector<typename Ops::Coefficient> a(ops.size()), b(ops.size());
+        Vector3<double> d{unit * o.x, unit * o.y, unit * o.z};
+        ops.m2l(m.data(), {0.0, 0.0, 0.0}, d, a.data());
+        cache.apply(op, m.data(), unit, b.data());
+        double scale = max_abs<Ops>(a);
+        for (size_t k = 0; k < a.size(); ++k) REQUIRE(std::abs(a[k] - b[k]) <= 1.0e-12 * scale);
+    }
+}
+
+// ######################################################################### //
+// # Operators.                                                            # //
+// ######################################################################### //
+
+TEST_CASE("Cached M2L operators match M2L at every scale", "[M2LCache]") {
+
+    SphericalOperators sph(8);
+    M2LCache<SphericalOperators> sph_cache(sph);
+    REQUIRE(sph_cache.operator_size() == sph.m2l_operator_size());
+
+    CartesianOperators<4> cart;
+    M2LCache<CartesianOperators<4>> cart_cache(cart);
+    REQUIRE(cart_cache.operator_size() == cart.size());
+
+    for (M2LOffset o: {M2LOffset{8, 0, 0}, M2LOffset{-6, 4, 2}, M2LOffset{0, 0, -10}, M2LOffset{5, -5, 7}}) {
+        check_against_m2l(sph, sph_cache, o);
+        check_against_m2l(cart, cart_cache, o);
+    }
+    REQUIRE(sph_cache.size() == 4);
+    REQUIRE(sph_cache.computed() == 4);
+
+    // A repeated lookup returns the cached operator.
+    REQUIRE(sph_cache.get({8, 0, 0}) == sph_cache.get({8, 0, 0}));
+    REQUIRE(sph_cache.size() == 4);
+
+    REQUIRE(M2LCache<SphericalOperators>::offset({1.5, -0.5, 2.0}, 0.25).x == 6);
+    REQUIRE_THROWS_AS(M2LCache<SphericalOperators>::offset({1.6, 0.0, 0.0}, 0.25), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # Files.                                                                # //
+// ######################################################################### //
+
+TEST_CASE("M2L caches round trip through a file", "[M2LCache]") {
+
+    TempFile file("test_m2l_cache_roundtrip.bin");
+    SphericalOperators ops(6);
+    std::vector<M2LOffset> offsets = {{8, 0, 0}, {-6, 4, 2}, {0, 6, -6}};
+
+    M2LCache<SphericalOperators> first(ops, file.path);
+    REQUIRE_FALSE(first.loaded());
+    REQUIRE_FALSE(first.rejected());
+    for (auto &o: offsets) first.get(o);
+    first.save(file.path);
+
+    M2LCache<SphericalOperators> second(ops, file.path);
+    REQUIRE(second.loaded());
+    REQUIRE(second.size() == offsets.size());
+    for (auto &o: offsets) {
+        const double *a = first.get(o), *b = second.get(o);
+        REQUIRE(std::equal(a, a + first.operator_size(), b));
+    }
+    REQUIRE(second.computed() == 0);
+
+    // New offsets are still computed lazily on top of the file.
+    second.get({2, 2, 12});
+    REQUIRE(second.computed() == 1);
+    REQUIRE(second.size() == offsets.size() + 1);
+
+}
+
+TEST_CASE("Stale or malformed M2L cache files are rejected", "[M2LCache]") {
+
+    TempFile file("test_m2l_cache_stale.bin");
+    {
+        M2LCache<SphericalOperators> cache(SphericalOperators(6));
+        cache.get({8, 0, 0});
+        cache.save(file.path);
+    }
+
+    // Another order, and another operator family.
+    M2LCache<SphericalOperators> order(SphericalOperators(7), file.path);
+    REQUIRE(order.rejected());
+    REQUIRE(order.size() == 0);
+    M2LCache<CartesianOperators<6>> family(CartesianOperators<6>(), file.path);
+    REQUIRE(family.rejected());
+
+    // Another format version.
+    {
+        std::fstream f(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t version = M2L_CACHE_VERSION + 1;
+        f.seekp(8);
+        f.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    }
+    M2LCache<SphericalOperators> version(SphericalOperators(6), file.path);
+    REQUIRE(version.rejected());
+    REQUIRE_FALSE(version.loaded());
+
+    // A truncated file.
+    {
+        std::ofstream f(file.path, std::ios::binary | std::ios::trunc);
+        f << "FMMM2LC";
+    }
+    M2LCache<SphericalOperators> truncated(SphericalOperators(6), file.path);
+    REQUIRE(truncated.rejected());
+
+}
+
+// ######################################################################### //
+// # FMM.                                                                  # //
+// ######################################################################### //
+
+TEST_CASE("Fmm with an M2L cache matches Fmm without", "[M2LCache]") {
+
+    std::mt19937_64 rng(37);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 5000;
+    std::vector<Vector3<double>> pts(n);
+    std::vector<double> q(n);
+    for (auto &x: pts) x = {u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+
+    ThreadPool pool(3);
+    TaskPool tasks(3);
+    TempFile file("test_m2l_cache_fmm.bin");
+    Fmm<SphericalOperators> fmm(SphericalOperators(6), pts, q, {0.5, 32}, pool, tasks);
+
+    std::vector<double> ref(n), phi(n);
+    std::vector<Vector3<double>> fref(n), field(n);
+    fmm.evaluate(ref, fref);
+
+    size_t offsets;
+    {
+        M2LCache<SphericalOperators> cache(fmm.operators(), file.path);
+        fmm.use_m2l_cache(&cache);
+        fmm.evaluate(phi, field);
+        offsets = cache.size();
+        REQUIRE(cache.computed() == offsets);
+        REQUIRE(offsets < fmm.m2l_count() / 10);
+        cache.save(file.path);
+    }
+
+    double num = 0.0, den = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        num += (phi[i] - ref[i]) * (phi[i] - ref[i]);
+        den += ref[i] * ref[i];
+    }
+    REQUIRE(std::sqrt(num / den) < 1.0e-12);
+
+    // A second run starts from the file and computes nothing.
+    M2LCache<SphericalOperators> cache(fmm.operators(), file.path);
+    REQUIRE(cache.loaded());
+    fmm.use_m2l_cache(&cache);
+    REQUIRE(cache.computed() == 0);
+    std::vector<double> again(n);
+    fmm.evaluate(again, field);
+    REQUIRE(again == phi);
+    fmm.use_m2l_cache(nullptr);
+
+}
@@ -0,0 +1,88 @@
+/*
+ * @file test_meshes.hpp
+ * @author Lesleis Nagy
+ * @date 19/10/2026
+ * @brief Structured tetrahedral meshes of a cube, shared by the tests and
+ *        benchmarks
+ */
+
+#ifndef FMM_TEST_MESHES_HPP
+#define FMM_TEST_MESHES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "tet_mesh.hpp"
+
+/**
+ * @brief The nodes and connectivity of the cube [0, side]^3 cut into n^3
+ *        cells of six tetrahedra each (Kuhn triangulation), leaving out the
+ *        cells of the upper octant if notch is set (a mesh that is not
+ *        convex).
+ */
+inline void cube_mesh(size_t n, double side, std::vector<Vector3<double>> &nodes, std::vector<uint32_t> &elements,
+                      bool notch = false) {
+    const size_t s = n + 1;
+    auto id = [&](size_t i, size_t j, size_t k) { return uint32_t((i * s + j) * s + k); };
+    nodes.clear();
+    for (size_t i = 0; i < s; ++i) {
+        for (size_t j = 0; j < s; ++j) {
+            for (size_t k = 0; k < s; ++k) {
+                nodes.push_back(side / double(n) * Vector3<double>{double(i), double(j), double(k)});
+            }
+        }
+    }
+    // The six paths from corner 000 to corner 111 along the cell's edges.
+    const size_t paths[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    elements.clear();
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t k = 0; k < n; ++k) {
+                if (notch && 2 * i >= n && 2 * j >= n && 2 * k >= n) continue;
+                for (auto &path: paths) {
+                    size_t c[3] = {i, j, k};
+                    elements.push_back(id(c[0], c[1], c[2]));
+                    for (size_t axis: path) {
+                        ++c[axis];
+                        elements.push_back(id(c[0], c[1], c[2]));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Moves every coordinate of the nodes of cube_mesh(n, side) that is
+ *        not on the boundary by up to a tenth of a cell, so that elements
+ *        have no common shape.
+ */
+inline void jitter_cube_nodes(size_t n, double side, unsigned seed, std::vector<Vector3<double>> &nodes) {
+    std::mt19937_64 rng(seed);
+    const double h = side / double(n);
+    std::uniform_real_distribution<double> u(-0.1 * h, 0.1 * h);
+    auto jitter = [&](double &c) {
+        if (c > 0.5 * h && c < side - 0.5 * h) c += u(rng);
+    };
+    for (Vector3<double> &p: nodes) {
+        jitter(p.x);
+        jitter(p.y);
+        jitter(p.z);
+    }
+}
+
+/**
+ * @brief The TetMesh of cube_mesh(n, side).
+ */
+inline TetMesh cube_tet_mesh(size_t n, double side, ThreadPool &pool = ThreadPool::global()) {
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(n, side, nodes, elements);
+    return TetMesh(nodes, elements, pool);
+}
+
+#endif //FMM_TEST_MESHES_HPP
@@ -0,0 +1,209 @@
+/*
+ * @file test_micromagnetics.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the micromagnetic energy and gradient evaluator
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "micromagnetics.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+static Vector3Array<double> random_field(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> normal;
+    Vector3Array<double> m(n);
+    for (size_t i = 0; i < n; ++i) {
+        Vector3<double> v{normal(gen), normal(gen), normal(gen)};
+        m.set(i, v / std::sqrt(inner(v, v)));
+    }
+    return m;
+}
+
+static Vector3Array<double> uniform_field(size_t n, const Vector3<double> &v) {
+    Vector3Array<double> m(n);
+    for (size_t i = 0; i < n; ++i) m.set(i, v);
+    return m;
+}
+
+/**
+ * @brief Every term on, with rotated anisotropy axes and an applied field.
+ */
+static MicromagMaterial material() {
+    MicromagMaterial mat;
+    mat.uniaxial = 2.0e4;
+    mat.easy_axis = Vector3<double>{1.0, 2.0, 2.0} / 3.0;
+    const double c = std::cos(0.3), s = std::sin(0.3);
+    mat.cubic_axes = {c, -s, 0.0, s, c, 0.0, 0.0, 0.0, 1.0};
+    mat.applied = {1.0e4, -2.0e4, 5.0e3};
+    return mat;
+}
+
+// ######################################################################### //
+// # Energies.                                                             # //
+// ######################################################################### //
+
+TEST_CASE("Uniform states have the analytic energies", "[Micromagnetics]") {
+
+    const double side = 50.0e-9, volume = side * side * side;
+    TetMesh mesh = cube_tet_mesh(8, side);
+    MicromagMaterial mat = material();
+    MicromagEvaluator evaluator(mesh, mat);
+    const size_t n = mesh.node_count();
+
+    const Vector3<double> u = mat.easy_axis;
+    Vector3Array<double> m = uniform_field(n, u), gradient(n), field(n);
+    double total = evaluator.evaluate(m, gradient);
+    const MicromagEnergies &e = evaluator.energies();
+    REQUIRE(std::abs(e.exchange) < 1.0e-30);
+    REQUIRE(e.uniaxial == Approx(-mat.uniaxial * volume).epsilon(1.0e-12));
+    REQUIRE(e.zeeman == Approx(-MU0 * mat.ms * inner(mat.applied, u) * volume).epsilon(1.0e-12));
+    REQUIRE(total == Approx(e.exchange + e.uniaxial + e.cubic + e.zeeman + e.demag).epsilon(1.0e-14));
+
+    // A uniformly magnetized cube has demagnetizing factor 1/3.
+    REQUIRE(e.demag == Approx(MU0 * mat.ms * mat.ms * volume / 6.0).epsilon(0.02));
+
+    // Along a body diagonal of the crystal axes a_i^2 = 1/3.
+    const auto &r = mat.cubic_axes.m;
+    const Vector3<double> diagonal = Vector3<double>{r[0][0] + r[1][0] + r[2][0], r[0][1] + r[1][1] + r[2][1],
+                                                     r[0][2] + r[1][2] + r[2][2]} / std::sqrt(3.0);
+    m = uniform_field(n, diagonal);
+    evaluator.energy(m);
+    REQUIRE(evaluator.energies().cubic == Approx(mat.cubic * volume / 3.0).epsilon(1.0e-12));
+
+    // Along the easy axis the uniaxial field is 2 Ku / (mu0 Ms) u at every
+    // node.
+    evaluator.set_terms({false, true, false, false, false});
+    m = uniform_field(n, u);
+    evaluator.evaluate(m, gradient);
+    evaluator.effective_field(gradient, field);
+    const double h = 2.0 * mat.uniaxial / (MU0 * mat.ms);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(field[i].x == Approx(h * u.x).epsilon(1.0e-12));
+        REQUIRE(field[i].y == Approx(h * u.y).epsilon(1.0e-12));
+        REQUIRE(field[i].z == Approx(h * u.z).epsilon(1.0e-12));
+    }
+
+}
+
+TEST_CASE("The exchange energy of a helix converges", "[Micromagnetics]") {
+
+    // m = (cos kx, sin kx, 0) has |grad m|^2 = k^2.
+    const double side = 40.0e-9, k = std::numbers::pi / side;
+    MicromagMaterial mat;
+    MicromagOptions options;
+    options.terms = {true, false, false, false, false};
+    const double exact = mat.exchange * k * k * side * side * side;
+    double previous = 1.0;
+    for (size_t cells: {size_t(4), size_t(8), size_t(16)}) {
+        TetMesh mesh = cube_tet_mesh(cells, side);
+        Vector3Array<double> m(mesh.node_count());
+        for (size_t i = 0; i < mesh.node_count(); ++i) {
+            const double x = mesh.node(i).x;
+            m.set(i, {std::cos(k * x), std::sin(k * x), 0.0});
+        }
+        MicromagEvaluator evaluator(mesh, mat, options);
+        const double error = std::abs(evaluator.energy(m) - exact) / exact;
+        REQUIRE(error < previous / 3.0);
+        previous = error;
+    }
+    REQUIRE(previous < 0.01);
+
+}
+
+// ######################################################################### //
+// # Gradients.                                                            # //
+// ######################################################################### //
+
+TEST_CASE("Gradients are the derivatives of the energies", "[Micromagnetics]") {
+
+    TetMesh mesh = cube_tet_mesh(3, 30.0e-9);
+    const size_t n = mesh.node_count();
+    MicromagEvaluator evaluator(mesh, material());
+    Vector3Array<double> m = random_field(n, 7), gradient(n);
+    evaluator.evaluate(m, gradient);
+
+    // Central differences on a spread of nodes and components: all terms
+    // are polynomials of degree at most 4 in m.
+    double largest = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        largest = std::max({largest, std::abs(gradient[i].x), std::abs(gradient[i].y), std::abs(gradient[i].z)});
+    }
+    const double h = 1.0e-4;
+    for (size_t i = 0; i < n; i += 5) {
+        for (size_t c = 0; c < 3; ++c) {
+            double *component = c == 0 ? m.x() : c == 1 ? m.y() : m.z();
+            const double saved = component[i];
+            component[i] = saved + h;
+            const double up = evaluator.energy(m);
+            component[i] = saved - h;
+            const double down = evaluator.energy(m);
+            component[i] = saved;
+            const double got = c == 0 ? gradient[i].x : c == 1 ? gradient[i].y : gradient[i].z;
+            REQUIRE((up - down) / (2.0 * h) == Approx(got).margin(1.0e-7 * largest));
+        }
+    }
+
+}
+
+TEST_CASE("Fused, per term and Fmm evaluations agree", "[Micromagnetics]") {
+
+    ThreadPool one(1), three(3);
+    TetMesh mesh = cube_tet_mesh(8, 60.0e-9, three);
+    const size_t n = mesh.node_count();
+    Vector3Array<double> m = random_field(n, 11), g1(n), g3(n), gs(n), gf(n);
+
+    MicromagEvaluator serial(mesh, material(), {}, one);
+    MicromagEvaluator fused(mesh, material(), {}, three);
+    const double e1 = serial.evaluate(m, g1);
+    const double e3 = fused.evaluate(m, g3);
+    REQUIRE(e1 == e3);
+    for (size_t i = 0; i < n; ++i) REQUIRE(g1[i].x == g3[i].x);
+    REQUIRE(fused.timings().fused > 0.0);
+    REQUIRE(fused.timings().demag > 0.0);
+    REQUIRE(fused.energy(m) == Approx(e3).epsilon(1.0e-13));
+
+    MicromagOptions options;
+    options.fused = false;
+    MicromagEvaluator separate(mesh, material(), options, three);
+    REQUIRE(separate.evaluate(m, gs) == Approx(e3).epsilon(1.0e-13));
+    REQUIRE(separate.timings().fused == 0.0);
+    REQUIRE(separate.timings().exchange > 0.0);
+    REQUIRE(separate.timings().cubic > 0.0);
+
+    options.fused = true;
+    options.demag_direct_limit = 0;
+    options.demag_order = 10;
+    MicromagEvaluator multipole(mesh, material(), options, three);
+    multipole.evaluate(m, gf);
+    REQUIRE(multipole.energies().demag == Approx(fused.energies().demag).epsilon(1.0e-5));
+    double num = 0.0, den = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        Vector3<double> d = gs[i] - g3[i], f = gf[i] - g3[i];
+        REQUIRE(inner(d, d) <= 1.0e-24 * inner(g3[i], g3[i]) + 1.0e-60);
+        num += inner(f, f);
+        den += inner(g3[i], g3[i]);
+    }
+    REQUIRE(std::sqrt(num / den) < 1.0e-5);
+
+    Vector3Array<double> wrong(n - 1);
+    REQUIRE_THROWS_AS(fused.energy(wrong), std::invalid_argument);
+    REQUIRE_THROWS_AS(fused.evaluate(m, wrong), std::invalid_argument);
+    MicromagMaterial empty;
+    empty.ms = 0.0;
+    fused.set_material(empty);
+    REQUIRE_THROWS_AS(fused.effective_field(g3, gs), std::invalid_argument);
+
+}
@@ -0,0 +1,240 @@
+/*
+ * @file test_minimizer.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test LBFGS and nonlinear CG minimization of unit vector fields
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "micromagnetics.hpp"
+#include "minimizer.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+static Vector3Array<double> random_vectors(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> normal;
+    Vector3Array<double> v(n);
+    for (size_t i = 0; i < n; ++i) v.set(i, {normal(gen), normal(gen), normal(gen)});
+    return v;
+}
+
+static double largest_length_error(const Vector3Array<double> &m) {
+    double largest = 0.0;
+    for (size_t i = 0; i < m.size(); ++i) largest = std::max(largest, std::abs(std::sqrt(inner(m[i], m[i])) - 1.0));
+    return largest;
+}
+
+// ######################################################################### //
+// # Normalization.                                                        # //
+// ######################################################################### //
+
+TEST_CASE("normalize_vectors scales to unit length", "[Minimizer]") {
+
+    const size_t n = 40000;
+    Vector3Array<double> v = random_vectors(n, 1), u = v;
+    u.set(17, {0.0, 0.0, 0.0});
+    v.set(17, {0.0, 0.0, 0.0});
+    normalize_vectors(u);
+    for (size_t i = 0; i < n; ++i) {
+        if (i == 17) continue;
+        const double r = std::sqrt(inner(v[i], v[i]));
+        REQUIRE(u[i].x == Approx(v[i].x / r).epsilon(1.0e-15));
+        REQUIRE(u[i].z == Approx(v[i].z / r).epsilon(1.0e-15));
+    }
+    REQUIRE(u[17].x == 0.0);
+    REQUIRE(u[17].y == 0.0);
+    REQUIRE(u[17].z == 0.0);
+
+}
+
+// ######################################################################### //
+// # Minimization.                                                         # //
+// ######################################################################### //
+
+TEST_CASE("Independent Zeeman energies reach their minima", "[Minimizer]") {
+
+    // E = -sum w_i m_i . h_i is least with m_i = h_i / |h_i|, -sum w_i |h_i|;
+    // scaling w_i over three decades makes the problem badly conditioned
+    // for steepest descent.
+    const size_t n = 5000;
+    Vector3Array<double> h = random_vectors(n, 2), start = random_vectors(n, 3);
+    std::vector<double> w(n);
+    double least = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        w[i] = std::pow(10.0, 3.0 * double(i % 97) / 96.0);
+        least -= w[i] * std::sqrt(inner(h[i], h[i]));
+    }
+    auto energy = [&](const Vector3Array<double> &m, Vector3Array<double> &g) {
+        double e = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            e -= w[i] * inner(m[i], h[i]);
+            g.set(i, -w[i] * h[i]);
+        }
+        return e;
+    };
+
+    for (MinimizeMethod method: {MinimizeMethod::lbfgs, MinimizeMethod::cg}) {
+        MinimizeOptions options;
+        options.method = method;
+        UnitVectorMinimizer minimizer(n, options);
+        Vector3Array<double> m = start;
+        MinimizeStats stats = minimizer.minimize(energy, m);
+        REQUIRE(stats.converged);
+        REQUIRE(stats.energy == Approx(least).epsilon(1.0e-10));
+        REQUIRE(stats.evaluations >= stats.iterations + 1);
+        REQUIRE(stats.history.size() == stats.iterations + 1);
+        for (size_t k = 1; k < stats.history.size(); ++k) REQUIRE(stats.history[k] < stats.history[k - 1]);
+        REQUIRE(largest_length_error(m) < 1.0e-14);
+        // The tangent gradient at node i is w_i |h_i| sin t_i, with t_i the
+        // angle from the minimum.
+        for (size_t i = 0; i < n; ++i) {
+            const double length = std::sqrt(inner(h[i], h[i]));
+            const double sine = std::min(1.0, stats.gradient_norm / (w[i] * length));
+            REQUIRE(inner(m[i], h[i]) / length >= std::sqrt(1.0 - sine * sine) - 1.0e-14);
+        }
+        REQUIRE(stats.timings.evaluate > 0.0);
+        REQUIRE(stats.timings.total >= stats.timings.evaluate);
+        REQUIRE(stats.evaluations_per_second > 0.0);
+    }
+
+}
+
+TEST_CASE("LBFGS drops a negative curvature pair from a full history", "[Minimizer]") {
+
+    // One vector in the xy-plane at angle t, with E = -(t - 1)^3 - t / 20:
+    // E decreases along t everywhere and is convex below t = 1, concave
+    // above, so with one pair kept the history is full on the way to t = 1
+    // and the first step past it gives a pair with s . y < 0. That pair is
+    // dropped with the (older) one it would replace, so the next step is a
+    // steepest descent one: m - t normalized, turning by atan(|E'(t)|).
+    auto slope = [](double t) { return -3.0 * (t - 1.0) * (t - 1.0) - 0.05; };
+    std::vector<double> angles;
+    auto energy = [&](const Vector3Array<double> &m, Vector3Array<double> &g) {
+        const double x = m.x()[0], y = m.y()[0], t = std::atan2(y, x), r2 = x * x + y * y;
+        angles.push_back(t);
+        g.set(0, {-y / r2 * slope(t), x / r2 * slope(t), 0.0});
+        return -std::pow(t - 1.0, 3.0) - 0.05 * t;
+    };
+
+    MinimizeOptions options;
+    options.history = 1;
+    options.max_iterations = 10;
+    UnitVectorMinimizer minimizer(1, options);
+    Vector3Array<double> m(1);
+    m.set(0, {1.0, 0.0, 0.0});
+    MinimizeStats stats = minimizer.minimize(energy, m);
+    // Every first trial is accepted, so angles holds the iterates.
+    REQUIRE(stats.evaluations == stats.iterations + 1);
+
+    size_t rejected = 0;
+    for (size_t k = 1; k + 1 < angles.size(); ++k) {
+        const double s = angles[k + 1] - angles[k], y = slope(angles[k + 1]) - slope(angles[k]);
+        if (s * y <= 0.0) {
+            rejected = k + 1;
+            break;
+        }
+    }
+    REQUIRE(rejected >= 2);
+    REQUIRE(rejected + 1 < angles.size());
+    const double t = angles[rejected];
+    REQUIRE(std::abs(slope(t)) < options.max_angle);
+    REQUIRE(angles[rejected + 1] - t == Approx(std::atan(std::abs(slope(t)))).epsilon(1.0e-12));
+
+}
+
+TEST_CASE("A micromagnetic state relaxes", "[Minimizer]") {
+
+    TetMesh mesh = cube_tet_mesh(6, 40.0e-9);
+    const size_t n = mesh.node_count();
+    MicromagMaterial mat;
+    mat.uniaxial = 5.0e4;
+    mat.cubic = 0.0;
+    mat.easy_axis = Vector3<double>{1.0, 1.0, 0.0} / std::sqrt(2.0);
+    mat.applied = {0.0, 0.0, 1.0e5};
+    MicromagOptions micromag;
+    micromag.terms.demag = false;
+    MicromagEvaluator evaluator(mesh, mat, micromag);
+    auto energy = [&](const Vector3Array<double> &m, Vector3Array<double> &g) { return evaluator.evaluate(m, g); };
+
+    // With no demagnetizing field the minimum is uniform, at the angle t
+    // from the easy axis (towards z) that minimizes
+    // -Ku cos^2 t - mu0 Ms H sin t: sin t = mu0 Ms H / (2 Ku).
+    const double volume = 40.0e-9 * 40.0e-9 * 40.0e-9;
+    const double sine = MU0 * mat.ms * mat.applied.z / (2.0 * mat.uniaxial);
+    const double least = (-mat.uniaxial * (1.0 - sine * sine) - MU0 * mat.ms * mat.applied.z * sine) * volume;
+
+    std::vector<size_t> evaluations;
+    for (MinimizeMethod method: {MinimizeMethod::lbfgs, MinimizeMethod::cg}) {
+        MinimizeOptions options;
+        options.method = method;
+        options.tolerance = 1.0e-6;
+        UnitVectorMinimizer minimizer(n, options);
+        // A small perturbation of the uniform state on the easy axis, in
+        // the basin of the minimum on that side.
+        Vector3Array<double> m = random_vectors(n, 5);
+        for (size_t i = 0; i < n; ++i) m.set(i, mat.easy_axis + 0.3 * m[i]);
+        MinimizeStats stats = minimizer.minimize(energy, m);
+        REQUIRE(stats.converged);
+        REQUIRE(stats.energy == Approx(least).epsilon(1.0e-8));
+        REQUIRE(largest_length_error(m) < 1.0e-14);
+        for (size_t i = 0; i < n; ++i) REQUIRE(m[i].z == Approx(sine).epsilon(1.0e-4));
+        evaluations.push_back(stats.evaluations);
+    }
+    // The exchange stiffness makes this badly conditioned: LBFGS needs far
+    // fewer evaluations.
+    REQUIRE(evaluations[0] < evaluations[1]);
+
+}
+
+TEST_CASE("Minimization does not depend on the thread count", "[Minimizer]") {
+
+    ThreadPool one(1), three(3);
+    TetMesh mesh = cube_tet_mesh(14, 60.0e-9);
+    const size_t n = mesh.node_count();
+    MicromagMaterial mat;
+    mat.uniaxial = 1.0e4;
+    MicromagOptions micromag;
+    micromag.terms.demag = false;
+    MicromagEvaluator evaluator(mesh, mat, micromag, one);
+    auto energy = [&](const Vector3Array<double> &m, Vector3Array<double> &g) { return evaluator.evaluate(m, g); };
+
+    MinimizeOptions options;
+    options.history = 5;
+    options.max_iterations = 40;
+    UnitVectorMinimizer serial(n, options, one), parallel(n, options, three);
+    Vector3Array<double> m1 = random_vectors(n, 9), m3 = m1;
+    MinimizeStats s1 = serial.minimize(energy, m1);
+    MinimizeStats s3 = parallel.minimize(energy, m3);
+    REQUIRE(s1.iterations == 40);
+    REQUIRE(s1.evaluations == s3.evaluations);
+    REQUIRE(s1.energy == s3.energy);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(m1[i].x == m3[i].x);
+        REQUIRE(m1[i].y == m3[i].y);
+        REQUIRE(m1[i].z == m3[i].z);
+    }
+
+    // Reuse: a second run from the same start repeats the first.
+    Vector3Array<double> again = random_vectors(n, 9);
+    MinimizeStats s2 = serial.minimize(energy, again);
+    REQUIRE(s2.energy == s1.energy);
+
+    Vector3Array<double> wrong(n - 1);
+    REQUIRE_THROWS_AS(serial.minimize(energy, wrong), std::invalid_argument);
+    options.history = 0;
+    REQUIRE_THROWS_AS(UnitVectorMinimizer(n, options), std::invalid_argument);
+    options.method = MinimizeMethod::cg;
+    REQUIRE_NOTHROW(UnitVectorMinimizer(n, options));
+
+}
@@ -0,0 +1,156 @@
+/*
+ * @file test_mparray.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test contiguous MPFR arrays and their batch kernels
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <random>
+
+#include "linalg.hpp"
+#include "mparray.hpp"
+
+// ######################################################################### //
+// # Storage.                                                              # //
+// ######################################################################### //
+
+TEST_CASE("MpArray limbs are contiguous", "[MpArray]") {
+
+    MpArray a(16, 200);
+
+    REQUIRE(a.size() == 16);
+    REQUIRE(a.precision() == 200);
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(mpfr_get_prec(a[i]) == 200);
+        REQUIRE(mpfr_zero_p(a[i]));
+        REQUIRE(mpfr_custom_get_significand(a[i]) == a.limbs() + i * a.limbs_per_value());
+    }
+
+}
+
+TEST_CASE("MpArray copy and move keep the slab", "[MpArray]") {
+
+    MpArray a(4, 128);
+    for (size_t i = 0; i < 4; ++i) a.set(i, 0.5 * static_cast<double>(i));
+
+    MpArray b = a;
+    const mp_limb_t *slab = b.limbs();
+    MpArray c = std::move(b);
+
+    REQUIRE(c.limbs() == slab);
+    for (size_t i = 0; i < 4; ++i) {
+        REQUIRE(c.get(i).to_double() == 0.5 * static_cast<double>(i));
+        REQUIRE(mpfr_custom_get_significand(c[i]) == c.limbs() + i * c.limbs_per_value());
+    }
+
+}
+
+// ######################################################################### //
+// # Batch kernels.                                                        # //
+// ######################################################################### //
+
+TEST_CASE("MpArray elementwise kernels", "[MpArray]") {
+
+    MpArray a(3, 128), b(3, 128), r(3, 128);
+    for (size_t i = 0; i < 3; ++i) {
+        a.set(i, 1.0 + static_cast<double>(i));
+        b.set(i, 2.0);
+    }
+
+    mp_batch_add(r, a, b);
+    REQUIRE(r.get(2).to_double() == 5.0);
+    mp_batch_sub(r, a, b);
+    REQUIRE(r.get(0).to_double() == -1.0);
+    mp_batch_mul(r, a, b);
+    REQUIRE(r.get(1).to_double() == 4.0);
+    mp_batch_div(r, a, b);
+    REQUIRE(r.get(2).to_double() == 1.5);
+
+    MpArray bad(2, 128);
+    REQUIRE_THROWS_AS(mp_batch_add(r, a, bad), std::invalid_argument);
+
+}
+
+TEST_CASE("MpArray batch inner product of Vector3", "[MpArray, Vector3]") {
+
+    MpArray a(3 * 2, 128), b(3 * 2, 128), r(2, 128);
+    mp_store(a, 0, Vector3<MpReal>{1.0, 2.0, 3.0});
+    mp_store(b, 0, Vector3<MpReal>{4.0, 5.0, 6.0});
+    mp_store(a, 1, Vector3<MpReal>{1.0, 0.0, 0.0});
+    mp_store(b, 1, Vector3<MpReal>{0.0, 1.0, 0.0});
+
+    mp_batch_inner<3>(r, a, b);
+
+    REQUIRE(r.get(0).to_double() == 32.0);
+    REQUIRE(r.get(1).to_double() == 0.0);
+    REQUIRE(mp_load_vector3(a, 0).z.to_double() == 3.0);
+
+}
+
+TEST_CASE("MpArray batch determinants", "[MpArray, Matrix3x3, Matrix4x4]") {
+
+    Matrix3x3<MpReal> m3 = {1.0,  2.0,  3.0,
+                            0.0,  1.0, -7.0,
+                            9.0, 10.0, 11.0};
+
+    Matrix4x4<MpReal> m4 = {1.0,  2.0,  3.0,  4.0,
+                            0.0,  1.0, -7.0, -8.0,
+                            9.0, 10.0, 11.0, 12.0,
+                            0.0,  0.0, -3.0, 13.0};
+
+    MpArray a3(9, 128), r3(1, 128);
+    mp_store(a3, 0, m3);
+    mp_batch_det3(r3, a3);
+    REQUIRE(r3.get(0).to_double() == -72.0);
+
+    MpArray a4(16, 128), r4(1, 128);
+    mp_store(a4, 0, m4);
+    mp_batch_det4(r4, a4);
+    REQUIRE(r4.get(0).to_double() == -1200.0);
+
+}
+
+TEST_CASE("MpArray threaded batches match the linalg templates", "[MpArray, Matrix4x4]") {
+
+    const size_t n = 5000;
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+
+    MpArray a(16 * n, 160), r(n, 160);
+    std::vector<Matrix4x4<MpReal>> ms(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (auto &row: ms[i].m)
+            for (auto &e: row) e = MpReal(u(rng), 160);
+        mp_store(a, i, ms[i]);
+    }
+
+    mp_batch_det4(r, a);
+
+    for (size_t i = 0; i < n; i += 97) {
+        REQUIRE(r.get(i).to_double() == Approx(det(ms[i]).to_double()).epsilon(1e-12));
+    }
+
+}
+
+TEST_CASE("MpArray batch adjugate matches the linalg template", "[MpArray, Matrix4x4]") {
+
+    Matrix4x4<MpReal> m = {1.0,  2.0,  3.0,  4.0,
+                           0.0,  1.0, -7.0, -8.0,
+                           9.0, 10.0, 11.0, 12.0,
+                           0.0,  0.0, -3.0, 13.0};
+
+    MpArray a(16, 128), r(16, 128);
+    mp_store(a, 0, m);
+    mp_batch_adj4(r, a);
+
+    Matrix4x4<MpReal> expected = adj(m);
+    Matrix4x4<MpReal> result = mp_load_matrix4x4(r, 0);
+
+    for (size_t i = 0; i < 4; ++i)
+        for (size_t j = 0; j < 4; ++j) REQUIRE(result(i, j) == expected(i, j));
+
+}
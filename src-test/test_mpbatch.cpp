@@ -0,0 +1,125 @@
+/*
+ * @file test_mpbatch.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the thread parallel high precision batch engine
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include "linalg.hpp"
+#include "mpbatch.hpp"
+
+static std::vector<Matrix4x4<MpReal>> random_matrices(size_t n, mpfr_prec_t prec) {
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Matrix4x4<MpReal>> ms(n);
+    for (auto &m: ms)
+        for (auto &row: m.m)
+            for (auto &e: row) e = MpReal(u(rng), prec);
+    return ms;
+}
+
+// ######################################################################### //
+// # Per-thread state.                                                     # //
+// ######################################################################### //
+
+TEST_CASE("MpThreadState installs and restores the default precision", "[MpThreadState]") {
+
+    mpfr_prec_t before = mpfr_get_default_prec();
+    {
+        MpThreadState state(300, false);
+        REQUIRE(mpfr_get_default_prec() == 300);
+        REQUIRE(MpReal(1.0).precision() == 300);
+    }
+    REQUIRE(mpfr_get_default_prec() == before);
+
+}
+
+// ######################################################################### //
+// # Batch engine.                                                         # //
+// ######################################################################### //
+
+TEST_CASE("MpBatchEngine determinant and adjugate", "[MpBatchEngine, Matrix4x4]") {
+
+    std::vector<Matrix4x4<MpReal>> ms = {{1.0,  2.0,  3.0,  4.0,
+                                          0.0,  1.0, -7.0, -8.0,
+                                          9.0, 10.0, 11.0, 12.0,
+                                          0.0,  0.0, -3.0, 13.0}};
+
+    MpBatchEngine engine(128, 4);
+
+    std::vector<MpReal> d = engine.det(ms);
+    REQUIRE(d[0].to_double() == -1200.0);
+
+    std::vector<Matrix4x4<MpReal>> a = engine.adj(ms);
+    Matrix4x4<MpReal> expected = adj(ms[0]);
+    for (size_t i = 0; i < 4; ++i)
+        for (size_t j = 0; j < 4; ++j) REQUIRE(a[0](i, j) == expected(i, j));
+
+}
+
+TEST_CASE("MpBatchEngine results do not depend on the thread count", "[MpBatchEngine]") {
+
+    auto ms = random_matrices(1000, 192);
+
+    MpBatchEngine one(192, 1, 32);
+    MpBatchEngine many(192, 8, 32);
+
+    std::vector<MpReal> d1 = one.det(ms);
+    std::vector<MpReal> d8 = many.det(ms);
+    for (size_t i = 0; i < ms.size(); ++i) REQUIRE(d1[i] == d8[i]);
+
+    REQUIRE(one.sum(d1) == many.sum(d8));
+
+    auto a1 = one.adj(ms);
+    auto a8 = many.adj(ms);
+    for (size_t i = 0; i < ms.size(); i += 37) REQUIRE(inner(a1[i], a1[i]) == inner(a8[i], a8[i]));
+
+}
+
+TEST_CASE("MpBatchEngine map runs at the engine precision", "[MpBatchEngine]") {
+
+    std::vector<double> in(100, 1.0);
+    MpBatchEngine engine(256, 4, 8);
+
+    std::vector<MpReal> out = engine.map(std::span<const double>(in), [](double x) {
+        return MpReal(x) / MpReal(3.0);
+    });
+
+    for (auto &x: out) {
+        REQUIRE(x.precision() == 256);
+        REQUIRE(x.to_double() == Approx(1.0 / 3.0));
+    }
+
+}
+
+TEST_CASE("MpBatchEngine at the default shard size", "[MpBatchEngine]") {
+
+    auto ms = random_matrices(300, 192);
+
+    MpBatchEngine reference(192, 1, 8);
+    MpBatchEngine engine(192, 4);
+
+    std::vector<MpReal> d0 = reference.det(ms);
+    auto a0 = reference.adj(ms);
+
+    std::vector<MpReal> d = engine.det(ms);
+    auto a = engine.adj(ms);
+    for (size_t i = 0; i < ms.size(); ++i) {
+        REQUIRE(d[i] == d0[i]);
+        for (size_t j = 0; j < 4; ++j)
+            for (size_t k = 0; k < 4; ++k) REQUIRE(a[i](j, k) == a0[i](j, k));
+    }
+
+    // Shards must not wait on the global pool while a task of it is waiting
+    // on the engine.
+    std::vector<MpReal> nested;
+    ThreadPool::global().run(1, [&](size_t, size_t) { nested = engine.det(ms); });
+    for (size_t i = 0; i < ms.size(); ++i) REQUIRE(nested[i] == d0[i]);
+
+}
@@ -0,0 +1,102 @@
+/*
+ * @file test_mpreal.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the MPFR backed scalar type
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include "linalg.hpp"
+#include "mpreal.hpp"
+
+// ######################################################################### //
+// # Scalar arithmetic.                                                    # //
+// ######################################################################### //
+
+TEST_CASE("MpReal arithmetic", "[MpReal]") {
+
+    MpReal a(1.5, 128);
+    MpReal b(0.25, 128);
+
+    REQUIRE((a + b).to_double() == 1.75);
+    REQUIRE((a - b).to_double() == 1.25);
+    REQUIRE((a * b).to_double() == 0.375);
+    REQUIRE((a / b).to_double() == 6.0);
+    REQUIRE((-a).to_double() == -1.5);
+
+}
+
+TEST_CASE("MpReal result precision is the larger operand precision", "[MpReal]") {
+
+    MpReal a(1.0, 64);
+    MpReal b(3.0, 256);
+
+    REQUIRE((a + b).precision() == 256);
+    REQUIRE((a / b).precision() == 256);
+
+    a += b;
+    REQUIRE(a.precision() == 256);
+
+}
+
+TEST_CASE("MpReal carries more precision than double", "[MpReal]") {
+
+    MpReal one(1.0, 200);
+    MpReal tiny(1.0e-30, 200);
+
+    MpReal r = (one + tiny) - one;
+
+    REQUIRE(r.to_double() == Approx(1.0e-30));
+
+}
+
+TEST_CASE("MpReal copy and move", "[MpReal]") {
+
+    MpReal a(2.0, 100);
+    MpReal b = a;
+    MpReal c = std::move(a);
+
+    REQUIRE(b == c);
+    REQUIRE(c.precision() == 100);
+
+    a = b;
+    REQUIRE(a.to_double() == 2.0);
+
+}
+
+// ######################################################################### //
+// # Use with the linalg templates.                                        # //
+// ######################################################################### //
+
+TEST_CASE("Vector3<MpReal> inner and cross product", "[MpReal, Vector3]") {
+
+    Vector3<MpReal> v1 = {1.0, 2.0, 3.0};
+    Vector3<MpReal> v2 = {4.0, 5.0, 6.0};
+
+    REQUIRE(inner(v1, v2).to_double() == 32.0);
+
+    Vector3<MpReal> c = cross(v1, v2);
+
+    REQUIRE(c.x.to_double() == -3.0);
+    REQUIRE(c.y.to_double() ==  6.0);
+    REQUIRE(c.z.to_double() == -3.0);
+
+}
+
+TEST_CASE("Matrix4x4<MpReal> determinant and adjugate", "[MpReal, Matrix4x4]") {
+
+    Matrix4x4<MpReal> m = {1.0,  2.0,  3.0,  4.0,
+                           0.0,  1.0, -7.0, -8.0,
+                           9.0, 10.0, 11.0, 12.0,
+                           0.0,  0.0, -3.0, 13.0};
+
+    REQUIRE(det(m).to_double() == -1200.0);
+
+    Matrix4x4<MpReal> a = adj(m);
+
+    REQUIRE(a(0,0).to_double() == 1329.0);
+    REQUIRE(a(3,3).to_double() == -72.0);
+
+}
@@ -0,0 +1,237 @@
+/*
+ * @file test_octree.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test Morton keys, the parallel radix sort and the linear octree
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "octree.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+
+// ######################################################################### //
+// # Morton keys.                                                          # //
+// ######################################################################### //
+
+TEST_CASE("Morton encoding round trips and matches the magic bits", "[Morton]") {
+
+    std::mt19937 rng(30);
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t x = rng() % MORTON_CELLS, y = rng() % MORTON_CELLS, z = rng() % MORTON_CELLS;
+        REQUIRE(morton_spread3(x) == morton_spread3_magic(x));
+        REQUIRE(morton_compact3_magic(morton_spread3_magic(x)) == x);
+        uint32_t a, b, c;
+        morton_decode(morton_encode(x, y, z), a, b, c);
+        REQUIRE(a == x);
+        REQUIRE(b == y);
+        REQUIRE(c == z);
+    }
+
+    REQUIRE(morton_encode(1, 0, 0) == 1);
+    REQUIRE(morton_encode(0, 1, 0) == 2);
+    REQUIRE(morton_encode(0, 0, 1) == 4);
+    REQUIRE(morton_encode(MORTON_CELLS - 1, MORTON_CELLS - 1, MORTON_CELLS - 1) == (uint64_t{1} << 63) - 1);
+
+}
+
+// ######################################################################### //
+// # Radix sort.                                                           # //
+// ######################################################################### //
+
+TEST_CASE("radix_sort is a stable sort independent of the thread count", "[RadixSort]") {
+
+    std::mt19937_64 rng(31);
+    const size_t n = 200000;
+    std::vector<uint64_t> keys(n);
+    for (auto &k: keys) k = rng() % 5000 << 40 | (rng() & 0xff);
+    std::vector<uint32_t> values(n);
+    for (size_t i = 0; i < n; ++i) values[i] = static_cast<uint32_t>(i);
+
+    std::vector<std::pair<uint64_t, uint32_t>> expected(n);
+    for (size_t i = 0; i < n; ++i) expected[i] = {keys[i], values[i]};
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](auto &a, auto &b) { return a.first < b.first; });
+
+    for (size_t threads: {1, 3}) {
+        ThreadPool pool(threads);
+        std::vector<uint64_t> k = keys;
+        std::vector<uint32_t> v = values;
+        radix_sort(k, v, 64, pool);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(k[i] == expected[i].first);
+            REQUIRE(v[i] == expected[i].second);
+        }
+    }
+
+}
+
+// ######################################################################### //
+// # Octree.                                                               # //
+// ######################################################################### //
+
+TEST_CASE("LinearOctree partitions the points into bounded leaves", "[LinearOctree]") {
+
+    std::mt19937_64 rng(32);
+    std::normal_distribution<double> g(0.0, 1.0);
+    const size_t n = 50000;
+    std::vector<Vector3<double>> points(n);
+    for (auto &p: points) p = {g(rng), g(rng), 0.1 * g(rng)};
+
+    ThreadPool pool(4);
+    LinearOctree<double> tree(points, 32, pool);
+
+    // Every point lies in exactly one leaf, and no leaf is over-full.
+    size_t covered = 0, next = 0;
+    for (uint32_t l: tree.leaves()) {
+        const OctreeNode &leaf = tree.node(l);
+        REQUIRE(leaf.begin == next);
+        REQUIRE((leaf.size() <= 32 || leaf.level == MORTON_BITS));
+        covered += leaf.size();
+        next = leaf.end;
+
+        // The points of the leaf are inside its cell.
+        Vector3<double> c = tree.center(l);
+        double h = tree.half_width(l) * (1.0 + 1.0e-12);
+        for (uint32_t i = leaf.begin; i < leaf.end; ++i) {
+            Vector3<double> p = tree.points()[i];
+            REQUIRE(std::abs(p.x - c.x) <= h);
+            REQUIRE(std::abs(p.y - c.y) <= h);
+            REQUIRE(std::abs(p.z - c.z) <= h);
+        }
+    }
+    REQUIRE(covered == n);
+
+    // Children are consistent with their parents and can be found by key.
+    for (size_t i = 1; i < tree.nodes().size(); ++i) {
+        const OctreeNode &node = tree.node(i);
+        const OctreeNode &parent = tree.node(node.parent);
+        REQUIRE(node.level == parent.level + 1);
+        REQUIRE((node.key >> 3) == parent.key);
+        REQUIRE(node.begin >= parent.begin);
+        REQUIRE(node.end <= parent.end);
+        REQUIRE(i >= parent.first_child);
+        REQUIRE(i < parent.first_child + parent.nchildren);
+        REQUIRE(tree.find(node.key, node.level) == i);
+    }
+    REQUIRE(tree.find(0, tree.depth()) == LinearOctree<double>::npos);
+
+    // The permutation maps sorted points back to the input.
+    for (size_t i = 0; i < n; ++i) {
+        Vector3<double> p = points[tree.permutation()[i]];
+        REQUIRE(p.x == tree.points()[i].x);
+        REQUIRE(p.z == tree.points()[i].z);
+    }
+    REQUIRE(std::is_sorted(tree.keys().begin(), tree.keys().end()));
+
+}
+
+TEST_CASE("LinearOctree handles degenerate inputs", "[LinearOctree]") {
+
+    std::vector<Vector3<float>> none;
+    LinearOctree<float> empty(none);
+    REQUIRE(empty.nodes().size() == 1);
+    REQUIRE(empty.leaves().size() == 1);
+
+    std::vector<Vector3<float>> same(100, {1.0f, 2.0f, 3.0f});
+    LinearOctree<float> stack(same, 8);
+    REQUIRE(stack.leaves().size() == 1);
+    REQUIRE(stack.node(stack.leaves()[0]).level == MORTON_BITS);
+    REQUIRE(stack.node(stack.leaves()[0]).size() == 100);
+
+}
+
+// ######################################################################### //
+// # Updates.                                                              # //
+// ######################################################################### //
+
+/**
+ * @brief Whether a tree is a valid partition of the points, as built.
+ */
+static bool valid(const LinearOctree<double> &tree, const std::vector<Vector3<double>> &points) {
+    size_t next = 0;
+    for (uint32_t l: tree.leaves()) {
+        const OctreeNode &leaf = tree.node(l);
+        if (leaf.begin != next) return false;
+        next = leaf.end;
+        Vector3<double> c = tree.center(l);
+        double h = tree.half_width(l) * (1.0 + 1.0e-12);
+        for (uint32_t i = leaf.begin; i < leaf.end; ++i) {
+            Vector3<double> p = tree.points()[i];
+            if (std::abs(p.x - c.x) > h || std::abs(p.y - c.y) > h || std::abs(p.z - c.z) > h) return false;
+        }
+    }
+    for (size_t i = 1; i < tree.nodes().size(); ++i) {
+        const OctreeNode &node = tree.node(i), &parent = tree.node(node.parent);
+        if (node.begin < parent.begin || node.end > parent.end) return false;
+    }
+    for (size_t i = 0; i < points.size(); ++i) {
+        Vector3<double> p = points[tree.permutation()[i]];
+        if (p.x != tree.points()[i].x || p.y != tree.points()[i].y || p.z != tree.points()[i].z) return false;
+    }
+    return next == points.size() && std::is_sorted(tree.keys().begin(), tree.keys().end());
+}
+
+TEST_CASE("LinearOctree refits small motions and rebuilds large ones", "[LinearOctree]") {
+
+    std::mt19937_64 rng(39);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 40000;
+    std::vector<Vector3<double>> points(n);
+    for (auto &p: points) p = {u(rng), u(rng), u(rng)};
+
+    ThreadPool pool(3);
+    LinearOctree<double> tree(points, 32, pool);
+    auto jitter = [&](double step) {
+        for (auto &p: points) p = p + Vector3<double>{step * u(rng), step * u(rng), step * u(rng)};
+    };
+
+    // Points leave the tight cube of the first build, which is then padded
+    // so that later small steps refit.
+    for (auto &p: points) p = 1.001 * p;
+    REQUIRE(tree.update(points, {}, pool) == OctreeUpdate::rebuild);
+    REQUIRE(valid(tree, points));
+
+    // Small steps never rebuild: the nodes are refitted, or rebuilt on the
+    // sorted points when one enters a cell with no leaf (at the padded
+    // border, say).
+    for (int step = 0; step < 10; ++step) {
+        jitter(1.0e-3);
+        REQUIRE(tree.update(points, {}, pool) != OctreeUpdate::rebuild);
+        REQUIRE(valid(tree, points));
+    }
+
+    // Points that stay in their leaves' cells refit the same nodes.
+    size_t nodes = tree.nodes().size();
+    for (auto &p: points) p = p + Vector3<double>{1.0e-9, -1.0e-9, 1.0e-9};
+    REQUIRE(tree.update(points, {}, pool) == OctreeUpdate::refit);
+    REQUIRE(valid(tree, points));
+    REQUIRE(tree.nodes().size() == nodes);
+
+    // A stricter leaf policy rebuilds the nodes on the sorted points, as a
+    // full build in this cube would.
+    jitter(1.0e-3);
+    REQUIRE(tree.update(points, {0.25, 1.0, 0.0, 0.05}, pool) == OctreeUpdate::restructure);
+    REQUIRE(valid(tree, points));
+    for (uint32_t l: tree.leaves()) REQUIRE(tree.node(l).size() <= 32);
+
+    // Shuffling the points displaces too many of them.
+    std::shuffle(points.begin(), points.end(), rng);
+    REQUIRE(tree.update(points, {}, pool) == OctreeUpdate::rebuild);
+    REQUIRE(valid(tree, points));
+
+    // A different number of points.
+    points.resize(n / 2);
+    REQUIRE(tree.update(points, {}, pool) == OctreeUpdate::rebuild);
+    REQUIRE(valid(tree, points));
+
+}
@@ -0,0 +1,169 @@
+/*
+ * @file test_p2p.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the direct summation kernel
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "linalg.hpp"
+#include "p2p.hpp"
+#include "parallel.hpp"
+#include "soa.hpp"
+#include "test_lanes.hpp"
+
+/**
+ * @brief Reference potential and field in long double.
+ */
+static void reference(const std::vector<Vector3<double>> &s, const std::vector<double> &q,
+                      const std::vector<Vector3<double>> &t,
+                      std::vector<long double> &phi, std::vector<Vector3<long double>> &e) {
+    phi.assign(t.size(), 0.0L);
+    e.assign(t.size(), {0.0L, 0.0L, 0.0L});
+    for (size_t i = 0; i < t.size(); ++i) {
+        for (size_t j = 0; j < s.size(); ++j) {
+            long double dx = (long double) t[i].x - s[j].x;
+            long double dy = (long double) t[i].y - s[j].y;
+            long double dz = (long double) t[i].z - s[j].z;
+            long double r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 == 0.0L) continue;
+            long double inv = 1.0L / std::sqrt(r2);
+            phi[i] += q[j] * inv;
+            long double inv3 = q[j] * inv * inv * inv;
+            e[i].x += dx * inv3;
+            e[i].y += dy * inv3;
+            e[i].z += dz * inv3;
+        }
+    }
+}
+
+TEST_CASE("p2p matches a long double reference", "[P2P]") {
+
+    std::mt19937_64 rng(32);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t ns = 1500, nt = 203;
+    std::vector<Vector3<double>> s(ns), t(nt);
+    std::vector<double> q(ns);
+    for (auto &p: s) p = {u(rng), u(rng), u(rng)};
+    for (auto &p: t) p = {u(rng), u(rng), u(rng)};
+    for (auto &c: q) c = u(rng);
+
+    std::vector<long double> phi_ref;
+    std::vector<Vector3<long double>> e_ref;
+    reference(s, q, t, phi_ref, e_ref);
+
+    ThreadPool pool(3);
+    Vector3Array<double> sources(s), targets(t), field(nt);
+    std::vector<double> phi(nt, 0.0);
+    p2p(sources, q, targets, phi, field, P2PMode::distinct, pool);
+
+    for (size_t i = 0; i < nt; ++i) {
+        REQUIRE(std::abs(phi[i] - (double) phi_ref[i]) <= 1.0e-11 * (1.0 + std::abs((double) phi_ref[i])));
+        Vector3<double> f = field[i];
+        REQUIRE(std::abs(f.x - (double) e_ref[i].x) <= 1.0e-10 * (1.0 + std::abs((double) e_ref[i].x)));
+        REQUIRE(std::abs(f.y - (double) e_ref[i].y) <= 1.0e-10 * (1.0 + std::abs((double) e_ref[i].y)));
+        REQUIRE(std::abs(f.z - (double) e_ref[i].z) <= 1.0e-10 * (1.0 + std::abs((double) e_ref[i].z)));
+    }
+
+    // p2p accumulates.
+    p2p(sources, q, targets, phi, field, P2PMode::distinct, pool);
+    REQUIRE(std::abs(phi[7] - 2.0 * (double) phi_ref[7]) <= 1.0e-10);
+
+}
+
+TEST_CASE("p2p self mode skips i == j", "[P2P]") {
+
+    std::mt19937_64 rng(33);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    const size_t n = 517;
+    std::vector<Vector3<double>> s(n);
+    std::vector<double> q(n, 1.0);
+    for (auto &p: s) p = {u(rng), u(rng), u(rng)};
+
+    std::vector<long double> phi_ref;
+    std::vector<Vector3<long double>> e_ref;
+    reference(s, q, s, phi_ref, e_ref);
+
+    Vector3Array<double> points(s), field(n);
+    std::vector<double> phi(n, 0.0);
+    p2p(points, q, points, phi, field, P2PMode::self);
+
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(std::isfinite(phi[i]));
+        REQUIRE(std::abs(phi[i] - (double) phi_ref[i]) <= 1.0e-11 * std::abs((double) phi_ref[i]));
+    }
+
+    std::vector<double> wrong(n + 1);
+    Vector3Array<double> more(n + 1);
+    REQUIRE_THROWS_AS(p2p(points, q, more, wrong, more, P2PMode::self), std::invalid_argument);
+
+}
+
+/**
+ * @brief Runs lanes S and the scalar lanes over the same self interaction of
+ *        points scaled by `scale`, and compares them.
+ */
+template <typename S>
+static void check_lanes(double scale, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    const size_t n = 1100;
+    Vector3Array<double> s(n), field_a(n), field_b(n);
+    std::vector<double> q(n), phi_a(n, 0.0), phi_b(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        s.set(i, {scale * u(rng), scale * u(rng), scale * u(rng)});
+        q[i] = u(rng);
+    }
+
+    detail::p2p_tiled<S>(s.x(), s.y(), s.z(), q.data(), n, s.x(), s.y(), s.z(), n,
+                         phi_a.data(), field_a.x(), field_a.y(), field_a.z());
+    detail::p2p_tiled<detail::P2PScalar>(s.x(), s.y(), s.z(), q.data(), n, s.x(), s.y(), s.z(), n,
+                                         phi_b.data(), field_b.x(), field_b.y(), field_b.z());
+
+    // The potential scales as 1/scale and the field as 1/scale^2; the margins
+    // are in units of those (the sums of signed charges cancel).
+    double unit = 1.0 / (scale * scale);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(std::isfinite(phi_a[i]));
+        REQUIRE(phi_a[i] == Approx(phi_b[i]).epsilon(1.0e-12).margin(1.0e-12 / scale));
+        REQUIRE(field_a[i].x / unit == Approx(field_b[i].x / unit).epsilon(1.0e-11).margin(1.0e-9));
+        REQUIRE(field_a[i].z / unit == Approx(field_b[i].z / unit).epsilon(1.0e-11).margin(1.0e-9));
+    }
+}
+
+TEST_CASE("The SIMD lanes agree with the scalar lanes", "[P2P]") {
+
+    for_each_simd_lanes([](auto lanes) { check_lanes<decltype(lanes)>(1.0, 34); });
+
+}
+
+TEST_CASE("The SIMD lanes agree with the scalar lanes for widely separated points", "[P2P]") {
+
+    // r2 far above FLT_MAX and far below FLT_MIN, outside the range of a
+    // single precision rsqrt estimate.
+    for_each_simd_lanes([](auto lanes) {
+        check_lanes<decltype(lanes)>(1.0e25, 35);
+        check_lanes<decltype(lanes)>(1.0e-25, 36);
+    });
+
+    // The public kernel too, on a pair per lane width at extreme distances.
+    const size_t n = 16;
+    Vector3Array<double> s(n), field(n);
+    std::vector<double> q(n, 1.0), phi(n, 0.0);
+    for (size_t i = 0; i < n; ++i) s.set(i, {i % 2 ? 1.0e30 * i : 1.0e-30 * i, 0.0, 0.0});
+    p2p_kernel(s.x(), s.y(), s.z(), q.data(), n, s.x(), s.y(), s.z(), n,
+               phi.data(), field.x(), field.y(), field.z());
+    std::vector<double> ref(n, 0.0);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            if (i != j) ref[i] += 1.0 / std::abs(s[i].x - s[j].x);
+    for (size_t i = 0; i < n; ++i) REQUIRE(phi[i] == Approx(ref[i]).epsilon(1.0e-12));
+
+}
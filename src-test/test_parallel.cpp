@@ -0,0 +1,116 @@
+/*
+ * @file test_parallel.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the worker pool and parallel loops
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "parallel.hpp"
+
+// ######################################################################### //
+// # Worker pool.                                                          # //
+// ######################################################################### //
+
+TEST_CASE("ThreadPool runs every task once", "[ThreadPool]") {
+
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+
+    pool.run(hits.size(), [&](size_t t, size_t worker) {
+        REQUIRE(worker < pool.size());
+        hits[t]++;
+    });
+
+    for (auto &h: hits) REQUIRE(h.load() == 1);
+
+}
+
+TEST_CASE("ThreadPool propagates exceptions", "[ThreadPool]") {
+
+    ThreadPool pool(4);
+
+    REQUIRE_THROWS_AS(pool.run(64, [](size_t t, size_t) {
+        if (t == 17) throw std::runtime_error("task failed");
+    }), std::runtime_error);
+
+    // The pool stays usable after a failed batch.
+    std::atomic<size_t> count = 0;
+    pool.run(64, [&](size_t, size_t) { count++; });
+    REQUIRE(count.load() == 64);
+
+}
+
+// ######################################################################### //
+// # Parallel loops.                                                       # //
+// ######################################################################### //
+
+TEST_CASE("parallel_for covers the range exactly once", "[parallel_for]") {
+
+    ThreadPool pool(3);
+    std::vector<int> v(100003, 0);
+
+    parallel_for(0, v.size(), 100, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) v[i] += 1;
+    }, pool);
+
+    REQUIRE(std::accumulate(v.begin(), v.end(), 0L) == 100003L);
+
+}
+
+TEST_CASE("parallel_for nested inside a task runs inline", "[parallel_for]") {
+
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> v(64 * 64);
+
+    parallel_for(0, 64, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            parallel_for(0, 64, 1, [&](size_t b, size_t e) {
+                for (size_t j = b; j < e; ++j) v[64 * i + j]++;
+            }, pool);
+        }
+    }, pool);
+
+    for (auto &x: v) REQUIRE(x.load() == 1);
+
+}
+
+TEST_CASE("parallel_for_worker keeps the worker index of a nested caller", "[parallel_for]") {
+
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> mismatches(1);
+
+    pool.run(64, [&](size_t, size_t worker) {
+        // A single chunk takes the inline shortcut.
+        parallel_for_worker(0, 10, 100, [&](size_t, size_t, size_t inner) {
+            if (inner != worker) mismatches[0]++;
+        }, pool);
+    });
+
+    REQUIRE(mismatches[0].load() == 0);
+
+}
+
+TEST_CASE("A worker of a larger pool gets indices of the smaller pool it calls", "[parallel_for]") {
+
+    ThreadPool big(6), small(2);
+    std::vector<std::atomic<int>> hits(small.size());
+    std::atomic<int> out_of_range = 0;
+
+    big.run(48, [&](size_t, size_t) {
+        parallel_for_worker(0, 1000, 10, [&](size_t, size_t, size_t worker) {
+            if (worker >= small.size()) out_of_range++;
+            else hits[worker]++;
+        }, small);
+    });
+
+    REQUIRE(out_of_range.load() == 0);
+
+}
@@ -0,0 +1,291 @@
+/*
+ * @file test_point_location.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test point location and interpolation in tetrahedral meshes
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include "point_location.hpp"
+#include "soa.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+/**
+ * @brief Moves the interior nodes of a cube mesh by up to a tenth of a cell,
+ *        so that elements have no common shape (the nodes on the notch stay
+ *        put).
+ */
+static void jitter(size_t n, double side, bool notch, std::vector<Vector3<double>> &nodes) {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> u(-0.1 * side / double(n), 0.1 * side / double(n));
+    const double half = 0.5 * side * (1.0 - 1.0e-12);
+    for (Vector3<double> &p: nodes) {
+        const Vector3<double> d{u(gen), u(gen), u(gen)};
+        if (notch && p.x >= half && p.y >= half && p.z >= half) continue;
+        if (p.x > 0.0 && p.y > 0.0 && p.z > 0.0 && p.x < side && p.y < side && p.z < side) p = p + d;
+    }
+}
+
+static std::vector<Vector3<double>> random_points(size_t n, double lo, double hi, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> u(lo, hi);
+    std::vector<Vector3<double>> points(n);
+    for (auto &p: points) p = {u(gen), u(gen), u(gen)};
+    return points;
+}
+
+/**
+ * @brief The element containing p by a scan of every element, or TET_NONE.
+ */
+static uint32_t scan(const TetMesh &mesh, const Vector3<double> &p) {
+    for (size_t e = 0; e < mesh.element_count(); ++e) {
+        auto l = barycentric(mesh, e, p);
+        if (*std::min_element(l.begin(), l.end()) >= -LOCATE_TOLERANCE) return uint32_t(e);
+    }
+    return TET_NONE;
+}
+
+// ######################################################################### //
+// # Barycentric coordinates.                                              # //
+// ######################################################################### //
+
+TEST_CASE("Barycentric coordinates reproduce the point", "[PointLocation]") {
+
+    const Vector3<double> x[4] = {{0.1, 0.2, -0.3}, {1.3, 0.1, 0.2}, {0.4, 1.1, 0.0}, {0.2, 0.3, 0.9}};
+    for (size_t i = 0; i < 4; ++i) {
+        auto l = barycentric(x[0], x[1], x[2], x[3], x[i]);
+        for (size_t j = 0; j < 4; ++j) REQUIRE(l[j] == Approx(i == j ? 1.0 : 0.0).margin(1.0e-14));
+    }
+    for (const Vector3<double> &p: random_points(100, -1.0, 2.0, 1)) {
+        auto l = barycentric(x[0], x[1], x[2], x[3], p);
+        // Swapping two nodes turns the element inside out.
+        auto r = barycentric(x[1], x[0], x[2], x[3], p);
+        const Vector3<double> q = l[0] * x[0] + l[1] * x[1] + l[2] * x[2] + l[3] * x[3];
+        REQUIRE(l[0] + l[1] + l[2] + l[3] == Approx(1.0).epsilon(1.0e-14));
+        REQUIRE(q.x == Approx(p.x).margin(1.0e-14));
+        REQUIRE(q.y == Approx(p.y).margin(1.0e-14));
+        REQUIRE(q.z == Approx(p.z).margin(1.0e-14));
+        REQUIRE(r[0] == Approx(l[1]).margin(1.0e-14));
+        REQUIRE(r[1] == Approx(l[0]).margin(1.0e-14));
+    }
+
+}
+
+// ######################################################################### //
+// # Location.                                                             # //
+// ######################################################################### //
+
+TEST_CASE("Faces are matched across elements", "[PointLocation]") {
+
+    const size_t n = 5;
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(n, 1.0, nodes, elements);
+    TetMesh mesh(nodes, elements);
+    TetLocator locator(mesh);
+    auto neighbours = locator.neighbours();
+    REQUIRE(neighbours.size() == 4 * mesh.element_count());
+
+    size_t boundary = 0;
+    for (size_t f = 0; f < neighbours.size(); ++f) {
+        const uint32_t e = uint32_t(f / 4), g = neighbours[f];
+        if (g == TET_NONE) {
+            ++boundary;
+            continue;
+        }
+        REQUIRE(g != e);
+        // The neighbour shares the three nodes of the face, and names e back.
+        size_t shared = 0;
+        for (uint32_t v: mesh.element(e)) {
+            for (uint32_t w: mesh.element(g)) shared += v == w;
+        }
+        REQUIRE(shared == 3);
+        REQUIRE(std::count(neighbours.begin() + 4 * g, neighbours.begin() + 4 * g + 4, e) == 1);
+    }
+    // Two triangles per boundary square.
+    REQUIRE(boundary == 12 * n * n);
+
+}
+
+TEST_CASE("Searches and walks find the containing element", "[PointLocation]") {
+
+    const size_t n = 6;
+    const double side = 2.0;
+    for (bool notch: {false, true}) {
+        std::vector<Vector3<double>> nodes;
+        std::vector<uint32_t> elements;
+        cube_mesh(n, side, nodes, elements, notch);
+        jitter(n, side, notch, nodes);
+        TetMesh mesh(nodes, elements);
+        double volume = 0.0;
+        for (double v: mesh.volumes()) volume += v;
+        REQUIRE(volume == Approx(notch ? 7.0 : 8.0).epsilon(1.0e-12));
+
+        TetLocator locator(mesh);
+        // Some points in the notch and some outside the cube.
+        const std::vector<Vector3<double>> points = random_points(600, -0.2, side + 0.2, 2);
+        uint32_t far = 0;
+        for (const Vector3<double> &p: points) {
+            const uint32_t expected = scan(mesh, p);
+            const TetLocation searched = locator.locate(p);
+            const TetLocation walked = locator.locate(p, far);
+            REQUIRE(searched.found() == (expected != TET_NONE));
+            REQUIRE(walked.found() == (expected != TET_NONE));
+            if (expected == TET_NONE) continue;
+            // A random point lies on no face, so the element is unique.
+            REQUIRE(searched.element == expected);
+            REQUIRE(walked.element == expected);
+            auto v = mesh.element(expected);
+            const auto &l = searched.weights;
+            const Vector3<double> q = l[0] * mesh.node(v[0]) + l[1] * mesh.node(v[1]) + l[2] * mesh.node(v[2]) +
+                                      l[3] * mesh.node(v[3]);
+            REQUIRE(q.x == Approx(p.x).margin(1.0e-13));
+            REQUIRE(q.y == Approx(p.y).margin(1.0e-13));
+            REQUIRE(q.z == Approx(p.z).margin(1.0e-13));
+            far = (far + 997) % uint32_t(mesh.element_count());
+        }
+    }
+
+}
+
+TEST_CASE("Points on nodes and faces are found", "[PointLocation]") {
+
+    const size_t n = 4;
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(n, 1.0, nodes, elements);
+    TetMesh mesh(nodes, elements);
+    TetLocator locator(mesh);
+    std::vector<TetLocation> out(nodes.size());
+    LocateStats stats = locator.locate(nodes, out);
+    REQUIRE(stats.outside == 0);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        REQUIRE(out[i].found());
+        auto v = mesh.element(out[i].element);
+        for (size_t j = 0; j < 4; ++j) {
+            REQUIRE(out[i].weights[j] == Approx(v[j] == i ? 1.0 : 0.0).margin(1.0e-14));
+        }
+    }
+
+}
+
+TEST_CASE("Batched queries match single queries", "[PointLocation]") {
+
+    const size_t n = 10;
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(n, 1.0, nodes, elements, true);
+    jitter(n, 1.0, true, nodes);
+    ThreadPool one(1), three(3);
+    TetMesh mesh(nodes, elements, one);
+    TetLocator serial(mesh, one), parallel(mesh, three);
+
+    const std::vector<Vector3<double>> points = random_points(20000, -0.05, 1.05, 3);
+    std::vector<TetLocation> a(points.size()), b(points.size());
+    LocateStats sa = serial.locate(points, a);
+    LocateStats sb = parallel.locate(points, b);
+    REQUIRE(sa.searches == sb.searches);
+    REQUIRE(sa.walk_steps == sb.walk_steps);
+    REQUIRE(sa.outside == sb.outside);
+    REQUIRE(sa.outside > 0);
+    // Sorted points are close: besides the points outside (whose walks end
+    // at the boundary), few searches, and few steps per point.
+    REQUIRE(sa.searches < sa.outside + points.size() / 20);
+    REQUIRE(sa.walk_steps < 4 * points.size());
+
+    for (size_t k = 0; k < points.size(); ++k) {
+        REQUIRE(a[k].element == b[k].element);
+        REQUIRE(a[k].element == serial.locate(points[k]).element);
+        for (size_t j = 0; j < 4; ++j) REQUIRE(a[k].weights[j] == b[k].weights[j]);
+    }
+
+    std::vector<TetLocation> wrong(points.size() - 1);
+    REQUIRE_THROWS_AS(serial.locate(points, wrong), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # Interpolation.                                                        # //
+// ######################################################################### //
+
+TEST_CASE("Linear fields interpolate exactly", "[PointLocation]") {
+
+    const size_t n = 8;
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(n, 1.0, nodes, elements, true);
+    jitter(n, 1.0, true, nodes);
+    TetMesh mesh(nodes, elements);
+    TetLocator locator(mesh);
+
+    const Matrix3x3<double> a{1.0, -2.0, 0.5, 0.3, 0.7, -1.1, 2.0, 0.0, 0.4};
+    const Vector3<double> c{0.2, -0.4, 1.0};
+    Vector3Array<double> field(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) field.set(i, a * nodes[i] + c);
+
+    const std::vector<Vector3<double>> points = random_points(5000, -0.1, 1.1, 4);
+    Vector3Array<double> out(points.size());
+    const size_t outside = locator.interpolate(field, points, out);
+    size_t expected = 0;
+    for (size_t k = 0; k < points.size(); ++k) {
+        const TetLocation location = locator.locate(points[k]);
+        if (!location.found()) {
+            ++expected;
+            REQUIRE(out[k].x == 0.0);
+            REQUIRE(out[k].y == 0.0);
+            REQUIRE(out[k].z == 0.0);
+            continue;
+        }
+        const Vector3<double> exact = a * points[k] + c;
+        REQUIRE(out[k].x == Approx(exact.x).margin(1.0e-13));
+        REQUIRE(out[k].y == Approx(exact.y).margin(1.0e-13));
+        REQUIRE(out[k].z == Approx(exact.z).margin(1.0e-13));
+    }
+    REQUIRE(outside == expected);
+    REQUIRE(outside > 0);
+
+    // Probing again from stored locations.
+    std::vector<TetLocation> locations(points.size());
+    locator.locate(points, locations);
+    Vector3Array<double> again(points.size());
+    REQUIRE(locator.interpolate(field, locations, again) == outside);
+    for (size_t k = 0; k < points.size(); ++k) REQUIRE(again[k].x == out[k].x);
+
+    Vector3Array<double> short_field(nodes.size() - 1), short_out(points.size() - 1);
+    REQUIRE_THROWS_AS(locator.interpolate(short_field, points, out), std::invalid_argument);
+    REQUIRE_THROWS_AS(locator.interpolate(field, locations, short_out), std::invalid_argument);
+
+}
+
+TEST_CASE("Refitting follows moved nodes", "[PointLocation]") {
+
+    const size_t n = 6;
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(n, 1.0, nodes, elements);
+    TetMesh mesh(nodes, elements);
+    TetLocator locator(mesh);
+
+    const Vector3<double> shift{3.0, -1.0, 0.5};
+    std::vector<Vector3<double>> displacement(nodes.size(), shift);
+    mesh.move_nodes(displacement);
+    locator.refit();
+    for (const Vector3<double> &p: random_points(500, 0.0, 1.0, 5)) {
+        const TetLocation moved = locator.locate(p + shift);
+        REQUIRE(moved.found());
+        REQUIRE(moved.element == scan(mesh, p + shift));
+        REQUIRE_FALSE(locator.locate(p).found());
+    }
+
+}
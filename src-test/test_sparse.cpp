@@ -0,0 +1,250 @@
+/*
+ * @file test_sparse.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the CSR and BSR matrices and their products
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "parallel.hpp"
+#include "sparse.hpp"
+
+/**
+ * @brief A random rows x cols matrix with about density of its entries
+ *        stored, some empty rows and one full row.
+ */
+static CsrMatrix random_csr(size_t rows, size_t cols, double density, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0), coin(0.0, 1.0);
+    std::vector<size_t> row_ptr{0};
+    std::vector<uint32_t> col_idx;
+    std::vector<double> values;
+    for (size_t i = 0; i < rows; ++i) {
+        const double p = i % 17 == 5 ? 0.0 : i == rows / 2 ? 1.0 : density;
+        for (size_t j = 0; j < cols; ++j) {
+            if (coin(rng) < p) {
+                col_idx.push_back(uint32_t(j));
+                values.push_back(u(rng));
+            }
+        }
+        row_ptr.push_back(col_idx.size());
+    }
+    return {rows, cols, std::move(row_ptr), std::move(col_idx), values};
+}
+
+static std::vector<double> random_vector(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> x(n);
+    for (double &v: x) v = u(rng);
+    return x;
+}
+
+/**
+ * @brief y = A x by the definition, row by row.
+ */
+template <typename Matrix>
+static std::vector<double> reference_product(const Matrix &a, const std::vector<double> &x) {
+    std::vector<double> y(a.rows(), 0.0);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t j = 0; j < a.cols(); ++j) y[i] += a(i, j) * x[j];
+    }
+    return y;
+}
+
+// ######################################################################### //
+// # Construction.                                                         # //
+// ######################################################################### //
+
+TEST_CASE("Malformed patterns are rejected", "[Sparse]") {
+
+    REQUIRE_NOTHROW(CsrMatrix(2, 3, {0, 1, 3}, {2, 0, 1}));
+    REQUIRE_THROWS_AS(CsrMatrix(2, 3, {0, 1}, {2}), std::invalid_argument);
+    REQUIRE_THROWS_AS(CsrMatrix(2, 3, {0, 2, 1}, {2}), std::invalid_argument);
+    REQUIRE_THROWS_AS(CsrMatrix(2, 3, {0, 1, 3}, {2, 1, 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(CsrMatrix(2, 3, {0, 1, 3}, {3, 0, 1}), std::invalid_argument);
+    std::vector<double> two = {1.0, 2.0};
+    REQUIRE_THROWS_AS(CsrMatrix(2, 3, {0, 1, 3}, {2, 0, 1}, two), std::invalid_argument);
+
+    REQUIRE_NOTHROW(BsrMatrix(1, 2, {0, 2}, {0, 1}));
+    REQUIRE_THROWS_AS(BsrMatrix(1, 2, {0, 2}, {1, 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(BsrMatrix::from_csr(random_csr(4, 6, 0.5, 1)), std::invalid_argument);
+
+}
+
+TEST_CASE("BSR from CSR keeps every entry", "[Sparse]") {
+
+    CsrMatrix a = random_csr(36, 45, 0.15, 2);
+    BsrMatrix b = BsrMatrix::from_csr(a);
+    REQUIRE(b.block_rows() == 12);
+    REQUIRE(b.block_cols() == 15);
+    REQUIRE(b.nnzb() <= a.nnz());
+    REQUIRE(9 * b.nnzb() >= a.nnz());
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t j = 0; j < a.cols(); ++j) REQUIRE(b(i, j) == a(i, j));
+    }
+
+}
+
+// ######################################################################### //
+// # Products.                                                             # //
+// ######################################################################### //
+
+TEST_CASE("Row ranges are balanced by entries", "[Sparse]") {
+
+    // Rows of 1, 2, ..., 4000 entries: equal row counts would be very
+    // unequal work.
+    const size_t rows = 4000;
+    std::vector<size_t> row_ptr(rows + 1, 0);
+    for (size_t i = 0; i < rows; ++i) row_ptr[i + 1] = row_ptr[i] + i + 1;
+    ThreadPool pool(4);
+    std::vector<size_t> bounds = detail::balanced_rows(row_ptr, 1, pool);
+
+    REQUIRE(bounds.size() == 17);
+    REQUIRE(bounds.front() == 0);
+    REQUIRE(bounds.back() == rows);
+    const double share = double(row_ptr[rows] + rows) / 16.0;
+    for (size_t t = 0; t + 1 < bounds.size(); ++t) {
+        REQUIRE(bounds[t] < bounds[t + 1]);
+        double work = double(row_ptr[bounds[t + 1]] - row_ptr[bounds[t]] + bounds[t + 1] - bounds[t]);
+        REQUIRE(std::abs(work - share) <= double(rows) + 1.0);
+    }
+
+    // A small product is not split.
+    ThreadPool one(1);
+    REQUIRE(detail::balanced_rows(row_ptr, 1, one).size() == 2);
+    std::vector<size_t> tiny = {0, 3, 3, 5};
+    REQUIRE(detail::balanced_rows(tiny, 1, pool) == std::vector<size_t>{0, 3});
+
+}
+
+TEST_CASE("SpMV matches the dense product", "[Sparse]") {
+
+    ThreadPool one(1), three(3);
+    for (auto [rows, cols, density]: {std::tuple{1, 1, 1.0}, std::tuple{37, 23, 0.3}, std::tuple{3000, 2900, 0.01}}) {
+        CsrMatrix a = random_csr(size_t(rows), size_t(cols), density, 3);
+        std::vector<double> x = random_vector(size_t(cols), 4);
+        std::vector<double> expected = reference_product(a, x);
+
+        std::vector<double> y1(a.rows()), y3(a.rows());
+        spmv(a, x, y1, one);
+        spmv(a, x, y3, three);
+        for (size_t i = 0; i < a.rows(); ++i) REQUIRE(y1[i] == Approx(expected[i]).margin(1.0e-12));
+        REQUIRE(y1 == y3);
+    }
+
+    CsrMatrix a = random_csr(4, 4, 0.5, 5);
+    std::vector<double> x(4), y(3);
+    REQUIRE_THROWS_AS(spmv(a, x, y), std::invalid_argument);
+
+}
+
+TEST_CASE("The CSR row gathers match the scalar row sum", "[Sparse]") {
+
+    // Every length up to three full groups of eight, so that each partial
+    // (masked or scalar) tail length occurs, with columns up to the last
+    // entry of x.
+    std::mt19937_64 rng(6);
+    const size_t m = 101;
+    std::vector<double> x = random_vector(m, 7);
+    for (size_t n = 0; n <= 24; ++n) {
+        std::vector<double> v = random_vector(n, 8 + n);
+        std::vector<uint32_t> c(n);
+        for (auto &j: c) j = uint32_t(rng() % m);
+        if (n > 0) c.back() = uint32_t(m - 1);
+        const double expected = detail::csr_row_dot_scalar(v.data(), c.data(), n, x.data());
+        REQUIRE(detail::csr_row_dot(v.data(), c.data(), n, x.data()) == Approx(expected).margin(1.0e-14));
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+        REQUIRE(detail::csr_row_dot_avx512(v.data(), c.data(), n, x.data()) == Approx(expected).margin(1.0e-14));
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+        REQUIRE(detail::csr_row_dot_avx2(v.data(), c.data(), n, x.data()) == Approx(expected).margin(1.0e-14));
+#endif
+    }
+
+}
+
+TEST_CASE("BSR SpMV matches the CSR product", "[Sparse]") {
+
+    ThreadPool three(3);
+    CsrMatrix a = random_csr(3 * 700, 3 * 650, 0.01, 6);
+    BsrMatrix b = BsrMatrix::from_csr(a);
+    std::vector<double> x = random_vector(a.cols(), 7);
+    std::vector<double> expected = reference_product(a, x), y(a.rows());
+    spmv(b, x, y, three);
+    for (size_t i = 0; i < a.rows(); ++i) REQUIRE(y[i] == Approx(expected[i]).margin(1.0e-12));
+
+    std::vector<double> wrong(a.rows() + 1);
+    REQUIRE_THROWS_AS(spmv(b, x, wrong), std::invalid_argument);
+
+}
+
+TEST_CASE("SpMM matches one SpMV per right-hand side", "[Sparse]") {
+
+    ThreadPool three(3);
+    CsrMatrix a = random_csr(3 * 400, 3 * 420, 0.02, 8);
+    BsrMatrix b = BsrMatrix::from_csr(a);
+
+    // 11 right-hand sides: a full register block of 8 and a remainder of 3.
+    for (size_t nrhs: {size_t(1), size_t(8), size_t(11)}) {
+        std::vector<double> x = random_vector(a.cols() * nrhs, 9);
+        std::vector<double> y(a.rows() * nrhs), z(a.rows() * nrhs);
+        spmm(a, x, y, nrhs, three);
+        spmm(b, x, z, nrhs, three);
+        for (size_t r = 0; r < nrhs; ++r) {
+            std::vector<double> column(a.cols()), single(a.rows());
+            for (size_t j = 0; j < a.cols(); ++j) column[j] = x[j * nrhs + r];
+            spmv(a, column, single, three);
+            for (size_t i = 0; i < a.rows(); ++i) {
+                REQUIRE(y[i * nrhs + r] == Approx(single[i]).margin(1.0e-12));
+                REQUIRE(z[i * nrhs + r] == Approx(single[i]).margin(1.0e-12));
+            }
+        }
+    }
+
+    std::vector<double> x(a.cols() * 2), y(a.rows() * 3);
+    REQUIRE_THROWS_AS(spmm(a, x, y, 2), std::invalid_argument);
+    REQUIRE_THROWS_AS(spmm(b, x, y, 2), std::invalid_argument);
+
+}
+
+TEST_CASE("SpGEMM and transpose match the dense products", "[Sparse]") {
+
+    ThreadPool one(1), three(3);
+    CsrMatrix a = random_csr(130, 90, 0.05, 10), b = random_csr(90, 110, 0.04, 11);
+    CsrMatrix c = spgemm(a, b, three), c1 = spgemm(a, b, one);
+    REQUIRE(c.rows() == 130);
+    REQUIRE(c.cols() == 110);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t j = 0; j < b.cols(); ++j) {
+            double sum = 0.0;
+            bool structural = false;
+            for (size_t k = 0; k < a.cols(); ++k) {
+                sum += a(i, k) * b(k, j);
+                structural = structural || (a.find(i, k) != CsrMatrix::npos && b.find(k, j) != CsrMatrix::npos);
+            }
+            REQUIRE(c(i, j) == Approx(sum).margin(1.0e-14));
+            REQUIRE((c.find(i, j) != CsrMatrix::npos) == structural);
+        }
+    }
+    REQUIRE(std::equal(c.values().begin(), c.values().end(), c1.values().begin(), c1.values().end()));
+
+    CsrMatrix t = transpose(a);
+    REQUIRE(t.rows() == a.cols());
+    REQUIRE(t.nnz() == a.nnz());
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t j = 0; j < a.cols(); ++j) REQUIRE(t(j, i) == a(i, j));
+    }
+
+    REQUIRE_THROWS_AS(spgemm(a, a), std::invalid_argument);
+
+}
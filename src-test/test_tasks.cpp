@@ -0,0 +1,142 @@
+/*
+ * @file test_tasks.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the work-stealing task pool and task graphs
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "tasks.hpp"
+
+// ######################################################################### //
+// # Work-stealing pool.                                                   # //
+// ######################################################################### //
+
+/**
+ * @brief Counts the nodes of a complete binary tree of the given depth,
+ *        spawning one task per node.
+ */
+static void count_nodes(TaskPool &pool, size_t depth, std::atomic<size_t> &count) {
+    count++;
+    if (depth == 0) return;
+    pool.spawn([&pool, depth, &count]() { count_nodes(pool, depth - 1, count); });
+    pool.spawn([&pool, depth, &count]() { count_nodes(pool, depth - 1, count); });
+}
+
+TEST_CASE("TaskPool runs every spawned task once", "[TaskPool]") {
+
+    TaskPool pool(4);
+    std::atomic<size_t> count = 0;
+    pool.run([&]() { count_nodes(pool, 14, count); });
+    REQUIRE(count.load() == (size_t{1} << 15) - 1);
+
+    // Worker indices are in range, and the pool can be run again.
+    std::vector<std::atomic<int>> seen(pool.size());
+    pool.run([&]() {
+        for (int i = 0; i < 1000; ++i) pool.spawn([&]() { seen[TaskPool::current_worker()]++; });
+    });
+    int total = 0;
+    for (auto &s: seen) total += s.load();
+    REQUIRE(total == 1000);
+
+}
+
+TEST_CASE("TaskPool propagates exceptions and rejects misuse", "[TaskPool]") {
+
+    TaskPool pool(3);
+    REQUIRE_THROWS_AS(pool.run([&]() {
+        for (int i = 0; i < 100; ++i) {
+            pool.spawn([i]() { if (i == 42) throw std::runtime_error("task failed"); });
+        }
+    }), std::runtime_error);
+
+    REQUIRE_THROWS_AS(pool.spawn([]() {}), std::logic_error);
+    REQUIRE_THROWS_AS(pool.run([&]() { pool.run([]() {}); }), std::logic_error);
+
+    std::atomic<size_t> count = 0;
+    pool.run([&]() { count_nodes(pool, 6, count); });
+    REQUIRE(count.load() == 127);
+
+}
+
+TEST_CASE("TaskPool run from a task of another pool keeps its membership", "[TaskPool]") {
+
+    TaskPool outer(4), inner(3);
+    std::atomic<size_t> count = 0, mismatched = 0;
+    outer.run([&]() {
+        for (int i = 0; i < 64; ++i) {
+            outer.spawn([&, i]() {
+                size_t worker = TaskPool::current_worker();
+                if (i % 2 == 0) {
+                    inner.run([&]() { count_nodes(inner, 3, count); });
+                } else {
+                    try {
+                        inner.run([]() { throw std::runtime_error("inner task failed"); });
+                    } catch (const std::runtime_error &) {}
+                }
+                if (TaskPool::current_worker() != worker) mismatched++;
+                // Spawning on the outer pool is still valid after the inner run.
+                outer.spawn([&]() { count++; });
+            });
+        }
+    });
+    REQUIRE(mismatched.load() == 0);
+    REQUIRE(count.load() == 32 * 15 + 64);
+
+}
+
+// ######################################################################### //
+// # Dependency graphs.                                                    # //
+// ######################################################################### //
+
+TEST_CASE("TaskGraph runs tasks after their predecessors", "[TaskGraph]") {
+
+    // A diamond lattice: task (i, j) after (i - 1, j) and (i, j - 1).
+    const size_t n = 40;
+    TaskPool pool(4);
+    TaskGraph graph;
+    std::vector<std::atomic<size_t>> value(n * n);
+    std::vector<size_t> id(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            id[i * n + j] = graph.add([&, i, j]() {
+                size_t v = 1;
+                if (i > 0) v += value[(i - 1) * n + j].load();
+                if (j > 0) v += value[i * n + j - 1].load();
+                value[i * n + j].store(v);
+            });
+            if (i > 0) graph.precede(id[(i - 1) * n + j], id[i * n + j]);
+            if (j > 0) graph.precede(id[i * n + j - 1], id[i * n + j]);
+        }
+    }
+    graph.run(pool);
+
+    // v(i, j) = C(i + j + 2, i + 1) - 1; check the first rows and columns.
+    REQUIRE(value[0].load() == 1);
+    REQUIRE(value[1].load() == 2);
+    REQUIRE(value[n + 1].load() == 5);
+    REQUIRE(value[2 * n + 2].load() == 19);
+
+    // Runs again from scratch.
+    graph.run(pool);
+    REQUIRE(value[2 * n + 2].load() == 19);
+
+}
+
+TEST_CASE("TaskGraph rejects cycles", "[TaskGraph]") {
+
+    TaskPool pool(2);
+    TaskGraph graph;
+    size_t a = graph.add([]() {}), b = graph.add([]() {}), c = graph.add([]() {});
+    graph.precede(a, b);
+    graph.precede(b, c);
+    graph.precede(c, b);
+    REQUIRE_THROWS_AS(graph.run(pool), std::logic_error);
+
+}
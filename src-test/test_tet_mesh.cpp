@@ -0,0 +1,135 @@
+/*
+ * @file test_tet_mesh.cpp
+ * @author Lesleis Nagy
+ * @date 18/10/2026
+ * @brief Test the tetrahedral mesh and its geometry caches
+ */
+
+#define CATCH_CONFIG_MAIN
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "linalg.hpp"
+#include "morton.hpp"
+#include "parallel.hpp"
+#include "tet_mesh.hpp"
+#include "test_meshes.hpp"
+
+// ######################################################################### //
+// # Construction.                                                         # //
+// ######################################################################### //
+
+TEST_CASE("Elements are stored in Morton order of their centroids", "[TetMesh]") {
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(6, 1.0, nodes, elements);
+    jitter_cube_nodes(6, 1.0, 42, nodes);
+    ThreadPool pool(3);
+    TetMesh mesh(nodes, elements, pool);
+
+    REQUIRE(mesh.node_count() == 343);
+    REQUIRE(mesh.element_count() == 6 * 216);
+
+    // Each stored element is its input element.
+    auto perm = mesh.element_permutation();
+    std::vector<bool> seen(mesh.element_count(), false);
+    for (size_t e = 0; e < mesh.element_count(); ++e) {
+        REQUIRE(!seen[perm[e]]);
+        seen[perm[e]] = true;
+        for (size_t i = 0; i < 4; ++i) REQUIRE(mesh.element(e)[i] == elements[4 * perm[e] + i]);
+    }
+
+    std::vector<Vector3<double>> centroids(mesh.element_count());
+    for (size_t e = 0; e < mesh.element_count(); ++e) centroids[e] = mesh.centroid(e);
+    BoundingCube<double> cube = bounding_cube<double>(centroids);
+    for (size_t e = 1; e < mesh.element_count(); ++e) {
+        REQUIRE(morton_key(cube, centroids[e - 1]) <= morton_key(cube, centroids[e]));
+    }
+
+    std::vector<uint32_t> partial(elements.begin(), elements.begin() + 6);
+    REQUIRE_THROWS_AS(TetMesh(nodes, partial), std::invalid_argument);
+    std::vector<uint32_t> missing = {0, 1, 2, 343};
+    REQUIRE_THROWS_AS(TetMesh(nodes, missing), std::invalid_argument);
+
+}
+
+// ######################################################################### //
+// # Geometry.                                                             # //
+// ######################################################################### //
+
+TEST_CASE("Cached geometry matches the element Jacobians", "[TetMesh]") {
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(5, 1.0, nodes, elements);
+    jitter_cube_nodes(5, 1.0, 42, nodes);
+    TetMesh mesh(nodes, elements);
+
+    // The elements tile the unit cube.
+    auto volumes = mesh.volumes();
+    double total = 0.0;
+    for (double v: volumes) total += v;
+    REQUIRE(total == Approx(1.0).epsilon(1.0e-12));
+
+    auto inverses = mesh.inverse_jacobians();
+    auto gradients = mesh.gradients();
+    for (size_t e = 0; e < mesh.element_count(); ++e) {
+        Matrix3x3<double> j = mesh.jacobian(e), product = inverses[e] * j;
+        for (size_t a = 0; a < 3; ++a) {
+            for (size_t b = 0; b < 3; ++b) REQUIRE(std::abs(product(a, b) - (a == b ? 1.0 : 0.0)) < 1.0e-12);
+        }
+
+        // The shape functions sum to one and reproduce linear functions:
+        // sum_i grad N_i = 0 and sum_i x_i grad N_i^T = I.
+        const TetGradients &g = gradients[e];
+        Vector3<double> sum = g[0] + g[1] + g[2] + g[3];
+        REQUIRE(std::sqrt(inner(sum, sum)) < 1.0e-10);
+        Matrix3x3<double> reproduce{};
+        for (size_t i = 0; i < 4; ++i) reproduce = reproduce + outer(mesh.node(mesh.element(e)[i]), g[i]);
+        for (size_t a = 0; a < 3; ++a) {
+            for (size_t b = 0; b < 3; ++b) REQUIRE(std::abs(reproduce(a, b) - (a == b ? 1.0 : 0.0)) < 1.0e-10);
+        }
+    }
+
+}
+
+TEST_CASE("Geometry caches are built once and invalidated by moving nodes", "[TetMesh]") {
+
+    std::vector<Vector3<double>> nodes;
+    std::vector<uint32_t> elements;
+    cube_mesh(4, 1.0, nodes, elements);
+    jitter_cube_nodes(4, 1.0, 42, nodes);
+    TetMesh mesh(nodes, elements);
+    REQUIRE(mesh.cache_builds() == 0);
+
+    REQUIRE(mesh.gradients().size() == mesh.element_count());
+    REQUIRE(mesh.cache_builds() == 3);
+    REQUIRE(mesh.volumes().size() == mesh.element_count());
+    REQUIRE(mesh.inverse_jacobians().size() == mesh.element_count());
+    REQUIRE(mesh.gradients().size() == mesh.element_count());
+    REQUIRE(mesh.cache_builds() == 3);
+
+    // Doubling every coordinate scales volumes by 8 and gradients by 1/2.
+    const double before = mesh.volumes()[7];
+    const Vector3<double> g = mesh.gradients()[7][2];
+    mesh.move_nodes(nodes);
+    REQUIRE(mesh.volumes()[7] == Approx(8.0 * before));
+    REQUIRE(mesh.gradients()[7][2].x == Approx(0.5 * g.x));
+    REQUIRE(mesh.cache_builds() == 6);
+
+    mesh.set_nodes(nodes);
+    REQUIRE(mesh.volumes()[7] == Approx(before));
+    REQUIRE_THROWS_AS(mesh.set_nodes(std::vector<Vector3<double>>(3)), std::invalid_argument);
+
+    // A flattened element is reported when the geometry is built.
+    std::vector<Vector3<double>> flat = {{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {1.0, 1.0, 0.0}};
+    std::vector<uint32_t> one = {0, 1, 2, 3};
+    TetMesh degenerate(flat, one);
+    REQUIRE_THROWS_AS(degenerate.volumes(), std::invalid_argument);
+
+}